@@ -205,12 +205,10 @@ static int client_copy_to_container(const struct client_arguments *args, const c
 
     config = get_connect_config(args);
     ret = ops->container.copy_to_container(&request, response, &config);
-    if (ret) {
-        goto out;
-    }
 
-    nret = archive_reader.close(archive_reader.context, &archive_err);
-    if (nret < 0) {
+    // always close to stop the archive writer
+    nret = archive_reader.close(archive_reader.context, ret != 0 ? NULL : &archive_err);
+    if (nret < 0 && ret == 0) {
         ret = nret;
     }
 
@@ -228,7 +226,7 @@ static void ignore_sigpipe()
     struct sigaction sa;
 
     /*
-     * Ignore SIGPIPE so the current process still exists after child process exited.
+     * Ignore SIGPIPE so the current process still exists after reader of archive closed the pipe.
      */
     (void)memset(&sa, 0, sizeof(struct sigaction));
 
@@ -27,6 +27,8 @@
 #include <sys/stat.h>
 #include <stdbool.h>
 #include <stdarg.h>
+#include <poll.h>
+#include <sys/ioctl.h>
 
 #include "common.h"
 
@@ -301,3 +303,112 @@ int open_no_inherit(const char *path, int flag, mode_t mode)
     return fd;
 }
 
+
+int write_file_atomic(const char *path, const char *data, size_t len)
+{
+    int fd = -1;
+    ssize_t nret;
+    char tmp_path[PATH_MAX] = { 0 };
+
+    nret = snprintf(tmp_path, sizeof(tmp_path), "%s.tmp.XXXXXX", path);
+    if (nret < 0 || (size_t)nret >= sizeof(tmp_path)) {
+        return SHIM_ERR;
+    }
+
+    // unique tmp file, isulad may update the same file at the same time
+    fd = mkostemp(tmp_path, O_CLOEXEC);
+    if (fd < 0) {
+        return SHIM_ERR;
+    }
+    nret = write_nointr(fd, data, len);
+    close(fd);
+    if (nret < 0 || (size_t)nret != len) {
+        (void)unlink(tmp_path);
+        return SHIM_ERR;
+    }
+
+    // readers always see a complete file
+    if (rename(tmp_path, path) != 0) {
+        (void)unlink(tmp_path);
+        return SHIM_ERR;
+    }
+
+    return SHIM_OK;
+}
+
+bool fd_is_fifo(int fd)
+{
+    struct stat st;
+
+    if (fstat(fd, &st) != 0) {
+        return false;
+    }
+
+    return S_ISFIFO(st.st_mode);
+}
+
+static bool pipe_is_empty(int fd)
+{
+    int avail = 0;
+
+    if (ioctl(fd, FIONREAD, &avail) != 0) {
+        return true;
+    }
+
+    return avail == 0;
+}
+
+static int wait_fd_writable(int fd)
+{
+    int ret;
+    struct pollfd pfd = { 0 };
+
+    pfd.fd = fd;
+    pfd.events = POLLOUT;
+
+    for (;;) {
+        ret = poll(&pfd, 1, -1);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        return ret < 0 ? SHIM_ERR : SHIM_OK;
+    }
+}
+
+ssize_t splice_pipe_drain(int fd_in, int fd_out, bool *eof)
+{
+    ssize_t nret;
+    ssize_t total = 0;
+
+    if (eof == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+    *eof = false;
+
+    for (;;) {
+        nret = splice(fd_in, NULL, fd_out, NULL, SHIM_SPLICE_CHUNK, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (nret > 0) {
+            total += nret;
+            continue;
+        }
+        if (nret == 0) {
+            // no writer left on fd_in
+            *eof = true;
+            return total;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN) {
+            return -1;
+        }
+        // EAGAIN: either fd_in is drained or fd_out is full
+        if (pipe_is_empty(fd_in)) {
+            return total;
+        }
+        if (wait_fd_writable(fd_out) != SHIM_OK) {
+            return -1;
+        }
+    }
+}
@@ -17,6 +17,7 @@
 #define __COMMON_H_
 
 #include <stdbool.h>
+#include <sys/types.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -43,10 +44,15 @@ extern "C" {
 
 #define SHIM_BINARY "isulad-shim"
 #define SHIM_LOG_NAME "shim-log.json"
+// container state published for isulad, so it need not fork runtime state
+#define SHIM_STATE_NAME "shim-state.json"
 
 #define CONTAINER_ACTION_REBOOT 129
 #define CONTAINER_ACTION_SHUTDOWN 130
 
+// max bytes moved by one splice call, same as the default pipe capacity
+#define SHIM_SPLICE_CHUNK (64 * 1024)
+
 ssize_t read_nointr(int fd, void *buf, size_t count);
 ssize_t write_nointr(int fd, const void *buf, size_t count);
 
@@ -64,6 +70,17 @@ void close_fd(int *pfd);
 
 int open_no_inherit(const char *path, int flag, mode_t mode);
 
+int write_file_atomic(const char *path, const char *data, size_t len);
+
+bool fd_is_fifo(int fd);
+
+/*
+ * Move everything currently buffered in pipe fd_in to pipe fd_out in kernel,
+ * wait for fd_out when it is full. Return bytes moved, or -1 with errno set.
+ * eof is set when fd_in has no writer left.
+ */
+ssize_t splice_pipe_drain(int fd_in, int fd_out, bool *eof);
+
 #ifdef __cplusplus
 }
 #endif
@@ -21,6 +21,7 @@
 #include <sys/un.h>
 #include <sys/uio.h>
 #include <fcntl.h>
+#include <sys/file.h>
 #include <unistd.h>
 #include <limits.h>
 #include <sys/wait.h>
@@ -36,9 +37,12 @@
 #include "common.h"
 #include "process.h"
 #include "terminal.h"
+#include "shim_client_runtime_state.h"
 
 #define MAX_EVENTS 100
 #define DEFAULT_IO_COPY_BUF (16*1024)
+// read until pipe is drained or the batch buffer is full before dispatching
+#define IO_COPY_BATCH_BUF (64*1024)
 #define DEFAULT_LOG_FILE_SIZE (4*1024)
 
 extern int g_log_fd;
@@ -155,6 +159,7 @@ static int add_io_dispatch(int epfd, io_thread_t *io_thd, int from, int to)
     // add src fd
     if (from != -1 && ioc->fd_from == -1) {
         ioc->fd_from = from;
+        ioc->from_nonblock = (fcntl(from, F_GETFL) & O_NONBLOCK) != 0;
         struct epoll_event ev;
         ev.events = EPOLLIN;
         ev.data.ptr = io_thd;
@@ -228,6 +233,106 @@ static void remove_io_dispatch(io_thread_t *io_thd, int from, int to)
     pthread_mutex_unlock(&(ioc->mutex));
 }
 
+enum {
+    io_copy_ok = 0,
+    io_copy_eof,
+    io_copy_not_supported
+};
+
+// fifo to fifo without log transformation, data never enters user space
+static int io_copy_by_splice(io_thread_t *io_thd)
+{
+    io_copy_t *ioc = io_thd->ioc;
+    fd_node_t *fn = ioc->fd_to;
+    bool eof = false;
+    ssize_t n;
+
+    if (io_thd->splice_mode == splice_off || fn == NULL || fn->next != NULL || fn->is_log) {
+        return io_copy_not_supported;
+    }
+
+    if (io_thd->splice_mode == splice_unknown) {
+        io_thd->splice_mode = (fd_is_fifo(ioc->fd_from) && fd_is_fifo(fn->fd)) ? splice_on : splice_off;
+        if (io_thd->splice_mode == splice_off) {
+            return io_copy_not_supported;
+        }
+    }
+
+    n = splice_pipe_drain(ioc->fd_from, fn->fd, &eof);
+    if (n < 0) {
+        if (errno == EINVAL) {
+            io_thd->splice_mode = splice_off;
+        } else {
+            // remove the write fd, left data will be drained by read
+            remove_io_dispatch(io_thd, -1, fn->fd);
+        }
+        return io_copy_not_supported;
+    }
+
+    return eof ? io_copy_eof : io_copy_ok;
+}
+
+// read as much as possible into buf, stop when the pipe is drained or buf is full.
+// A blocking fd is read only once, the next read would block until more data comes
+static ssize_t read_batch(int fd, bool nonblock, char *buf, size_t size, bool *eof)
+{
+    size_t total = 0;
+    ssize_t r_count;
+
+    *eof = false;
+    while (total < size) {
+        r_count = read(fd, buf + total, size - total);
+        if (r_count > 0) {
+            total += (size_t)r_count;
+            if (!nonblock) {
+                break;
+            }
+            continue;
+        }
+        if (r_count == 0) {
+            // End of file. The remote has closed the connection.
+            *eof = true;
+            break;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        // If errno == EAGAIN, that means we have read all data
+        if (errno != EAGAIN) {
+            *eof = true;
+        }
+        break;
+    }
+
+    return (ssize_t)total;
+}
+
+static void io_copy_dispatch(io_thread_t *io_thd, char *buf, size_t len)
+{
+    io_copy_t *ioc = io_thd->ioc;
+    fd_node_t *fn = ioc->fd_to;
+    fd_node_t *next = NULL;
+    size_t off;
+    size_t chunk;
+
+    for (; fn != NULL; fn = next) {
+        next = fn->next;
+        if (fn->is_log) {
+            // log writer caches at most DEFAULT_IO_COPY_BUF bytes for one call
+            for (off = 0; off < len; off += chunk) {
+                chunk = len - off > DEFAULT_IO_COPY_BUF ? DEFAULT_IO_COPY_BUF : len - off;
+                shim_write_container_log_file(io_thd->terminal, ioc->id == stdid_out ? "stdout" : "stderr",
+                                              buf + off, (int)chunk);
+            }
+        } else {
+            if (write_nointr(fn->fd, buf, len) < 0) {
+                // remove the write fd
+                remove_io_dispatch(io_thd, -1, fn->fd);
+            }
+        }
+    }
+}
+
 static void* task_io_copy(void *data)
 {
     io_thread_t *io_thd = (io_thread_t*)data;
@@ -235,42 +340,32 @@ static void* task_io_copy(void *data)
         return NULL;
     }
     io_copy_t *ioc = io_thd->ioc;
-    char *buf = calloc(1, DEFAULT_IO_COPY_BUF + 1);
+    char *buf = calloc(1, IO_COPY_BATCH_BUF + 1);
     if (buf == NULL) {
         _exit(EXIT_FAILURE);
     }
 
     for (;;) {
-        memset(buf, 0, DEFAULT_IO_COPY_BUF);
         sem_wait(&(io_thd->sem_thd));
         if (io_thd->shutdown) {
             break;
         }
 
-        int r_count = read(ioc->fd_from, buf, DEFAULT_IO_COPY_BUF);
-        if (r_count == -1) {
-            // If errno == EAGAIN, that means we have read all data
-            if (errno == EAGAIN || errno == EINTR) {
-                continue;
-            }
+        int ret = io_copy_by_splice(io_thd);
+        if (ret == io_copy_eof) {
             break;
-        } else if (r_count == 0) {
-            // End of file. The remote has closed the connection.
+        }
+        if (ret == io_copy_ok) {
+            continue;
+        }
+
+        bool eof = false;
+        ssize_t r_count = read_batch(ioc->fd_from, ioc->from_nonblock, buf, IO_COPY_BATCH_BUF, &eof);
+        if (r_count > 0) {
+            io_copy_dispatch(io_thd, buf, (size_t)r_count);
+        }
+        if (eof) {
             break;
-        } else {
-            fd_node_t *fn = ioc->fd_to;
-            for (; fn != NULL; fn = fn->next) {
-                if (fn->is_log) {
-                    shim_write_container_log_file(io_thd->terminal, ioc->id == stdid_out ? "stdout" : "stderr", buf, r_count);
-                } else {
-                    int w_count = 0;
-                    w_count = write_nointr(fn->fd, buf, r_count);
-                    if (w_count < 0) {
-                        // remove the write fd
-                        remove_io_dispatch(io_thd, -1, fn->fd);
-                    }
-                }
-            }
         }
     }
     struct epoll_event ev;
@@ -714,6 +809,7 @@ static int terminal_init(log_terminal **terminal, shim_client_process_state *p_s
     log_term->log_path = p_state->log_path;
     /* Default to disable log. */
     log_term->fd = -1;
+    log_term->index_fd = -1;
     log_term->log_maxfile = 1;
     /* Default value 4k, the min size of a single log file */
     log_term->log_maxsize = DEFAULT_LOG_FILE_SIZE;
@@ -934,6 +1030,46 @@ static void process_delete(process_t *p)
     return;
 }
 
+static void publish_runtime_state(process_t *p, const char *status, int exit_code)
+{
+    shim_client_runtime_state state = { 0 };
+    struct parser_context ctx = { OPT_GEN_SIMPLIFY, 0 };
+    parser_error err = NULL;
+    char *json = NULL;
+    int lock_fd = -1;
+
+    if (p->state->exec) {
+        return;
+    }
+
+    state.status = (char *)status;
+    state.pid = p->ctr_pid;
+    state.exit_code = exit_code;
+
+    json = shim_client_runtime_state_generate_json(&state, &ctx, &err);
+    if (json == NULL) {
+        write_message(g_log_fd, WARN_MSG, "generate runtime state failed:%s", err);
+        goto out;
+    }
+
+    // isulad updates the state under lock of workdir too, so it never sees a stale stopped state
+    lock_fd = open_no_inherit(".", O_RDONLY | O_DIRECTORY, 0);
+    if (lock_fd < 0 || flock(lock_fd, LOCK_EX) != 0) {
+        write_message(g_log_fd, WARN_MSG, "lock workdir failed:%d", SHIM_SYS_ERR(errno));
+    }
+
+    if (write_file_atomic(SHIM_STATE_NAME, json, strlen(json)) != SHIM_OK) {
+        write_message(g_log_fd, WARN_MSG, "write runtime state failed:%d", SHIM_SYS_ERR(errno));
+    }
+
+out:
+    if (lock_fd >= 0) {
+        close(lock_fd);
+    }
+    free(json);
+    free(err);
+}
+
 int create_process(process_t *p)
 {
     int ret = -1;
@@ -1036,6 +1172,7 @@ int create_process(process_t *p)
     }
 
     p->ctr_pid = ctr_pid;
+    publish_runtime_state(p, "created", 0);
     adapt_for_isulad_stdin(p);
     ret = SHIM_OK;
 
@@ -1076,6 +1213,7 @@ int process_signal_handle_routine(process_t *p)
             continue;
         }
         if (exit_shim) {
+            publish_runtime_state(p, "stopped", status);
             process_kill_all(p);
             process_delete(p);
             if (p->exit_fd > 0) {
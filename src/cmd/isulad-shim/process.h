@@ -46,11 +46,19 @@ typedef struct fd_node {
 
 typedef struct {
     int fd_from;
+    // blocking fd_from, such as pty master, can only be read once per event
+    bool from_nonblock;
     fd_node_t *fd_to;
     int id;// 0,1,2
     pthread_mutex_t mutex;
 } io_copy_t;
 
+enum {
+    splice_unknown = 0,
+    splice_on,
+    splice_off
+};
+
 typedef struct {
     int epfd;
     pthread_t tid;
@@ -59,6 +67,8 @@ typedef struct {
     io_copy_t *ioc;
     bool shutdown;
     log_terminal *terminal;
+    // whether fifo to fifo copy can be done by splice
+    int splice_mode;
 } io_thread_t;
 
 typedef struct process {
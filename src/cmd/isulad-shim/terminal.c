@@ -18,20 +18,43 @@
 #include <sys/stat.h>
 #include <linux/limits.h>
 #include <limits.h>
+#include <sys/uio.h>
 #include "terminal.h"
 #include "common.h"
+#include "log_index.h"
 
-#define BUF_CACHE_SIZE (16 * 1024)
+#define LOG_PREFIX "{\"log\":\""
+#define LOG_PREFIX_LEN (sizeof(LOG_PREFIX) - 1)
+/* worst case of escaping one byte is \u00XX */
+#define LOG_ESCAPE_MAX 6
 
-static ssize_t shim_write_nointr_lock(log_terminal *terminal, const void *buf, size_t count)
+/* rename log file and its index together, the index may not exist */
+static int shim_rename_log_file_with_index(const char *from, const char *to)
 {
-    ssize_t ret;
+    int ret;
+    char from_index[PATH_MAX] = { 0 };
+    char to_index[PATH_MAX] = { 0 };
 
-    (void)pthread_rwlock_wrlock(&terminal->log_terminal_rwlock);
-    ret = write_nointr(terminal->fd, buf, count);
-    (void)pthread_rwlock_unlock(&terminal->log_terminal_rwlock);
+    ret = rename(from, to);
+    if (ret < 0 && errno != ENOENT) {
+        return SHIM_ERR;
+    }
 
-    return ret;
+    ret = snprintf(from_index, PATH_MAX, "%s%s", from, LOG_INDEX_SUFFIX);
+    if (ret < 0 || ret >= PATH_MAX) {
+        return SHIM_ERR;
+    }
+    ret = snprintf(to_index, PATH_MAX, "%s%s", to, LOG_INDEX_SUFFIX);
+    if (ret < 0 || ret >= PATH_MAX) {
+        return SHIM_ERR;
+    }
+    ret = rename(from_index, to_index);
+    if (ret < 0 && errno == ENOENT) {
+        /* do not leave a stale index beside the rotated log */
+        (void)unlink(to_index);
+    }
+
+    return SHIM_OK;
 }
 
 static int shim_rename_old_log_file(log_terminal *terminal)
@@ -56,8 +79,8 @@ static int shim_rename_old_log_file(log_terminal *terminal)
             return SHIM_ERR;
         }
 
-        ret = rename(tmp, rename_fname);
-        if (ret < 0 && errno != ENOENT) {
+        ret = shim_rename_log_file_with_index(tmp, rename_fname);
+        if (ret != SHIM_OK) {
             free(rename_fname);
             return SHIM_ERR;
         }
@@ -101,7 +124,11 @@ static int shim_dump_log_file(log_terminal *terminal)
      */
     close(terminal->fd);
     terminal->fd = -1;
-    (void)rename(terminal->log_path, file_newname);
+    if (terminal->index_fd >= 0) {
+        close(terminal->index_fd);
+        terminal->index_fd = -1;
+    }
+    (void)shim_rename_log_file_with_index(terminal->log_path, file_newname);
     ret = shim_create_container_log_file(terminal);
 clean_out:
     free(file_newname);
@@ -125,42 +152,6 @@ static int64_t get_log_file_size(int fd)
     return log_st.st_size;
 }
 
-static int shim_json_data_write(log_terminal *terminal, const char *buf,
-                                int read_count)
-{
-    int ret;
-    int64_t available_space = -1;
-    int64_t file_size;
-
-    file_size = get_log_file_size(terminal->fd);
-    if (file_size < 0) {
-        return SHIM_ERR;
-    }
-
-    available_space = terminal->log_maxsize - file_size;
-    if (read_count <= available_space) {
-        return shim_write_nointr_lock(terminal, buf, read_count);
-    }
-
-    ret = shim_dump_log_file(terminal);
-    if (ret < 0) {
-        return SHIM_ERR;
-    }
-
-    /*
-     * Now file is new, then write the max bytes that will be wrote to log file.
-     * We have set the log file min size 16k, so the scenario of log_maxsize < read_count
-     * shouldn't happen, otherwise, discard some last bytes.
-     */
-    ret = shim_write_nointr_lock(terminal, buf,
-                                 terminal->log_maxsize < read_count ? terminal->log_maxsize : read_count);
-    if (ret < 0) {
-        return SHIM_ERR;
-    }
-
-    return (read_count - ret);
-}
-
 static bool get_time_buffer(struct timespec *timestamp, char *timebuffer,
                             size_t maxsize)
 {
@@ -188,7 +179,7 @@ static bool get_time_buffer(struct timespec *timestamp, char *timebuffer,
     return true;
 }
 
-static bool get_now_time_buffer(char *timebuffer, size_t maxsize)
+static bool get_now_time_buffer(char *timebuffer, size_t maxsize, int64_t *now_ns)
 {
     int err = 0;
     struct timespec ts;
@@ -197,63 +188,272 @@ static bool get_now_time_buffer(char *timebuffer, size_t maxsize)
     if (err != 0) {
         return false;
     }
+    *now_ns = (int64_t)ts.tv_sec * 1000000000LL + (int64_t)ts.tv_nsec;
 
     return get_time_buffer(&ts, timebuffer, maxsize);
 }
 
-static ssize_t shim_logger_write(log_terminal *terminal, const char *type, const char *buf,
-                                 int read_count)
+/* write all iovecs, the array is modified on partial write */
+static ssize_t shim_writev_all(int fd, struct iovec *iov, int iovcnt)
 {
-    logger_json_file *msg = NULL;
-    ssize_t ret = -1;
-    size_t len;
-    char *json = NULL;
-    char timebuffer[64] = { 0 };
-    parser_error err = NULL;
-    struct parser_context ctx = { OPT_GEN_SIMPLIFY | OPT_GEN_NO_VALIDATE_UTF8, stderr };
+    ssize_t nret;
+    ssize_t total = 0;
+
+    while (iovcnt > 0) {
+        nret = writev(fd, iov, iovcnt);
+        if (nret < 0) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            return -1;
+        }
+        total += nret;
+        while (iovcnt > 0 && (size_t)nret >= iov->iov_len) {
+            nret -= (ssize_t)iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + nret;
+            iov->iov_len -= (size_t)nret;
+        }
+    }
 
-    if (read_count < 0 || read_count >= INT_MAX) {
-        return SHIM_ERR;
+    return total;
+}
+
+/*
+ * notes: this funciton must be called with log_terminal_rwlock.
+ * Index entries are hints for readers, so failures are ignored.
+ */
+static void shim_log_index_add(log_terminal *terminal, const log_stream_encoder *enc)
+{
+    log_index_entry entry;
+    ssize_t nret;
+
+    if (terminal->index_fd < 0 || terminal->log_size < terminal->index_next || enc->time_ns == 0) {
+        return;
     }
 
-    msg = calloc(sizeof(logger_json_file), 1);
-    if (msg == NULL) {
-        return SHIM_ERR;
+    entry.timestamp = enc->time_ns;
+    entry.offset = (uint64_t)terminal->log_size;
+    nret = write(terminal->index_fd, &entry, sizeof(entry));
+    if (nret != (ssize_t)sizeof(entry)) {
+        /* a torn entry would shift all later ones, stop indexing this file */
+        close(terminal->index_fd);
+        terminal->index_fd = -1;
+        return;
+    }
+    terminal->index_next = terminal->log_size + LOG_INDEX_INTERVAL;
+}
+
+/* notes: this funciton must be called with log_terminal_rwlock */
+static int shim_writev_lines(log_terminal *terminal, const log_stream_encoder *enc, size_t first, size_t last)
+{
+    struct iovec iov[LOG_BATCH_MAX_LINES * 2];
+    int iovcnt = 0;
+    size_t i;
+    size_t end;
+    ssize_t nret;
+
+    if (first >= last) {
+        return SHIM_OK;
     }
 
-    msg->log = calloc(read_count, 1);
-    if (!msg->log) {
-        goto cleanup;
+    for (i = first; i < last; i++) {
+        end = (i + 1 < enc->lines) ? enc->line_offs[i + 1] : enc->buf_len;
+        iov[iovcnt].iov_base = enc->buf + enc->line_offs[i];
+        iov[iovcnt].iov_len = end - enc->line_offs[i];
+        iovcnt++;
+        iov[iovcnt].iov_base = (void *)enc->suffix;
+        iov[iovcnt].iov_len = enc->suffix_len;
+        iovcnt++;
     }
-    memcpy(msg->log, buf, read_count);
-    msg->log_len = read_count;
-    msg->stream = type ? safe_strdup(type) : safe_strdup("stdout");
 
-    get_now_time_buffer(timebuffer, sizeof(timebuffer));
-    msg->time = safe_strdup(timebuffer);
-    json = logger_json_file_generate_json(msg, &ctx, &err);
-    if (!json) {
-        goto cleanup;
+    /* log_size is at the start of a line here */
+    shim_log_index_add(terminal, enc);
+    nret = shim_writev_all(terminal->fd, iov, iovcnt);
+    if (nret < 0) {
+        return SHIM_ERR;
     }
-    len = strlen(json);
-    json[len] = '\n';
+    terminal->log_size += nret;
+
+    return SHIM_OK;
+}
+
+/* write encoded lines of the batch, rotate the log file when the next line does not fit */
+static int shim_log_batch_flush(log_terminal *terminal, log_stream_encoder *enc)
+{
+    int ret = SHIM_OK;
+    size_t i;
+    size_t first = 0;
+    size_t line_len;
+    int64_t pending = 0;
+
+    if (enc->lines == 0) {
+        return SHIM_OK;
+    }
+
+    (void)pthread_rwlock_wrlock(&terminal->log_terminal_rwlock);
     if (terminal->fd < 0) {
-        goto cleanup;
+        ret = SHIM_ERR;
+        goto out;
     }
 
-    ret = shim_json_data_write(terminal, json, len + 1);
-cleanup:
-    free(json);
-    free_logger_json_file(msg);
-    free(err);
+    for (i = 0; i < enc->lines; i++) {
+        line_len = ((i + 1 < enc->lines) ? enc->line_offs[i + 1] : enc->buf_len) - enc->line_offs[i] + enc->suffix_len;
+        if (terminal->log_size + pending + (int64_t)line_len <= (int64_t)terminal->log_maxsize) {
+            pending += (int64_t)line_len;
+            continue;
+        }
+
+        ret = shim_writev_lines(terminal, enc, first, i);
+        if (ret != SHIM_OK) {
+            goto out;
+        }
+        first = i;
+        pending = (int64_t)line_len;
+
+        /* a line larger than log_maxsize is kept whole in a file of its own */
+        if (terminal->log_size == 0) {
+            continue;
+        }
+        ret = shim_dump_log_file(terminal);
+        if (ret != SHIM_OK) {
+            goto out;
+        }
+    }
+
+    ret = shim_writev_lines(terminal, enc, first, enc->lines);
+
+out:
+    (void)pthread_rwlock_unlock(&terminal->log_terminal_rwlock);
+    enc->buf_len = 0;
+    enc->lines = 0;
     return ret;
 }
 
+static int shim_log_buf_reserve(log_stream_encoder *enc, size_t need)
+{
+    size_t cap;
+    char *tmp = NULL;
+
+    if (enc->buf_cap - enc->buf_len >= need) {
+        return SHIM_OK;
+    }
+
+    cap = enc->buf_cap != 0 ? enc->buf_cap : BUF_CACHE_SIZE;
+    while (cap - enc->buf_len < need) {
+        cap *= 2;
+    }
+    tmp = realloc(enc->buf, cap);
+    if (tmp == NULL) {
+        return SHIM_ERR;
+    }
+    enc->buf = tmp;
+    enc->buf_cap = cap;
+
+    return SHIM_OK;
+}
+
+/* same escaping as yajl_gen_string without utf8 validation */
+static size_t shim_json_escape(char *out, const char *buf, size_t len)
+{
+    static const char hex[] = "0123456789abcdef";
+    char *p = out;
+    size_t i;
+    unsigned char c;
+
+    for (i = 0; i < len; i++) {
+        c = (unsigned char)buf[i];
+        switch (c) {
+            case '"':
+                *p++ = '\\';
+                *p++ = '"';
+                break;
+            case '\\':
+                *p++ = '\\';
+                *p++ = '\\';
+                break;
+            case '\b':
+                *p++ = '\\';
+                *p++ = 'b';
+                break;
+            case '\f':
+                *p++ = '\\';
+                *p++ = 'f';
+                break;
+            case '\n':
+                *p++ = '\\';
+                *p++ = 'n';
+                break;
+            case '\r':
+                *p++ = '\\';
+                *p++ = 'r';
+                break;
+            case '\t':
+                *p++ = '\\';
+                *p++ = 't';
+                break;
+            default:
+                if (c < 0x20) {
+                    *p++ = '\\';
+                    *p++ = 'u';
+                    *p++ = '0';
+                    *p++ = '0';
+                    *p++ = hex[c >> 4];
+                    *p++ = hex[c & 0xf];
+                } else {
+                    *p++ = (char)c;
+                }
+                break;
+        }
+    }
+
+    return (size_t)(p - out);
+}
+
+/* encode one log line into the batch, the common suffix is added when writing */
+static void shim_log_batch_add(log_terminal *terminal, log_stream_encoder *enc, const char *buf, int read_count)
+{
+    if (read_count <= 0 || terminal->fd < 0) {
+        return;
+    }
+
+    if (enc->lines == LOG_BATCH_MAX_LINES) {
+        (void)shim_log_batch_flush(terminal, enc);
+    }
+
+    if (shim_log_buf_reserve(enc, LOG_PREFIX_LEN + (size_t)read_count * LOG_ESCAPE_MAX) != SHIM_OK) {
+        return;
+    }
+
+    enc->line_offs[enc->lines] = enc->buf_len;
+    (void)memcpy(enc->buf + enc->buf_len, LOG_PREFIX, LOG_PREFIX_LEN);
+    enc->buf_len += LOG_PREFIX_LEN;
+    enc->buf_len += shim_json_escape(enc->buf + enc->buf_len, buf, (size_t)read_count);
+    enc->lines++;
+}
+
+static void shim_log_batch_begin(log_stream_encoder *enc, const char *type)
+{
+    char timebuffer[64] = { 0 };
+    int nret;
+
+    enc->time_ns = 0;
+    (void)get_now_time_buffer(timebuffer, sizeof(timebuffer), &enc->time_ns);
+    nret = snprintf(enc->suffix, sizeof(enc->suffix), "\",\"stream\":\"%s\",\"time\":\"%s\"}\n", type, timebuffer);
+    if (nret < 0 || (size_t)nret >= sizeof(enc->suffix)) {
+        nret = snprintf(enc->suffix, sizeof(enc->suffix), "\",\"stream\":\"%s\"}\n", type);
+        enc->time_ns = 0;
+    }
+    enc->suffix_len = nret > 0 ? (size_t)nret : 0;
+}
+
 void shim_write_container_log_file(log_terminal *terminal, const char *type, char *buf,
                                    int read_count)
 {
-    static char cache[BUF_CACHE_SIZE];
-    static int size = 0;
+    log_stream_encoder *enc = NULL;
     int upto, index;
     int begin = 0, buf_readed = 0,  buf_left = 0;
 
@@ -261,51 +461,79 @@ void shim_write_container_log_file(log_terminal *terminal, const char *type, cha
         return;
     }
 
+    if (type == NULL) {
+        type = "stdout";
+    }
+    enc = &terminal->encoders[strcmp(type, "stderr") == 0 ? 1 : 0];
+    shim_log_batch_begin(enc, type);
+
     if (buf != NULL && read_count > 0) {
-        upto = size + read_count;
+        upto = enc->size + read_count;
         if (upto > BUF_CACHE_SIZE) {
             upto = BUF_CACHE_SIZE;
         }
 
-        if (upto > size) {
-            buf_readed = upto - size;
-            memcpy(cache + size, buf, buf_readed);
+        if (upto > enc->size) {
+            buf_readed = upto - enc->size;
+            memcpy(enc->cache + enc->size, buf, buf_readed);
             buf_left = read_count - buf_readed;
-            size += buf_readed;
+            enc->size += buf_readed;
         }
     }
 
-    if (size == 0) {
+    if (enc->size == 0) {
         return;
     }
 
-    for (index = 0; index < size; index++) {
-        if (cache[index] == '\n') {
-            (void)shim_logger_write(terminal, type, cache + begin, index - begin + 1);
+    for (index = 0; index < enc->size; index++) {
+        if (enc->cache[index] == '\n') {
+            shim_log_batch_add(terminal, enc, enc->cache + begin, index - begin + 1);
             begin = index + 1;
         }
     }
 
-    if (buf == NULL || (begin == 0 && size == BUF_CACHE_SIZE)) {
-        if (begin < size) {
-            (void)shim_logger_write(terminal, type, cache + begin, size - begin);
+    if (buf == NULL || (begin == 0 && enc->size == BUF_CACHE_SIZE)) {
+        if (begin < enc->size) {
+            shim_log_batch_add(terminal, enc, enc->cache + begin, enc->size - begin);
             begin = 0;
-            size = 0;
+            enc->size = 0;
         }
         if (buf == NULL) {
-            return;
+            goto flush;
         }
     }
 
     if (begin > 0) {
-        memcpy(cache, cache + begin, size - begin);
-        size -= begin;
+        memmove(enc->cache, enc->cache + begin, enc->size - begin);
+        enc->size -= begin;
     }
 
     if (buf_left > 0) {
-        memcpy(cache + size, buf + buf_readed, buf_left);
-        size += buf_left;
+        memcpy(enc->cache + enc->size, buf + buf_readed, buf_left);
+        enc->size += buf_left;
     }
+
+flush:
+    (void)shim_log_batch_flush(terminal, enc);
+}
+
+static void shim_open_log_index_file(log_terminal *terminal)
+{
+    int ret;
+    int flags = O_CLOEXEC | O_WRONLY | O_CREAT | O_APPEND;
+    char index_path[PATH_MAX] = { 0 };
+
+    ret = snprintf(index_path, PATH_MAX, "%s%s", terminal->log_path, LOG_INDEX_SUFFIX);
+    if (ret < 0 || ret >= PATH_MAX) {
+        return;
+    }
+
+    /* entries of an index left by a removed log file are meaningless */
+    if (terminal->log_size == 0) {
+        flags |= O_TRUNC;
+    }
+    terminal->index_fd = open(index_path, flags, 0600);
+    terminal->index_next = terminal->log_size;
 }
 
 int shim_create_container_log_file(log_terminal *terminal)
@@ -319,6 +547,14 @@ int shim_create_container_log_file(log_terminal *terminal)
         return SHIM_ERR;
     }
 
+    /* log file may be reopened by a restarted container, keep appending to it */
+    terminal->log_size = get_log_file_size(terminal->fd);
+    if (terminal->log_size < 0) {
+        terminal->log_size = 0;
+    }
+
+    /* index is optional, logs are written without it */
+    shim_open_log_index_file(terminal);
+
     return SHIM_OK;
 }
-
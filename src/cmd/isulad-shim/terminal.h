@@ -24,12 +24,42 @@
 extern "C" {
 #endif
 
+#define BUF_CACHE_SIZE (16 * 1024)
+#define LOG_BATCH_MAX_LINES 64
+#define LOG_SUFFIX_MAX 128
+
+/* per stream state of json log encoder, reused for every chunk */
+typedef struct {
+    /* bytes of the last incomplete line */
+    char cache[BUF_CACHE_SIZE];
+    int size;
+    /* encoded lines of current batch, without the common suffix */
+    char *buf;
+    size_t buf_len;
+    size_t buf_cap;
+    /* start of each encoded line in buf */
+    size_t line_offs[LOG_BATCH_MAX_LINES];
+    size_t lines;
+    /* ","stream":"stdout","time":"..."}\n shared by all lines of a batch */
+    char suffix[LOG_SUFFIX_MAX];
+    size_t suffix_len;
+    /* unix nanoseconds in suffix, recorded in log index */
+    int64_t time_ns;
+} log_stream_encoder;
+
 typedef struct {
     uint64_t log_maxsize;
     char *log_path;
     int fd;
     unsigned int log_maxfile;
     pthread_rwlock_t log_terminal_rwlock;
+    /* size of current log file, tracked in memory instead of fstat before each write */
+    int64_t log_size;
+    /* sparse time index of current log file, see log_index.h */
+    int index_fd;
+    /* log_size from which the next index entry is added */
+    int64_t index_next;
+    log_stream_encoder encoders[2];
 } log_terminal;
 
 void shim_write_container_log_file(log_terminal *terminal, const char *type, char *buf,
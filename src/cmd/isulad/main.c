@@ -56,6 +56,7 @@
 #include "restore.h"
 #include "supervisor.h"
 #include "containers_gc.h"
+#include "health_check.h"
 #include "plugin.h"
 #include "selinux_label.h"
 
@@ -1420,6 +1421,11 @@ static int start_daemon_threads(char **msg)
         goto out;
     }
 
+    if (new_health_check_scheduler()) {
+        *msg = "Create health check scheduler failed";
+        goto out;
+    }
+
     containers_restore();
 
     /* sync containers list with remote */
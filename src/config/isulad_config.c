@@ -1300,6 +1300,28 @@ out:
     return port;
 }
 
+/* conf get parallelism of garbage collector */
+int32_t conf_get_gc_parallelism()
+{
+    int32_t parallelism = 0;
+    struct service_arguments *conf = NULL;
+
+    if (isulad_server_conf_rdlock() != 0) {
+        return parallelism;
+    }
+
+    conf = conf_get_server_conf();
+    if (conf == NULL || conf->json_confs == NULL) {
+        goto out;
+    }
+
+    parallelism = conf->json_confs->gc_parallelism;
+
+out:
+    (void)isulad_server_conf_unlock();
+    return parallelism;
+}
+
 /* save args to conf */
 int save_args_to_conf(struct service_arguments *args)
 {
@@ -1718,6 +1740,19 @@ static int merge_authorization_conf_into_global(struct service_arguments *args,
     if (tmp_json_confs->authorization_plugin != NULL) {
         override_string_value(&args->json_confs->authorization_plugin, &tmp_json_confs->authorization_plugin);
     }
+    if (tmp_json_confs->authorization_cache_ttl != 0) {
+        args->json_confs->authorization_cache_ttl = tmp_json_confs->authorization_cache_ttl;
+    }
+    if (tmp_json_confs->authorization_cache_negative_ttl != 0) {
+        args->json_confs->authorization_cache_negative_ttl = tmp_json_confs->authorization_cache_negative_ttl;
+    }
+    if (string_array_append(tmp_json_confs->authorization_cache_actions,
+                            tmp_json_confs->authorization_cache_actions_len,
+                            &(args->json_confs->authorization_cache_actions_len),
+                            &(args->json_confs->authorization_cache_actions)) != 0) {
+        ERROR("merge authorization cache actions config failed");
+        return -1;
+    }
 
     return 0;
 }
@@ -1846,6 +1881,10 @@ int merge_json_confs_into_global(struct service_arguments *args)
         args->json_confs->websocket_server_listening_port = tmp_json_confs->websocket_server_listening_port;
     }
 
+    if (tmp_json_confs->gc_parallelism > 0) {
+        args->json_confs->gc_parallelism = tmp_json_confs->gc_parallelism;
+    }
+
     override_bool_pointer_value(&args->json_confs->use_decrypted_key, &tmp_json_confs->use_decrypted_key);
 
     if (tmp_json_confs->insecure_skip_verify_enforce) {
@@ -49,6 +49,7 @@ char *conf_get_isulad_log_file();
 char *conf_get_engine_log_file();
 char *conf_get_enable_plugins();
 int32_t conf_get_websocket_server_listening_port();
+int32_t conf_get_gc_parallelism();
 
 int save_args_to_conf(struct service_arguments *args);
 
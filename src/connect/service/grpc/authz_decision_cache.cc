@@ -0,0 +1,159 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-04-13
+ * Description: provide cache of authorization plugin decisions
+ ******************************************************************************/
+#include "authz_decision_cache.h"
+#include "log.h"
+
+namespace {
+const int64_t DefaultTtlSeconds { 5 };
+const int64_t DefaultNegativeTtlSeconds { 2 };
+// read only actions, which are called frequently by monitoring agents
+const char * const DefaultCacheableActions[] = {
+    "container_inspect", "container_list", "container_stats", "container_top",
+    "docker_info",       "docker_version", "image_inspect",   "image_list",
+};
+} // namespace
+
+AuthzDecisionCache *AuthzDecisionCache::GetInstance() noexcept
+{
+    static AuthzDecisionCache instance;
+    return &instance;
+}
+
+AuthzDecisionCache::AuthzDecisionCache()
+    : m_ttl(DefaultTtlSeconds), m_negativeTtl(DefaultNegativeTtlSeconds), m_stats { 0, 0, 0, 0 }
+{
+    for (auto action : DefaultCacheableActions) {
+        m_actions.insert(action);
+    }
+}
+
+void AuthzDecisionCache::Configure(int64_t ttlSeconds, int64_t negativeTtlSeconds,
+                                   const std::vector<std::string> &actions)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // 0 means not configured, keep the default
+    if (ttlSeconds != 0) {
+        m_ttl = std::chrono::seconds(ttlSeconds > 0 ? ttlSeconds : 0);
+    }
+    if (negativeTtlSeconds != 0) {
+        m_negativeTtl = std::chrono::seconds(negativeTtlSeconds > 0 ? negativeTtlSeconds : 0);
+    }
+    if (!actions.empty()) {
+        m_actions.clear();
+        m_actions.insert(actions.begin(), actions.end());
+    }
+    m_decisions.clear();
+    INFO("Authorization cache ttl: %lds, negative ttl: %lds, cacheable actions: %zu", (long)m_ttl.count(),
+         (long)m_negativeTtl.count(), m_actions.size());
+}
+
+bool AuthzDecisionCache::Cacheable(const std::string &action)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_ttl.count() > 0 || m_negativeTtl.count() > 0) {
+        if (m_actions.find(action) != m_actions.end()) {
+            return true;
+        }
+    }
+    m_stats.bypasses++;
+    return false;
+}
+
+std::string AuthzDecisionCache::Key(const std::string &user, const std::string &action)
+{
+    // user name may contain ':', so separate them by a byte not allowed in both
+    std::string key { user };
+    key.push_back('\0');
+    key.append(action);
+    return key;
+}
+
+bool AuthzDecisionCache::Lookup(const std::string &user, const std::string &action, bool &allowed,
+                                std::string &errmsg)
+{
+    bool found { false };
+    bool needLog { false };
+    Stats snapshot {};
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_decisions.find(Key(user, action));
+        if (it == m_decisions.end() || std::chrono::steady_clock::now() >= it->second.expireTime) {
+            m_stats.misses++;
+        } else {
+            found = true;
+            allowed = it->second.allowed;
+            if (allowed) {
+                m_stats.hits++;
+            } else {
+                errmsg = it->second.errmsg;
+                m_stats.negativeHits++;
+            }
+        }
+        if ((m_stats.hits + m_stats.negativeHits + m_stats.misses) % StatsLogInterval == 0) {
+            snapshot = m_stats;
+            needLog = true;
+        }
+    }
+
+    if (needLog) {
+        LogStats(snapshot);
+    }
+    return found;
+}
+
+void AuthzDecisionCache::LogStats(const Stats &stats)
+{
+    INFO("Authorization cache hits: %lu, negative hits: %lu, misses: %lu, bypasses: %lu",
+         (unsigned long)stats.hits, (unsigned long)stats.negativeHits, (unsigned long)stats.misses,
+         (unsigned long)stats.bypasses);
+}
+
+void AuthzDecisionCache::GarbageCollection(std::chrono::steady_clock::time_point now)
+{
+    for (auto it = m_decisions.begin(); it != m_decisions.end();) {
+        if (now >= it->second.expireTime) {
+            it = m_decisions.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void AuthzDecisionCache::Insert(const std::string &user, const std::string &action, bool allowed,
+                                const std::string &errmsg)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto ttl = allowed ? m_ttl : m_negativeTtl;
+    auto now = std::chrono::steady_clock::now();
+
+    if (ttl.count() <= 0) {
+        return;
+    }
+
+    if (m_decisions.size() >= MaxEntries) {
+        GarbageCollection(now);
+        if (m_decisions.size() >= MaxEntries) {
+            WARN("Too many authorization decisions cached, drop all of them");
+            m_decisions.clear();
+        }
+    }
+
+    Decision decision { allowed, allowed ? "" : errmsg, now + ttl };
+    m_decisions[Key(user, action)] = decision;
+}
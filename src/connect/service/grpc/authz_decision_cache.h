@@ -0,0 +1,71 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-04-13
+ * Description: provide cache of authorization plugin decisions
+ ******************************************************************************/
+
+#ifndef __AUTHZ_DECISION_CACHE_H_
+#define __AUTHZ_DECISION_CACHE_H_
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+
+// Decisions of authz plugin keyed by (user, action). Allowed and denied
+// decisions have their own ttl, a ttl not greater than 0 disables caching them.
+// Failures to reach the plugin are never cached.
+class AuthzDecisionCache {
+public:
+    static AuthzDecisionCache *GetInstance() noexcept;
+    void Configure(int64_t ttlSeconds, int64_t negativeTtlSeconds, const std::vector<std::string> &actions);
+    bool Cacheable(const std::string &action);
+    // return true if a decision is found, errmsg is set for denied decision
+    bool Lookup(const std::string &user, const std::string &action, bool &allowed, std::string &errmsg);
+    void Insert(const std::string &user, const std::string &action, bool allowed, const std::string &errmsg);
+
+private:
+    struct Stats {
+        uint64_t hits;
+        uint64_t negativeHits;
+        uint64_t misses;
+        // requests of actions which are not cacheable
+        uint64_t bypasses;
+    };
+    struct Decision {
+        bool allowed;
+        std::string errmsg;
+        std::chrono::steady_clock::time_point expireTime;
+    };
+
+    AuthzDecisionCache();
+    AuthzDecisionCache(const AuthzDecisionCache &) = delete;
+    AuthzDecisionCache &operator=(const AuthzDecisionCache &) = delete;
+    virtual ~AuthzDecisionCache() = default;
+    static std::string Key(const std::string &user, const std::string &action);
+    void GarbageCollection(std::chrono::steady_clock::time_point now);
+    static void LogStats(const Stats &stats);
+
+    std::mutex m_mutex;
+    std::unordered_map<std::string, Decision> m_decisions;
+    std::unordered_set<std::string> m_actions;
+    std::chrono::seconds m_ttl;
+    std::chrono::seconds m_negativeTtl;
+    Stats m_stats;
+    const size_t MaxEntries { 4096 };
+    // counters are logged every StatsLogInterval lookups
+    const uint64_t StatsLogInterval { 1000 };
+};
+
+#endif /* __AUTHZ_DECISION_CACHE_H_ */
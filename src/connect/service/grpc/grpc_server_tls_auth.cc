@@ -17,6 +17,7 @@
 #include <map>
 #include <stdlib.h>
 #include "http.h"
+#include "authz_decision_cache.h"
 
 namespace AuthorizationPluginConfig {
 std::string auth_plugin = "";
@@ -42,15 +43,25 @@ Status auth(ServerContext *context, std::string action)
             return Status(StatusCode::UNKNOWN, "unkown error");
         }
         std::string username = std::string(username_kv->second.data(), username_kv->second.length());
+        AuthzDecisionCache *cache = AuthzDecisionCache::GetInstance();
+        bool cacheable = cache->Cacheable(action);
+        bool allowed = false;
+        std::string cachedErr;
+        if (cacheable && cache->Lookup(username, action, allowed, cachedErr)) {
+            if (!allowed) {
+                return Status(StatusCode::PERMISSION_DENIED, cachedErr);
+            }
+            return Status::OK;
+        }
         char *errmsg = nullptr;
-        if (authz_http_request(username.c_str(), action.c_str(), &errmsg)) {
-            std::string err = errmsg;
-            free(errmsg);
+        int ret = authz_http_request(username.c_str(), action.c_str(), &errmsg);
+        std::string err = (errmsg != nullptr) ? errmsg : "";
+        free(errmsg);
+        if (cacheable && (ret == 0 || ret == AUTHZ_DENIED)) {
+            cache->Insert(username, action, ret == 0, err);
+        }
+        if (ret != 0) {
             return Status(StatusCode::PERMISSION_DENIED, err);
-        } else {
-            if (errmsg != nullptr) {
-                free(errmsg);
-            }
         }
     } else {
         return Status(StatusCode::UNIMPLEMENTED, "authorization plugin invalid");
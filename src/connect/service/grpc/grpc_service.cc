@@ -28,6 +28,7 @@
 #include "network_plugin.h"
 #include "errors.h"
 #include "grpc_server_tls_auth.h"
+#include "authz_decision_cache.h"
 
 using grpc::SslServerCredentialsOptions;
 
@@ -107,6 +108,13 @@ private:
         if (args->json_confs->tls) {
             if (args->json_confs->authorization_plugin != nullptr) {
                 AuthorizationPluginConfig::auth_plugin = args->json_confs->authorization_plugin;
+                std::vector<std::string> actions;
+                for (size_t i = 0; i < args->json_confs->authorization_cache_actions_len; i++) {
+                    actions.push_back(args->json_confs->authorization_cache_actions[i]);
+                }
+                AuthzDecisionCache::GetInstance()->Configure(args->json_confs->authorization_cache_ttl,
+                                                             args->json_confs->authorization_cache_negative_ttl,
+                                                             actions);
             }
 
             std::string key = ReadTextFile(args->json_confs->tls_config->key_file, err);
@@ -509,7 +509,6 @@ FILE *util_fopen(const char *filename, const char *mode)
 
 static char *util_file_digest(const char *filename)
 {
-    FILE *fp = NULL;
     char *digest = NULL;
 
     if (filename == NULL) {
@@ -517,21 +516,11 @@ static char *util_file_digest(const char *filename)
         return NULL;
     }
 
-    fp = util_fopen(filename, "r");
-    if (fp == NULL) {
-        ERROR("failed to open file %s: %s", filename, strerror(errno));
-        return NULL;
-    }
-
-    digest = sha256_digest(fp, false);
+    digest = sha256_digest_file(filename, false);
     if (digest == NULL) {
         ERROR("calc digest for file %s failed: %s", filename, strerror(errno));
-        goto err_out;
     }
 
-err_out:
-    fclose(fp);
-
     return digest;
 }
 
@@ -853,6 +842,65 @@ free_out:
     return ret;
 }
 
+/* write content into a temporary file and rename it to fname, so readers see either old or new content */
+int util_atomic_write_file(const char *fname, const char *content, size_t content_len, mode_t mode, bool sync)
+{
+    int ret = 0;
+    int nret = 0;
+    int dst_fd = -1;
+    ssize_t len = 0;
+    char tmp_fname[PATH_MAX] = { 0 };
+
+    if (fname == NULL || content == NULL) {
+        return -1;
+    }
+
+    nret = snprintf(tmp_fname, sizeof(tmp_fname), "%s.tmp.XXXXXX", fname);
+    if (nret < 0 || (size_t)nret >= sizeof(tmp_fname)) {
+        ERROR("Failed to sprintf tmp file name for %s", fname);
+        return -1;
+    }
+
+    // unique tmp file, so concurrent writers of the same file never truncate each other
+    dst_fd = mkostemp(tmp_fname, O_CLOEXEC);
+    if (dst_fd < 0) {
+        ERROR("Creat file: %s, failed: %s", tmp_fname, strerror(errno));
+        return -1;
+    }
+    if (fchmod(dst_fd, mode) != 0) {
+        ERROR("Chmod file %s failed: %s", tmp_fname, strerror(errno));
+        ret = -1;
+        goto free_out;
+    }
+    len = util_write_nointr(dst_fd, content, content_len);
+    if (len < 0 || ((size_t)len) != content_len) {
+        ERROR("Write file failed: %s", strerror(errno));
+        ret = -1;
+        goto free_out;
+    }
+    if (sync && fdatasync(dst_fd) != 0) {
+        ERROR("Sync file %s failed: %s", tmp_fname, strerror(errno));
+        ret = -1;
+        goto free_out;
+    }
+    close(dst_fd);
+    dst_fd = -1;
+
+    if (rename(tmp_fname, fname) != 0) {
+        ERROR("Rename %s to %s failed: %s", tmp_fname, fname, strerror(errno));
+        ret = -1;
+    }
+
+free_out:
+    if (dst_fd >= 0) {
+        close(dst_fd);
+    }
+    if (ret != 0) {
+        (void)unlink(tmp_fname);
+    }
+    return ret;
+}
+
 char *verify_file_and_get_real_path(const char *file)
 {
 #define MAX_FILE_SIZE (10 * SIZE_MB)
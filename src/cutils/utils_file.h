@@ -71,6 +71,8 @@ char *look_path(const char *file, char **err);
 
 int util_write_file(const char *fname, const char *content, size_t content_len, mode_t mode);
 
+int util_atomic_write_file(const char *fname, const char *content, size_t content_len, mode_t mode, bool sync);
+
 char *verify_file_and_get_real_path(const char *file);
 
 int util_copy_file(const char *src_file, const char *dst_file, mode_t mode);
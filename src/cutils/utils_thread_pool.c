@@ -0,0 +1,292 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-03-20
+ * Description: provide bounded thread pool functions
+ ********************************************************************************/
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+
+#include "utils_thread_pool.h"
+#include "utils.h"
+#include "log.h"
+#include "linked_list.h"
+
+#define THREAD_POOL_NAME_LEN 16
+
+struct thread_pool_job {
+    thread_pool_job_cb_t cb;
+    void *arg;
+};
+
+struct _thread_pool_t {
+    char name[THREAD_POOL_NAME_LEN];
+    pthread_mutex_t mutex;
+    /* signaled when a job is queued or the pool is shutting down */
+    pthread_cond_t job_cond;
+    /* signaled when the pool becomes idle */
+    pthread_cond_t idle_cond;
+    struct linked_list jobs;
+    size_t pending;
+    size_t running;
+    uint64_t finished;
+    bool shutdown;
+    size_t workers;
+    pthread_t *tids;
+};
+
+size_t thread_pool_default_workers(size_t jobs, size_t max_workers)
+{
+    long cpus = 0;
+    size_t workers = 0;
+
+    cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus <= 0) {
+        cpus = 1;
+    }
+    workers = (size_t)cpus;
+
+    if (max_workers == 0 || max_workers > THREAD_POOL_MAX_WORKERS) {
+        max_workers = THREAD_POOL_MAX_WORKERS;
+    }
+    if (workers > max_workers) {
+        workers = max_workers;
+    }
+    if (jobs != 0 && workers > jobs) {
+        workers = jobs;
+    }
+    if (workers == 0) {
+        workers = 1;
+    }
+
+    return workers;
+}
+
+static struct linked_list *pop_job(thread_pool_t *pool)
+{
+    struct linked_list *node = NULL;
+
+    node = linked_list_first_node(&pool->jobs);
+    linked_list_del(node);
+    pool->pending--;
+
+    return node;
+}
+
+static void *thread_pool_worker(void *arg)
+{
+    thread_pool_t *pool = (thread_pool_t *)arg;
+    struct linked_list *node = NULL;
+    struct thread_pool_job *job = NULL;
+
+    (void)prctl(PR_SET_NAME, pool->name);
+
+    if (pthread_mutex_lock(&pool->mutex) != 0) {
+        ERROR("Failed to lock thread pool %s", pool->name);
+        return NULL;
+    }
+    for (;;) {
+        while (linked_list_empty(&pool->jobs) && !pool->shutdown) {
+            (void)pthread_cond_wait(&pool->job_cond, &pool->mutex);
+        }
+        if (linked_list_empty(&pool->jobs)) {
+            /* shutdown and nothing left to do */
+            break;
+        }
+
+        node = pop_job(pool);
+        pool->running++;
+        (void)pthread_mutex_unlock(&pool->mutex);
+
+        job = (struct thread_pool_job *)node->elem;
+        job->cb(job->arg);
+        free(job);
+        free(node);
+
+        (void)pthread_mutex_lock(&pool->mutex);
+        pool->running--;
+        pool->finished++;
+        if (pool->running == 0 && linked_list_empty(&pool->jobs)) {
+            (void)pthread_cond_broadcast(&pool->idle_cond);
+        }
+    }
+    (void)pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+static void thread_pool_destroy(thread_pool_t *pool)
+{
+    (void)pthread_mutex_destroy(&pool->mutex);
+    (void)pthread_cond_destroy(&pool->job_cond);
+    (void)pthread_cond_destroy(&pool->idle_cond);
+    free(pool->tids);
+    free(pool);
+}
+
+static void thread_pool_stop_workers(thread_pool_t *pool, size_t started)
+{
+    size_t i = 0;
+
+    (void)pthread_mutex_lock(&pool->mutex);
+    pool->shutdown = true;
+    (void)pthread_cond_broadcast(&pool->job_cond);
+    (void)pthread_mutex_unlock(&pool->mutex);
+
+    for (i = 0; i < started; i++) {
+        (void)pthread_join(pool->tids[i], NULL);
+    }
+}
+
+thread_pool_t *thread_pool_new(const char *name, size_t workers)
+{
+    size_t i = 0;
+    thread_pool_t *pool = NULL;
+
+    if (workers == 0 || workers > THREAD_POOL_MAX_WORKERS) {
+        ERROR("Invalid thread pool workers: %zu", workers);
+        return NULL;
+    }
+
+    pool = util_common_calloc_s(sizeof(thread_pool_t));
+    if (pool == NULL) {
+        ERROR("Out of memory");
+        return NULL;
+    }
+    pool->tids = util_smart_calloc_s(sizeof(pthread_t), workers);
+    if (pool->tids == NULL) {
+        ERROR("Out of memory");
+        free(pool);
+        return NULL;
+    }
+
+    (void)strncpy(pool->name, name != NULL ? name : "ThreadPool", THREAD_POOL_NAME_LEN - 1);
+    (void)pthread_mutex_init(&pool->mutex, NULL);
+    (void)pthread_cond_init(&pool->job_cond, NULL);
+    (void)pthread_cond_init(&pool->idle_cond, NULL);
+    linked_list_init(&pool->jobs);
+
+    for (i = 0; i < workers; i++) {
+        if (pthread_create(&pool->tids[i], NULL, thread_pool_worker, pool) != 0) {
+            ERROR("Failed to create worker %zu for thread pool %s", i, pool->name);
+            thread_pool_stop_workers(pool, i);
+            thread_pool_destroy(pool);
+            return NULL;
+        }
+    }
+    pool->workers = workers;
+
+    return pool;
+}
+
+int thread_pool_submit(thread_pool_t *pool, thread_pool_job_cb_t cb, void *arg)
+{
+    int ret = 0;
+    struct linked_list *node = NULL;
+    struct thread_pool_job *job = NULL;
+
+    if (pool == NULL || cb == NULL) {
+        return -1;
+    }
+
+    node = util_common_calloc_s(sizeof(struct linked_list));
+    job = util_common_calloc_s(sizeof(struct thread_pool_job));
+    if (node == NULL || job == NULL) {
+        ERROR("Out of memory");
+        ret = -1;
+        goto out;
+    }
+    job->cb = cb;
+    job->arg = arg;
+    linked_list_init(node);
+    linked_list_add_elem(node, job);
+
+    if (pthread_mutex_lock(&pool->mutex) != 0) {
+        ERROR("Failed to lock thread pool %s", pool->name);
+        ret = -1;
+        goto out;
+    }
+    if (pool->shutdown) {
+        (void)pthread_mutex_unlock(&pool->mutex);
+        ERROR("Thread pool %s is shutting down", pool->name);
+        ret = -1;
+        goto out;
+    }
+    linked_list_add_tail(&pool->jobs, node);
+    pool->pending++;
+    (void)pthread_cond_signal(&pool->job_cond);
+    (void)pthread_mutex_unlock(&pool->mutex);
+
+    return 0;
+
+out:
+    free(node);
+    free(job);
+    return ret;
+}
+
+void thread_pool_wait(thread_pool_t *pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+
+    (void)pthread_mutex_lock(&pool->mutex);
+    while (!linked_list_empty(&pool->jobs) || pool->running != 0) {
+        (void)pthread_cond_wait(&pool->idle_cond, &pool->mutex);
+    }
+    (void)pthread_mutex_unlock(&pool->mutex);
+}
+
+size_t thread_pool_pending(thread_pool_t *pool)
+{
+    size_t pending = 0;
+
+    if (pool == NULL) {
+        return 0;
+    }
+
+    (void)pthread_mutex_lock(&pool->mutex);
+    pending = pool->pending;
+    (void)pthread_mutex_unlock(&pool->mutex);
+
+    return pending;
+}
+
+uint64_t thread_pool_finished(thread_pool_t *pool)
+{
+    uint64_t finished = 0;
+
+    if (pool == NULL) {
+        return 0;
+    }
+
+    (void)pthread_mutex_lock(&pool->mutex);
+    finished = pool->finished;
+    (void)pthread_mutex_unlock(&pool->mutex);
+
+    return finished;
+}
+
+void thread_pool_free(thread_pool_t *pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+
+    thread_pool_stop_workers(pool, pool->workers);
+    thread_pool_destroy(pool);
+}
+
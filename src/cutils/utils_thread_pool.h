@@ -0,0 +1,57 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-03-20
+ * Description: provide bounded thread pool definition
+ ********************************************************************************/
+#ifndef __UTILS_THREAD_POOL_H
+#define __UTILS_THREAD_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define THREAD_POOL_MAX_WORKERS 64
+
+typedef void (*thread_pool_job_cb_t)(void *arg);
+
+typedef struct _thread_pool_t thread_pool_t;
+
+/* compute a default worker count bounded by online cpus, max_workers and jobs */
+size_t thread_pool_default_workers(size_t jobs, size_t max_workers);
+
+/* create a pool with fixed number of workers, workers will be started immediately */
+thread_pool_t *thread_pool_new(const char *name, size_t workers);
+
+/* queue a job, the job will be run by one of the workers */
+int thread_pool_submit(thread_pool_t *pool, thread_pool_job_cb_t cb, void *arg);
+
+/* block until all submitted jobs have finished */
+void thread_pool_wait(thread_pool_t *pool);
+
+/* number of jobs queued but not started */
+size_t thread_pool_pending(thread_pool_t *pool);
+
+/* number of jobs which have been finished since the pool was created */
+uint64_t thread_pool_finished(thread_pool_t *pool);
+
+/* run all queued jobs, stop workers and free the pool */
+void thread_pool_free(thread_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UTILS_THREAD_POOL_H */
+
@@ -0,0 +1,260 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-04-08
+ * Description: provide hierarchical timer wheel functions
+ ********************************************************************************/
+#include <stdlib.h>
+
+#include "utils_timer_wheel.h"
+#include "log.h"
+#include "utils.h"
+
+#define TIMER_WHEEL_LEVEL_MASK ((uint64_t)TIMER_WHEEL_LEVEL_SIZE - 1)
+#define TIMER_WHEEL_MAX_TICKS (((uint64_t)1 << (TIMER_WHEEL_LEVEL_BITS * TIMER_WHEEL_LEVELS)) - 1)
+
+static void list_init(timer_wheel_entry_t *head)
+{
+    head->prev = head;
+    head->next = head;
+}
+
+static void list_add_tail(timer_wheel_entry_t *head, timer_wheel_entry_t *entry)
+{
+    entry->prev = head->prev;
+    entry->next = head;
+    head->prev->next = entry;
+    head->prev = entry;
+}
+
+static void list_del(timer_wheel_entry_t *entry)
+{
+    entry->prev->next = entry->next;
+    entry->next->prev = entry->prev;
+    entry->prev = NULL;
+    entry->next = NULL;
+}
+
+/* move all entries of src to the empty list dst */
+static void list_splice(timer_wheel_entry_t *src, timer_wheel_entry_t *dst)
+{
+    if (src->next == src) {
+        return;
+    }
+    dst->next = src->next;
+    dst->prev = src->prev;
+    dst->next->prev = dst;
+    dst->prev->next = dst;
+    list_init(src);
+}
+
+timer_wheel_t *timer_wheel_new(uint64_t tick_ms, uint64_t now_ms)
+{
+    int i, j;
+    timer_wheel_t *wheel = NULL;
+
+    if (tick_ms == 0) {
+        ERROR("Invalid tick of timer wheel");
+        return NULL;
+    }
+
+    wheel = util_common_calloc_s(sizeof(timer_wheel_t));
+    if (wheel == NULL) {
+        ERROR("Out of memory");
+        return NULL;
+    }
+
+    for (i = 0; i < TIMER_WHEEL_LEVELS; i++) {
+        for (j = 0; j < TIMER_WHEEL_LEVEL_SIZE; j++) {
+            list_init(&wheel->slots[i][j]);
+        }
+    }
+    wheel->tick_ms = tick_ms;
+    wheel->current = now_ms / tick_ms;
+
+    return wheel;
+}
+
+/* entries still armed are owned by caller, they are just forgotten */
+void timer_wheel_free(timer_wheel_t *wheel)
+{
+    free(wheel);
+}
+
+void timer_wheel_entry_init(timer_wheel_entry_t *entry)
+{
+    if (entry == NULL) {
+        return;
+    }
+    entry->prev = NULL;
+    entry->next = NULL;
+    entry->expires = 0;
+}
+
+bool timer_wheel_entry_pending(const timer_wheel_entry_t *entry)
+{
+    return entry != NULL && entry->next != NULL;
+}
+
+static void internal_add(timer_wheel_t *wheel, timer_wheel_entry_t *entry)
+{
+    int level = 0;
+    uint64_t delta;
+    uint64_t expires = entry->expires;
+
+    if (expires < wheel->current) {
+        /* already expired, run it on next tick */
+        expires = wheel->current;
+    }
+    delta = expires - wheel->current;
+    if (delta > TIMER_WHEEL_MAX_TICKS) {
+        expires = wheel->current + TIMER_WHEEL_MAX_TICKS;
+        delta = TIMER_WHEEL_MAX_TICKS;
+    }
+    entry->expires = expires;
+
+    while (level < TIMER_WHEEL_LEVELS - 1 &&
+           delta >= ((uint64_t)1 << (TIMER_WHEEL_LEVEL_BITS * (level + 1)))) {
+        level++;
+    }
+
+    list_add_tail(&wheel->slots[level][(expires >> (TIMER_WHEEL_LEVEL_BITS * level)) & TIMER_WHEEL_LEVEL_MASK],
+                  entry);
+}
+
+void timer_wheel_add(timer_wheel_t *wheel, timer_wheel_entry_t *entry, uint64_t expires_ms)
+{
+    if (wheel == NULL || entry == NULL) {
+        return;
+    }
+
+    if (timer_wheel_entry_pending(entry)) {
+        timer_wheel_del(wheel, entry);
+    }
+
+    /* round up, a timer never fires before its expire time */
+    entry->expires = expires_ms / wheel->tick_ms + ((expires_ms % wheel->tick_ms) != 0 ? 1 : 0);
+    internal_add(wheel, entry);
+    wheel->size++;
+}
+
+void timer_wheel_del(timer_wheel_t *wheel, timer_wheel_entry_t *entry)
+{
+    if (wheel == NULL || !timer_wheel_entry_pending(entry)) {
+        return;
+    }
+
+    list_del(entry);
+    wheel->size--;
+}
+
+/* redistribute entries of one slot of upper level to lower levels, return slot index */
+static uint64_t cascade(timer_wheel_t *wheel, int level)
+{
+    uint64_t idx = (wheel->current >> (TIMER_WHEEL_LEVEL_BITS * level)) & TIMER_WHEEL_LEVEL_MASK;
+    timer_wheel_entry_t head;
+    timer_wheel_entry_t *entry = NULL;
+
+    list_init(&head);
+    list_splice(&wheel->slots[level][idx], &head);
+    while (head.next != &head) {
+        entry = head.next;
+        list_del(entry);
+        internal_add(wheel, entry);
+    }
+
+    return idx;
+}
+
+size_t timer_wheel_advance(timer_wheel_t *wheel, uint64_t now_ms, timer_wheel_expire_cb_t cb, void *arg)
+{
+    int level;
+    size_t expired = 0;
+    uint64_t target;
+    timer_wheel_entry_t head;
+    timer_wheel_entry_t *entry = NULL;
+
+    if (wheel == NULL) {
+        return 0;
+    }
+
+    target = now_ms / wheel->tick_ms;
+    while (wheel->current <= target) {
+        if (wheel->size == 0) {
+            /* nothing to cascade or run, jump directly */
+            wheel->current = target + 1;
+            break;
+        }
+
+        for (level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+            if (((wheel->current >> (TIMER_WHEEL_LEVEL_BITS * (level - 1))) & TIMER_WHEEL_LEVEL_MASK) != 0 ||
+                cascade(wheel, level) != 0) {
+                break;
+            }
+        }
+
+        list_init(&head);
+        list_splice(&wheel->slots[0][wheel->current & TIMER_WHEEL_LEVEL_MASK], &head);
+        wheel->current++;
+
+        while (head.next != &head) {
+            entry = head.next;
+            list_del(entry);
+            wheel->size--;
+            expired++;
+            if (cb != NULL) {
+                cb(entry, arg);
+            }
+        }
+    }
+
+    return expired;
+}
+
+size_t timer_wheel_size(const timer_wheel_t *wheel)
+{
+    if (wheel == NULL) {
+        return 0;
+    }
+
+    return wheel->size;
+}
+
+uint64_t timer_wheel_next_expiry(const timer_wheel_t *wheel)
+{
+    int level;
+    uint64_t k, idx;
+    uint64_t next = UINT64_MAX;
+    const timer_wheel_entry_t *head = NULL;
+    const timer_wheel_entry_t *entry = NULL;
+
+    if (wheel == NULL || wheel->size == 0) {
+        return UINT64_MAX;
+    }
+
+    for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        idx = (wheel->current >> (TIMER_WHEEL_LEVEL_BITS * level)) & TIMER_WHEEL_LEVEL_MASK;
+        /* slots after current one of a level are in expire order, the current one may hold wrapped timers */
+        for (k = 0; k < TIMER_WHEEL_LEVEL_SIZE; k++) {
+            head = &wheel->slots[level][(idx + k) & TIMER_WHEEL_LEVEL_MASK];
+            for (entry = head->next; entry != head; entry = entry->next) {
+                if (entry->expires < next) {
+                    next = entry->expires;
+                }
+            }
+            if (k > 0 && head->next != head) {
+                break;
+            }
+        }
+    }
+
+    return next * wheel->tick_ms;
+}
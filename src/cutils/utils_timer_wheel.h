@@ -0,0 +1,78 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-04-08
+ * Description: provide hierarchical timer wheel definition
+ ********************************************************************************/
+#ifndef __UTILS_TIMER_WHEEL_H
+#define __UTILS_TIMER_WHEEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TIMER_WHEEL_LEVEL_BITS 6
+#define TIMER_WHEEL_LEVEL_SIZE (1 << TIMER_WHEEL_LEVEL_BITS)
+#define TIMER_WHEEL_LEVELS 4
+
+/*
+ * Timers are embedded by the caller, so adding and deleting never allocate.
+ * The wheel is not thread safe, callers must serialize all operations on it.
+ */
+typedef struct timer_wheel_entry {
+    struct timer_wheel_entry *prev;
+    struct timer_wheel_entry *next;
+    uint64_t expires;
+} timer_wheel_entry_t;
+
+typedef void (*timer_wheel_expire_cb_t)(timer_wheel_entry_t *entry, void *arg);
+
+typedef struct timer_wheel {
+    uint64_t tick_ms;
+    /* next tick to be processed */
+    uint64_t current;
+    size_t size;
+    timer_wheel_entry_t slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_LEVEL_SIZE];
+} timer_wheel_t;
+
+timer_wheel_t *timer_wheel_new(uint64_t tick_ms, uint64_t now_ms);
+
+void timer_wheel_free(timer_wheel_t *wheel);
+
+void timer_wheel_entry_init(timer_wheel_entry_t *entry);
+
+bool timer_wheel_entry_pending(const timer_wheel_entry_t *entry);
+
+/* (re)arm entry to expire at expires_ms, timers in the past expire on next tick */
+void timer_wheel_add(timer_wheel_t *wheel, timer_wheel_entry_t *entry, uint64_t expires_ms);
+
+void timer_wheel_del(timer_wheel_t *wheel, timer_wheel_entry_t *entry);
+
+/*
+ * run all timers expired up to now_ms, return number of expired timers.
+ * Entry is disarmed before cb is called, so cb may add it again.
+ */
+size_t timer_wheel_advance(timer_wheel_t *wheel, uint64_t now_ms, timer_wheel_expire_cb_t cb, void *arg);
+
+size_t timer_wheel_size(const timer_wheel_t *wheel);
+
+/* time in ms at which the earliest timer expires, UINT64_MAX if no timer is armed */
+uint64_t timer_wheel_next_expiry(const timer_wheel_t *wheel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UTILS_TIMER_WHEEL_H */
@@ -17,6 +17,7 @@
 #include <string.h>
 
 #include "http.h"
+#include "http_pool.h"
 #include "buffer.h"
 #include "log.h"
 #include "utils.h"
@@ -349,11 +350,11 @@ int authz_http_request(const char *username, const char *action, char **resp)
 {
     char *request_body = NULL;
     char err_msg[AUTHZ_ERROR_MSG_SIZE] = { 0 };
-    long response_code = 0;
     int ret = 0;
     int nret = 0;
     size_t length = 0;
-    struct http_get_options *options = NULL;
+    struct http_pool_request request = { 0 };
+
     if (strlen(username) > ((SIZE_MAX - strlen(action)) - strlen(":")) - 1) {
         ERROR("Invalid arguments");
         return -1;
@@ -371,33 +372,26 @@ int authz_http_request(const char *username, const char *action, char **resp)
         free(request_body);
         return -1;
     }
-    options = util_common_calloc_s(sizeof(struct http_get_options));
-    if (options == NULL) {
-        ERROR("Failed to malloc http_get_options");
-        *resp = util_strdup_s("Inernal server error: Out of memory");
-        free(request_body);
-        return -1;
-    }
 
-    options->with_head = 1;
-    options->with_header_json = 1;
-    options->input = request_body;
-    options->input_len = strlen(request_body);
-    options->unix_socket_path = util_strdup_s(AUTHZ_UNIX_SOCK);
-
-    ret = http_request(AUTHZ_REQUEST_URL, options, &response_code, 0);
+    /* connection to authz plugin is kept alive by http pool */
+    request.url = AUTHZ_REQUEST_URL;
+    request.unix_socket_path = AUTHZ_UNIX_SOCK;
+    request.body = request_body;
+    request.body_len = strlen(request_body);
+    ret = http_pool_perform(&request, 1);
     if (ret != 0) {
         ERROR("Failed to request authz plugin. Is server running ?");
         *resp = util_strdup_s("Failed to request authz plugin. Is server running ?");
         ret = -1;
         goto out;
     }
-    if (response_code != StatusOK) {
-        ret = -1;
+    if (request.response_code != StatusOK) {
+        ret = AUTHZ_DENIED;
         nret = snprintf(err_msg, sizeof(err_msg), "action '%s' for user '%s': permission denied", action, username);
         if (nret < 0 || (size_t)nret >= sizeof(err_msg)) {
             ERROR("Out of memory");
             *resp = util_strdup_s("Inernal server error: Out of memory");
+            ret = -1;
             goto out;
         }
         *resp = util_strdup_s(err_msg);
@@ -405,11 +399,7 @@ int authz_http_request(const char *username, const char *action, char **resp)
     }
 
 out:
+    buffer_free(request.output);
     free(request_body);
-    if (options != NULL) {
-        free(options->unix_socket_path);
-        free(options);
-    }
     return ret;
 }
-
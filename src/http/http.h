@@ -73,6 +73,9 @@ struct http_get_options {
 /* authz error msg size */
 #define  AUTHZ_ERROR_MSG_SIZE       256
 
+/* authz_http_request() result of a denied action */
+#define  AUTHZ_DENIED               (-2)
+
 /* http_request() targets */
 #define HTTP_REQUEST_STRBUF         0
 #define HTTP_REQUEST_FILE           1
@@ -151,9 +154,15 @@ enum http_response_code {
 
 void free_http_get_options(struct http_get_options *options);
 
+size_t fwrite_buffer(const char *ptr, size_t eltsize, size_t nmemb, void *buffer_);
+
 int http_request(const char *url, struct http_get_options *options,
                  long *response_code, int recursive_len);
 
+/*
+ * return 0 if action is allowed, AUTHZ_DENIED if the authz plugin denied it,
+ * -1 if failed to get decision from the plugin.
+ */
 int authz_http_request(const char *username, const char *action, char **resp);
 
 void http_global_init(void);
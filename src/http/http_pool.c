@@ -0,0 +1,325 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-04-12
+ * Description: provide keep-alive http requests over a shared curl multi handle
+ ******************************************************************************/
+#define _GNU_SOURCE
+#include <curl/curl.h>
+#include <pthread.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/prctl.h>
+
+#include "http_pool.h"
+#include "http.h"
+#include "log.h"
+#include "utils.h"
+
+/* idle connections kept in the shared cache, one or more per plugin socket */
+#define HTTP_POOL_MAX_CONNECTS 64
+#define HTTP_POOL_WAIT_MS 1000
+
+struct http_pool_batch {
+    size_t pending;
+};
+
+struct http_pool_transfer {
+    struct http_pool_request *req;
+    struct http_pool_batch *batch;
+    CURL *easy;
+    struct curl_slist *headers;
+    uint64_t start_us;
+    char errbuf[CURL_ERROR_SIZE];
+    struct http_pool_transfer *next;
+};
+
+struct http_pool {
+    pthread_mutex_t lock;
+    /* signaled when a transfer is done */
+    pthread_cond_t done_cond;
+    /* only used by the pool thread after init */
+    CURLM *multi;
+    /* wake up the pool thread when transfers are queued */
+    int wake_fd;
+    /* transfers submitted but not added to multi yet */
+    struct http_pool_transfer *queued;
+    bool ready;
+};
+
+static struct http_pool g_http_pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .done_cond = PTHREAD_COND_INITIALIZER,
+    .multi = NULL,
+    .wake_fd = -1,
+    .queued = NULL,
+    .ready = false,
+};
+static pthread_once_t g_http_pool_once = PTHREAD_ONCE_INIT;
+
+static uint64_t monotonic_us(void)
+{
+    struct timespec ts = { 0 };
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static void transfer_done(struct http_pool_transfer *t, CURLcode code)
+{
+    if (code != CURLE_OK) {
+        ERROR("Request %s failed: %s", t->req->url, t->errbuf[0] != '\0' ? t->errbuf : curl_easy_strerror(code));
+        t->req->result = -1;
+    } else {
+        curl_easy_getinfo(t->easy, CURLINFO_RESPONSE_CODE, &t->req->response_code);
+        t->req->result = 0;
+    }
+    t->req->elapsed_us = monotonic_us() - t->start_us;
+
+    /* connection of the easy handle stays in the cache of multi */
+    curl_easy_cleanup(t->easy);
+    t->easy = NULL;
+    curl_slist_free_all(t->headers);
+    t->headers = NULL;
+
+    pthread_mutex_lock(&g_http_pool.lock);
+    t->batch->pending--;
+    pthread_cond_broadcast(&g_http_pool.done_cond);
+    pthread_mutex_unlock(&g_http_pool.lock);
+}
+
+static void add_queued_transfers(void)
+{
+    CURLMcode mcode;
+    struct http_pool_transfer *list = NULL;
+    struct http_pool_transfer *t = NULL;
+
+    pthread_mutex_lock(&g_http_pool.lock);
+    list = g_http_pool.queued;
+    g_http_pool.queued = NULL;
+    pthread_mutex_unlock(&g_http_pool.lock);
+
+    while (list != NULL) {
+        t = list;
+        list = list->next;
+        t->next = NULL;
+        mcode = curl_multi_add_handle(g_http_pool.multi, t->easy);
+        if (mcode != CURLM_OK) {
+            ERROR("Add request %s failed: %s", t->req->url, curl_multi_strerror(mcode));
+            transfer_done(t, CURLE_FAILED_INIT);
+        }
+    }
+}
+
+static void collect_done_transfers(void)
+{
+    int msgs = 0;
+    CURLMsg *msg = NULL;
+    struct http_pool_transfer *t = NULL;
+
+    while ((msg = curl_multi_info_read(g_http_pool.multi, &msgs)) != NULL) {
+        if (msg->msg != CURLMSG_DONE) {
+            continue;
+        }
+        t = NULL;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&t);
+        curl_multi_remove_handle(g_http_pool.multi, msg->easy_handle);
+        if (t != NULL) {
+            transfer_done(t, msg->data.result);
+        }
+    }
+}
+
+static void *http_pool_routine(void *arg)
+{
+    int running = 0;
+    eventfd_t value = 0;
+    struct curl_waitfd wake = { 0 };
+
+    (void)arg;
+    if (pthread_detach(pthread_self()) != 0) {
+        ERROR("Detach http pool thread failed");
+    }
+    prctl(PR_SET_NAME, "HttpPool");
+
+    for (;;) {
+        wake.fd = g_http_pool.wake_fd;
+        wake.events = CURL_WAIT_POLLIN;
+        wake.revents = 0;
+        if (curl_multi_wait(g_http_pool.multi, &wake, 1, HTTP_POOL_WAIT_MS, NULL) != CURLM_OK) {
+            ERROR("Wait http pool failed");
+            usleep_nointerupt(10000);
+        }
+        (void)eventfd_read(g_http_pool.wake_fd, &value);
+
+        add_queued_transfers();
+        (void)curl_multi_perform(g_http_pool.multi, &running);
+        collect_done_transfers();
+    }
+
+    return NULL;
+}
+
+static void http_pool_init(void)
+{
+    pthread_t thread = 0;
+
+    http_global_init();
+    g_http_pool.multi = curl_multi_init();
+    if (g_http_pool.multi == NULL) {
+        ERROR("Init curl multi handle failed");
+        return;
+    }
+    curl_multi_setopt(g_http_pool.multi, CURLMOPT_MAXCONNECTS, (long)HTTP_POOL_MAX_CONNECTS);
+
+    g_http_pool.wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (g_http_pool.wake_fd < 0) {
+        SYSERROR("Create eventfd for http pool failed");
+        goto err_out;
+    }
+
+    if (pthread_create(&thread, NULL, http_pool_routine, NULL) != 0) {
+        ERROR("Create http pool thread failed");
+        goto err_out;
+    }
+
+    g_http_pool.ready = true;
+    return;
+
+err_out:
+    if (g_http_pool.wake_fd >= 0) {
+        close(g_http_pool.wake_fd);
+        g_http_pool.wake_fd = -1;
+    }
+    curl_multi_cleanup(g_http_pool.multi);
+    g_http_pool.multi = NULL;
+}
+
+static int transfer_prepare(struct http_pool_transfer *t)
+{
+    struct http_pool_request *req = t->req;
+
+    req->result = -1;
+    req->response_code = 0;
+    req->elapsed_us = 0;
+    req->output = buffer_alloc(HTTP_GET_BUFFER_SIZE);
+    if (req->output == NULL) {
+        ERROR("Failed to malloc output buffer");
+        return -1;
+    }
+
+    t->easy = curl_easy_init();
+    if (t->easy == NULL) {
+        ERROR("Init curl easy handle failed");
+        return -1;
+    }
+    t->headers = curl_slist_append(t->headers, "Content-Type: application/json");
+    // Disable "Expect: 100-continue"
+    t->headers = curl_slist_append(t->headers, "Expect:");
+
+    curl_easy_setopt(t->easy, CURLOPT_URL, req->url);
+    if (req->unix_socket_path != NULL) {
+        curl_easy_setopt(t->easy, CURLOPT_UNIX_SOCKET_PATH, req->unix_socket_path);
+    }
+    curl_easy_setopt(t->easy, CURLOPT_NOSIGNAL, 1L);
+    /* complete connection within 5 seconds */
+    curl_easy_setopt(t->easy, CURLOPT_CONNECTTIMEOUT, 5L);
+    curl_easy_setopt(t->easy, CURLOPT_ERRORBUFFER, t->errbuf);
+    curl_easy_setopt(t->easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
+    curl_easy_setopt(t->easy, CURLOPT_NOPROGRESS, 1L);
+    curl_easy_setopt(t->easy, CURLOPT_HEADER, 1L);
+    curl_easy_setopt(t->easy, CURLOPT_HTTPHEADER, t->headers);
+    curl_easy_setopt(t->easy, CURLOPT_POSTFIELDS, req->body);
+    curl_easy_setopt(t->easy, CURLOPT_POSTFIELDSIZE, (long)req->body_len);
+    curl_easy_setopt(t->easy, CURLOPT_POST, 1L);
+    curl_easy_setopt(t->easy, CURLOPT_WRITEDATA, req->output);
+    curl_easy_setopt(t->easy, CURLOPT_WRITEFUNCTION, fwrite_buffer);
+    curl_easy_setopt(t->easy, CURLOPT_PRIVATE, (char *)t);
+
+    return 0;
+}
+
+int http_pool_perform(struct http_pool_request *requests, size_t count)
+{
+    int ret = 0;
+    size_t i;
+    struct http_pool_batch batch = { 0 };
+    struct http_pool_transfer *transfers = NULL;
+
+    if (requests == NULL || count == 0) {
+        return 0;
+    }
+
+    (void)pthread_once(&g_http_pool_once, http_pool_init);
+    if (!g_http_pool.ready) {
+        ERROR("Http pool is not ready");
+        return -1;
+    }
+
+    if (count > SIZE_MAX / sizeof(struct http_pool_transfer)) {
+        ERROR("Too many requests");
+        return -1;
+    }
+    transfers = util_common_calloc_s(count * sizeof(struct http_pool_transfer));
+    if (transfers == NULL) {
+        ERROR("Out of memory");
+        return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        transfers[i].req = &requests[i];
+        transfers[i].batch = &batch;
+        if (transfer_prepare(&transfers[i]) != 0) {
+            ret = -1;
+            goto out;
+        }
+    }
+
+    pthread_mutex_lock(&g_http_pool.lock);
+    for (i = 0; i < count; i++) {
+        transfers[i].start_us = monotonic_us();
+        transfers[i].next = g_http_pool.queued;
+        g_http_pool.queued = &transfers[i];
+    }
+    batch.pending = count;
+    pthread_mutex_unlock(&g_http_pool.lock);
+
+    if (eventfd_write(g_http_pool.wake_fd, 1) != 0) {
+        /* the pool thread still picks them up on next wait timeout */
+        WARN("Wake up http pool failed: %s", strerror(errno));
+    }
+
+    pthread_mutex_lock(&g_http_pool.lock);
+    while (batch.pending > 0) {
+        pthread_cond_wait(&g_http_pool.done_cond, &g_http_pool.lock);
+    }
+    pthread_mutex_unlock(&g_http_pool.lock);
+
+    for (i = 0; i < count; i++) {
+        if (requests[i].result != 0) {
+            ret = -1;
+        }
+    }
+
+out:
+    /* transfers not submitted still own their handles */
+    for (i = 0; i < count; i++) {
+        if (transfers[i].easy != NULL) {
+            curl_easy_cleanup(transfers[i].easy);
+        }
+        curl_slist_free_all(transfers[i].headers);
+    }
+    free(transfers);
+    return ret;
+}
@@ -0,0 +1,56 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-04-12
+ * Description: provide keep-alive http requests over a shared curl multi handle
+ ******************************************************************************/
+#ifndef ISULAD_HTTP_POOL_H
+#define ISULAD_HTTP_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * All requests are driven by one background thread on a shared curl multi
+ * handle, so connections are kept alive and reused per unix socket, and the
+ * requests of a batch are in flight at the same time.
+ */
+struct http_pool_request {
+    /* input, url and unix socket path must be valid until request done */
+    const char *url;
+    const char *unix_socket_path;
+    /* POST body with json content type */
+    const char *body;
+    size_t body_len;
+
+    /* output, response with header which can be parsed by parse_http, caller frees it by buffer_free */
+    Buffer *output;
+    long response_code;
+    /* 0 means got response, -1 means transfer failed */
+    int result;
+    /* time from submit to done */
+    uint64_t elapsed_us;
+};
+
+/* perform requests in parallel and wait all of them done, return -1 if any request failed */
+int http_pool_perform(struct http_pool_request *requests, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ISULAD_HTTP_POOL_H */
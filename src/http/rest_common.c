@@ -14,6 +14,7 @@
  ******************************************************************************/
 #include "rest_common.h"
 #include <dlfcn.h>
+#include <pthread.h>
 #include <string.h>
 #include "log.h"
 #include "utils.h"
@@ -39,6 +40,8 @@ struct httpclient_ops {
 };
 
 static struct httpclient_ops g_hc_ops;
+/* g_hc_ops is shared by threads of isulad, which unpack plugin responses in parallel */
+static pthread_mutex_t g_hc_ops_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 /*
  * dlclose may leak the fd which is opened by dlopen in lower version of glibc,
@@ -144,15 +147,27 @@ int get_response(Buffer *output, unpack_response_func_t unpack_func, void *arg)
     size_t reslen = 0;
     struct parsed_http_message *msg = NULL;
 
-    if (output == NULL || unpack_func == NULL) {
+    if (output == NULL || output->contents == NULL || unpack_func == NULL) {
         ERROR("Invalid parameter");
         return -1;
     }
 
-    if (g_hc_ops.handle == NULL || g_hc_ops.parse_http_op == NULL || g_hc_ops.buffer_strlen_op == NULL) {
-        ERROR("http client ops is null");
+    if (pthread_mutex_lock(&g_hc_ops_mutex) != 0) {
+        ERROR("Failed to lock http client ops");
         return -1;
     }
+
+    /* responses of http pool are not sent by rest_send_requst, load ops here */
+    if (g_hc_ops.handle == NULL && ops_init(&g_hc_ops) != 0) {
+        ERROR("Failed to init g_hc_ops");
+        ret = -1;
+        goto out;
+    }
+    if (g_hc_ops.parse_http_op == NULL || g_hc_ops.buffer_strlen_op == NULL) {
+        ERROR("http client ops is null");
+        ret = -1;
+        goto out;
+    }
     msg = util_common_calloc_s(sizeof(struct parsed_http_message));
     if (msg == NULL) {
         ERROR("Failed to malloc memory");
@@ -180,6 +195,7 @@ int get_response(Buffer *output, unpack_response_func_t unpack_func, void *arg)
 
 out:
     free_httpclient_ops(&g_hc_ops);
+    (void)pthread_mutex_unlock(&g_hc_ops_mutex);
     if (msg != NULL) {
         if (msg->body != NULL) {
             free(msg->body);
@@ -246,16 +262,22 @@ int rest_send_requst(const char *socket, const char *url, char *request_body, si
         ERROR("Invalid parameter");
         return -1;
     }
+    if (pthread_mutex_lock(&g_hc_ops_mutex) != 0) {
+        ERROR("Failed to lock http client ops");
+        return -1;
+    }
     if (init_http_client_opt()) {
         ERROR("Failed to init g_hc_ops");
         free_httpclient_ops(&g_hc_ops);
-        return -1;
+        ret = -1;
+        goto unlock_out;
     }
 
     options = util_common_calloc_s(sizeof(struct http_get_options));
     if (options == NULL) {
         ERROR("Failed to malloc http_get_options");
-        return -1;
+        ret = -1;
+        goto unlock_out;
     }
 
     if (set_http_get_options(socket, request_body, body_len, options, output)) {
@@ -275,6 +297,8 @@ out:
     if (ret != 0) {
         free_httpclient_ops(&g_hc_ops);
     }
+unlock_out:
+    (void)pthread_mutex_unlock(&g_hc_ops_mutex);
     return ret;
 }
 
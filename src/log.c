@@ -25,6 +25,9 @@
 #include <sys/stat.h>
 #include <stdarg.h>
 #include <inttypes.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/prctl.h>
 
 #include "utils.h"
 
@@ -39,10 +42,62 @@ static __thread char *g_log_prefix = NULL;
 
 static bool g_log_quiet = false;
 static char *g_log_module = NULL;
-static int g_log_level = ISULA_LOG_DEBUG;
+int g_isulad_log_level = ISULA_LOG_DEBUG;
 static int g_log_driver = LOG_DRIVER_STDOUT;
 int g_isulad_log_fd = -1;
 
+/*
+ * Logs of fifo driver are queued in a ring of the logging thread, and a single
+ * writer thread drains all rings into the fifo. A ring has only one producer
+ * and one consumer, so neither side takes a lock. Lines are queued as a 32 bits
+ * length followed by the line, and the writer batches whole lines into writes
+ * no larger than PIPE_BUF, which keeps them atomic against other fifo writers.
+ * A producer waits for a full ring to be drained for a while, instead of
+ * dropping lines when log gather is slow.
+ */
+#define LOG_RING_SIZE (64 * 1024)
+#define LOG_RING_MASK (LOG_RING_SIZE - 1)
+#define LOG_WRITER_INTERVAL_MS 50
+#define LOG_WRITE_RETRY 100
+
+struct log_ring {
+    char data[LOG_RING_SIZE];
+    /* only changed by producer */
+    uint64_t head;
+    /* only changed by writer */
+    uint64_t tail;
+    /* owner thread exited, ring is freed by writer when drained */
+    bool closed;
+    struct log_ring *next;
+};
+
+struct log_writer {
+    /* protect list of rings and draining */
+    pthread_mutex_t rings_lock;
+    struct log_ring *rings;
+    pthread_mutex_t wake_lock;
+    pthread_cond_t wake_cond;
+    bool wake;
+    /* false in forked children, which have no writer */
+    bool async;
+};
+
+static struct log_writer g_log_writer = {
+    .rings_lock = PTHREAD_MUTEX_INITIALIZER,
+    .rings = NULL,
+    .wake_lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake_cond = PTHREAD_COND_INITIALIZER,
+    .wake = false,
+    .async = false,
+};
+static pthread_once_t g_log_writer_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g_log_ring_key;
+static __thread struct log_ring *g_log_ring = NULL;
+
+/* local time in seconds only changes once a second, format it once per thread */
+static __thread time_t g_log_time_sec = (time_t) -1;
+static __thread char g_log_time_prefix[ISULAD_LOG_TIME_MAX_LEN] = { 0 };
+
 /* set log prefix */
 void set_log_prefix(const char *prefix)
 {
@@ -150,7 +205,7 @@ static int log_init_checker(const struct log_config *log)
 
     for (i = ISULA_LOG_FATAL; i < ISULA_LOG_MAX; i++) {
         if (strcasecmp(g_log_prio_name[i], log->priority) == 0) {
-            g_log_level = i;
+            g_isulad_log_level = i;
             break;
         }
     }
@@ -169,6 +224,291 @@ static int log_init_checker(const struct log_config *log)
     return 0;
 }
 
+static void log_writer_wakeup(void)
+{
+    if (pthread_mutex_lock(&g_log_writer.wake_lock) != 0) {
+        return;
+    }
+    g_log_writer.wake = true;
+    (void)pthread_cond_signal(&g_log_writer.wake_cond);
+    (void)pthread_mutex_unlock(&g_log_writer.wake_lock);
+}
+
+static void log_ring_copy_in(struct log_ring *ring, uint64_t pos, const void *src, size_t len)
+{
+    size_t off = (size_t)(pos & LOG_RING_MASK);
+    size_t first = LOG_RING_SIZE - off;
+
+    if (first > len) {
+        first = len;
+    }
+    (void)memcpy(ring->data + off, src, first);
+    (void)memcpy(ring->data, (const char *)src + first, len - first);
+}
+
+static void log_ring_copy_out(const struct log_ring *ring, uint64_t pos, void *dst, size_t len)
+{
+    size_t off = (size_t)(pos & LOG_RING_MASK);
+    size_t first = LOG_RING_SIZE - off;
+
+    if (first > len) {
+        first = len;
+    }
+    (void)memcpy(dst, ring->data + off, first);
+    (void)memcpy((char *)dst + first, ring->data, len - first);
+}
+
+static void log_ring_thread_exit(void *arg)
+{
+    struct log_ring *ring = arg;
+
+    /* logs from later destructors get a new ring */
+    g_log_ring = NULL;
+    __atomic_store_n(&ring->closed, true, __ATOMIC_RELEASE);
+}
+
+static struct log_ring *log_ring_get(void)
+{
+    struct log_ring *ring = NULL;
+
+    if (g_log_ring != NULL) {
+        return g_log_ring;
+    }
+
+    ring = calloc(1, sizeof(struct log_ring));
+    if (ring == NULL) {
+        return NULL;
+    }
+    if (pthread_setspecific(g_log_ring_key, ring) != 0) {
+        free(ring);
+        return NULL;
+    }
+
+    if (pthread_mutex_lock(&g_log_writer.rings_lock) != 0) {
+        (void)pthread_setspecific(g_log_ring_key, NULL);
+        free(ring);
+        return NULL;
+    }
+    ring->next = g_log_writer.rings;
+    g_log_writer.rings = ring;
+    (void)pthread_mutex_unlock(&g_log_writer.rings_lock);
+
+    g_log_ring = ring;
+    return ring;
+}
+
+/* queue line to writer, false if it must be written by caller */
+static bool log_ring_push(const char *line, size_t len)
+{
+    int i;
+    uint32_t hdr = (uint32_t)len;
+    uint64_t head;
+    uint64_t used;
+    struct log_ring *ring = NULL;
+
+    if (!g_log_writer.async || len > PIPE_BUF) {
+        return false;
+    }
+
+    ring = log_ring_get();
+    if (ring == NULL) {
+        return false;
+    }
+
+    head = ring->head;
+    used = head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    for (i = 0; LOG_RING_SIZE - used < sizeof(hdr) + len; i++) {
+        if (i == LOG_WRITE_RETRY) {
+            /* writer is stuck, write it directly rather than drop it */
+            return false;
+        }
+        log_writer_wakeup();
+        (void)usleep(1000);
+        used = head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    }
+
+    log_ring_copy_in(ring, head, &hdr, sizeof(hdr));
+    log_ring_copy_in(ring, head + sizeof(hdr), line, len);
+    __atomic_store_n(&ring->head, head + sizeof(hdr) + len, __ATOMIC_RELEASE);
+
+    used += sizeof(hdr) + len;
+    if (used > LOG_RING_SIZE / 2) {
+        log_writer_wakeup();
+    }
+
+    return true;
+}
+
+static void log_write_batch(const char *buf, size_t len)
+{
+    int i;
+    ssize_t nret = -1;
+
+    if (len == 0 || g_isulad_log_fd == -1) {
+        return;
+    }
+
+    for (i = 0; i < LOG_WRITE_RETRY; i++) {
+        nret = isulad_save_log(g_isulad_log_fd, buf, len);
+        if (nret >= 0 || errno != EAGAIN) {
+            break;
+        }
+        /* fifo is full, wait log gather to read */
+        (void)usleep(1000);
+    }
+    if (nret < 0) {
+        COMMAND_ERROR("Write log into logfile failed");
+    }
+}
+
+/* drain one ring into batch, which is flushed when a line does not fit */
+static void log_ring_drain(struct log_ring *ring, char *batch, size_t *batch_len)
+{
+    uint32_t hdr = 0;
+    uint64_t tail = ring->tail;
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+    while (tail < head) {
+        log_ring_copy_out(ring, tail, &hdr, sizeof(hdr));
+        if (*batch_len + hdr > PIPE_BUF) {
+            log_write_batch(batch, *batch_len);
+            *batch_len = 0;
+        }
+        log_ring_copy_out(ring, tail + sizeof(hdr), batch + *batch_len, hdr);
+        *batch_len += hdr;
+        tail += sizeof(hdr) + hdr;
+    }
+
+    __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+}
+
+/* called with rings locked */
+static void log_drain_rings_locked(void)
+{
+    char batch[PIPE_BUF];
+    size_t batch_len = 0;
+    bool closed = false;
+    struct log_ring **pring = NULL;
+    struct log_ring *ring = NULL;
+
+    pring = &g_log_writer.rings;
+    while (*pring != NULL) {
+        ring = *pring;
+        /* read closed before drain, so nothing is queued after the last drain */
+        closed = __atomic_load_n(&ring->closed, __ATOMIC_ACQUIRE);
+        log_ring_drain(ring, batch, &batch_len);
+        if (closed) {
+            *pring = ring->next;
+            free(ring);
+            continue;
+        }
+        pring = &ring->next;
+    }
+    log_write_batch(batch, batch_len);
+}
+
+static void log_drain_rings(void)
+{
+    if (pthread_mutex_lock(&g_log_writer.rings_lock) != 0) {
+        return;
+    }
+    log_drain_rings_locked();
+    (void)pthread_mutex_unlock(&g_log_writer.rings_lock);
+}
+
+/* errors are written at once, after lines queued before them. false if it must be written by caller */
+static bool log_write_urgent(const char *line, size_t len)
+{
+    if (!g_log_writer.async) {
+        return false;
+    }
+
+    if (pthread_mutex_lock(&g_log_writer.rings_lock) != 0) {
+        return false;
+    }
+    log_drain_rings_locked();
+    log_write_batch(line, len);
+    (void)pthread_mutex_unlock(&g_log_writer.rings_lock);
+
+    return true;
+}
+
+/* forked children exit without writer, rings of parent are not theirs to write */
+static void log_drain_rings_at_exit(void)
+{
+    if (!g_log_writer.async) {
+        return;
+    }
+    log_drain_rings();
+}
+
+static void *log_writer_routine(void *arg)
+{
+    struct timespec deadline;
+
+    (void)arg;
+    (void)pthread_detach(pthread_self());
+    (void)prctl(PR_SET_NAME, "LogWriter");
+
+    for (;;) {
+        (void)pthread_mutex_lock(&g_log_writer.wake_lock);
+        if (!g_log_writer.wake) {
+            (void)clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += LOG_WRITER_INTERVAL_MS * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            (void)pthread_cond_timedwait(&g_log_writer.wake_cond, &g_log_writer.wake_lock, &deadline);
+        }
+        g_log_writer.wake = false;
+        (void)pthread_mutex_unlock(&g_log_writer.wake_lock);
+
+        log_drain_rings();
+    }
+
+    return NULL;
+}
+
+/*
+ * forked child has no writer thread, it logs synchronously. Locks may be
+ * held by threads of parent which do not exist in child, and lines in rings
+ * are written by parent, so child starts with no rings and fresh locks.
+ */
+static void log_writer_atfork_child(void)
+{
+    g_log_writer.async = false;
+    g_log_writer.rings = NULL;
+    (void)pthread_mutex_init(&g_log_writer.rings_lock, NULL);
+    (void)pthread_mutex_init(&g_log_writer.wake_lock, NULL);
+    (void)pthread_cond_init(&g_log_writer.wake_cond, NULL);
+    g_log_ring = NULL;
+}
+
+static void log_writer_start(void)
+{
+    pthread_t thread;
+
+    if (pthread_key_create(&g_log_ring_key, log_ring_thread_exit) != 0) {
+        COMMAND_ERROR("Failed to create log ring key");
+        return;
+    }
+
+    if (pthread_atfork(NULL, NULL, log_writer_atfork_child) != 0) {
+        COMMAND_ERROR("Failed to register log atfork handler");
+        return;
+    }
+
+    if (pthread_create(&thread, NULL, log_writer_routine, NULL) != 0) {
+        COMMAND_ERROR("Failed to create log writer thread");
+        return;
+    }
+
+    /* logs queued at exit are still written */
+    (void)atexit(log_drain_rings_at_exit);
+    g_log_writer.async = true;
+}
+
 /* log init */
 int log_init(struct log_config *log)
 {
@@ -206,6 +546,11 @@ int log_init(struct log_config *log)
 
     if (g_isulad_log_fd == -1) {
         nret = -1;
+        goto out;
+    }
+
+    if (g_log_driver == LOG_DRIVER_FIFO) {
+        (void)pthread_once(&g_log_writer_once, log_writer_start);
     }
 out:
     if (nret != 0 && g_log_driver == LOG_DRIVER_FIFO) {
@@ -216,35 +561,41 @@ out:
     return nret;
 }
 
-static char *parse_timespec_to_human()
+static int parse_timespec_to_human(char *date_time, size_t len)
 {
     struct timespec timestamp;
     struct tm ptm = {0};
-    char date_time[ISULAD_LOG_TIME_MAX_LEN] = { 0 };
     int nret;
 #define SEC_TO_NSEC 1000000
 #define FIRST_YEAR_OF_GMT 1900
 
     if (clock_gettime(CLOCK_REALTIME, &timestamp) == -1) {
         COMMAND_ERROR("Failed to get real time");
-        return 0;
+        return -1;
     }
 
-    if (localtime_r(&(timestamp.tv_sec), &ptm) == NULL) {
-        SYSERROR("Transfer timespec failed");
-        return NULL;
+    if (timestamp.tv_sec != g_log_time_sec) {
+        if (localtime_r(&(timestamp.tv_sec), &ptm) == NULL) {
+            COMMAND_ERROR("Transfer timespec failed");
+            return -1;
+        }
+        nret = snprintf(g_log_time_prefix, sizeof(g_log_time_prefix), "%04d%02d%02d%02d%02d%02d",
+                        ptm.tm_year + FIRST_YEAR_OF_GMT, ptm.tm_mon + 1, ptm.tm_mday, ptm.tm_hour, ptm.tm_min,
+                        ptm.tm_sec);
+        if (nret < 0 || (size_t)nret >= sizeof(g_log_time_prefix)) {
+            COMMAND_ERROR("Sprintf failed");
+            return -1;
+        }
+        g_log_time_sec = timestamp.tv_sec;
     }
 
-    nret = snprintf(date_time, ISULAD_LOG_TIME_MAX_LEN, "%04d%02d%02d%02d%02d%02d.%03ld",
-                    ptm.tm_year + FIRST_YEAR_OF_GMT, ptm.tm_mon + 1, ptm.tm_mday, ptm.tm_hour, ptm.tm_min, ptm.tm_sec,
-                    timestamp.tv_nsec / SEC_TO_NSEC);
-
-    if (nret < 0 || nret >= ISULAD_LOG_TIME_MAX_LEN) {
+    nret = snprintf(date_time, len, "%s.%03ld", g_log_time_prefix, timestamp.tv_nsec / SEC_TO_NSEC);
+    if (nret < 0 || (size_t)nret >= len) {
         COMMAND_ERROR("Sprintf failed");
-        return NULL;
+        return -1;
     }
 
-    return util_strdup_s(date_time);
+    return 0;
 }
 
 static int do_log_by_driver(const struct log_object_metadata *meta, const char *msg, const char *date_time)
@@ -275,10 +626,13 @@ static int do_log_by_driver(const struct log_object_metadata *meta, const char *
 int new_log(const struct log_object_metadata *meta, const char *format, ...)
 {
     int rc = 0;
-    int ret = 0;
     va_list args;
-    char msg[MAX_MSG_LENGTH] = { 0 };
-    char *date_time = NULL;
+    char msg[MAX_MSG_LENGTH];
+    char date_time[ISULAD_LOG_TIME_MAX_LEN];
+
+    if (meta == NULL || meta->level > g_isulad_log_level) {
+        return 0;
+    }
 
     va_start(args, format);
     rc = vsnprintf(msg, MAX_MSG_LENGTH, format, args);
@@ -290,16 +644,11 @@ int new_log(const struct log_object_metadata *meta, const char *format, ...)
         }
     }
 
-    date_time = parse_timespec_to_human();
-    if (date_time == NULL) {
-        goto out;
+    if (parse_timespec_to_human(date_time, sizeof(date_time)) != 0) {
+        return 0;
     }
 
-    ret = do_log_by_driver(meta, msg, date_time);
-
-out:
-    free(date_time);
-    return ret;
+    return do_log_by_driver(meta, msg, date_time);
 }
 
 void do_fifo_log(const struct log_object_metadata *meta, const char *timestamp, const char *msg)
@@ -308,9 +657,9 @@ void do_fifo_log(const struct log_object_metadata *meta, const char *timestamp,
     int nret = 0;
     size_t size = 0;
     char *tmp_prefix = NULL;
-    char log_buffer[ISULAD_LOG_BUFFER_SIZE] = { 0 };
+    char log_buffer[ISULAD_LOG_BUFFER_SIZE];
 
-    if (meta == NULL || meta->level > g_log_level) {
+    if (meta == NULL || meta->level > g_isulad_log_level) {
         return;
     }
     log_fd = g_isulad_log_fd;
@@ -341,6 +690,14 @@ void do_fifo_log(const struct log_object_metadata *meta, const char *timestamp,
 
     log_buffer[size] = '\n';
 
+    if (meta->level <= ISULA_LOG_ERROR) {
+        if (log_write_urgent(log_buffer, size + 1)) {
+            return;
+        }
+    } else if (log_ring_push(log_buffer, size + 1)) {
+        return;
+    }
+
     if (isulad_save_log(log_fd, log_buffer, (size + 1)) == -1) {
         COMMAND_ERROR("Write log into logfile failed");
     }
@@ -351,7 +708,7 @@ void do_stderr_log(const struct log_object_metadata *meta, const char *timestamp
 {
     char *tmp_prefix = NULL;
 
-    if (meta == NULL || meta->level > g_log_level) {
+    if (meta == NULL || meta->level > g_isulad_log_level) {
         return;
     }
 
@@ -81,12 +81,17 @@ int change_str_logdriver_to_enum(const char *driver);
 
 int new_log(const struct log_object_metadata *meta, const char *format, ...);
 
-#define COMMON_LOG(loglevel, format, ...)                                                   \
-    do {                                                                                    \
-        struct log_object_metadata meta = {                                          \
-            .file = __FILENAME__, .func = __func__, .line = __LINE__, .level = loglevel,    \
-        };                                                                                  \
-        (void)new_log(&meta, format, ##__VA_ARGS__);                                     \
+/* level set by log_init, checked before any argument is formatted */
+extern int g_isulad_log_level;
+
+#define COMMON_LOG(loglevel, format, ...)                                                       \
+    do {                                                                                        \
+        if ((loglevel) <= g_isulad_log_level) {                                                 \
+            struct log_object_metadata meta = {                                                 \
+                .file = __FILENAME__, .func = __func__, .line = __LINE__, .level = loglevel,    \
+            };                                                                                  \
+            (void)new_log(&meta, format, ##__VA_ARGS__);                                        \
+        }                                                                                       \
     } while (0)
 
 #define DEBUG(format, ...)                               \
@@ -104,12 +109,14 @@ int new_log(const struct log_object_metadata *meta, const char *format, ...);
 #define ERROR(format, ...)                               \
     COMMON_LOG(ISULA_LOG_ERROR, format, ##__VA_ARGS__)
 
-#define EVENT(format, ...)                                                      \
-    do {                                                                        \
-        struct log_object_metadata meta = {                              \
-            .file = NULL, .func = NULL, .line = 0, .level = ISULA_LOG_ERROR,    \
-        };                                                                      \
-        (void)new_log(&meta, format, ##__VA_ARGS__);                         \
+#define EVENT(format, ...)                                                          \
+    do {                                                                            \
+        if (ISULA_LOG_ERROR <= g_isulad_log_level) {                                \
+            struct log_object_metadata meta = {                                     \
+                .file = NULL, .func = NULL, .line = 0, .level = ISULA_LOG_ERROR,    \
+            };                                                                      \
+            (void)new_log(&meta, format, ##__VA_ARGS__);                            \
+        }                                                                           \
     } while (0)
 
 #define CRIT(format, ...)                                \
@@ -0,0 +1,45 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-04-10
+ * Description: provide format of container log index file
+ ******************************************************************************/
+#ifndef __ISULAD_LOG_INDEX_H
+#define __ISULAD_LOG_INDEX_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * isulad-shim keeps a sparse index beside each json log file, console.log is
+ * indexed by console.log.idx and they are rotated together. The index is an
+ * array of log_index_entry in host byte order, one entry is appended when
+ * at least LOG_INDEX_INTERVAL bytes of log were written since the last one.
+ * Entries are only hints, readers must check them against the log file.
+ */
+#define LOG_INDEX_SUFFIX ".idx"
+#define LOG_INDEX_INTERVAL (64 * 1024)
+
+typedef struct {
+    /* unix nanoseconds of the line starts at offset */
+    int64_t timestamp;
+    /* offset of the start of a line in log file */
+    uint64_t offset;
+} log_index_entry;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ISULAD_LOG_INDEX_H */
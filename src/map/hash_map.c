@@ -0,0 +1,430 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-03-25
+ * Description: provide open addressing hash map functions
+ ******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "hash_map.h"
+#include "log.h"
+#include "utils.h"
+
+#define HASH_MAP_MIN_CAPACITY 16
+/* grow when more than 3/4 of the slots are used */
+#define HASH_MAP_LOAD_NUM 3
+#define HASH_MAP_LOAD_DEN 4
+
+static void hash_map_free_key_value(void *key, void *val)
+{
+    free(key);
+    free(val);
+}
+
+static size_t hash_mix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+
+    return (size_t)h;
+}
+
+static size_t hash_str(const char *str)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    for (; *str != '\0'; str++) {
+        h ^= (unsigned char)*str;
+        h *= 0x100000001b3ULL;
+    }
+
+    return hash_mix(h);
+}
+
+static size_t hash_map_hash_key(map_type_t type, const void *key)
+{
+    size_t h = 0;
+
+    if (map_type_key_is_str(type)) {
+        h = hash_str((const char *)key);
+    } else if (map_type_key_is_ptr(type)) {
+        h = hash_mix((uint64_t)(uintptr_t)key);
+    } else {
+        h = hash_mix((uint64_t)(unsigned int)(*(const int *)key));
+    }
+
+    /* hash 0 marks an empty slot */
+    return h != 0 ? h : 1;
+}
+
+static bool hash_map_key_equal(map_type_t type, const void *first, const void *second)
+{
+    if (map_type_key_is_str(type)) {
+        return strcmp((const char *)first, (const char *)second) == 0;
+    }
+    if (map_type_key_is_ptr(type)) {
+        return first == second;
+    }
+
+    return *(const int *)first == *(const int *)second;
+}
+
+/* return slot of key, or the empty slot where key should be inserted */
+static size_t hash_map_find_slot(const hash_map_t *map, const void *key, size_t hash, bool *found)
+{
+    size_t mask = map->capacity - 1;
+    size_t pos = hash & mask;
+    const hash_map_entry_t *entry = NULL;
+
+    for (;;) {
+        entry = &map->entries[pos];
+        if (entry->hash == 0) {
+            *found = false;
+            return pos;
+        }
+        if (entry->hash == hash && hash_map_key_equal(map->type, entry->key, key)) {
+            *found = true;
+            return pos;
+        }
+        pos = (pos + 1) & mask;
+    }
+}
+
+static int hash_map_resize(hash_map_t *map, size_t capacity)
+{
+    size_t i;
+    size_t pos;
+    size_t mask = capacity - 1;
+    hash_map_entry_t *entries = NULL;
+
+    entries = util_smart_calloc_s(sizeof(hash_map_entry_t), capacity);
+    if (entries == NULL) {
+        ERROR("Out of memory");
+        return -1;
+    }
+
+    for (i = 0; i < map->capacity; i++) {
+        if (map->entries[i].hash == 0) {
+            continue;
+        }
+        pos = map->entries[i].hash & mask;
+        while (entries[pos].hash != 0) {
+            pos = (pos + 1) & mask;
+        }
+        entries[pos] = map->entries[i];
+    }
+
+    free(map->entries);
+    map->entries = entries;
+    map->capacity = capacity;
+
+    return 0;
+}
+
+static int hash_map_reserve_one(hash_map_t *map)
+{
+    if ((map->size + 1) * HASH_MAP_LOAD_DEN <= map->capacity * HASH_MAP_LOAD_NUM) {
+        return 0;
+    }
+
+    if (map->capacity > SIZE_MAX / 2 / sizeof(hash_map_entry_t)) {
+        ERROR("Hash map is too large");
+        return -1;
+    }
+
+    return hash_map_resize(map, map->capacity * 2);
+}
+
+hash_map_t *hash_map_new(map_type_t kvtype, map_kvfree_func kvfree)
+{
+    hash_map_t *map = NULL;
+
+    if (kvtype > MAP_PTR_PTR) {
+        ERROR("invalid map type!");
+        return NULL;
+    }
+
+    map = util_common_calloc_s(sizeof(hash_map_t));
+    if (map == NULL) {
+        ERROR("Out of memory");
+        return NULL;
+    }
+
+    map->entries = util_smart_calloc_s(sizeof(hash_map_entry_t), HASH_MAP_MIN_CAPACITY);
+    if (map->entries == NULL) {
+        ERROR("Out of memory");
+        free(map);
+        return NULL;
+    }
+    map->capacity = HASH_MAP_MIN_CAPACITY;
+    map->type = kvtype;
+    map->kvfree = (kvfree == MAP_DEFAULT_FREE_FUNC) ? hash_map_free_key_value : kvfree;
+
+    return map;
+}
+
+/* just clear all entries */
+void hash_map_clear(hash_map_t *map)
+{
+    size_t i;
+
+    if (map == NULL) {
+        return;
+    }
+
+    for (i = 0; i < map->capacity; i++) {
+        if (map->entries[i].hash == 0) {
+            continue;
+        }
+        map->kvfree(map->entries[i].key, map->entries[i].value);
+        map->entries[i].hash = 0;
+        map->entries[i].key = NULL;
+        map->entries[i].value = NULL;
+    }
+    map->size = 0;
+}
+
+void hash_map_free(hash_map_t *map)
+{
+    if (map == NULL) {
+        return;
+    }
+
+    hash_map_clear(map);
+    free(map->entries);
+    free(map);
+}
+
+static void hash_map_release_converted(const hash_map_t *map, void *key, void *value)
+{
+    if (!map_type_key_is_ptr(map->type)) {
+        free(key);
+    }
+    if (!map_type_val_is_ptr(map->type)) {
+        free(value);
+    }
+}
+
+static bool hash_map_put(hash_map_t *map, void *key, void *value, bool replace)
+{
+    bool found = false;
+    size_t hash;
+    size_t pos;
+    void *tmp = NULL;
+    void *tmp_value = NULL;
+
+    if (map == NULL || key == NULL || value == NULL) {
+        ERROR("invalid parameter");
+        return false;
+    }
+
+    hash = hash_map_hash_key(map->type, key);
+    pos = hash_map_find_slot(map, key, hash, &found);
+    if (found && !replace) {
+        ERROR("the key already existed in hash map!");
+        return false;
+    }
+
+    if (!found && hash_map_reserve_one(map) != 0) {
+        return false;
+    }
+
+    tmp = map_type_convert_key(map->type, key);
+    if (tmp == NULL) {
+        ERROR("failed to convert key, out of memory or invalid k-v type");
+        return false;
+    }
+    tmp_value = map_type_convert_value(map->type, value);
+    if (tmp_value == NULL) {
+        ERROR("failed to convert value, out of memory or invalid k-v type");
+        hash_map_release_converted(map, tmp, NULL);
+        return false;
+    }
+
+    if (found) {
+        /* keep the stored key, same as map_replace */
+        map->kvfree(tmp, map->entries[pos].value);
+        map->entries[pos].value = tmp_value;
+        return true;
+    }
+
+    /* slot may have moved after resize */
+    pos = hash_map_find_slot(map, key, hash, &found);
+    map->entries[pos].hash = hash;
+    map->entries[pos].key = tmp;
+    map->entries[pos].value = tmp_value;
+    map->size++;
+
+    return true;
+}
+
+bool hash_map_insert(hash_map_t *map, void *key, void *value)
+{
+    return hash_map_put(map, key, value, false);
+}
+
+bool hash_map_replace(hash_map_t *map, void *key, void *value)
+{
+    return hash_map_put(map, key, value, true);
+}
+
+bool hash_map_remove(hash_map_t *map, void *key)
+{
+    bool found = false;
+    size_t mask;
+    size_t hole;
+    size_t pos;
+    size_t home;
+
+    if (map == NULL || key == NULL) {
+        return false;
+    }
+
+    hole = hash_map_find_slot(map, key, hash_map_hash_key(map->type, key), &found);
+    if (!found) {
+        return false;
+    }
+
+    map->kvfree(map->entries[hole].key, map->entries[hole].value);
+    map->size--;
+
+    /* backward shift the following entries of the probe chain, no tombstones needed */
+    mask = map->capacity - 1;
+    pos = hole;
+    for (;;) {
+        pos = (pos + 1) & mask;
+        if (map->entries[pos].hash == 0) {
+            break;
+        }
+        home = map->entries[pos].hash & mask;
+        /* entry can be moved into hole only if its home slot is not in (hole, pos] */
+        if ((pos > hole && (home <= hole || home > pos)) || (pos < hole && (home <= hole && home > pos))) {
+            map->entries[hole] = map->entries[pos];
+            hole = pos;
+        }
+    }
+    map->entries[hole].hash = 0;
+    map->entries[hole].key = NULL;
+    map->entries[hole].value = NULL;
+
+    return true;
+}
+
+void *hash_map_search(const hash_map_t *map, void *key)
+{
+    bool found = false;
+    size_t pos;
+
+    if (map == NULL || key == NULL) {
+        return NULL;
+    }
+
+    pos = hash_map_find_slot(map, key, hash_map_hash_key(map->type, key), &found);
+
+    return found ? map->entries[pos].value : NULL;
+}
+
+size_t hash_map_size(const hash_map_t *map)
+{
+    if (map == NULL) {
+        return 0;
+    }
+
+    return map->size;
+}
+
+static void hash_map_itor_skip_empty(hash_map_itor *itor)
+{
+    while (itor->pos < itor->map->capacity && itor->map->entries[itor->pos].hash == 0) {
+        itor->pos++;
+    }
+}
+
+hash_map_itor *hash_map_itor_new(const hash_map_t *map)
+{
+    hash_map_itor *itor = NULL;
+
+    if (map == NULL) {
+        return NULL;
+    }
+
+    itor = util_common_calloc_s(sizeof(hash_map_itor));
+    if (itor == NULL) {
+        ERROR("Out of memory");
+        return NULL;
+    }
+    itor->map = map;
+    hash_map_itor_skip_empty(itor);
+
+    return itor;
+}
+
+void hash_map_itor_free(hash_map_itor *itor)
+{
+    free(itor);
+}
+
+bool hash_map_itor_first(hash_map_itor *itor)
+{
+    if (itor == NULL) {
+        return false;
+    }
+
+    itor->pos = 0;
+    hash_map_itor_skip_empty(itor);
+
+    return hash_map_itor_valid(itor);
+}
+
+bool hash_map_itor_next(hash_map_itor *itor)
+{
+    if (!hash_map_itor_valid(itor)) {
+        return false;
+    }
+
+    itor->pos++;
+    hash_map_itor_skip_empty(itor);
+
+    return hash_map_itor_valid(itor);
+}
+
+bool hash_map_itor_valid(const hash_map_itor *itor)
+{
+    if (itor == NULL) {
+        return false;
+    }
+
+    return itor->pos < itor->map->capacity;
+}
+
+void *hash_map_itor_key(const hash_map_itor *itor)
+{
+    if (!hash_map_itor_valid(itor)) {
+        return NULL;
+    }
+
+    return itor->map->entries[itor->pos].key;
+}
+
+void *hash_map_itor_value(const hash_map_itor *itor)
+{
+    if (!hash_map_itor_valid(itor)) {
+        return NULL;
+    }
+
+    return itor->map->entries[itor->pos].value;
+}
+
@@ -0,0 +1,100 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-03-25
+ * Description: provide open addressing hash map definition
+ ******************************************************************************/
+#ifndef __ISULAD_HASH_MAP_H__
+#define __ISULAD_HASH_MAP_H__
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "map.h"
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+/*
+ * hash_map_t has the same key/value semantics as map_t: string and int
+ * keys/values are copied, pointer keys/values are stored as is, and kvfree
+ * is called for every removed entry. Entries are kept in one flat array
+ * with linear probing, so there is no allocation per entry besides the
+ * copies of keys and values. Iteration order is unspecified.
+ */
+typedef struct hash_map_entry {
+    size_t hash;
+    void *key;
+    void *value;
+} hash_map_entry_t;
+
+typedef struct _hash_map_t {
+    map_type_t type;
+    map_kvfree_func kvfree;
+    hash_map_entry_t *entries;
+    size_t capacity;
+    size_t size;
+} hash_map_t;
+
+typedef struct hash_map_itor {
+    const hash_map_t *map;
+    size_t pos;
+} hash_map_itor;
+
+hash_map_t *hash_map_new(map_type_t kvtype, map_kvfree_func kvfree);
+
+void hash_map_free(hash_map_t *map);
+
+void hash_map_clear(hash_map_t *map);
+
+/* function to insert key value, fail if key exists */
+bool hash_map_insert(hash_map_t *map, void *key, void *value);
+
+/* function to insert or replace key value */
+bool hash_map_replace(hash_map_t *map, void *key, void *value);
+
+/* function to remove element by key */
+bool hash_map_remove(hash_map_t *map, void *key);
+
+/* function to search key */
+void *hash_map_search(const hash_map_t *map, void *key);
+
+/* function to get size of map */
+size_t hash_map_size(const hash_map_t *map);
+
+/* function to return map itor located at first element */
+hash_map_itor *hash_map_itor_new(const hash_map_t *map);
+
+/* function to free map itor */
+void hash_map_itor_free(hash_map_itor *itor);
+
+/* function to locate first map itor */
+bool hash_map_itor_first(hash_map_itor *itor);
+
+/* function to locate next itor */
+bool hash_map_itor_next(hash_map_itor *itor);
+
+/* function to check itor is valid */
+bool hash_map_itor_valid(const hash_map_itor *itor);
+
+/* function to get key of itor */
+void *hash_map_itor_key(const hash_map_itor *itor);
+
+/* function to get value of itor */
+void *hash_map_itor_value(const hash_map_itor *itor);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif
+
+#endif /* __ISULAD_HASH_MAP_H__ */
+
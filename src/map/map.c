@@ -187,14 +187,33 @@ static bool is_val_ptr(map_type_t type)
     return (type == MAP_INT_PTR || type == MAP_STR_PTR || type == MAP_PTR_PTR);
 }
 
-static void *map_convert_key(const map_t *map, void *key)
+/* is key of the map type stored without copy */
+bool map_type_key_is_ptr(map_type_t type)
+{
+    return is_key_ptr(type);
+}
+
+/* is value of the map type stored without copy */
+bool map_type_val_is_ptr(map_type_t type)
+{
+    return is_val_ptr(type);
+}
+
+/* is key of the map type a string */
+bool map_type_key_is_str(map_type_t type)
+{
+    return is_key_str(type);
+}
+
+/* copy key according to the key type of map, pointer keys are not copied */
+void *map_type_convert_key(map_type_t type, void *key)
 {
     void *insert_key = NULL;
     int *ikey = NULL;
     char *skey = NULL;
-    if (is_key_ptr(map->type)) {
+    if (is_key_ptr(type)) {
         insert_key = key;
-    } else if (is_key_int(map->type)) {
+    } else if (is_key_int(type)) {
         ikey = util_common_calloc_s(sizeof(int));
         if (ikey == NULL) {
             ERROR("out of memory");
@@ -202,7 +221,7 @@ static void *map_convert_key(const map_t *map, void *key)
         }
         *ikey = *(int *)key;
         insert_key = (void *)ikey;
-    } else if (is_key_str(map->type)) {
+    } else if (is_key_str(type)) {
         skey = util_strdup_s((const char *)key);
         if (skey == NULL) {
             ERROR("out of memory");
@@ -215,29 +234,30 @@ static void *map_convert_key(const map_t *map, void *key)
     return insert_key;
 }
 
-static void *map_convert_value(const map_t *map, void *value)
+/* copy value according to the value type of map, pointer values are not copied */
+void *map_type_convert_value(map_type_t type, void *value)
 {
     void *insert_value = NULL;
     bool *bvalue = NULL;
     int *ivalue = NULL;
     char *svalue = NULL;
-    if (is_val_ptr(map->type)) {
+    if (is_val_ptr(type)) {
         insert_value = value;
-    } else if (is_val_bool(map->type)) {
+    } else if (is_val_bool(type)) {
         bvalue = util_common_calloc_s(sizeof(bool));
         if (bvalue == NULL) {
             return NULL;
         }
         *bvalue = *(bool *)value;
         insert_value = (void *)bvalue;
-    } else if (is_val_int(map->type)) {
+    } else if (is_val_int(type)) {
         ivalue = util_common_calloc_s(sizeof(int));
         if (ivalue == NULL) {
             return NULL;
         }
         *ivalue = *(int *)value;
         insert_value = (void *)ivalue;
-    } else if (is_val_str(map->type)) {
+    } else if (is_val_str(type)) {
         svalue = util_strdup_s((const char *)value);
         insert_value = (void *)svalue;
     } else {
@@ -246,6 +266,16 @@ static void *map_convert_value(const map_t *map, void *value)
     return insert_value;
 }
 
+static void *map_convert_key(const map_t *map, void *key)
+{
+    return map_type_convert_key(map->type, key);
+}
+
+static void *map_convert_value(const map_t *map, void *value)
+{
+    return map_type_convert_value(map->type, value);
+}
+
 /* function to replace key value */
 bool map_replace(const map_t *map, void *key, void *value)
 {
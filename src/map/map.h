@@ -99,6 +99,17 @@ void map_free(map_t *map);
 
 void map_clear(map_t *map);
 
+/* helpers shared with other map implementations, such as hash_map_t */
+bool map_type_key_is_ptr(map_type_t type);
+
+bool map_type_val_is_ptr(map_type_t type);
+
+bool map_type_key_is_str(map_type_t type);
+
+void *map_type_convert_key(map_type_t type, void *key);
+
+void *map_type_convert_value(map_type_t type, void *value);
+
 #if defined(__cplusplus) || defined(c_plusplus)
 }
 #endif
@@ -0,0 +1,364 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-03-23
+ * Description: provide radix tree functions for string prefix lookup
+ ******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+
+#include "radix_tree.h"
+#include "log.h"
+#include "utils.h"
+
+static radix_node_t *radix_node_new(const char *label, size_t label_len)
+{
+    radix_node_t *node = NULL;
+
+    node = util_common_calloc_s(sizeof(radix_node_t));
+    if (node == NULL) {
+        ERROR("Out of memory");
+        return NULL;
+    }
+
+    if (label_len > 0) {
+        node->label = util_common_calloc_s(label_len);
+        if (node->label == NULL) {
+            ERROR("Out of memory");
+            free(node);
+            return NULL;
+        }
+        (void)memcpy(node->label, label, label_len);
+        node->label_len = label_len;
+    }
+
+    return node;
+}
+
+static void radix_node_free(radix_node_t *node)
+{
+    radix_node_t *child = NULL;
+    radix_node_t *next = NULL;
+
+    if (node == NULL) {
+        return;
+    }
+
+    for (child = node->children; child != NULL; child = next) {
+        next = child->sibling;
+        radix_node_free(child);
+    }
+    free(node->label);
+    free(node);
+}
+
+static radix_node_t *radix_node_find_child(const radix_node_t *node, char c)
+{
+    radix_node_t *child = NULL;
+
+    for (child = node->children; child != NULL; child = child->sibling) {
+        if (child->label[0] == c) {
+            return child;
+        }
+    }
+
+    return NULL;
+}
+
+static void radix_node_add_child(radix_node_t *node, radix_node_t *child)
+{
+    child->parent = node;
+    child->sibling = node->children;
+    node->children = child;
+}
+
+static void radix_node_del_child(radix_node_t *node, const radix_node_t *child)
+{
+    radix_node_t **pprev = NULL;
+
+    for (pprev = &node->children; *pprev != NULL; pprev = &(*pprev)->sibling) {
+        if (*pprev == child) {
+            *pprev = child->sibling;
+            return;
+        }
+    }
+}
+
+static size_t common_prefix_len(const char *label, size_t label_len, const char *key)
+{
+    size_t i = 0;
+
+    while (i < label_len && key[i] != '\0' && label[i] == key[i]) {
+        i++;
+    }
+
+    return i;
+}
+
+/* split child at offset, return the new node which holds child's label[0, offset) */
+static radix_node_t *radix_node_split(radix_node_t *child, size_t offset)
+{
+    char *rest = NULL;
+    radix_node_t *mid = NULL;
+    radix_node_t *parent = child->parent;
+
+    mid = radix_node_new(child->label, offset);
+    if (mid == NULL) {
+        return NULL;
+    }
+    rest = util_common_calloc_s(child->label_len - offset);
+    if (rest == NULL) {
+        ERROR("Out of memory");
+        radix_node_free(mid);
+        return NULL;
+    }
+    (void)memcpy(rest, child->label + offset, child->label_len - offset);
+
+    radix_node_del_child(parent, child);
+    free(child->label);
+    child->label = rest;
+    child->label_len -= offset;
+    child->sibling = NULL;
+
+    mid->count = child->count;
+    radix_node_add_child(mid, child);
+    radix_node_add_child(parent, mid);
+
+    return mid;
+}
+
+/* find the node which exactly matches key */
+static radix_node_t *radix_tree_find(const radix_tree_t *tree, const char *key)
+{
+    size_t pos = 0;
+    radix_node_t *node = tree->root;
+    radix_node_t *child = NULL;
+
+    while (key[pos] != '\0') {
+        child = radix_node_find_child(node, key[pos]);
+        if (child == NULL || common_prefix_len(child->label, child->label_len, key + pos) != child->label_len) {
+            return NULL;
+        }
+        pos += child->label_len;
+        node = child;
+    }
+
+    return node->has_value ? node : NULL;
+}
+
+radix_tree_t *radix_tree_new(void)
+{
+    radix_tree_t *tree = NULL;
+
+    tree = util_common_calloc_s(sizeof(radix_tree_t));
+    if (tree == NULL) {
+        ERROR("Out of memory");
+        return NULL;
+    }
+    tree->root = radix_node_new(NULL, 0);
+    if (tree->root == NULL) {
+        free(tree);
+        return NULL;
+    }
+
+    return tree;
+}
+
+void radix_tree_free(radix_tree_t *tree)
+{
+    if (tree == NULL) {
+        return;
+    }
+
+    radix_node_free(tree->root);
+    free(tree);
+}
+
+bool radix_tree_insert(radix_tree_t *tree, const char *key, void *value)
+{
+    size_t pos = 0;
+    size_t common = 0;
+    radix_node_t *node = NULL;
+    radix_node_t *child = NULL;
+
+    if (tree == NULL || key == NULL || key[0] == '\0') {
+        return false;
+    }
+
+    if (radix_tree_find(tree, key) != NULL) {
+        return false;
+    }
+
+    node = tree->root;
+    while (key[pos] != '\0') {
+        child = radix_node_find_child(node, key[pos]);
+        if (child == NULL) {
+            child = radix_node_new(key + pos, strlen(key + pos));
+            if (child == NULL) {
+                return false;
+            }
+            radix_node_add_child(node, child);
+            node = child;
+            break;
+        }
+
+        common = common_prefix_len(child->label, child->label_len, key + pos);
+        if (common < child->label_len) {
+            child = radix_node_split(child, common);
+            if (child == NULL) {
+                return false;
+            }
+        }
+        pos += common;
+        node = child;
+    }
+
+    node->has_value = true;
+    node->value = value;
+
+    for (; node != NULL; node = node->parent) {
+        node->count++;
+    }
+
+    return true;
+}
+
+/* merge node with its only child if node does not hold a value itself */
+static void radix_node_compact(radix_node_t *node)
+{
+    char *label = NULL;
+    radix_node_t *child = node->children;
+    radix_node_t *grandchild = NULL;
+
+    if (node->parent == NULL || node->has_value || child == NULL || child->sibling != NULL) {
+        return;
+    }
+
+    label = util_common_calloc_s(node->label_len + child->label_len);
+    if (label == NULL) {
+        /* keep the tree uncompacted, it is still valid */
+        return;
+    }
+    (void)memcpy(label, node->label, node->label_len);
+    (void)memcpy(label + node->label_len, child->label, child->label_len);
+
+    free(node->label);
+    node->label = label;
+    node->label_len += child->label_len;
+    node->has_value = child->has_value;
+    node->value = child->value;
+    node->children = child->children;
+    for (grandchild = node->children; grandchild != NULL; grandchild = grandchild->sibling) {
+        grandchild->parent = node;
+    }
+
+    free(child->label);
+    free(child);
+}
+
+bool radix_tree_remove(radix_tree_t *tree, const char *key)
+{
+    radix_node_t *node = NULL;
+    radix_node_t *parent = NULL;
+    radix_node_t *iter = NULL;
+
+    if (tree == NULL || key == NULL) {
+        return false;
+    }
+
+    node = radix_tree_find(tree, key);
+    if (node == NULL) {
+        return false;
+    }
+
+    node->has_value = false;
+    node->value = NULL;
+    for (iter = node; iter != NULL; iter = iter->parent) {
+        iter->count--;
+    }
+
+    parent = node->parent;
+    if (node->children == NULL) {
+        radix_node_del_child(parent, node);
+        radix_node_free(node);
+        radix_node_compact(parent);
+    } else {
+        radix_node_compact(node);
+    }
+
+    return true;
+}
+
+void *radix_tree_search(const radix_tree_t *tree, const char *key)
+{
+    radix_node_t *node = NULL;
+
+    if (tree == NULL || key == NULL) {
+        return NULL;
+    }
+
+    node = radix_tree_find(tree, key);
+    return node != NULL ? node->value : NULL;
+}
+
+radix_prefix_result_t radix_tree_search_prefix(const radix_tree_t *tree, const char *prefix, void **value)
+{
+    size_t pos = 0;
+    size_t common = 0;
+    radix_node_t *node = NULL;
+    radix_node_t *child = NULL;
+
+    if (tree == NULL || prefix == NULL || value == NULL) {
+        return RADIX_PREFIX_NOT_FOUND;
+    }
+
+    node = tree->root;
+    while (prefix[pos] != '\0') {
+        child = radix_node_find_child(node, prefix[pos]);
+        if (child == NULL) {
+            return RADIX_PREFIX_NOT_FOUND;
+        }
+        common = common_prefix_len(child->label, child->label_len, prefix + pos);
+        node = child;
+        pos += common;
+        if (common < child->label_len) {
+            if (prefix[pos] != '\0') {
+                return RADIX_PREFIX_NOT_FOUND;
+            }
+            break;
+        }
+    }
+
+    if (node->count == 0) {
+        return RADIX_PREFIX_NOT_FOUND;
+    }
+    if (node->count > 1) {
+        return RADIX_PREFIX_AMBIGUOUS;
+    }
+
+    /* only one value in the subtree, and empty nodes are always pruned */
+    while (!node->has_value) {
+        node = node->children;
+    }
+    *value = node->value;
+
+    return RADIX_PREFIX_UNIQUE;
+}
+
+size_t radix_tree_size(const radix_tree_t *tree)
+{
+    if (tree == NULL) {
+        return 0;
+    }
+
+    return tree->root->count;
+}
+
@@ -0,0 +1,62 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-03-23
+ * Description: provide radix tree definition for string prefix lookup
+ ******************************************************************************/
+#ifndef __RADIX_TREE_H_
+#define __RADIX_TREE_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+typedef struct radix_node {
+    /* label of the edge from parent to this node, not nul terminated */
+    char *label;
+    size_t label_len;
+    bool has_value;
+    void *value;
+    /* number of values stored in the subtree of this node */
+    size_t count;
+    struct radix_node *parent;
+    struct radix_node *children;
+    struct radix_node *sibling;
+} radix_node_t;
+
+typedef struct radix_tree {
+    radix_node_t *root;
+} radix_tree_t;
+
+typedef enum {
+    RADIX_PREFIX_NOT_FOUND = 0,
+    RADIX_PREFIX_UNIQUE,
+    RADIX_PREFIX_AMBIGUOUS
+} radix_prefix_result_t;
+
+/* values are borrowed, tree never frees them */
+radix_tree_t *radix_tree_new(void);
+void radix_tree_free(radix_tree_t *tree);
+bool radix_tree_insert(radix_tree_t *tree, const char *key, void *value);
+bool radix_tree_remove(radix_tree_t *tree, const char *key);
+void *radix_tree_search(const radix_tree_t *tree, const char *key);
+radix_prefix_result_t radix_tree_search_prefix(const radix_tree_t *tree, const char *prefix, void **value);
+size_t radix_tree_size(const radix_tree_t *tree);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif
+
+#endif /* __RADIX_TREE_H_ */
+
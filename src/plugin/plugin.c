@@ -31,6 +31,7 @@
 #include "specs.h"
 #include "specs_extend.h"
 #include "rest_common.h"
+#include "http_pool.h"
 #include "containers_store.h"
 #include "constants.h"
 
@@ -55,6 +56,9 @@
 
 #define PLUGIN_ACTIVATE_MAX_RETRY 3
 
+/* latency of a plugin is logged every PLUGIN_LATENCY_LOG_INTERVAL requests */
+#define PLUGIN_LATENCY_LOG_INTERVAL 1000
+
 #ifndef RestHttpHead
 #define RestHttpHead "http://localhost"
 #endif
@@ -65,11 +69,18 @@
 #define PluginServicePostStop "/PluginService/PostStop"
 #define PluginServicePostRemove "/PluginService/PostRemove"
 
-static int pm_init_plugin(const plugin_t *plugin);
+/* one request to a plugin, body is owned by caller */
+typedef struct plugin_call {
+    plugin_t *plugin;
+    const char *url;
+    const char *body;
+    unpack_response_func_t unpack;
+    void *arg;
+} plugin_call_t;
+
+static int pm_init_plugin(plugin_t *plugin);
 
-static int plugin_event_pre_start_handle(const plugin_t *plugin, const char *cid);
-static int plugin_event_post_stop_handle(const plugin_t *plugin, const char *cid);
-static int plugin_event_post_remove_handle(const plugin_t *plugin, const char *cid);
+static char *plugin_event_request_generate(uint64_t pe, const char *cid, plugin_call_t *call);
 
 enum plugin_action { ACTIVE_PLUGIN, DEACTIVE_PLUGIN };
 
@@ -429,11 +440,44 @@ static void pm_unlock(void)
     }
 }
 
+/* log latency summary and the non empty buckets of histogram */
+static void plugin_log_latency(const char *name, const plugin_latency_t *latency)
+{
+    size_t i;
+    int nret;
+    size_t len = 0;
+    char histogram[PLUGIN_LATENCY_BUCKETS * 32] = { 0 };
+
+    for (i = 0; i < PLUGIN_LATENCY_BUCKETS; i++) {
+        if (latency->buckets[i] == 0) {
+            continue;
+        }
+        if (i == PLUGIN_LATENCY_BUCKETS - 1) {
+            nret = snprintf(histogram + len, sizeof(histogram) - len, " >=%lums:%lu",
+                            (unsigned long)(1UL << (i - 1)), (unsigned long)latency->buckets[i]);
+        } else {
+            nret = snprintf(histogram + len, sizeof(histogram) - len, " <%lums:%lu", (unsigned long)(1UL << i),
+                            (unsigned long)latency->buckets[i]);
+        }
+        if (nret < 0 || (size_t)nret >= sizeof(histogram) - len) {
+            break;
+        }
+        len += (size_t)nret;
+    }
+
+    INFO("plugin %s served %lu requests, %lu failed, average %lu us, max %lu us, histogram:%s", name,
+         (unsigned long)latency->count, (unsigned long)latency->failed,
+         (unsigned long)(latency->total_us / latency->count), (unsigned long)latency->max_us, histogram);
+}
+
 static void free_plugin(plugin_t *plugin)
 {
     if (plugin == NULL) {
         return;
     }
+    if (plugin->latency.count > 0) {
+        plugin_log_latency(plugin->name, &plugin->latency);
+    }
     UTIL_FREE_AND_SET_NULL(plugin->name);
     UTIL_FREE_AND_SET_NULL(plugin->addr);
     UTIL_FREE_AND_SET_NULL(plugin->manifest);
@@ -840,6 +884,93 @@ bool plugin_is_watching(plugin_t *plugin, uint64_t pe)
     return ok;
 }
 
+static void plugin_record_latency(plugin_t *plugin, uint64_t elapsed_us, bool failed)
+{
+    size_t i = 0;
+    bool need_log = false;
+    plugin_latency_t snapshot;
+    uint64_t ms = elapsed_us / 1000;
+    plugin_latency_t *latency = &plugin->latency;
+
+    while (i < PLUGIN_LATENCY_BUCKETS - 1 && ms >= (1ULL << i)) {
+        i++;
+    }
+
+    plugin_wrlock(plugin);
+    latency->count++;
+    if (failed) {
+        latency->failed++;
+    }
+    latency->total_us += elapsed_us;
+    if (elapsed_us > latency->max_us) {
+        latency->max_us = elapsed_us;
+    }
+    latency->buckets[i]++;
+    if (latency->count % PLUGIN_LATENCY_LOG_INTERVAL == 0) {
+        snapshot = *latency;
+        need_log = true;
+    }
+    plugin_unlock(plugin);
+
+    if (need_log) {
+        plugin_log_latency(plugin->name, &snapshot);
+    }
+}
+
+/*
+ * send requests to plugins in parallel over kept-alive connections, responses
+ * are unpacked in caller thread one by one, so unpack may set error message.
+ */
+static int plugin_calls_run(const plugin_call_t *calls, size_t count)
+{
+    int ret = 0;
+    size_t i;
+    struct http_pool_request *reqs = NULL;
+
+    if (count == 0) {
+        return 0;
+    }
+    if (count > SIZE_MAX / sizeof(struct http_pool_request)) {
+        ERROR("Too many plugin requests");
+        return -1;
+    }
+    reqs = util_common_calloc_s(count * sizeof(struct http_pool_request));
+    if (reqs == NULL) {
+        ERROR("Out of memory");
+        return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        reqs[i].url = calls[i].url;
+        reqs[i].unix_socket_path = calls[i].plugin->addr;
+        reqs[i].body = calls[i].body;
+        reqs[i].body_len = strlen(calls[i].body) + 1;
+    }
+
+    (void)http_pool_perform(reqs, count);
+
+    for (i = 0; i < count; i++) {
+        plugin_record_latency(calls[i].plugin, reqs[i].elapsed_us, reqs[i].result != 0);
+        if (reqs[i].result != 0) {
+            ERROR("send request %s to %s failed", calls[i].url, calls[i].plugin->addr);
+            ret = -1;
+            continue;
+        }
+        DEBUG("plugin %s request %s took %lu us", calls[i].plugin->name, calls[i].url,
+              (unsigned long)reqs[i].elapsed_us);
+        if (get_response(reqs[i].output, calls[i].unpack, calls[i].arg) != 0) {
+            ERROR("unpack response of %s from %s failed", calls[i].url, calls[i].plugin->addr);
+            ret = -1;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        buffer_free(reqs[i].output);
+    }
+    free(reqs);
+    return ret;
+}
+
 static int unpack_activate_response(const struct parsed_http_message *message, void *arg)
 {
     int ret = 0;
@@ -880,19 +1011,16 @@ out:
 int pm_activate_plugin(plugin_t *plugin)
 {
     int ret = 0;
-    int nret = 0;
     plugin_activate_plugin_request reqs = { 0 };
     char *body = NULL;
-    size_t body_len = 0;
     struct parser_context ctx = {
         OPT_GEN_SIMPLIFY,
         0,
     };
     parser_error err = NULL;
-    Buffer *output = NULL;
     char *errmsg = NULL;
     plugin_manifest_t manifest = { 0 };
-    char socket[PATH_MAX] = { 0 };
+    plugin_call_t call = { 0 };
 
     body = plugin_activate_plugin_request_generate_json(&reqs, &ctx, &err);
     if (body == NULL) {
@@ -901,23 +1029,14 @@ int pm_activate_plugin(plugin_t *plugin)
         goto out;
     }
 
-    body_len = strlen(body) + 1;
-    nret = snprintf(socket, PATH_MAX, "unix://%s", plugin->addr);
-    if (nret < 0 || nret >= PATH_MAX) {
-        ERROR("get plugin socket failed");
-        ret = -1;
-        goto out;
-    }
-
-    ret = rest_send_requst(socket, RestHttpHead PluginServiceActivate, body, body_len, &output);
-    if (ret != 0) {
-        ERROR("send activate request to %s failed", plugin->addr);
-        goto out;
-    }
-
-    ret = get_response(output, unpack_activate_response, (void *)(&manifest));
+    call.plugin = plugin;
+    call.url = RestHttpHead PluginServiceActivate;
+    call.body = body;
+    call.unpack = unpack_activate_response;
+    call.arg = (void *)(&manifest);
+    ret = plugin_calls_run(&call, 1);
     if (ret != 0) {
-        ERROR("unpack activate response from %s failed", plugin->addr);
+        ERROR("activate plugin %s failed", plugin->addr);
         goto out;
     }
 
@@ -925,7 +1044,6 @@ out:
     plugin_set_activated(plugin, ret == 0, errmsg);
     plugin_set_manifest(plugin, &manifest);
 
-    buffer_free(output);
     free(err);
     free(body);
 
@@ -1071,22 +1189,19 @@ out:
     return ret;
 }
 
-static int pm_init_plugin(const plugin_t *plugin)
+static int pm_init_plugin(plugin_t *plugin)
 {
     int ret = 0;
-    int nret = 0;
     char **cnames = NULL;
     size_t container_num = 0;
     plugin_init_plugin_request reqs = { 0 };
     char *body = NULL;
-    size_t body_len = 0;
     struct parser_context ctx = {
         OPT_GEN_SIMPLIFY,
         0,
     };
     parser_error err = NULL;
-    Buffer *output = NULL;
-    char socket[PATH_MAX] = { 0 };
+    plugin_call_t call = { 0 };
     size_t i = 0;
 
     cnames = containers_store_list_ids();
@@ -1128,27 +1243,17 @@ static int pm_init_plugin(const plugin_t *plugin)
         goto out;
     }
 
-    body_len = strlen(body) + 1;
-    nret = snprintf(socket, PATH_MAX, "unix://%s", plugin->addr);
-    if (nret < 0 || nret >= PATH_MAX) {
-        ERROR("get plugin socket failed %s", plugin->addr);
-        ret = -1;
-        goto out;
-    }
-    ret = rest_send_requst(socket, RestHttpHead PluginServiceInit, body, body_len, &output);
+    call.plugin = plugin;
+    call.url = RestHttpHead PluginServiceInit;
+    call.body = body;
+    call.unpack = unpack_init_response;
+    ret = plugin_calls_run(&call, 1);
     if (ret != 0) {
         ret = -1;
         ERROR("plugin init request to %s failed", plugin->addr);
         goto out;
     }
 
-    ret = get_response(output, unpack_init_response, NULL);
-    if (ret != 0) {
-        ret = -1;
-        ERROR("unpack plugin init response from %s failed", plugin->addr);
-        goto out;
-    }
-
 out:
     util_free_array(cnames);
     cnames = NULL;
@@ -1159,8 +1264,6 @@ out:
     }
     UTIL_FREE_AND_SET_NULL(reqs.containers);
 
-    buffer_free(output);
-
     free(err);
     free(body);
     return ret;
@@ -1318,20 +1421,37 @@ bad:
     return -1;
 }
 
+/* events except pre-create do not depend on each other, send them to all plugins in parallel */
 static int plugin_event_handle_dispath_impl(const char *cid, const char *plugins, uint64_t pe)
 {
     int ret = 0;
     plugin_t *plugin = NULL;
     char **pnames = NULL;
+    char **bodies = NULL;
+    plugin_call_t *calls = NULL;
+    size_t pnames_len = 0;
+    size_t count = 0;
     size_t i = 0;
 
     pnames = get_enable_plugins(plugins);
     if (pnames == NULL) {
         goto out;
     }
+    pnames_len = util_array_len((const char **)pnames);
+    if (pnames_len == 0) {
+        goto out;
+    }
+
+    calls = util_common_calloc_s(pnames_len * sizeof(plugin_call_t));
+    bodies = util_common_calloc_s(pnames_len * sizeof(char *));
+    if (calls == NULL || bodies == NULL) {
+        ERROR("Out of memory");
+        ret = -1;
+        goto out;
+    }
 
     pm_rdlock();
-    for (i = 0; i < util_array_len((const char **)pnames); i++) {
+    for (i = 0; i < pnames_len; i++) {
         if (pm_get_plugin(pnames[i], &plugin)) { /* plugin not found */
             ERROR("plugin %s not registered.", pnames[i]);
             ret = -1;
@@ -1342,31 +1462,31 @@ static int plugin_event_handle_dispath_impl(const char *cid, const char *plugins
             continue;
         }
 
-        switch (pe) {
-            case PLUGIN_EVENT_CONTAINER_PRE_START:
-                ret = plugin_event_pre_start_handle(plugin, cid);
-                break;
-            case PLUGIN_EVENT_CONTAINER_POST_STOP:
-                ret = plugin_event_post_stop_handle(plugin, cid);
-                break;
-            case PLUGIN_EVENT_CONTAINER_POST_REMOVE:
-                ret = plugin_event_post_remove_handle(plugin, cid);
-                break;
-            default:
-                ERROR("plugin event %d not support.", pe);
-                ret = -1;
-                break;
-        }
-
-        pm_put_plugin(plugin);
-        if (ret != 0) {
+        bodies[count] = plugin_event_request_generate(pe, cid, &calls[count]);
+        if (bodies[count] == NULL) {
+            ERROR("marshal event 0x%lx request to %s failed", (unsigned long)pe, plugin->addr);
+            pm_put_plugin(plugin);
             ret = -1;
             continue;
         }
+        calls[count].plugin = plugin;
+        calls[count].body = bodies[count];
+        count++;
+    }
+
+    if (plugin_calls_run(calls, count) != 0) {
+        ret = -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        pm_put_plugin(calls[i].plugin);
+        free(bodies[i]);
     }
     pm_unlock();
 
 out:
+    free(calls);
+    free(bodies);
     util_free_array(pnames);
     return ret;
 }
@@ -1442,21 +1562,18 @@ out:
     return ret;
 }
 
-static int plugin_event_pre_create_handle(const plugin_t *plugin, const char *cid, char **base)
+static int plugin_event_pre_create_handle(plugin_t *plugin, const char *cid, char **base)
 {
     int ret = 0;
-    int nret = 0;
     char *body = NULL;
-    size_t body_len = 0;
     struct parser_context ctx = {
         OPT_GEN_SIMPLIFY,
         0,
     };
     parser_error err = NULL;
-    Buffer *output = NULL;
     char *dst = NULL;
     char *new = NULL;
-    char socket[PATH_MAX] = { 0 };
+    plugin_call_t call = { 0 };
     plugin_event_pre_create_request reqs = { 0 };
 
     reqs.id = (char *)cid;
@@ -1469,25 +1586,16 @@ static int plugin_event_pre_create_handle(const plugin_t *plugin, const char *ci
         goto out;
     }
 
-    body_len = strlen(body) + 1;
-    nret = snprintf(socket, sizeof(socket), "unix://%s", plugin->addr);
-    if (nret < 0 || (size_t)nret >= sizeof(socket)) {
-        ERROR("get plugin socket failed %s", plugin->addr);
-        ret = -1;
-        goto out;
-    }
-
-    ret = rest_send_requst(socket, RestHttpHead PluginServicePreCreate, body, body_len, &output);
+    /* every plugin updates pspec of the previous one, so pre-create is sent one by one */
+    call.plugin = plugin;
+    call.url = RestHttpHead PluginServicePreCreate;
+    call.body = body;
+    call.unpack = unpack_event_pre_create_response;
+    call.arg = (void *)(&new);
+    ret = plugin_calls_run(&call, 1);
     if (ret != 0) {
         ret = -1;
-        ERROR("send event precreate request to %s failed", plugin->addr);
-        goto out;
-    }
-
-    ret = get_response(output, unpack_event_pre_create_response, (void *)(&new));
-    if (ret != 0) {
-        ret = -1;
-        ERROR("unpack event precreate response from %s failed", plugin->addr);
+        ERROR("event precreate request to %s failed", plugin->addr);
         goto out;
     }
 
@@ -1505,7 +1613,6 @@ static int plugin_event_pre_create_handle(const plugin_t *plugin, const char *ci
 out:
     free(dst);
     free(new);
-    buffer_free(output);
     free(err);
     free(body);
     return ret;
@@ -1618,60 +1725,6 @@ out:
     return ret;
 }
 
-static int plugin_event_pre_start_handle(const plugin_t *plugin, const char *cid)
-{
-    int ret = 0;
-    int nret = 0;
-    char *body = NULL;
-    size_t body_len = 0;
-    struct parser_context ctx = {
-        OPT_GEN_SIMPLIFY,
-        0,
-    };
-    parser_error err = NULL;
-    Buffer *output = NULL;
-    char socket[PATH_MAX] = { 0 };
-    plugin_event_pre_start_request reqs = { 0 };
-
-    reqs.id = (char *)cid;
-
-    body = plugin_event_pre_start_request_generate_json(&reqs, &ctx, &err);
-    if (body == NULL) {
-        ERROR("marshal event prestart request to %s failed", plugin->addr);
-        ret = -1;
-        goto out;
-    }
-
-    body_len = strlen(body) + 1;
-    nret = snprintf(socket, sizeof(socket), "unix://%s", plugin->addr);
-    if (nret < 0 || (size_t)nret >= sizeof(socket)) {
-        ERROR("get plugin socket failed %s", plugin->addr);
-        ret = -1;
-        goto out;
-    }
-
-    ret = rest_send_requst(socket, RestHttpHead PluginServicePreStart, body, body_len, &output);
-    if (ret != 0) {
-        ret = -1;
-        ERROR("send event prestart request to %s failed", plugin->addr);
-        goto out;
-    }
-
-    ret = get_response(output, unpack_event_pre_start_response, NULL);
-    if (ret != 0) {
-        ret = -1;
-        ERROR("unpack event prestart response from %s failed", plugin->addr);
-        goto out;
-    }
-
-out:
-    buffer_free(output);
-
-    free(err);
-    free(body);
-    return ret;
-}
-
 int plugin_event_container_pre_start(const container_t *cont)
 {
     if (cont == NULL) {
@@ -1718,59 +1771,6 @@ out:
     return ret;
 }
 
-static int plugin_event_post_stop_handle(const plugin_t *plugin, const char *cid)
-{
-    int ret = 0;
-    int nret = 0;
-    char *body = NULL;
-    size_t body_len = 0;
-    struct parser_context ctx = {
-        OPT_GEN_SIMPLIFY,
-        0,
-    };
-    parser_error err = NULL;
-    Buffer *output = NULL;
-    char socket[PATH_MAX] = { 0 };
-    plugin_event_post_stop_request reqs = { 0 };
-
-    reqs.id = (char *)cid;
-
-    body = plugin_event_post_stop_request_generate_json(&reqs, &ctx, &err);
-    if (body == NULL) {
-        ERROR("marshal event post_stop request to %s failed", plugin->addr);
-        ret = -1;
-        goto out;
-    }
-
-    body_len = strlen(body) + 1;
-    nret = snprintf(socket, sizeof(socket), "unix://%s", plugin->addr);
-    if (nret < 0 || (size_t)nret >= sizeof(socket)) {
-        ERROR("get plugin socket failed %s", plugin->addr);
-        ret = -1;
-        goto out;
-    }
-
-    ret = rest_send_requst(socket, RestHttpHead PluginServicePostStop, body, body_len, &output);
-    if (ret != 0) {
-        ret = -1;
-        ERROR("send event post_stop request to %s failed", plugin->addr);
-        goto out;
-    }
-
-    ret = get_response(output, unpack_event_post_stop_response, NULL);
-    if (ret != 0) {
-        ret = -1;
-        ERROR("unpack event post_stop response from %s failed", plugin->addr);
-        goto out;
-    }
-
-out:
-    buffer_free(output);
-    free(err);
-    free(body);
-    return ret;
-}
-
 int plugin_event_container_post_stop(const container_t *cont)
 {
     if (cont == NULL) {
@@ -1817,59 +1817,6 @@ out:
     return ret;
 }
 
-static int plugin_event_post_remove_handle(const plugin_t *plugin, const char *cid)
-{
-    int ret = 0;
-    int nret = 0;
-    char *body = NULL;
-    size_t body_len = 0;
-    struct parser_context ctx = {
-        OPT_GEN_SIMPLIFY,
-        0,
-    };
-    parser_error err = NULL;
-    Buffer *output = NULL;
-    char socket[PATH_MAX] = { 0 };
-    plugin_event_post_remove_request reqs = { 0 };
-
-    reqs.id = (char *)cid;
-
-    body = plugin_event_post_remove_request_generate_json(&reqs, &ctx, &err);
-    if (body == NULL) {
-        ERROR("marshal event post_remove request to %s failed", plugin->addr);
-        ret = -1;
-        goto out;
-    }
-
-    body_len = strlen(body) + 1;
-    nret = snprintf(socket, sizeof(socket), "unix://%s", plugin->addr);
-    if (nret < 0 || (size_t)nret >= sizeof(socket)) {
-        ERROR("get plugin socket failed %s", plugin->addr);
-        ret = -1;
-        goto out;
-    }
-
-    ret = rest_send_requst(socket, RestHttpHead PluginServicePostRemove, body, body_len, &output);
-    if (ret != 0) {
-        ret = -1;
-        ERROR("send event post_remove request to %s failed", plugin->addr);
-        goto out;
-    }
-
-    ret = get_response(output, unpack_event_post_remove_response, NULL);
-    if (ret != 0) {
-        ret = -1;
-        ERROR("unpack event post_remove response from %s failed", plugin->addr);
-        goto out;
-    }
-
-out:
-    buffer_free(output);
-    free(err);
-    free(body);
-    return ret;
-}
-
 int plugin_event_container_post_remove(const container_t *cont)
 {
     if (cont == NULL) {
@@ -1916,3 +1863,42 @@ out:
     return ret;
 }
 
+static char *plugin_event_request_generate(uint64_t pe, const char *cid, plugin_call_t *call)
+{
+    char *body = NULL;
+    struct parser_context ctx = {
+        OPT_GEN_SIMPLIFY,
+        0,
+    };
+    parser_error err = NULL;
+    plugin_event_pre_start_request pre_start = { 0 };
+    plugin_event_post_stop_request post_stop = { 0 };
+    plugin_event_post_remove_request post_remove = { 0 };
+
+    switch (pe) {
+        case PLUGIN_EVENT_CONTAINER_PRE_START:
+            pre_start.id = (char *)cid;
+            body = plugin_event_pre_start_request_generate_json(&pre_start, &ctx, &err);
+            call->url = RestHttpHead PluginServicePreStart;
+            call->unpack = unpack_event_pre_start_response;
+            break;
+        case PLUGIN_EVENT_CONTAINER_POST_STOP:
+            post_stop.id = (char *)cid;
+            body = plugin_event_post_stop_request_generate_json(&post_stop, &ctx, &err);
+            call->url = RestHttpHead PluginServicePostStop;
+            call->unpack = unpack_event_post_stop_response;
+            break;
+        case PLUGIN_EVENT_CONTAINER_POST_REMOVE:
+            post_remove.id = (char *)cid;
+            body = plugin_event_post_remove_request_generate_json(&post_remove, &ctx, &err);
+            call->url = RestHttpHead PluginServicePostRemove;
+            call->unpack = unpack_event_post_remove_response;
+            break;
+        default:
+            ERROR("plugin event %lu not support.", (unsigned long)pe);
+            break;
+    }
+
+    free(err);
+    return body;
+}
@@ -46,6 +46,20 @@ typedef struct plugin_manifest {
     uint64_t watch_event;
 } plugin_manifest_t;
 
+#define PLUGIN_LATENCY_BUCKETS 16
+
+/*
+ * latency of requests sent to a plugin, bucket 0 counts requests done in
+ * less than 1ms, bucket i counts [2^(i-1), 2^i) ms, the last one counts the rest.
+ */
+typedef struct plugin_latency {
+    uint64_t count;
+    uint64_t failed;
+    uint64_t total_us;
+    uint64_t max_us;
+    uint64_t buckets[PLUGIN_LATENCY_BUCKETS];
+} plugin_latency_t;
+
 typedef struct plugin {
     pthread_rwlock_t lock;
 
@@ -57,6 +71,8 @@ typedef struct plugin {
     size_t activated_errcnt;
     char *activated_errmsg;
 
+    plugin_latency_t latency;
+
     uint64_t ref;
 } plugin_t;
 
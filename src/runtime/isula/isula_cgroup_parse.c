@@ -0,0 +1,191 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-04-02
+ * Description: provide parsers of cgroup files
+ ******************************************************************************/
+#define _GNU_SOURCE
+#include "isula_cgroup_parse.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+#include "utils.h"
+
+#define CGROUP_PARSE_LINE_SIZE 4096
+
+static bool controllers_contain(const char *controllers, const char *subsystem)
+{
+    size_t len = strlen(subsystem);
+    const char *p = controllers;
+
+    while (p != NULL && *p != '\0') {
+        if (strncmp(p, subsystem, len) == 0 && (p[len] == ',' || p[len] == '\0')) {
+            return true;
+        }
+        p = strchr(p, ',');
+        if (p != NULL) {
+            p++;
+        }
+    }
+
+    return false;
+}
+
+char *cgroup_parse_path(const char *content, const char *subsystem)
+{
+    char *dup = NULL;
+    char *line = NULL;
+    char *saveptr = NULL;
+    char *controllers = NULL;
+    char *path = NULL;
+    char *result = NULL;
+
+    if (content == NULL) {
+        return NULL;
+    }
+
+    dup = util_strdup_s(content);
+    for (line = strtok_r(dup, "\n", &saveptr); line != NULL; line = strtok_r(NULL, "\n", &saveptr)) {
+        /* hierarchy-ID:controller-list:cgroup-path */
+        controllers = strchr(line, ':');
+        if (controllers == NULL) {
+            continue;
+        }
+        controllers++;
+        path = strchr(controllers, ':');
+        if (path == NULL) {
+            continue;
+        }
+        *path = '\0';
+        path++;
+
+        if (subsystem == NULL) {
+            if (strncmp(line, "0:", 2) == 0 && controllers[0] == '\0') {
+                result = util_strdup_s(path);
+                break;
+            }
+            continue;
+        }
+        if (controllers_contain(controllers, subsystem)) {
+            result = util_strdup_s(path);
+            break;
+        }
+    }
+
+    free(dup);
+    return result;
+}
+
+uint64_t cgroup_parse_u64(const char *str)
+{
+    char *end = NULL;
+    unsigned long long val;
+
+    while (*str == ' ' || *str == '\t') {
+        str++;
+    }
+    /* "max" means unlimited in cgroup v2 */
+    if (strncmp(str, "max", 3) == 0) {
+        return UINT64_MAX;
+    }
+    /* strtoull accepts a sign, which no cgroup counter has */
+    if (*str < '0' || *str > '9') {
+        return 0;
+    }
+
+    errno = 0;
+    val = strtoull(str, &end, 10);
+    if (errno != 0 || end == str) {
+        return 0;
+    }
+
+    return (uint64_t)val;
+}
+
+uint64_t cgroup_parse_field_u64(const char *content, const char *key)
+{
+    size_t len = strlen(key);
+    const char *p = content;
+
+    while ((p = strstr(p, key)) != NULL) {
+        if ((p == content || p[-1] == ' ' || p[-1] == '\n') && (p[len] == ' ' || p[len] == '=')) {
+            return cgroup_parse_u64(p + len + 1);
+        }
+        p += len;
+    }
+
+    return 0;
+}
+
+uint64_t cgroup_parse_sum_field_u64(const char *content, const char *key)
+{
+    uint64_t sum = 0;
+    const char *line = content;
+
+    while (line != NULL && *line != '\0') {
+        const char *next = strchr(line, '\n');
+        size_t line_len = next != NULL ? (size_t)(next - line) : strlen(line);
+        char tmp[CGROUP_PARSE_LINE_SIZE] = { 0 };
+
+        if (line_len < sizeof(tmp)) {
+            (void)memcpy(tmp, line, line_len);
+            sum += cgroup_parse_field_u64(tmp, key);
+        }
+        line = next != NULL ? next + 1 : NULL;
+    }
+
+    return sum;
+}
+
+int cgroup_parse_pids(char *content, pid_t **pids, size_t *pids_len)
+{
+    int pid = 0;
+    size_t count = 0;
+    size_t i = 0;
+    char *p = NULL;
+    char *line = NULL;
+    char *saveptr = NULL;
+    pid_t *result = NULL;
+
+    /* number of lines, the last one may have no newline */
+    for (p = content; *p != '\0'; p++) {
+        if (*p == '\n' || p[1] == '\0') {
+            count++;
+        }
+    }
+    if (count == 0) {
+        *pids = NULL;
+        *pids_len = 0;
+        return 0;
+    }
+
+    result = util_smart_calloc_s(sizeof(pid_t), count);
+    if (result == NULL) {
+        ERROR("Out of memory");
+        return -1;
+    }
+
+    for (line = strtok_r(content, "\n", &saveptr); line != NULL && i < count; line = strtok_r(NULL, "\n", &saveptr)) {
+        if (util_safe_int(line, &pid) != 0 || pid <= 0) {
+            WARN("Invalid pid %s in cgroup.procs", line);
+            continue;
+        }
+        result[i++] = (pid_t)pid;
+    }
+
+    *pids = result;
+    *pids_len = i;
+    return 0;
+}
@@ -0,0 +1,45 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-04-02
+ * Description: provide parsers of cgroup files definition
+ ******************************************************************************/
+#ifndef __ISULA_CGROUP_PARSE_H
+#define __ISULA_CGROUP_PARSE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* find cgroup path of subsystem in content of /proc/<pid>/cgroup, NULL subsystem means cgroup v2 */
+char *cgroup_parse_path(const char *content, const char *subsystem);
+
+/* parse a single value file, "max" is UINT64_MAX, malformed value is 0 */
+uint64_t cgroup_parse_u64(const char *str);
+
+/* find value of "key value" or "key=value" field in a cgroup stat file, 0 if missing */
+uint64_t cgroup_parse_field_u64(const char *content, const char *key);
+
+/* sum values of key in all lines, io.stat has one line per device */
+uint64_t cgroup_parse_sum_field_u64(const char *content, const char *key);
+
+/* parse content of cgroup.procs, invalid lines are skipped. content is modified */
+int cgroup_parse_pids(char *content, pid_t **pids, size_t *pids_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ISULA_CGROUP_PARSE_H */
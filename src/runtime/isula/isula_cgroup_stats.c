@@ -0,0 +1,509 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-04-02
+ * Description: provide cgroup stats reader for containers of isulad-shim
+ ******************************************************************************/
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/vfs.h>
+
+#include "isula_cgroup_stats.h"
+#include "isula_cgroup_parse.h"
+#include "log.h"
+#include "utils.h"
+#include "sysinfo.h"
+#include "hash_map.h"
+
+#ifndef CGROUP2_SUPER_MAGIC
+#define CGROUP2_SUPER_MAGIC 0x63677270
+#endif
+
+#define CGROUP_MOUNTPOINT "/sys/fs/cgroup"
+#define CGROUP_STATS_BUF_SIZE 4096
+#define CGROUP_PROCS_MAX_BUF_SIZE (16 * 1024 * 1024)
+
+typedef enum {
+    CGROUP_STATS_CPU = 0,
+    CGROUP_STATS_MEM_USAGE,
+    CGROUP_STATS_MEM_LIMIT,
+    CGROUP_STATS_KMEM_USAGE,
+    CGROUP_STATS_KMEM_LIMIT,
+    CGROUP_STATS_BLKIO,
+    CGROUP_STATS_PIDS,
+    CGROUP_STATS_PROCS,
+    CGROUP_STATS_FILE_MAX
+} cgroup_stats_file_t;
+
+typedef struct {
+    /* controller of cgroup v1 which the file belongs to */
+    const char *subsystem;
+    const char *v1_file;
+    /* NULL if there is no such file in cgroup v2 */
+    const char *v2_file;
+} cgroup_stats_file_desc;
+
+static const cgroup_stats_file_desc g_stats_files[CGROUP_STATS_FILE_MAX] = {
+    [CGROUP_STATS_CPU] = { "cpuacct", "cpuacct.usage", "cpu.stat" },
+    [CGROUP_STATS_MEM_USAGE] = { "memory", "memory.usage_in_bytes", "memory.current" },
+    [CGROUP_STATS_MEM_LIMIT] = { "memory", "memory.limit_in_bytes", "memory.max" },
+    [CGROUP_STATS_KMEM_USAGE] = { "memory", "memory.kmem.usage_in_bytes", NULL },
+    [CGROUP_STATS_KMEM_LIMIT] = { "memory", "memory.kmem.limit_in_bytes", NULL },
+    [CGROUP_STATS_BLKIO] = { "blkio", "blkio.throttle.io_service_bytes", "io.stat" },
+    [CGROUP_STATS_PIDS] = { "pids", "pids.current", "pids.current" },
+    [CGROUP_STATS_PROCS] = { "cpuacct", "cgroup.procs", "cgroup.procs" },
+};
+
+typedef struct {
+    /* init pid of container when the files were opened */
+    pid_t pid;
+    int fds[CGROUP_STATS_FILE_MAX];
+} cgroup_stats_handle;
+
+typedef struct {
+    char *mountpoint;
+    char *root;
+} cgroup_v1_mount;
+
+static pthread_mutex_t g_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+/* container id -> cgroup_stats_handle */
+static hash_map_t *g_stats_handles = NULL;
+/* 0 if not detected yet */
+static int g_cgroup_version = 0;
+static cgroup_v1_mount g_v1_mounts[CGROUP_STATS_FILE_MAX];
+
+static void stats_handle_free(cgroup_stats_handle *handle)
+{
+    int i;
+
+    if (handle == NULL) {
+        return;
+    }
+
+    for (i = 0; i < CGROUP_STATS_FILE_MAX; i++) {
+        if (handle->fds[i] >= 0) {
+            close(handle->fds[i]);
+        }
+    }
+    free(handle);
+}
+
+static void stats_handle_kvfree(void *key, void *value)
+{
+    free(key);
+    stats_handle_free(value);
+}
+
+static int detect_cgroup_version(void)
+{
+    int i;
+    struct statfs fs = { 0 };
+
+    if (statfs(CGROUP_MOUNTPOINT, &fs) == 0 && fs.f_type == CGROUP2_SUPER_MAGIC) {
+        return 2;
+    }
+
+    for (i = 0; i < CGROUP_STATS_FILE_MAX; i++) {
+        if (find_cgroup_mountpoint_and_root(g_stats_files[i].subsystem, &g_v1_mounts[i].mountpoint,
+                                            &g_v1_mounts[i].root) != 0) {
+            WARN("Unable to find %s cgroup in mounts", g_stats_files[i].subsystem);
+        }
+    }
+
+    return 1;
+}
+
+/* must be called with g_stats_lock held */
+static int stats_init_locked(void)
+{
+    if (g_stats_handles == NULL) {
+        g_stats_handles = hash_map_new(MAP_STR_PTR, stats_handle_kvfree);
+        if (g_stats_handles == NULL) {
+            ERROR("Failed to create cgroup stats map");
+            return -1;
+        }
+    }
+
+    if (g_cgroup_version == 0) {
+        g_cgroup_version = detect_cgroup_version();
+    }
+
+    return 0;
+}
+
+static int open_cgroup_file(const char *mountpoint, const char *root, const char *path, const char *file)
+{
+    int nret;
+    int fd = -1;
+    size_t root_len = 0;
+    char fname[PATH_MAX] = { 0 };
+
+    /* the path in /proc/<pid>/cgroup is relative to root of the hierarchy */
+    if (root != NULL && strcmp(root, "/") != 0) {
+        root_len = strlen(root);
+        if (strncmp(path, root, root_len) == 0 && (path[root_len] == '/' || path[root_len] == '\0')) {
+            path += root_len;
+        }
+    }
+
+    nret = snprintf(fname, sizeof(fname), "%s%s/%s", mountpoint, path, file);
+    if (nret < 0 || (size_t)nret >= sizeof(fname)) {
+        ERROR("Cgroup file path of %s is too long", file);
+        return -1;
+    }
+
+    fd = util_open(fname, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        DEBUG("Failed to open cgroup file %s: %s", fname, strerror(errno));
+    }
+
+    return fd;
+}
+
+static cgroup_stats_handle *stats_handle_open(pid_t pid)
+{
+    int i;
+    char fname[PATH_MAX] = { 0 };
+    char *content = NULL;
+    char *path = NULL;
+    cgroup_stats_handle *handle = NULL;
+
+    if (snprintf(fname, sizeof(fname), "/proc/%d/cgroup", pid) < 0) {
+        ERROR("Failed to sprintf cgroup file of %d", pid);
+        return NULL;
+    }
+
+    content = util_read_text_file(fname);
+    if (content == NULL) {
+        ERROR("Failed to read %s", fname);
+        return NULL;
+    }
+
+    handle = util_common_calloc_s(sizeof(cgroup_stats_handle));
+    if (handle == NULL) {
+        ERROR("Out of memory");
+        goto out;
+    }
+    handle->pid = pid;
+    for (i = 0; i < CGROUP_STATS_FILE_MAX; i++) {
+        handle->fds[i] = -1;
+    }
+
+    for (i = 0; i < CGROUP_STATS_FILE_MAX; i++) {
+        const cgroup_stats_file_desc *desc = &g_stats_files[i];
+
+        if (g_cgroup_version == 2) {
+            if (desc->v2_file == NULL) {
+                continue;
+            }
+            path = cgroup_parse_path(content, NULL);
+            if (path != NULL) {
+                handle->fds[i] = open_cgroup_file(CGROUP_MOUNTPOINT, NULL, path, desc->v2_file);
+            }
+        } else {
+            if (g_v1_mounts[i].mountpoint == NULL) {
+                continue;
+            }
+            path = cgroup_parse_path(content, desc->subsystem);
+            if (path != NULL) {
+                handle->fds[i] = open_cgroup_file(g_v1_mounts[i].mountpoint, g_v1_mounts[i].root, path,
+                                                  desc->v1_file);
+            }
+        }
+        free(path);
+        path = NULL;
+    }
+
+    /* every container has cgroup.procs, without it the cgroup is gone */
+    if (handle->fds[CGROUP_STATS_PROCS] < 0) {
+        ERROR("Failed to open cgroup of process %d", pid);
+        stats_handle_free(handle);
+        handle = NULL;
+    }
+
+out:
+    free(content);
+    return handle;
+}
+
+/* get handle of container, must be called with g_stats_lock held */
+static cgroup_stats_handle *stats_handle_get_locked(const char *id, pid_t pid)
+{
+    cgroup_stats_handle *handle = NULL;
+
+    if (stats_init_locked() != 0) {
+        return NULL;
+    }
+
+    handle = hash_map_search(g_stats_handles, (void *)id);
+    if (handle != NULL && handle->pid == pid) {
+        return handle;
+    }
+
+    /* container is restarted, or queried the first time */
+    handle = stats_handle_open(pid);
+    if (handle == NULL) {
+        (void)hash_map_remove(g_stats_handles, (void *)id);
+        return NULL;
+    }
+
+    if (!hash_map_replace(g_stats_handles, (void *)id, handle)) {
+        ERROR("Failed to cache cgroup stats handle of %s", id);
+        stats_handle_free(handle);
+        return NULL;
+    }
+
+    return handle;
+}
+
+/* read whole file from offset 0 into buf, return length of content */
+static ssize_t pread_all(int fd, char *buf, size_t size)
+{
+    ssize_t nret;
+    size_t total = 0;
+
+    while (total < size) {
+        nret = pread(fd, buf + total, size - total, (off_t)total);
+        if (nret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (nret == 0) {
+            break;
+        }
+        total += (size_t)nret;
+    }
+
+    return (ssize_t)total;
+}
+
+static int read_cgroup_buf(const cgroup_stats_handle *handle, cgroup_stats_file_t file, char *buf, size_t size)
+{
+    ssize_t len;
+
+    if (handle->fds[file] < 0) {
+        buf[0] = '\0';
+        return 0;
+    }
+
+    len = pread_all(handle->fds[file], buf, size - 1);
+    if (len < 0) {
+        ERROR("Failed to read cgroup file %s: %s", g_stats_files[file].v1_file, strerror(errno));
+        return -1;
+    }
+    buf[len] = '\0';
+
+    return 0;
+}
+
+static int read_cgroup_u64(const cgroup_stats_handle *handle, cgroup_stats_file_t file, uint64_t *val)
+{
+    char buf[CGROUP_STATS_BUF_SIZE] = { 0 };
+
+    if (read_cgroup_buf(handle, file, buf, sizeof(buf)) != 0) {
+        return -1;
+    }
+    *val = cgroup_parse_u64(buf);
+
+    return 0;
+}
+
+static int read_cpu_stats(const cgroup_stats_handle *handle, struct engine_container_resources_stats_info *rs_stats)
+{
+    char buf[CGROUP_STATS_BUF_SIZE] = { 0 };
+
+    if (g_cgroup_version != 2) {
+        return read_cgroup_u64(handle, CGROUP_STATS_CPU, &rs_stats->cpu_use_nanos);
+    }
+
+    if (read_cgroup_buf(handle, CGROUP_STATS_CPU, buf, sizeof(buf)) != 0) {
+        return -1;
+    }
+    rs_stats->cpu_use_nanos = cgroup_parse_field_u64(buf, "usage_usec") * 1000;
+
+    return 0;
+}
+
+static int read_blkio_stats(const cgroup_stats_handle *handle, struct engine_container_resources_stats_info *rs_stats)
+{
+    char buf[CGROUP_STATS_BUF_SIZE] = { 0 };
+
+    if (read_cgroup_buf(handle, CGROUP_STATS_BLKIO, buf, sizeof(buf)) != 0) {
+        return -1;
+    }
+
+    if (g_cgroup_version == 2) {
+        rs_stats->blkio_read = cgroup_parse_sum_field_u64(buf, "rbytes");
+        rs_stats->blkio_write = cgroup_parse_sum_field_u64(buf, "wbytes");
+    } else {
+        /* lines of "major:minor Read bytes" */
+        rs_stats->blkio_read = cgroup_parse_sum_field_u64(buf, "Read");
+        rs_stats->blkio_write = cgroup_parse_sum_field_u64(buf, "Write");
+    }
+
+    return 0;
+}
+
+static int read_stats(const cgroup_stats_handle *handle, struct engine_container_resources_stats_info *rs_stats)
+{
+    if (read_cpu_stats(handle, rs_stats) != 0) {
+        return -1;
+    }
+    if (read_cgroup_u64(handle, CGROUP_STATS_MEM_USAGE, &rs_stats->mem_used) != 0 ||
+        read_cgroup_u64(handle, CGROUP_STATS_MEM_LIMIT, &rs_stats->mem_limit) != 0) {
+        return -1;
+    }
+    if (read_cgroup_u64(handle, CGROUP_STATS_KMEM_USAGE, &rs_stats->kmem_used) != 0 ||
+        read_cgroup_u64(handle, CGROUP_STATS_KMEM_LIMIT, &rs_stats->kmem_limit) != 0) {
+        return -1;
+    }
+    if (read_blkio_stats(handle, rs_stats) != 0) {
+        return -1;
+    }
+
+    return read_cgroup_u64(handle, CGROUP_STATS_PIDS, &rs_stats->pids_current);
+}
+
+int isula_cgroup_stats_read(const char *id, pid_t pid, struct engine_container_resources_stats_info *rs_stats)
+{
+    int ret = 0;
+    cgroup_stats_handle *handle = NULL;
+
+    if (id == NULL || pid <= 0 || rs_stats == NULL) {
+        ERROR("Invalid arguments");
+        return -1;
+    }
+
+    if (pthread_mutex_lock(&g_stats_lock) != 0) {
+        ERROR("Failed to lock cgroup stats");
+        return -1;
+    }
+
+    handle = stats_handle_get_locked(id, pid);
+    if (handle == NULL) {
+        ret = -1;
+        goto unlock;
+    }
+
+    if (read_stats(handle, rs_stats) != 0) {
+        /* cgroup was removed, reopen it next time */
+        (void)hash_map_remove(g_stats_handles, (void *)id);
+        ret = -1;
+    }
+
+unlock:
+    if (pthread_mutex_unlock(&g_stats_lock) != 0) {
+        ERROR("Failed to unlock cgroup stats");
+    }
+    return ret;
+}
+
+static char *read_cgroup_procs(const cgroup_stats_handle *handle)
+{
+    ssize_t len;
+    size_t size = CGROUP_STATS_BUF_SIZE;
+    char *buf = NULL;
+
+    for (;;) {
+        buf = util_common_calloc_s(size);
+        if (buf == NULL) {
+            ERROR("Out of memory");
+            return NULL;
+        }
+        len = pread_all(handle->fds[CGROUP_STATS_PROCS], buf, size - 1);
+        if (len < 0) {
+            ERROR("Failed to read cgroup.procs: %s", strerror(errno));
+            free(buf);
+            return NULL;
+        }
+        if ((size_t)len < size - 1) {
+            return buf;
+        }
+        free(buf);
+        if (size >= CGROUP_PROCS_MAX_BUF_SIZE) {
+            ERROR("Too many processes in cgroup");
+            return NULL;
+        }
+        size *= 2;
+    }
+}
+
+int isula_cgroup_stats_pids(const char *id, pid_t pid, pid_t **pids, size_t *pids_len)
+{
+    int ret = 0;
+    char *content = NULL;
+    cgroup_stats_handle *handle = NULL;
+
+    if (id == NULL || pid <= 0 || pids == NULL || pids_len == NULL) {
+        ERROR("Invalid arguments");
+        return -1;
+    }
+
+    if (pthread_mutex_lock(&g_stats_lock) != 0) {
+        ERROR("Failed to lock cgroup stats");
+        return -1;
+    }
+
+    handle = stats_handle_get_locked(id, pid);
+    if (handle == NULL) {
+        ret = -1;
+        goto unlock;
+    }
+
+    content = read_cgroup_procs(handle);
+    if (content == NULL) {
+        (void)hash_map_remove(g_stats_handles, (void *)id);
+        ret = -1;
+    }
+
+unlock:
+    if (pthread_mutex_unlock(&g_stats_lock) != 0) {
+        ERROR("Failed to unlock cgroup stats");
+    }
+
+    /* parse outside of lock, the list may be long */
+    if (content != NULL) {
+        ret = cgroup_parse_pids(content, pids, pids_len);
+        free(content);
+    }
+    return ret;
+}
+
+void isula_cgroup_stats_release(const char *id)
+{
+    if (id == NULL) {
+        return;
+    }
+
+    if (pthread_mutex_lock(&g_stats_lock) != 0) {
+        ERROR("Failed to lock cgroup stats");
+        return;
+    }
+
+    if (g_stats_handles != NULL) {
+        (void)hash_map_remove(g_stats_handles, (void *)id);
+    }
+
+    if (pthread_mutex_unlock(&g_stats_lock) != 0) {
+        ERROR("Failed to unlock cgroup stats");
+    }
+}
@@ -0,0 +1,41 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-04-02
+ * Description: provide cgroup stats reader for containers of isulad-shim
+ ******************************************************************************/
+#ifndef __ISULA_CGROUP_STATS_H
+#define __ISULA_CGROUP_STATS_H
+
+#include <sys/types.h>
+
+#include "engine.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Cgroup files of a container are opened once, when the container is first
+ * queried, and read with pread afterwards. The handle is reopened when the
+ * init pid of container changes, and dropped by isula_cgroup_stats_release.
+ */
+int isula_cgroup_stats_read(const char *id, pid_t pid, struct engine_container_resources_stats_info *rs_stats);
+
+int isula_cgroup_stats_pids(const char *id, pid_t pid, pid_t **pids, size_t *pids_len);
+
+void isula_cgroup_stats_release(const char *id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ISULA_CGROUP_STATS_H */
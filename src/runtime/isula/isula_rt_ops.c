@@ -16,6 +16,7 @@
 #define _GNU_SOURCE
 
 #include <unistd.h>
+#include <sys/file.h>
 #include <sys/wait.h>
 
 #include <limits.h>
@@ -26,14 +27,18 @@
 #include "engine.h"
 #include "constants.h"
 #include "shim_client_process_state.h"
+#include "shim_client_runtime_state.h"
 #include "oci_runtime_state.h"
 #include "isulad_config.h"
 #include "utils_string.h"
 #include "libisulad.h"
+#include "isula_cgroup_stats.h"
 
 #define SHIM_BINARY "isulad-shim"
 #define SHIM_LOG_SIZE ((BUFSIZ-100)/2)
 #define PID_WAIT_TIME 120
+/* state of container published by isulad-shim, same as SHIM_STATE_NAME of isulad-shim */
+#define SHIM_STATE_FILE "shim-state.json"
 
 
 static void copy_process(shim_client_process_state *p, defs_process *dp)
@@ -456,6 +461,117 @@ static int status_string_to_int(const char *status)
     return ENGINE_CONTAINER_STATUS_UNKNOWN;
 }
 
+static int shim_state_path(const char *workdir, char *path, size_t len)
+{
+    int nret = snprintf(path, len, "%s/%s", workdir, SHIM_STATE_FILE);
+
+    if (nret < 0 || (size_t)nret >= len) {
+        ERROR("failed make shim state full path");
+        return -1;
+    }
+
+    return 0;
+}
+
+/* return NULL if shim does not publish its state, e.g. shim of older version */
+static shim_client_runtime_state *read_shim_state(const char *workdir)
+{
+    char path[PATH_MAX] = {0};
+    parser_error perr = NULL;
+    shim_client_runtime_state *state = NULL;
+
+    if (shim_state_path(workdir, path, sizeof(path)) != 0 || !util_file_exists(path)) {
+        return NULL;
+    }
+
+    state = shim_client_runtime_state_parse_file(path, NULL, &perr);
+    if (state == NULL || state->status == NULL) {
+        WARN("failed parse shim state %s: %s", path, perr);
+        free_shim_client_runtime_state(state);
+        state = NULL;
+    }
+
+    free(perr);
+    return state;
+}
+
+/* record the state changed by runtime command, shim only knows created and stopped */
+static void update_shim_state(const char *workdir, const char *status)
+{
+    char path[PATH_MAX] = {0};
+    char *json = NULL;
+    parser_error perr = NULL;
+    struct parser_context ctx = {OPT_GEN_SIMPLIFY, 0};
+    shim_client_runtime_state *state = NULL;
+    int lock_fd = -1;
+
+    /* shim publishes stopped under lock of workdir, so stopped read here is never stale */
+    lock_fd = util_open(workdir, O_RDONLY | O_DIRECTORY, 0);
+    if (lock_fd < 0 || flock(lock_fd, LOCK_EX) != 0) {
+        WARN("failed lock %s: %s", workdir, strerror(errno));
+        goto out;
+    }
+
+    state = read_shim_state(workdir);
+    if (state == NULL) {
+        goto out;
+    }
+
+    /* container exited already, never overwrite the state published by shim */
+    if (strcmp(state->status, "stopped") == 0) {
+        goto out;
+    }
+
+    free(state->status);
+    state->status = util_strdup_s(status);
+
+    if (shim_state_path(workdir, path, sizeof(path)) != 0) {
+        goto out;
+    }
+
+    json = shim_client_runtime_state_generate_json(state, &ctx, &perr);
+    if (json == NULL || util_atomic_write_file(path, json, strlen(json), DEFAULT_SECURE_FILE_MODE, false) != 0) {
+        /* stale state is worse than none, let status fall back to runtime */
+        WARN("failed update shim state %s, remove it", path);
+        if (unlink(path) != 0 && errno != ENOENT) {
+            ERROR("failed remove shim state %s: %s", path, strerror(errno));
+        }
+    }
+
+out:
+    if (lock_fd >= 0) {
+        close(lock_fd);
+    }
+    free(json);
+    free(perr);
+    free_shim_client_runtime_state(state);
+}
+
+static int status_from_shim_state(const char *workdir, const char *id, struct engine_container_status_info *ecsi)
+{
+    shim_client_runtime_state *state = NULL;
+
+    state = read_shim_state(workdir);
+    if (state == NULL) {
+        return -1;
+    }
+
+    ecsi->status = status_string_to_int(state->status);
+    if (ecsi->status != ENGINE_CONTAINER_STATUS_STOPPED && state->pid > 0 && kill(state->pid, 0) != 0 &&
+        errno == ESRCH) {
+        ecsi->status = ENGINE_CONTAINER_STATUS_STOPPED;
+    }
+    ecsi->pid = (uint32_t)state->pid;
+    if (state->pid != 0) {
+        ecsi->has_pid = true;
+    }
+
+    INFO("container %s status %s pid %d", id, state->status, state->pid);
+
+    free_shim_client_runtime_state(state);
+    return 0;
+}
+
 static int runtime_call_status(const char *workdir, const char *runtime,
                                const char *id, struct engine_container_status_info *ecsi)
 {
@@ -517,6 +633,7 @@ static int runtime_call_simple(const char *workdir, const char *runtime,
     runtime_exec_info_init(&rei, workdir, runtime, subcmd, opts, opts_len, id, params, PARAM_NUM);
     if (!util_exec_cmd(runtime_exec_func, &rei, NULL, &stdout, &stderr)) {
         WARN("call runtime %s failed stderr %s", subcmd, stderr);
+        ret = -1;
         goto out;
     }
 
@@ -814,6 +931,7 @@ int rt_isula_start(const char *id, const char *runtime,
         ret = -1;
         goto out;
     }
+    update_shim_state(workdir, "running");
 
 out:
     if (ret != 0) {
@@ -855,6 +973,8 @@ int rt_isula_clean_resource(const char *id, const char *runtime,
         shim_kill_force(workdir);
     }
 
+    isula_cgroup_stats_release(id);
+
     (void)runtime_call_kill_force(workdir, runtime, id);
     (void)runtime_call_delete_force(workdir, runtime, id);
 
@@ -1033,6 +1153,10 @@ int rt_isula_status(const char *id, const char *runtime,
         goto out;
     }
 
+    if (status_from_shim_state(workdir, id, status) == 0) {
+        goto out;
+    }
+
     ret = runtime_call_status(workdir, runtime, id, status);
 
 out:
@@ -1068,7 +1192,12 @@ int rt_isula_pause(const char *id, const char *runtime, const rt_pause_params_t
         return -1;
     }
 
-    return runtime_call_simple(workdir, runtime, "pause", NULL, 0, id);
+    if (runtime_call_simple(workdir, runtime, "pause", NULL, 0, id) != 0) {
+        return -1;
+    }
+    update_shim_state(workdir, "paused");
+
+    return 0;
 }
 
 int rt_isula_resume(const char *id, const char *runtime, const rt_resume_params_t *params)
@@ -1085,23 +1214,78 @@ int rt_isula_resume(const char *id, const char *runtime, const rt_resume_params_
         return -1;
     }
 
-    return runtime_call_simple(workdir, runtime, "resume", NULL, 0, id);
+    if (runtime_call_simple(workdir, runtime, "resume", NULL, 0, id) != 0) {
+        return -1;
+    }
+    update_shim_state(workdir, "running");
+
+    return 0;
+}
+
+/* pid is published by isulad-shim once the container is created, do not wait for it here */
+static int read_container_pid(const char *id, const char *state, pid_t *pid)
+{
+    int ival = 0;
+    char fname[PATH_MAX] = {0};
+
+    if (state == NULL) {
+        ERROR("missing state path");
+        return -1;
+    }
+
+    if (snprintf(fname, sizeof(fname), "%s/%s/pid", state, id) < 0) {
+        ERROR("failed make pid full path");
+        return -1;
+    }
+
+    file_read_int(fname, &ival);
+    if (ival <= 0) {
+        ERROR("failed read pid of container %s", id);
+        return -1;
+    }
+
+    *pid = (pid_t)ival;
+    return 0;
 }
 
 int rt_isula_listpids(const char *name, const char *runtime, const rt_listpids_params_t *params, rt_listpids_out_t *out)
 {
-    ERROR("isula top/listpids not support on isulad-shim");
-    isulad_set_error_message("isula top/listpids not support on isulad-shim");
-    return -1;
+    pid_t pid = 0;
+
+    if (name == NULL || params == NULL || out == NULL) {
+        ERROR("nullptr arguments not allowed");
+        return -1;
+    }
+
+    if (read_container_pid(name, params->state, &pid) != 0) {
+        isulad_set_error_message("Failed to get pid of container %s", name);
+        return -1;
+    }
+
+    if (isula_cgroup_stats_pids(name, pid, &out->pids, &out->pids_len) != 0) {
+        isulad_set_error_message("Failed to list pids of container %s", name);
+        return -1;
+    }
+
+    return 0;
 }
 
 int rt_isula_resources_stats(const char *name, const char *runtime,
                              const rt_stats_params_t *params,
                              struct engine_container_resources_stats_info *rs_stats)
 {
-    ERROR("isula stats not support on isulad-shim");
-    isulad_set_error_message("isula stats not support on isulad-shim");
-    return -1;
+    pid_t pid = 0;
+
+    if (name == NULL || params == NULL || rs_stats == NULL) {
+        ERROR("nullptr arguments not allowed");
+        return -1;
+    }
+
+    if (read_container_pid(name, params->state, &pid) != 0) {
+        return -1;
+    }
+
+    return isula_cgroup_stats_read(name, pid, rs_stats);
 }
 
 int rt_isula_resize(const char *id, const char *runtime, const rt_resize_params_t *params)
@@ -82,6 +82,7 @@ typedef struct _rt_status_params_t {
 
 typedef struct _rt_stats_params_t {
     const char *rootpath;
+    const char *state;
 } rt_stats_params_t;
 
 typedef struct _rt_exec_params_t {
@@ -119,6 +120,7 @@ typedef struct _rt_update_params_t {
 
 typedef struct _rt_listpids_params_t {
     const char *rootpath;
+    const char *state;
 } rt_listpids_params_t;
 
 typedef struct _rt_listpids_out_t {
@@ -40,6 +40,7 @@
 #include "container_exec_response.h"
 #include "container_inspect_request.h"
 #include "container_inspect_response.h"
+#include "container_inspect.h"
 #include "container_attach_request.h"
 #include "container_attach_response.h"
 #include "container_pause_request.h"
@@ -126,6 +127,9 @@ typedef struct {
 
     int(*inspect)(const container_inspect_request *request, container_inspect_response **response);
 
+    /* same as inspect, but return the struct directly for in-process callers, errmsg is set on failure */
+    int(*inspect_struct)(const container_inspect_request *request, container_inspect **inspect, char **errmsg);
+
     int(*wait)(const container_wait_request *request, container_wait_response **response);
 
     int(*events)(const struct isulad_events_request *request, const stream_func_wrapper *stream);
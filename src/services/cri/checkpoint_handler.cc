@@ -188,6 +188,16 @@ void CheckpointData::SetHostNetwork(bool hostNetwork)
     m_hostNetwork = hostNetwork;
 }
 
+const std::map<std::string, std::string> &CheckpointData::GetPodIPs() const
+{
+    return m_podIPs;
+}
+
+void CheckpointData::SetPodIPs(const std::map<std::string, std::string> &podIPs)
+{
+    m_podIPs = podIPs;
+}
+
 void CheckpointData::CheckpointDataToCStruct(cri_checkpoint_data **data, Errors &error)
 {
     size_t len = m_portMappings.size();
@@ -221,9 +231,23 @@ void CheckpointData::CheckpointDataToCStruct(cri_checkpoint_data **data, Errors
             (*data)->port_mappings_len++;
         }
     }
+    if (!m_podIPs.empty()) {
+        (*data)->pod_ips = (json_map_string_string *)util_common_calloc_s(sizeof(json_map_string_string));
+        if ((*data)->pod_ips == nullptr) {
+            error.SetError("Out of memory");
+            goto out;
+        }
+        for (auto &iter : m_podIPs) {
+            if (append_json_map_string_string((*data)->pod_ips, iter.first.c_str(), iter.second.c_str()) != 0) {
+                error.SetError("Failed to append pod ip");
+                goto out;
+            }
+        }
+    }
     return;
 out:
     free_cri_checkpoint_data(*data);
+    *data = nullptr;
 }
 
 void CheckpointData::CStructToCheckpointData(const cri_checkpoint_data *data, Errors &error)
@@ -242,10 +266,16 @@ void CheckpointData::CStructToCheckpointData(const cri_checkpoint_data *data, Er
             m_portMappings.push_back(tmpPortMap);
         }
     }
+    if (data->pod_ips != nullptr) {
+        for (size_t i = 0; i < data->pod_ips->len; i++) {
+            m_podIPs[data->pod_ips->keys[i]] = data->pod_ips->values[i];
+        }
+    }
     return;
 out:
     m_hostNetwork = false;
     m_portMappings.clear();
+    m_podIPs.clear();
 }
 
 const std::string &PodSandboxCheckpoint::GetVersion() const
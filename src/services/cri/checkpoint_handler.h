@@ -16,6 +16,7 @@
 #define _CRI_CHECKPOINT_H
 #include <string>
 #include <vector>
+#include <map>
 #include <memory>
 
 #include "errors.h"
@@ -55,10 +56,14 @@ public:
     void InsertPortMapping(const PortMapping &portMapping);
     bool GetHostNetwork();
     void SetHostNetwork(bool hostNetwork);
+    const std::map<std::string, std::string> &GetPodIPs() const;
+    void SetPodIPs(const std::map<std::string, std::string> &podIPs);
 
 private:
     std::vector<PortMapping> m_portMappings;
     bool m_hostNetwork { false };
+    // interface name -> ip, recorded from cni result of the pod
+    std::map<std::string, std::string> m_podIPs;
 };
 
 class PodSandboxCheckpoint {
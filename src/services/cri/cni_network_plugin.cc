@@ -20,9 +20,13 @@
 #include <utility>
 #include <set>
 
+#include <clibcni/types.h>
+
 #include "log.h"
 #include "utils.h"
+#include "constants.h"
 #include "cri_helpers.h"
+#include "checkpoint_handler.h"
 
 namespace Network {
 static std::string VendorCNIDir(const std::string &prefix, const std::string &pluginType)
@@ -30,6 +34,38 @@ static std::string VendorCNIDir(const std::string &prefix, const std::string &pl
     return prefix + "/opt/" + pluginType + "/bin";
 }
 
+// prefer ipv4 address, same as GetPodIP
+static std::string GetIPFromCNIResult(const struct result *presult)
+{
+    std::string ipv6;
+
+    if (presult == nullptr) {
+        return "";
+    }
+
+    for (size_t i = 0; i < presult->ips_len; i++) {
+        const struct ipconfig *ipc = presult->ips[i];
+        if (ipc == nullptr || ipc->address == nullptr || ipc->address->ip == nullptr) {
+            continue;
+        }
+        char *cIP = ip_to_string(ipc->address->ip, ipc->address->ip_len);
+        if (cIP == nullptr) {
+            continue;
+        }
+        std::string ip = cIP;
+        free(cIP);
+        if (ipc->version != nullptr && strcmp(ipc->version, "6") == 0) {
+            if (ipv6.empty()) {
+                ipv6 = ip;
+            }
+            continue;
+        }
+        return ip;
+    }
+
+    return ipv6;
+}
+
 static std::unique_ptr<CNINetwork> GetLoNetwork(const std::string &binDir, const std::string &vendorDirPrefix)
 {
     const std::string loNetConfListJson { "{\"cniVersion\": \"0.3.0\", \"name\": \"cni-loopback\","
@@ -88,12 +124,15 @@ char **CNINetwork::GetPaths(Errors &err)
     return paths;
 }
 
-void ProbeNetworkPlugins(const std::string &pluginDir, const std::string &binDir,
+void ProbeNetworkPlugins(const std::string &pluginDir, const std::string &binDir, const std::string &rootDir,
                          std::vector<std::shared_ptr<NetworkPlugin>> *plugins)
 {
     const std::string useBinDir = binDir.empty() ? DEFAULT_CNI_DIR : binDir;
     auto plugin = std::make_shared<CniNetworkPlugin>(useBinDir, pluginDir);
     plugin->SetLoNetwork(GetLoNetwork(useBinDir, ""));
+    if (!rootDir.empty()) {
+        plugin->SetCheckpointDir(rootDir + "/" + cri::SANDBOX_CHECKPOINT_DIR);
+    }
     plugins->push_back(plugin);
 }
 
@@ -104,6 +143,11 @@ void CniNetworkPlugin::SetLoNetwork(std::unique_ptr<CNINetwork> lo)
     }
 }
 
+void CniNetworkPlugin::SetCheckpointDir(const std::string &dir)
+{
+    m_podIPCache.SetDir(dir);
+}
+
 CniNetworkPlugin::CniNetworkPlugin(const std::string &binDir, const std::string &pluginDir,
                                    const std::string &vendorCNIDirPrefix)
     : m_pluginDir(pluginDir)
@@ -411,6 +455,7 @@ void CniNetworkPlugin::SetUpPod(const std::string &ns, const std::string &name,
     DEBUG("add checkpoint: ", jsonCheckpoint.c_str());
 
     struct result *preResult = nullptr;
+    std::string podIP;
     if (m_loNetwork != nullptr) {
         AddToNetwork(m_loNetwork.get(), jsonCheckpoint, name, ns, interfaceName, id, netnsPath, &preResult, err);
         free_result(preResult);
@@ -434,14 +479,19 @@ void CniNetworkPlugin::SetUpPod(const std::string &ns, const std::string &name,
     }
 
     AddToNetwork((netIter->second).get(), jsonCheckpoint, name, ns, interfaceName, id, netnsPath, &preResult, err);
-    free_result(preResult);
-    preResult = nullptr;
     if (err.NotEmpty()) {
         ERROR("Error while adding to cni network: %s", err.GetCMessage());
+    } else {
+        podIP = GetIPFromCNIResult(preResult);
     }
+    free_result(preResult);
+    preResult = nullptr;
 
 unlock_out:
     UnlockNetworkMap(err);
+    if (err.Empty() && !podIP.empty()) {
+        m_podIPCache.Add(id, interfaceName, podIP, jsonCheckpoint);
+    }
 }
 
 void CniNetworkPlugin::TearDownPod(const std::string &ns, const std::string &name, const std::string &networkPlane,
@@ -481,6 +531,7 @@ void CniNetworkPlugin::TearDownPod(const std::string &ns, const std::string &nam
 
 unlock_out:
     UnlockNetworkMap(err);
+    m_podIPCache.Remove(id, interfaceName, jsonCheckpoint);
 }
 
 std::map<int, bool> *CniNetworkPlugin::Capabilities()
@@ -505,6 +556,12 @@ void CniNetworkPlugin::GetPodNetworkStatus(const std::string &ns, const std::str
         goto out;
     }
 
+    if (m_podIPCache.Get(podSandboxID, interfaceName, ip)) {
+        status.SetIP(ip);
+        goto out;
+    }
+
+    // pod set up before ip cache existed, or cni result had no ip, enter netns to get it
     netnsPath = m_criImpl->GetNetNS(podSandboxID, tmpErr);
     if (tmpErr.NotEmpty()) {
         err.Errorf("CNI failed to retrieve network namespace path: %s", tmpErr.GetCMessage());
@@ -521,9 +578,97 @@ void CniNetworkPlugin::GetPodNetworkStatus(const std::string &ns, const std::str
         goto out;
     }
     status.SetIP(ip);
+    m_podIPCache.Add(podSandboxID, interfaceName, ip, "");
 
 out:
-    INFO("get_pod_network_status: %s", podSandboxID.c_str());
+    DEBUG("get_pod_network_status: %s", podSandboxID.c_str());
+}
+
+void PodIPCheckpointCache::SetDir(const std::string &dir)
+{
+    m_checkpointDir = dir;
+}
+
+std::string PodIPCheckpointCache::CheckpointPath(const std::string &podSandboxID)
+{
+    if (m_checkpointDir.empty()) {
+        return "";
+    }
+    return m_checkpointDir + "/" + podSandboxID;
+}
+
+void PodIPCheckpointCache::SaveCheckpoint(const std::string &podSandboxID,
+                                          const std::map<std::string, std::string> &podIPs,
+                                          const std::string &jsonCheckpoint)
+{
+    Errors err;
+    cri::PodSandboxCheckpoint checkpoint;
+    std::string data;
+    std::string path = CheckpointPath(podSandboxID);
+
+    if (path.empty()) {
+        return;
+    }
+    if (podIPs.empty() || jsonCheckpoint.empty()) {
+        if (util_path_remove(path.c_str()) != 0 && errno != ENOENT) {
+            WARN("Failed to remove pod ip checkpoint %s", path.c_str());
+        }
+        return;
+    }
+
+    CRIHelpers::GetCheckpoint(jsonCheckpoint, checkpoint, err);
+    if (err.NotEmpty()) {
+        WARN("Failed to parse checkpoint of %s: %s", podSandboxID.c_str(), err.GetCMessage());
+        return;
+    }
+    if (checkpoint.GetData() == nullptr) {
+        checkpoint.SetData(new (std::nothrow) cri::CheckpointData);
+        if (checkpoint.GetData() == nullptr) {
+            ERROR("Out of memory");
+            return;
+        }
+    }
+    checkpoint.GetData()->SetPodIPs(podIPs);
+    data = CRIHelpers::CreateCheckpoint(checkpoint, err);
+    if (err.NotEmpty()) {
+        WARN("Failed to create checkpoint of %s: %s", podSandboxID.c_str(), err.GetCMessage());
+        return;
+    }
+
+    if (util_mkdir_p(m_checkpointDir.c_str(), CONFIG_DIRECTORY_MODE) != 0) {
+        WARN("Failed to create dir %s", m_checkpointDir.c_str());
+        return;
+    }
+    if (util_atomic_write_file(path.c_str(), data.c_str(), data.length(), CONFIG_FILE_MODE, false) != 0) {
+        WARN("Failed to write pod ip checkpoint %s", path.c_str());
+    }
+}
+
+void PodIPCheckpointCache::LoadCheckpoint(const std::string &podSandboxID,
+                                          std::map<std::string, std::string> &podIPs)
+{
+    Errors err;
+    cri::PodSandboxCheckpoint checkpoint;
+    std::string path = CheckpointPath(podSandboxID);
+
+    if (path.empty() || !util_file_exists(path.c_str())) {
+        return;
+    }
+
+    char *data = util_read_text_file(path.c_str());
+    if (data == nullptr) {
+        WARN("Failed to read pod ip checkpoint %s", path.c_str());
+        return;
+    }
+    CRIHelpers::GetCheckpoint(data, checkpoint, err);
+    free(data);
+    if (err.NotEmpty()) {
+        WARN("Invalid pod ip checkpoint %s: %s", path.c_str(), err.GetCMessage());
+        return;
+    }
+    if (checkpoint.GetData() != nullptr && !checkpoint.GetData()->GetPodIPs().empty()) {
+        podIPs = checkpoint.GetData()->GetPodIPs();
+    }
 }
 
 void CniNetworkPlugin::AddToNetwork(CNINetwork *snetwork, const std::string &jsonCheckpoint, const std::string &podName,
@@ -26,6 +26,7 @@
 #include "utils.h"
 #include "errors.h"
 #include "cri_runtime_service.h"
+#include "pod_ip_cache.h"
 
 namespace Network {
 #define UNUSED(x) ((void)(x))
@@ -74,6 +75,23 @@ private:
     };
 };
 
+// persist pod ips together with the sandbox checkpoint, so they survive restart of isulad
+class PodIPCheckpointCache : public PodIPCache {
+public:
+    // pod ip checkpoints are stored in dir, empty means only cache in memory
+    void SetDir(const std::string &dir);
+
+protected:
+    void SaveCheckpoint(const std::string &podSandboxID, const std::map<std::string, std::string> &podIPs,
+                        const std::string &jsonCheckpoint) override;
+    void LoadCheckpoint(const std::string &podSandboxID, std::map<std::string, std::string> &podIPs) override;
+
+private:
+    std::string CheckpointPath(const std::string &podSandboxID);
+
+    std::string m_checkpointDir;
+};
+
 class CniNetworkPlugin : public NetworkPlugin {
 public:
     CniNetworkPlugin(const std::string &binDir, const std::string &pluginDir,
@@ -105,6 +123,8 @@ public:
 
     virtual void SetLoNetwork(std::unique_ptr<CNINetwork> lo);
 
+    void SetCheckpointDir(const std::string &dir);
+
 private:
     virtual void PlatformInit(Errors &error);
     virtual void SyncNetworkConfig();
@@ -150,6 +170,8 @@ private:
 
     pthread_rwlock_t m_netsLock = PTHREAD_RWLOCK_INITIALIZER;
     std::map<std::string, std::unique_ptr<CNINetwork>> m_networks;
+
+    PodIPCheckpointCache m_podIPCache;
 };
 
 } // namespace Network
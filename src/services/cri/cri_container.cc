@@ -1507,40 +1507,32 @@ void CRIRuntimeServiceImpl::Attach(const runtime::v1alpha2::AttachRequest &req,
 container_inspect *CRIRuntimeServiceImpl::InspectContainer(const std::string &containerID, Errors &err)
 {
     container_inspect *inspect_data { nullptr };
-    container_inspect_response *resp { nullptr };
-    parser_error perr { nullptr };
+    container_inspect_request *req { nullptr };
+    char *errmsg { nullptr };
 
-    if (m_cb == nullptr || m_cb->container.inspect == nullptr) {
+    if (m_cb == nullptr || m_cb->container.inspect_struct == nullptr) {
         err.SetError("Umimplements inspect");
         return inspect_data;
     }
 
-    container_inspect_request *req =
-        (container_inspect_request *)util_common_calloc_s(sizeof(container_inspect_request));
+    req = (container_inspect_request *)util_common_calloc_s(sizeof(container_inspect_request));
     if (req == nullptr) {
         err.SetError("Out of memory");
-        goto cleanup;
+        return inspect_data;
     }
     req->id = util_strdup_s(containerID.c_str());
-    if (m_cb->container.inspect(req, &resp)) {
-        if (resp != nullptr && resp->errmsg != nullptr) {
-            err.SetError(resp->errmsg);
+    // get inspect data directly, avoid generating and parsing the json of it
+    if (m_cb->container.inspect_struct(req, &inspect_data, &errmsg) != 0) {
+        if (errmsg != nullptr) {
+            err.SetError(errmsg);
         } else {
             err.Errorf("Failed to call inspect callback");
         }
-        goto cleanup;
-    }
-    /* parse oci container json */
-    if (resp != nullptr && resp->container_json) {
-        inspect_data = container_inspect_parse_data(resp->container_json, nullptr, &perr);
-        if (inspect_data == nullptr) {
-            err.Errorf("Parse container json failed: %s", perr);
-            goto cleanup;
-        }
+        free_container_inspect(inspect_data);
+        inspect_data = nullptr;
     }
-cleanup:
+
     free_container_inspect_request(req);
-    free_container_inspect_response(resp);
-    free(perr);
+    free(errmsg);
     return inspect_data;
 }
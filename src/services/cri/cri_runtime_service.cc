@@ -69,7 +69,8 @@ void CRIRuntimeServiceImpl::Init(Network::NetworkPluginConf mConf, const std::st
     }
 
     std::vector<std::shared_ptr<Network::NetworkPlugin>> plugins;
-    Network::ProbeNetworkPlugins(mConf.GetPluginConfDir(), mConf.GetPluginBinDir(), &plugins);
+    Network::ProbeNetworkPlugins(mConf.GetPluginConfDir(), mConf.GetPluginBinDir(), mConf.GetDockershimRootDirectory(),
+                                 &plugins);
 
     std::shared_ptr<Network::NetworkPlugin> chosen { nullptr };
     Network::InitNetworkPlugin(&plugins, mConf.GetPluginName(), this, mConf.GetHairpinMode(),
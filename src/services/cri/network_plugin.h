@@ -221,7 +221,7 @@ void InitNetworkPlugin(std::vector<std::shared_ptr<NetworkPlugin>> *plugins, std
                        CRIRuntimeServiceImpl *criImpl, std::string hairpinMode, std::string nonMasqueradeCIDR, int mtu,
                        std::shared_ptr<NetworkPlugin> *result, Errors &error);
 
-void ProbeNetworkPlugins(const std::string &pluginDir, const std::string &binDir,
+void ProbeNetworkPlugins(const std::string &pluginDir, const std::string &binDir, const std::string &rootDir,
                          std::vector<std::shared_ptr<NetworkPlugin>> *plugins);
 
 std::string GetPodIP(const std::string &nsenterPath, const std::string &netnsPath, const std::string &interfaceName,
@@ -0,0 +1,119 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-04-16
+ * Description: provide cache of pod ips functions
+ ******************************************************************************/
+#include "pod_ip_cache.h"
+
+#include "log.h"
+
+namespace Network {
+bool PodIPCache::Find(const std::string &podSandboxID, const std::string &interfaceName, std::string &ip,
+                      bool &known)
+{
+    auto iter = m_podIPs.find(podSandboxID);
+    if (iter == m_podIPs.end()) {
+        known = false;
+        return false;
+    }
+    known = true;
+    auto ipIter = iter->second.find(interfaceName);
+    if (ipIter == iter->second.end()) {
+        return false;
+    }
+    ip = ipIter->second;
+    return true;
+}
+
+bool PodIPCache::Get(const std::string &podSandboxID, const std::string &interfaceName, std::string &ip)
+{
+    bool found { false };
+    bool known { false };
+    std::map<std::string, std::string> loaded;
+
+    if (pthread_rwlock_rdlock(&m_podIPsLock) != 0) {
+        ERROR("Failed to get read lock of pod ips");
+        return false;
+    }
+    found = Find(podSandboxID, interfaceName, ip, known);
+    (void)pthread_rwlock_unlock(&m_podIPsLock);
+    if (known) {
+        return found;
+    }
+
+    // first query after isulad restart, checkpoint does not change until we unlock
+    std::lock_guard<std::mutex> checkpointLock(m_checkpointMutex);
+    LoadCheckpoint(podSandboxID, loaded);
+
+    if (pthread_rwlock_wrlock(&m_podIPsLock) != 0) {
+        ERROR("Failed to get write lock of pod ips");
+        return false;
+    }
+    if (!loaded.empty() && m_podIPs.find(podSandboxID) == m_podIPs.end()) {
+        m_podIPs[podSandboxID] = loaded;
+    }
+    found = Find(podSandboxID, interfaceName, ip, known);
+    (void)pthread_rwlock_unlock(&m_podIPsLock);
+
+    return found;
+}
+
+void PodIPCache::Add(const std::string &podSandboxID, const std::string &interfaceName, const std::string &ip,
+                     const std::string &jsonCheckpoint)
+{
+    std::map<std::string, std::string> podIPs;
+    std::unique_lock<std::mutex> checkpointLock(m_checkpointMutex, std::defer_lock);
+
+    if (podSandboxID.empty() || interfaceName.empty() || ip.empty()) {
+        return;
+    }
+
+    if (!jsonCheckpoint.empty()) {
+        checkpointLock.lock();
+    }
+    if (pthread_rwlock_wrlock(&m_podIPsLock) != 0) {
+        ERROR("Failed to get write lock of pod ips");
+        return;
+    }
+    m_podIPs[podSandboxID][interfaceName] = ip;
+    podIPs = m_podIPs[podSandboxID];
+    (void)pthread_rwlock_unlock(&m_podIPsLock);
+
+    if (!jsonCheckpoint.empty()) {
+        SaveCheckpoint(podSandboxID, podIPs, jsonCheckpoint);
+    }
+}
+
+void PodIPCache::Remove(const std::string &podSandboxID, const std::string &interfaceName,
+                        const std::string &jsonCheckpoint)
+{
+    std::map<std::string, std::string> remain;
+    std::lock_guard<std::mutex> checkpointLock(m_checkpointMutex);
+
+    if (pthread_rwlock_wrlock(&m_podIPsLock) != 0) {
+        ERROR("Failed to get write lock of pod ips");
+        return;
+    }
+    auto iter = m_podIPs.find(podSandboxID);
+    if (iter != m_podIPs.end()) {
+        iter->second.erase(interfaceName);
+        remain = iter->second;
+        if (remain.empty()) {
+            m_podIPs.erase(iter);
+        }
+    }
+    (void)pthread_rwlock_unlock(&m_podIPsLock);
+
+    SaveCheckpoint(podSandboxID, remain, jsonCheckpoint);
+}
+
+} // namespace Network
@@ -0,0 +1,60 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-04-16
+ * Description: provide cache of pod ips definition
+ ******************************************************************************/
+
+#ifndef _CRI_POD_IP_CACHE_H_
+#define _CRI_POD_IP_CACHE_H_
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <pthread.h>
+
+namespace Network {
+// Pod ips recorded from cni results, podSandboxID -> (interface name -> ip).
+// Checkpoints are written in the order of updates, but never with the map
+// locked, so queries of pod ips do not wait for file IO.
+class PodIPCache {
+public:
+    PodIPCache() = default;
+    PodIPCache(const PodIPCache &) = delete;
+    PodIPCache &operator=(const PodIPCache &) = delete;
+    virtual ~PodIPCache() = default;
+
+    // load checkpoint of pod on first query after restart
+    bool Get(const std::string &podSandboxID, const std::string &interfaceName, std::string &ip);
+    // jsonCheckpoint is the sandbox checkpoint to store ips with, empty means only cache in memory
+    void Add(const std::string &podSandboxID, const std::string &interfaceName, const std::string &ip,
+             const std::string &jsonCheckpoint);
+    void Remove(const std::string &podSandboxID, const std::string &interfaceName, const std::string &jsonCheckpoint);
+
+protected:
+    // remove checkpoint of pod if podIPs or jsonCheckpoint is empty
+    virtual void SaveCheckpoint(const std::string &podSandboxID, const std::map<std::string, std::string> &podIPs,
+                                const std::string &jsonCheckpoint) = 0;
+    virtual void LoadCheckpoint(const std::string &podSandboxID, std::map<std::string, std::string> &podIPs) = 0;
+
+private:
+    // must be called with m_podIPsLock locked
+    bool Find(const std::string &podSandboxID, const std::string &interfaceName, std::string &ip, bool &known);
+
+    // serializes checkpoint IO, taken before m_podIPsLock
+    std::mutex m_checkpointMutex;
+    pthread_rwlock_t m_podIPsLock = PTHREAD_RWLOCK_INITIALIZER;
+    std::map<std::string, std::map<std::string, std::string>> m_podIPs;
+};
+
+} // namespace Network
+
+#endif
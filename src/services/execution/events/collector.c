@@ -37,15 +37,20 @@
 
 static struct context_lists g_context_lists;
 
-struct events_lists {
-    unsigned int size;
-    pthread_mutex_t event_mutex;
-    struct linked_list event_list;
-};
-static struct events_lists g_events_buffer;
-
 #define EVENTSLIMIT 64
 
+/*
+ * Ring of the latest EVENTSLIMIT events. Events are appended by the monitor
+ * thread in timestamp order, so the ring is sorted from the oldest slot.
+ */
+struct events_ring {
+    pthread_rwlock_t rwlock;
+    /* number of events ever appended, the n-th event lives in slot n % EVENTSLIMIT */
+    uint64_t appended;
+    struct isulad_events_format events[EVENTSLIMIT];
+};
+static struct events_ring g_events_buffer;
+
 struct context_elem {
     stream_func_wrapper stream;
     char *name;
@@ -697,62 +702,44 @@ static int event_copy(const struct isulad_events_format *src, struct isulad_even
     return 0;
 }
 
+static void event_clear(struct isulad_events_format *event)
+{
+    free(event->id);
+    free(event->opt);
+    util_free_array_by_len(event->annotations, event->annotations_len);
+    (void)memset(event, 0, sizeof(struct isulad_events_format));
+}
+
 /* events append */
 static void events_append(const struct isulad_events_format *event)
 {
-    struct isulad_events_format *tmpevent = NULL;
-    struct linked_list *newnode = NULL;
-    struct linked_list *firstnode = NULL;
+    struct isulad_events_format *slot = NULL;
+    struct isulad_events_format newevent = { 0 };
+    struct isulad_events_format oldevent = { 0 };
+
+    /* copy and free outside of the lock, only swap the slot while holding it */
+    if (event_copy(event, &newevent) != 0) {
+        CRIT("Failed to copy event.");
+        event_clear(&newevent);
+        return;
+    }
 
-    if (pthread_mutex_lock(&g_events_buffer.event_mutex)) {
+    if (pthread_rwlock_wrlock(&g_events_buffer.rwlock)) {
         WARN("Failed to lock");
+        event_clear(&newevent);
         return;
     }
 
-    if (g_events_buffer.size < EVENTSLIMIT) {
-        newnode = util_common_calloc_s(sizeof(struct linked_list));
-        if (newnode == NULL) {
-            CRIT("Memory allocation error.");
-            goto unlock;
-        }
-
-        tmpevent = util_common_calloc_s(sizeof(struct isulad_events_format));
-        if (tmpevent == NULL) {
-            CRIT("Memory allocation error.");
-            free(newnode);
-            goto unlock;
-        }
-
-        if (event_copy(event, tmpevent) != 0) {
-            CRIT("Failed to copy event.");
-            isulad_events_format_free(tmpevent);
-            free(newnode);
-            goto unlock;
-        }
-
-        linked_list_add_elem(newnode, tmpevent);
-        linked_list_add_tail(&g_events_buffer.event_list, newnode);
-        g_events_buffer.size++;
-    } else {
-        firstnode = linked_list_first_node(&g_events_buffer.event_list);
-        if (firstnode != NULL) {
-            linked_list_del(firstnode);
-
-            tmpevent = (struct isulad_events_format *)firstnode->elem;
-            if (event_copy(event, tmpevent) != 0) {
-                CRIT("Failed to copy event.");
-                goto unlock;
-            }
-
-            linked_list_add_tail(&g_events_buffer.event_list, firstnode);
-        }
-    }
+    slot = &g_events_buffer.events[g_events_buffer.appended % EVENTSLIMIT];
+    oldevent = *slot;
+    *slot = newevent;
+    g_events_buffer.appended++;
 
-unlock:
-    if (pthread_mutex_unlock(&g_events_buffer.event_mutex)) {
+    if (pthread_rwlock_unlock(&g_events_buffer.rwlock)) {
         WARN("Failed to unlock");
-        return;
     }
+
+    event_clear(&oldevent);
 }
 
 static int do_write_events(const stream_func_wrapper *stream, struct isulad_events_format *event)
@@ -793,32 +780,103 @@ static int check_util_time(const types_timestamp_t *until, const struct isulad_e
     return 0;
 }
 
+/* notes: this funciton must be called with g_events_buffer.rwlock */
+static const struct isulad_events_format *events_ring_get(uint64_t seq)
+{
+    return &g_events_buffer.events[seq % EVENTSLIMIT];
+}
+
+/*
+ * find the first buffered event not before since by binary search.
+ * notes: this funciton must be called with g_events_buffer.rwlock
+ */
+static uint64_t events_ring_lower_bound(const types_timestamp_t *since)
+{
+    uint64_t low = 0;
+    uint64_t high = g_events_buffer.appended;
+    uint64_t mid = 0;
+
+    if (g_events_buffer.appended > EVENTSLIMIT) {
+        low = g_events_buffer.appended - EVENTSLIMIT;
+    }
+
+    if (since == NULL || !(since->has_seconds || since->has_nanos)) {
+        return low;
+    }
+
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        if (check_since_time(since, events_ring_get(mid)) != 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/* copy events in [since, until] out of the ring, so slow clients never block the monitor thread */
+static int events_ring_snapshot(const types_timestamp_t *since, const types_timestamp_t *until,
+                                struct isulad_events_format **events, size_t *events_len)
+{
+    int ret = 0;
+    size_t len = 0;
+    uint64_t seq = 0;
+    const struct isulad_events_format *c_event = NULL;
+
+    *events = util_smart_calloc_s(sizeof(struct isulad_events_format), EVENTSLIMIT);
+    if (*events == NULL) {
+        ERROR("Out of memory");
+        return -1;
+    }
+
+    if (pthread_rwlock_rdlock(&g_events_buffer.rwlock)) {
+        WARN("Failed to lock");
+        free(*events);
+        *events = NULL;
+        return -1;
+    }
+
+    for (seq = events_ring_lower_bound(since); seq < g_events_buffer.appended; seq++) {
+        c_event = events_ring_get(seq);
+        if (check_util_time(until, c_event) != 0) {
+            break;
+        }
+        if (event_copy(c_event, &(*events)[len]) != 0) {
+            ret = -1;
+            break;
+        }
+        len++;
+    }
+
+    if (pthread_rwlock_unlock(&g_events_buffer.rwlock)) {
+        WARN("Failed to unlock");
+    }
+
+    *events_len = len;
+    return ret;
+}
+
 static int do_subscribe(const char *name, const types_timestamp_t *since, const types_timestamp_t *until,
                         const stream_func_wrapper *stream)
 {
     bool regflag = false;
     int ret = 0;
+    size_t i = 0;
+    size_t events_len = 0;
     regex_t preg;
     regmatch_t regmatch = { 0 };
-    struct linked_list *it = NULL;
-    struct linked_list *next = NULL;
+    struct isulad_events_format *events = NULL;
     struct isulad_events_format *c_event = NULL;
 
-    if (pthread_mutex_lock(&g_events_buffer.event_mutex)) {
-        WARN("Failed to lock");
-        return -1;
+    ret = events_ring_snapshot(since, until, &events, &events_len);
+    if (ret != 0) {
+        goto out;
     }
 
-    linked_list_for_each_safe(it, &g_events_buffer.event_list, next) {
-        c_event = (struct isulad_events_format *)it->elem;
-
-        if (check_since_time(since, c_event) != 0) {
-            continue;
-        }
-
-        if (check_util_time(until, c_event) != 0) {
-            break;
-        }
+    for (i = 0; i < events_len; i++) {
+        c_event = &events[i];
 
         if (regflag) {
             regfree(&preg);
@@ -837,12 +895,14 @@ static int do_subscribe(const char *name, const types_timestamp_t *since, const
         }
     }
 
-    if (pthread_mutex_unlock(&g_events_buffer.event_mutex)) {
-        WARN("Failed to unlock");
-    }
+out:
     if (regflag) {
         regfree(&preg);
     }
+    for (i = 0; events != NULL && i < EVENTSLIMIT; i++) {
+        event_clear(&events[i]);
+    }
+    free(events);
 
     return ret;
 }
@@ -1164,8 +1224,7 @@ int newcollector()
     pthread_t exit_thread;
 
     linked_list_init(&(g_context_lists.context_list));
-    linked_list_init(&(g_events_buffer.event_list));
-    g_events_buffer.size = 0;
+    g_events_buffer.appended = 0;
 
     ret = pthread_mutex_init(&(g_context_lists.context_mutex), NULL);
     if (ret != 0) {
@@ -1173,9 +1232,9 @@ int newcollector()
         goto out;
     }
 
-    ret = pthread_mutex_init(&(g_events_buffer.event_mutex), NULL);
+    ret = pthread_rwlock_init(&(g_events_buffer.rwlock), NULL);
     if (ret != 0) {
-        CRIT("Mutex initialization failed");
+        CRIT("Rwlock initialization failed");
         pthread_mutex_destroy(&(g_context_lists.context_mutex));
         goto out;
     }
@@ -1185,7 +1244,7 @@ int newcollector()
     if (ret != 0) {
         CRIT("Thread creation failed");
         pthread_mutex_destroy(&(g_context_lists.context_mutex));
-        pthread_mutex_destroy(&(g_events_buffer.event_mutex));
+        pthread_rwlock_destroy(&(g_events_buffer.rwlock));
         goto out;
     }
 
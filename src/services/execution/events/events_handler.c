@@ -145,7 +145,7 @@ static int container_state_changed(container_t *cont, const struct isulad_events
             started_at = NULL;
 
             if (should_restart) {
-                cont->common_config->restart_count++;
+                container_inc_restart_count(cont);
                 state_set_restarting(cont->state, (int)events->exit_status);
                 container_wait_stop_cond_broadcast(cont);
                 INFO("Try to restart container %s after %.2fs", id, (double)timeout / Time_Second);
@@ -165,7 +165,7 @@ static int container_state_changed(container_t *cont, const struct isulad_events
                 }
             }
 
-            if (container_to_disk(cont)) {
+            if (container_state_to_disk(cont)) {
                 container_unlock(cont);
                 ERROR("Failed to save container \"%s\" to disk", id);
                 ret = -1;
@@ -1024,7 +1024,7 @@ set_stopped:
     }
 
 save_container:
-    if (container_to_disk(cont)) {
+    if (container_state_to_disk(cont)) {
         ERROR("Failed to save container \"%s\" to disk", cont->common_config->id);
         ret = -1;
         goto out;
@@ -1085,7 +1085,7 @@ static int container_start_prepare(container_t *cont, const container_start_requ
 {
     const char *id = cont->common_config->id;
 
-    if (container_to_disk_locking(cont)) {
+    if (container_state_to_disk_locking(cont)) {
         ERROR("Failed to save container \"%s\" to disk", id);
         isulad_set_error_message("Failed to save container \"%s\" to disk", id);
         return -1;
@@ -1191,7 +1191,7 @@ static int kill_with_signal(container_t *cont, uint32_t signal)
         goto out;
     }
     cont->common_config->has_been_manually_stopped = true;
-    (void)container_to_disk(cont);
+    (void)container_state_to_disk(cont);
 
     if (!is_running(cont->state)) {
         INFO("Container %s is already stopped", id);
@@ -1345,7 +1345,7 @@ static int restart_container(container_t *cont)
         update_start_and_finish_time(cont->state, timebuffer);
     }
 
-    if (container_to_disk(cont)) {
+    if (container_state_to_disk(cont)) {
         ERROR("Failed to save container \"%s\" to disk", cont->common_config->id);
         ret = -1;
         goto out;
@@ -1371,7 +1371,7 @@ static uint32_t stop_and_start(container_t *cont, int timeout)
 
     /* begin start container */
     state_set_starting(cont->state);
-    if (container_to_disk_locking(cont)) {
+    if (container_state_to_disk_locking(cont)) {
         ERROR("Failed to save container \"%s\" to disk", id);
         cc = ISULAD_ERR_EXEC;
         isulad_set_error_message("Failed to save container \"%s\" to disk", id);
@@ -1758,7 +1758,7 @@ static int do_cleanup_container_resources(container_t *cont)
     }
     container_unref(cont_tmp);
 
-    (void)container_to_disk(cont);
+    (void)container_state_to_disk(cont);
 
     if (gc_is_gc_progress(id)) {
         isulad_set_error_message("You cannot remove container %s in garbage collector progress.", id);
@@ -424,6 +424,7 @@ static int get_containers_stats(char **idsarray, size_t ids_len, const struct st
         if (is_running(cont->state)) {
             rt_stats_params_t params = { 0 };
             params.rootpath = cont->root_path;
+            params.state = cont->state_path;
 
             nret = runtime_resources_stats(cont->common_config->id, cont->runtime, &params, &einfo);
             if (nret != 0) {
@@ -532,7 +533,7 @@ static int do_resume_container(container_t *cont)
 
     update_health_monitor(cont->common_config->id);
 
-    if (container_to_disk(cont)) {
+    if (container_state_to_disk(cont)) {
         ERROR("Failed to save container \"%s\" to disk", id);
         ret = -1;
         goto out;
@@ -720,7 +721,7 @@ static int pause_container(container_t *cont)
 
     update_health_monitor(cont->common_config->id);
 
-    if (container_to_disk(cont)) {
+    if (container_state_to_disk(cont)) {
         ERROR("Failed to save container \"%s\" to disk", id);
         ret = -1;
         goto out;
@@ -89,72 +89,15 @@ pack_response:
     return (cc == ISULAD_SUCCESS) ? 0 : -1;
 }
 
-#define STOP_JSON "{\"filters\":{\"status\":{\"exited\":true}}}"
-#define CREATED_JSON "{\"filters\":{\"status\":{\"created\":true}}}"
-static int get_container_nums(int *cRunning, int *cPaused, int *cStopped)
+static void get_container_nums(int *cRunning, int *cPaused, int *cStopped)
 {
-    container_list_request *list_running_request = NULL;
-    container_list_request *list_stopped_request = NULL;
-    container_list_request *list_created_request = NULL;
-    container_list_response *list_running_response = NULL;
-    container_list_response *list_stopped_response = NULL;
-    container_list_response *list_created_response = NULL;
-    int ret = 0;
-    parser_error err = NULL;
-
-    list_running_request = util_common_calloc_s(sizeof(*list_running_request));
-    if (list_running_request == NULL) {
-        ERROR("Out of memory!");
-        ret = -1;
-        goto out;
-    }
-
-    ret = container_list_cb(list_running_request, &list_running_response);
-    if (ret != 0) {
-        ERROR("Failed to get container list info!");
-        ret = -1;
-        goto out;
-    }
-    *cRunning = (int)list_running_response->containers_len;
+    container_state_counters_t counters = { 0 };
 
-    list_created_request = container_list_request_parse_data(CREATED_JSON, NULL, &err);
-    if (list_created_request == NULL) {
-        ERROR("Failed to parse json: %s", err);
-        ret = -1;
-        goto out;
-    }
+    container_state_get_counters(&counters);
 
-    ret = container_list_cb(list_created_request, &list_created_response);
-    if (ret != 0) {
-        ERROR("Failed to get container list info!");
-        ret = -1;
-        goto out;
-    }
-
-    list_stopped_request = container_list_request_parse_data(STOP_JSON, NULL, &err);
-    if (list_stopped_request == NULL) {
-        ERROR("Failed to parse json: %s", err);
-        ret = -1;
-        goto out;
-    }
-
-    ret = container_list_cb(list_stopped_request, &list_stopped_response);
-    if (ret != 0) {
-        ERROR("Failed to get container list info!");
-        ret = -1;
-        goto out;
-    }
-    *cStopped = (int)(list_stopped_response->containers_len + list_created_response->containers_len);
-
-out:
-    free_container_list_request(list_running_request);
-    free_container_list_request(list_stopped_request);
-    free_container_list_request(list_created_request);
-    free_container_list_response(list_running_response);
-    free_container_list_response(list_stopped_response);
-    free_container_list_response(list_created_response);
-    free(err);
-    return ret;
+    *cRunning = (int)counters.running;
+    *cPaused = (int)counters.paused;
+    *cStopped = (int)counters.stopped;
 }
 
 static int get_proxy_env(char **proxy, const char *type)
@@ -216,12 +159,7 @@ static int isulad_info_cb(const host_info_request *request, host_info_response *
         goto pack_response;
     }
 
-    ret = get_container_nums(&cRunning, &cPaused, &cStopped);
-    if (ret != 0) {
-        ERROR("Failed to get container status info!");
-        cc = ISULAD_ERR_EXEC;
-        goto pack_response;
-    }
+    get_container_nums(&cRunning, &cPaused, &cStopped);
 
     im_request = util_common_calloc_s(sizeof(im_image_count_request));
     if (im_request == NULL) {
@@ -565,8 +503,8 @@ out:
     return pid_arg;
 }
 
-static int get_pids(const char *name, const char *runtime, const char *rootpath, pid_t **pids, size_t *pids_len,
-                    char **pid_args)
+static int get_pids(const char *name, const char *runtime, const char *rootpath, const char *statepath, pid_t **pids,
+                    size_t *pids_len, char **pid_args)
 {
     int ret = 0;
     size_t i = 0;
@@ -581,6 +519,7 @@ static int get_pids(const char *name, const char *runtime, const char *rootpath,
     }
 
     params.rootpath = rootpath;
+    params.state = statepath;
 
     if (runtime_listpids(name, runtime, &params, out) != 0) {
         ERROR("runtime failed to list pids");
@@ -784,7 +723,7 @@ static int container_top_cb(container_top_request *request, container_top_respon
     runtime = cont->runtime;
     set_log_prefix(id);
 
-    if (get_pids(id, runtime, rootpath, &pids, &pids_len, &pid_args) != 0) {
+    if (get_pids(id, runtime, rootpath, cont->state_path, &pids, &pids_len, &pid_args) != 0) {
         ERROR("failed to get all pids");
         cc = ISULAD_ERR_EXEC;
         goto pack_response;
@@ -1350,13 +1289,11 @@ out:
  * -1: no such container with "id"
  * -2: have the container with "id", but failed to inspect due to other reasons
 */
-static int inspect_container_helper(const char *id, int timeout, char **container_json)
+static int inspect_container_data(const char *id, int timeout, container_inspect **out_inspect)
 {
     int ret = 0;
     container_inspect *inspect = NULL;
-    parser_error err = NULL;
     container_t *cont = NULL;
-    struct parser_context ctx = { OPT_GEN_KAY_VALUE | OPT_GEN_SIMPLIFY, 0 };
 
     if (!util_valid_container_id_or_name(id)) {
         ERROR("Inspect invalid name %s", id);
@@ -1385,17 +1322,38 @@ static int inspect_container_helper(const char *id, int timeout, char **containe
         goto unlock;
     }
 
+    *out_inspect = inspect;
+    inspect = NULL;
+
+unlock:
+    container_unlock(cont);
+out:
+    container_unref(cont);
+    free_container_inspect(inspect);
+
+    return ret;
+}
+
+static int inspect_container_helper(const char *id, int timeout, char **container_json)
+{
+    int ret = 0;
+    container_inspect *inspect = NULL;
+    parser_error err = NULL;
+    struct parser_context ctx = { OPT_GEN_KAY_VALUE | OPT_GEN_SIMPLIFY, 0 };
+
+    ret = inspect_container_data(id, timeout, &inspect);
+    if (ret != 0) {
+        goto out;
+    }
+
     *container_json = container_inspect_generate_json(inspect, &ctx, &err);
     if (*container_json == NULL) {
         ERROR("Failed to generate inspect json:%s", err);
         ret = -2;
-        goto unlock;
+        goto out;
     }
 
-unlock:
-    container_unlock(cont);
 out:
-    container_unref(cont);
     free_container_inspect(inspect);
     free(err);
 
@@ -1455,6 +1413,31 @@ pack_response:
     return (cc == ISULAD_SUCCESS) ? 0 : -1;
 }
 
+static int container_inspect_struct_cb(const container_inspect_request *request, container_inspect **inspect,
+                                      char **errmsg)
+{
+    int ret = 0;
+
+    DAEMON_CLEAR_ERRMSG();
+
+    if (request == NULL || request->id == NULL || inspect == NULL || errmsg == NULL) {
+        ERROR("Invalid NULL input");
+        return -1;
+    }
+
+    DEBUG("Inspect struct :%s", request->id);
+
+    if (inspect_container_data(request->id, request->timeout, inspect) != 0) {
+        if (g_isulad_errmsg != NULL) {
+            *errmsg = util_strdup_s(g_isulad_errmsg);
+            DAEMON_CLEAR_ERRMSG();
+        }
+        ret = -1;
+    }
+
+    return ret;
+}
+
 static void pack_wait_response(container_wait_response *response, uint32_t cc, uint32_t exit_code)
 {
     if (response == NULL) {
@@ -1711,6 +1694,7 @@ void container_information_callback_init(service_container_callback_t *cb)
     cb->version = container_version_cb;
     cb->info = isulad_info_cb;
     cb->inspect = container_inspect_cb;
+    cb->inspect_struct = container_inspect_struct_cb;
     cb->list = container_list_cb;
     cb->wait = container_wait_cb;
     cb->top = container_top_cb;
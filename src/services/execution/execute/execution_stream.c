@@ -43,6 +43,7 @@
 #include "containers_gc.h"
 #include "error.h"
 #include "logger_json_file.h"
+#include "log_file_reader.h"
 #include "constants.h"
 #include "runtime.h"
 #include "collector.h"
@@ -1243,7 +1244,7 @@ static container_path_stat *resolve_and_stat_path(const char *rootpath, const ch
     return stat;
 }
 
-static int pause_container(const container_t *cont)
+static int pause_container(container_t *cont)
 {
     int ret = 0;
     rt_pause_params_t params = { 0 };
@@ -1259,7 +1260,7 @@ static int pause_container(const container_t *cont)
 
     state_set_paused(cont->state);
 
-    if (container_to_disk(cont)) {
+    if (container_state_to_disk(cont)) {
         ERROR("Failed to save container \"%s\" to disk", id);
         ret = -1;
         goto out;
@@ -1269,7 +1270,7 @@ out:
     return ret;
 }
 
-static int resume_container(const container_t *cont)
+static int resume_container(container_t *cont)
 {
     int ret = 0;
     rt_resume_params_t params = { 0 };
@@ -1285,7 +1286,7 @@ static int resume_container(const container_t *cont)
 
     state_reset_paused(cont->state);
 
-    if (container_to_disk(cont)) {
+    if (container_state_to_disk(cont)) {
         ERROR("Failed to save container \"%s\" to disk", id);
         ret = -1;
         goto out;
@@ -1438,7 +1439,8 @@ static ssize_t extract_stream_to_io_read(void *content, void *buf, size_t buf_le
     return (ssize_t)(copy.data_len);
 }
 
-int read_and_extract_archive(stream_func_wrapper *stream, const char *resolved_path, const char *transform)
+int read_and_extract_archive(stream_func_wrapper *stream, const char *resolved_path, const char *src_base,
+                             const char *dst_base)
 {
     int ret = -1;
     char *err = NULL;
@@ -1446,7 +1448,7 @@ int read_and_extract_archive(stream_func_wrapper *stream, const char *resolved_p
 
     content.context = stream;
     content.read = extract_stream_to_io_read;
-    ret = archive_untar(&content, false, resolved_path, transform, &err);
+    ret = archive_untar(&content, false, resolved_path, src_base, dst_base, &err);
     if (ret != 0) {
         ERROR("Can not untar to container: %s", (err != NULL) ? err : "unknown");
         isulad_set_error_message("Can not untar to container: %s", (err != NULL) ? err : "unknown");
@@ -1456,7 +1458,7 @@ int read_and_extract_archive(stream_func_wrapper *stream, const char *resolved_p
 }
 
 static char *copy_to_container_get_dstdir(const container_t *cont, const container_copy_to_request *request,
-                                          char **transform)
+                                          char **src_base, char **dst_base)
 {
     char *dstdir = NULL;
     char *error = NULL;
@@ -1497,7 +1499,7 @@ static char *copy_to_container_get_dstdir(const container_t *cont, const contain
     srcinfo.path = request->src_path;
     srcinfo.rebase_name = request->src_rebase_name;
 
-    dstdir = prepare_archive_copy(&srcinfo, dstinfo, transform, &error);
+    dstdir = prepare_archive_copy(&srcinfo, dstinfo, src_base, dst_base, &error);
     if (dstdir == NULL) {
         if (error == NULL) {
             ERROR("Can not prepare archive copy");
@@ -1592,7 +1594,8 @@ static int copy_to_container_cb(const container_copy_to_request *request,
     char *resolvedpath = NULL;
     char *abspath = NULL;
     char *dstdir = NULL;
-    char *transform = NULL;
+    char *src_base = NULL;
+    char *dst_base = NULL;
     container_t *cont = NULL;
     bool need_pause = false;
 
@@ -1629,7 +1632,7 @@ static int copy_to_container_cb(const container_copy_to_request *request,
         goto unpause_container;
     }
 
-    dstdir = copy_to_container_get_dstdir(cont, request, &transform);
+    dstdir = copy_to_container_get_dstdir(cont, request, &src_base, &dst_base);
     if (dstdir == NULL) {
         goto cleanup_rootfs;
     }
@@ -1644,7 +1647,7 @@ static int copy_to_container_cb(const container_copy_to_request *request,
         goto cleanup_rootfs;
     }
 
-    nret = read_and_extract_archive(stream, resolvedpath, transform);
+    nret = read_and_extract_archive(stream, resolvedpath, src_base, dst_base);
     if (nret < 0) {
         ERROR("Failed to send archive data");
         goto cleanup_rootfs;
@@ -1675,7 +1678,8 @@ pack_response:
     free(resolvedpath);
     free(abspath);
     free(dstdir);
-    free(transform);
+    free(src_base);
+    free(dst_base);
     return ret;
 }
 
@@ -1699,94 +1703,6 @@ static int container_logs_cb_check(const struct isulad_logs_request *request, st
     return 0;
 }
 
-static int do_decode_write_log_entry(const char *json_str, const stream_func_wrapper *stream)
-{
-    bool write_ok = false;
-    int ret = -1;
-    parser_error jerr = NULL;
-    logger_json_file *logentry = NULL;
-    struct parser_context ctx = { OPT_GEN_SIMPLIFY | OPT_GEN_NO_VALIDATE_UTF8, stderr };
-
-    logentry = logger_json_file_parse_data(json_str, &ctx, &jerr);
-    if (logentry == NULL) {
-        ERROR("parse logentry: %s, failed: %s", json_str, jerr);
-        goto out;
-    }
-
-    /* send to client */
-    write_ok = stream->write_func(stream->writer, logentry);
-    if (!write_ok) {
-        ERROR("Send log to client failed");
-        goto out;
-    }
-
-    ret = 0;
-out:
-    free_logger_json_file(logentry);
-    free(jerr);
-    return ret;
-}
-
-/*
- * return:
- *      <  0, mean read failed
- *      == 0, mean read zero line
- *      >  0, mean read many lines
- * */
-static int64_t do_read_log_file(const char *path, int64_t require_line, long pos, const stream_func_wrapper *stream,
-                                long *last_pos)
-{
-#define MAX_JSON_DECODE_RETRY 20
-    int retries = 0;
-    int decode_retries = 0;
-    int64_t read_lines = 0;
-    FILE *fp = NULL;
-    char buffer[MAXLINE + 1] = { 0 };
-
-    for (retries = 0; retries <= LOG_MAX_RETRIES; retries++) {
-        fp = util_fopen(path, "r");
-        if (fp != NULL || errno != ENOENT) {
-            break;
-        }
-        /* fopen is too fast, need wait rename operator finish */
-        usleep_nointerupt(1000);
-    }
-    if (fp == NULL) {
-        ERROR("open file: %s failed: %s", path, strerror(errno));
-        return -1;
-    }
-    if (pos > 0 && fseek(fp, pos, SEEK_SET) != 0) {
-        ERROR("fseek to %ld failed: %s", pos, strerror(errno));
-        read_lines = -1;
-        goto out;
-    }
-    *last_pos = pos;
-
-    while (fgets(buffer, MAXLINE, fp) != NULL) {
-        (*last_pos) += (long)strlen(buffer);
-
-        if (do_decode_write_log_entry(buffer, stream) != 0) {
-            /* read a incomplete json object, try agin */
-            decode_retries++;
-            if (decode_retries < MAX_JSON_DECODE_RETRY) {
-                continue;
-            }
-            read_lines = -1;
-            goto out;
-        }
-        decode_retries = 0;
-
-        read_lines++;
-        if (read_lines == require_line) {
-            break;
-        }
-    }
-
-out:
-    fclose(fp);
-    return read_lines;
-}
-
 struct last_log_file_position {
     /* read file position */
     long pos;
@@ -1794,8 +1710,8 @@ struct last_log_file_position {
     int file_index;
 };
 
-static int do_read_all_container_logs(int64_t require_line, const char *path, const stream_func_wrapper *stream,
-                                      struct last_log_file_position *position)
+static int do_read_all_container_logs(int64_t require_line, int64_t since, const char *path,
+                                      const stream_func_wrapper *stream, struct last_log_file_position *position)
 {
     int ret = -1;
     int i = position->file_index;
@@ -1810,7 +1726,7 @@ static int do_read_all_container_logs(int64_t require_line, const char *path, co
             ERROR("Sprintf failed");
             goto out;
         }
-        read_lines = do_read_log_file(log_path, left_lines, pos, stream, &(position->pos));
+        read_lines = log_file_read_lines(log_path, left_lines, pos, since, stream, &(position->pos));
         if (read_lines < 0) {
             if (errno == ENOENT) {
                 continue;
@@ -1829,14 +1745,14 @@ static int do_read_all_container_logs(int64_t require_line, const char *path, co
             goto out;
         }
     }
-    read_lines = do_read_log_file(path, left_lines, pos, stream, &(position->pos));
+    read_lines = log_file_read_lines(path, left_lines, pos, since, stream, &(position->pos));
     ret = read_lines < 0 ? -1 : 0;
 out:
     position->file_index = i;
     return ret;
 }
 
-static int do_show_all_logs(const struct container_log_config *conf, const stream_func_wrapper *stream,
+static int do_show_all_logs(const struct container_log_config *conf, int64_t since, const stream_func_wrapper *stream,
                             struct last_log_file_position *last_pos)
 {
     int ret = 0;
@@ -1857,95 +1773,12 @@ static int do_show_all_logs(const struct container_log_config *conf, const strea
     }
     last_pos->file_index = index;
     last_pos->pos = 0;
-    ret = do_read_all_container_logs(-1, conf->path, stream, last_pos);
-out:
-    return ret;
-}
-
-static int do_tail_find(FILE *fp, int64_t require_line, int64_t *get_line, long *get_pos)
-{
-#define SECTION_SIZE 4096
-    char buffer[SECTION_SIZE] = { 0 };
-    size_t read_size, i;
-    long len, pos, step_size;
-    int ret = -1;
-
-    if (fseek(fp, 0L, SEEK_END) != 0) {
-        ERROR("Fseek failed: %s", strerror(errno));
-        goto out;
-    }
-    len = ftell(fp);
-    if (len < 0) {
-        ERROR("Ftell failed: %s", strerror(errno));
-        goto out;
-    }
-    if (len < SECTION_SIZE) {
-        pos = len;
-        step_size = len;
-    } else {
-        step_size = SECTION_SIZE;
-        pos = len - step_size;
-    }
-    while (true) {
-        if (fseek(fp, pos, SEEK_SET) != 0) {
-            ERROR("Fseek failed: %s", strerror(errno));
-            goto out;
-        }
-        read_size = fread(buffer, sizeof(char), (size_t)step_size, fp);
-        for (i = read_size; i > 0; i--) {
-            if (buffer[i - 1] != '\n') {
-                continue;
-            }
-            (*get_line) += 1;
-            if ((*get_line) > require_line) {
-                (*get_pos) = pos + (long)i;
-                (*get_line) = require_line;
-                ret = 0;
-                goto out;
-            }
-        }
-        if (pos == 0) {
-            break;
-        }
-        if (pos < step_size) {
-            step_size = pos;
-            pos = 0;
-        } else {
-            pos -= step_size;
-        }
-    }
-
-    ret = 0;
+    ret = do_read_all_container_logs(-1, since, conf->path, stream, last_pos);
 out:
     return ret;
 }
 
-static int util_find_tail_position(const char *file_name, int64_t require_line, int64_t *get_line, long *pos)
-{
-    FILE *fp = NULL;
-    int ret = -1;
-
-    if (file_name == NULL) {
-        return 0;
-    }
-    if (get_line == NULL || pos == NULL) {
-        ERROR("Invalid Arguments");
-        return -1;
-    }
-
-    fp = util_fopen(file_name, "rb");
-    if (fp == NULL) {
-        ERROR("open file: %s failed: %s", file_name, strerror(errno));
-        return -1;
-    }
-
-    ret = do_tail_find(fp, require_line, get_line, pos);
-
-    fclose(fp);
-    return ret;
-}
-
-static int do_tail_container_logs(int64_t require_line, const struct container_log_config *conf,
+static int do_tail_container_logs(int64_t require_line, int64_t since, const struct container_log_config *conf,
                                   const stream_func_wrapper *stream, struct last_log_file_position *last_pos)
 {
     int i, ret;
@@ -1956,19 +1789,19 @@ static int do_tail_container_logs(int64_t require_line, const struct container_l
 
     if (require_line < 0) {
         /* read all logs */
-        return do_show_all_logs(conf, stream, last_pos);
+        return do_show_all_logs(conf, since, stream, last_pos);
     }
     if (require_line == 0) {
         /* require empty logs */
         return 0;
     }
-    ret = util_find_tail_position(conf->path, left, &get_line, &pos);
+    ret = log_file_find_tail_position(conf->path, left, &get_line, &pos);
     if (ret != 0) {
         return -1;
     }
     if (pos != 0) {
         /* first line in first log file */
-        get_line = do_read_log_file(conf->path, require_line, pos, stream, &(last_pos->pos));
+        get_line = log_file_read_lines(conf->path, require_line, pos, since, stream, &(last_pos->pos));
         last_pos->file_index = 0;
         return get_line < 0 ? -1 : 0;
     }
@@ -1984,7 +1817,7 @@ static int do_tail_container_logs(int64_t require_line, const struct container_l
             ERROR("Sprintf failed");
             goto out;
         }
-        ret = util_find_tail_position(log_path, left, &get_line, &pos);
+        ret = log_file_find_tail_position(log_path, left, &get_line, &pos);
         if (ret != 0) {
             if (errno == ENOENT) {
                 i--;
@@ -2000,7 +1833,7 @@ static int do_tail_container_logs(int64_t require_line, const struct container_l
 
     last_pos->pos = pos;
     last_pos->file_index = i;
-    ret = do_read_all_container_logs(require_line, conf->path, stream, last_pos);
+    ret = do_read_all_container_logs(require_line, since, conf->path, stream, last_pos);
 out:
     return ret;
 }
@@ -2011,6 +1844,7 @@ struct follow_args {
     bool *finish;
     long last_file_pos;
     int last_file_index;
+    int64_t since;
 };
 
 static int handle_rotate(int fd, int wd, const char *path)
@@ -2103,7 +1937,7 @@ static int hanlde_events(int fd, const struct follow_args *farg)
         }
 
         last_pos.file_index = rename_cnt;
-        if (do_read_all_container_logs(write_cnt, farg->path, farg->stream, &last_pos) != 0) {
+        if (do_read_all_container_logs(write_cnt, farg->since, farg->path, farg->stream, &last_pos) != 0) {
             ERROR("Read all new logs failed");
             goto out;
         }
@@ -2153,7 +1987,7 @@ set_flag:
 }
 
 static int do_follow_log_file(const char *cid, stream_func_wrapper *stream, struct last_log_file_position *last_pos,
-                              const char *path)
+                              const char *path, int64_t since)
 {
     int ret = 0;
     bool finish = false;
@@ -2164,6 +1998,7 @@ static int do_follow_log_file(const char *cid, stream_func_wrapper *stream, stru
         .path = path,
         .last_file_pos = last_pos->pos,
         .last_file_index = last_pos->file_index,
+        .since = since,
         .stream = stream,
         .finish = finish_pointer,
     };
@@ -2266,6 +2101,7 @@ static int container_logs_cb(const struct isulad_logs_request *request, stream_f
     struct container_log_config *log_config = NULL;
     struct last_log_file_position last_pos = {0};
     Container_Status status = CONTAINER_STATUS_UNKNOWN;
+    int64_t since = 0;
 
     *response = (struct isulad_logs_response *)util_common_calloc_s(sizeof(struct isulad_logs_response));
     if (*response == NULL) {
@@ -2279,6 +2115,13 @@ static int container_logs_cb(const struct isulad_logs_request *request, stream_f
         goto out;
     }
 
+    if (request->since != NULL && to_unix_nanos_from_str(request->since, &since) != 0) {
+        ERROR("Invalid since time: %s", request->since);
+        cc = ISULAD_ERR_INPUT;
+        isulad_set_error_message("Invalid since time: %s", request->since);
+        goto out;
+    }
+
     cont = containers_store_get(request->id);
     if (cont == NULL) {
         ERROR("No such container: %s", request->id);
@@ -2316,7 +2159,7 @@ static int container_logs_cb(const struct isulad_logs_request *request, stream_f
     }
 
     /* tail of container log file */
-    if (do_tail_container_logs(request->tail, log_config, stream, &last_pos) != 0) {
+    if (do_tail_container_logs(request->tail, since, log_config, stream, &last_pos) != 0) {
         isulad_set_error_message("do tail log file failed");
         cc = ISULAD_ERR_EXEC;
         goto out;
@@ -2331,7 +2174,7 @@ static int container_logs_cb(const struct isulad_logs_request *request, stream_f
     }
 
     /* follow of container log file */
-    if (do_follow_log_file(id, stream, &last_pos, log_config->path) != 0) {
+    if (do_follow_log_file(id, stream, &last_pos, log_config->path, since) != 0) {
         isulad_set_error_message("do follow log file failed");
         cc = ISULAD_ERR_EXEC;
         goto out;
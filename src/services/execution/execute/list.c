@@ -15,6 +15,7 @@
 
 #include <stdio.h>
 #include <unistd.h>
+#include <regex.h>
 
 #include "log.h"
 #include "containers_store.h"
@@ -24,9 +25,31 @@
 #include "utils.h"
 #include "error.h"
 
+/* values of a filter field, a source matches if equal to or matches pattern of any value */
+struct list_filter_field {
+    char **values;
+    regex_t *regs;
+    /* value is not a valid pattern, only matched exactly */
+    bool *invalid;
+    size_t len;
+};
+
+struct list_label_filter {
+    char *key;
+    /* NULL if only existence of key is required */
+    char *value;
+};
+
 struct list_context {
     struct filters_args *ps_filters;
     container_list_request *list_config;
+
+    /* compiled from ps_filters once per request, matching a view needs no allocation */
+    struct list_filter_field names;
+    struct list_filter_field ids;
+    struct list_label_filter *labels;
+    size_t labels_len;
+    bool status_matched[CONTAINER_STATUS_MAX_STATE];
 };
 
 static int dup_container_list_request(const container_list_request *src, container_list_request **dest)
@@ -58,11 +81,45 @@ out:
     return ret;
 }
 
+static void free_list_filter_field(struct list_filter_field *field)
+{
+    size_t i;
+
+    for (i = 0; i < field->len; i++) {
+        if (!field->invalid[i]) {
+            regfree(&field->regs[i]);
+        }
+    }
+    free(field->regs);
+    field->regs = NULL;
+    free(field->invalid);
+    field->invalid = NULL;
+    util_free_array(field->values);
+    field->values = NULL;
+    field->len = 0;
+}
+
+static void free_list_label_filters(struct list_context *ctx)
+{
+    size_t i;
+
+    for (i = 0; i < ctx->labels_len; i++) {
+        free(ctx->labels[i].key);
+        free(ctx->labels[i].value);
+    }
+    free(ctx->labels);
+    ctx->labels = NULL;
+    ctx->labels_len = 0;
+}
+
 static void free_list_context(struct list_context *ctx)
 {
     if (ctx == NULL) {
         return;
     }
+    free_list_filter_field(&ctx->names);
+    free_list_filter_field(&ctx->ids);
+    free_list_label_filters(ctx);
     filters_args_free(ctx->ps_filters);
     ctx->ps_filters = NULL;
     free_container_list_request(ctx->list_config);
@@ -102,148 +159,6 @@ static const char *accepted_ps_filter_tags[] = {
     NULL
 };
 
-static int filter_by_name(const struct list_context *ctx, const map_t *map_id_name, const map_t *matches, bool idsearch)
-{
-    int ret = 0;
-    bool default_value = true;
-
-    if (ctx == NULL || map_id_name == NULL) {
-        return -1;
-    }
-
-    map_itor *itor = map_itor_new(map_id_name);
-    if (itor == NULL) {
-        ERROR("Out of memory");
-        ret = -1;
-        goto out;
-    }
-
-    for (; map_itor_valid(itor); map_itor_next(itor)) {
-        void *id = map_itor_key(itor);
-        const char *name = map_itor_value(itor);
-        if (idsearch && map_search(matches, id) == NULL) {
-            continue;
-        }
-        if (filters_args_match(ctx->ps_filters, "name", name)) {
-            if (!map_replace(matches, id, &default_value)) {
-                ERROR("Failed to insert");
-                map_itor_free(itor);
-                ret = -1;
-                goto out;
-            }
-        }
-    }
-    map_itor_free(itor);
-
-out:
-    return ret;
-}
-
-
-static int append_ids(const map_t *matches, char ***filtered_ids)
-{
-    map_itor *itor = map_itor_new(matches);
-    if (itor == NULL) {
-        ERROR("Out of memory");
-        return -1;
-    }
-
-    for (; map_itor_valid(itor); map_itor_next(itor)) {
-        if (util_array_append(filtered_ids, map_itor_key(itor)) != 0) {
-            ERROR("Append failed");
-            util_free_array(*filtered_ids);
-            *filtered_ids = NULL;
-            map_itor_free(itor);
-            return -1;
-        }
-    }
-    map_itor_free(itor);
-    return 0;
-}
-
-static int insert_matched_id(char **ids, map_t *matches, void *value, size_t ids_len)
-{
-    size_t i;
-
-    for (i = 0; i < ids_len; i++) {
-        container_t *cont = containers_store_get_by_prefix(ids[i]);
-        if (cont != NULL) {
-            bool inserted;
-            inserted = map_insert(matches, cont->common_config->id, value);
-            container_unref(cont);
-            if (!inserted) {
-                ERROR("Insert map failed: %s", ids[i]);
-                return -1;
-            }
-        }
-    }
-    return 0;
-}
-
-static inline void set_idsearch(size_t ids_len, bool *value)
-{
-    if (ids_len > 0) {
-        *value = true;
-    }
-}
-
-static char **filter_by_name_id_matches(const struct list_context *ctx, const map_t *map_id_name)
-{
-    int ret = 0;
-    size_t names_len, ids_len;
-    bool idsearch = false;
-    bool default_value = true;
-    char **names = NULL;
-    char **ids = NULL;
-    char **filtered_ids = NULL;
-    map_t *matches = NULL;
-
-    names = filters_args_get(ctx->ps_filters, "name");
-    names_len = util_array_len((const char **)names);
-
-    ids = filters_args_get(ctx->ps_filters, "id");
-    ids_len = util_array_len((const char **)ids);
-    if (names_len == 0 && ids_len == 0) {
-        if (append_ids(map_id_name, &filtered_ids) != 0) {
-            goto cleanup;
-        }
-        return filtered_ids;
-    }
-
-    set_idsearch(ids_len, &idsearch);
-
-    matches = map_new(MAP_STR_BOOL, MAP_DEFAULT_CMP_FUNC, MAP_DEFAULT_FREE_FUNC);
-    if (matches == NULL) {
-        ERROR("Out of memory");
-        goto cleanup;
-    }
-
-
-    if (insert_matched_id(ids, matches, &default_value, ids_len) != 0) {
-        goto cleanup;
-    }
-
-    if (names_len > 0) {
-        ret = filter_by_name(ctx, map_id_name, matches, idsearch);
-        if (ret != 0) {
-            goto cleanup;
-        }
-    }
-
-    if (map_size(matches) > 0) {
-        if (append_ids(map_id_name, &filtered_ids) != 0) {
-            goto cleanup;
-        }
-    }
-
-cleanup:
-    util_free_array(ids);
-    util_free_array(names);
-    map_free(matches);
-    return filtered_ids;
-}
-
-
 int dup_json_map_string_string(const json_map_string_string *src, json_map_string_string *dest)
 {
     int ret = 0;
@@ -281,283 +196,199 @@ out:
     return ret;
 }
 
-char *container_get_health_state(const container_config_v2_state *cont_state)
+static int compile_filter_field(const struct filters_args *filters, const char *key, struct list_filter_field *field)
 {
-    if (cont_state == NULL || cont_state->health == NULL || cont_state->health->status == NULL) {
-        return NULL;
-    }
+    size_t i;
 
-    if (strcmp(cont_state->health->status, HEALTH_STARTING) == 0) {
-        return util_strdup_s("health: starting");
+    field->values = filters_args_get(filters, key);
+    field->len = util_array_len((const char **)field->values);
+    if (field->len == 0) {
+        return 0;
     }
 
-    return util_strdup_s(cont_state->health->status);
-}
-
-static int replace_labels(container_container *isuladinfo, json_map_string_string *labels, const map_t *map_labels)
-{
-    isuladinfo->labels = util_common_calloc_s(sizeof(json_map_string_string));
-
-    if (isuladinfo->labels == NULL) {
+    field->regs = util_common_calloc_s(field->len * sizeof(regex_t));
+    field->invalid = util_common_calloc_s(field->len * sizeof(bool));
+    if (field->regs == NULL || field->invalid == NULL) {
         ERROR("Out of memory");
+        free(field->regs);
+        field->regs = NULL;
+        free(field->invalid);
+        field->invalid = NULL;
+        util_free_array(field->values);
+        field->values = NULL;
+        field->len = 0;
         return -1;
     }
 
-    if (dup_json_map_string_string(labels, isuladinfo->labels) != 0) {
-        ERROR("Failed to dup labels");
-        return -1;
-    }
-    size_t i;
-    for (i = 0; i < labels->len; i++) {
-        if (!map_replace(map_labels, (void *)labels->keys[i], labels->values[i])) {
-            ERROR("Failed to insert labels to map");
-            return -1;
+    for (i = 0; i < field->len; i++) {
+        if (regcomp(&field->regs[i], field->values[i], REG_EXTENDED | REG_NOSUB) != 0) {
+            field->invalid[i] = true;
         }
     }
-    return 0;
-}
-
-static int replace_annotations(const container_config_v2_common_config *common_config,
-                               container_container *isuladinfo)
-{
-    if (common_config->config->annotations != NULL &&
-        common_config->config->annotations->len != 0) {
-        isuladinfo->annotations = util_common_calloc_s(sizeof(json_map_string_string));
-        if (isuladinfo->annotations == NULL) {
-            ERROR("Out of memory");
-            return -1;
-        }
 
-        if (dup_json_map_string_string(common_config->config->annotations,
-                                       isuladinfo->annotations) != 0) {
-            ERROR("Failed to dup annotations");
-            return -1;
-        }
-    }
     return 0;
 }
 
-static void dup_id_name(const container_config_v2_common_config *common_config, container_container *isuladinfo)
-{
-    if (common_config->id != NULL) {
-        isuladinfo->id = util_strdup_s(common_config->id);
-    }
-
-    if (common_config->name != NULL) {
-        isuladinfo->name = util_strdup_s(common_config->name);
-    }
-}
-
-static int convert_common_config_info(const map_t *map_labels, const container_config_v2_common_config *common_config,
-                                      container_container *isuladinfo)
+static int compile_label_filters(const struct filters_args *filters, struct list_context *ctx)
 {
     int ret = 0;
-    bool args_err = false;
+    size_t i;
+    size_t len;
+    char **labels = NULL;
+    char *pos = NULL;
 
-    if (map_labels == NULL || common_config == NULL || isuladinfo == NULL) {
-        return -1;
+    labels = filters_args_get(filters, "label");
+    len = util_array_len((const char **)labels);
+    if (len == 0) {
+        goto out;
     }
 
-    if (common_config->config == NULL) {
-        return 0;
+    ctx->labels = util_common_calloc_s(len * sizeof(struct list_label_filter));
+    if (ctx->labels == NULL) {
+        ERROR("Out of memory");
+        ret = -1;
+        goto out;
     }
-    args_err = (common_config->config->labels != NULL && common_config->config->labels->len != 0);
-    if (args_err) {
-        json_map_string_string *labels = common_config->config->labels;
 
-        ret = replace_labels(isuladinfo, labels, map_labels);
-        if (ret == -1) {
-            goto out;
+    // Splitted by '=' to at most 2 substring
+    for (i = 0; i < len; i++) {
+        pos = strchr(labels[i], '=');
+        if (pos != NULL) {
+            ctx->labels[i].value = util_strdup_s(pos + 1);
+            *pos = '\0';
         }
+        ctx->labels[i].key = util_strdup_s(labels[i]);
+        ctx->labels_len++;
     }
 
-    ret = replace_annotations(common_config, isuladinfo);
-    if (ret == -1) {
-        goto out;
-    }
-
-    dup_id_name(common_config, isuladinfo);
-    args_err = (common_config->created != NULL &&
-                to_unix_nanos_from_str(common_config->created, &isuladinfo->created) != 0);
-    if (args_err) {
-        ret = -1;
-        goto out;
-    }
-    isuladinfo->restartcount = (uint64_t)common_config->restart_count;
 out:
+    util_free_array(labels);
     return ret;
 }
 
-static int container_info_match(const struct list_context *ctx, const map_t *map_labels,
-                                const container_container *isuladinfo, const container_config_v2_state *cont_state)
+static void compile_status_filter(struct list_context *ctx)
 {
-    int ret = 0;
+    int i;
     Container_Status cs;
 
-    if (ctx == NULL || map_labels == NULL || cont_state == NULL) {
-        return -1;
-    }
-
-    if (!filters_args_match(ctx->ps_filters, "name", isuladinfo->name)) {
-        ret = -1;
-        goto out;
-    }
-
-    if (!filters_args_match(ctx->ps_filters, "id", isuladinfo->id)) {
-        ret = -1;
-        goto out;
-    }
-
-    cs = state_judge_status(cont_state);
-    if (cs == CONTAINER_STATUS_CREATED) {
-        if (!filters_args_match(ctx->ps_filters, "status", "created") && \
-            !filters_args_match(ctx->ps_filters, "status", "inited")) {
-            ret = -1;
-            goto out;
+    for (i = 0; i < CONTAINER_STATUS_MAX_STATE; i++) {
+        cs = (Container_Status)i;
+        if (cs == CONTAINER_STATUS_CREATED) {
+            ctx->status_matched[i] = filters_args_match(ctx->ps_filters, "status", "created") ||
+                                     filters_args_match(ctx->ps_filters, "status", "inited");
+        } else {
+            ctx->status_matched[i] = filters_args_match(ctx->ps_filters, "status", state_to_string(cs));
         }
-    } else if (!filters_args_match(ctx->ps_filters, "status", state_to_string(cs))) {
-        ret = -1;
-        goto out;
-    }
-
-    // Do not include container if any of the labels don't match
-    if (!filters_args_match_kv_list(ctx->ps_filters, "label", map_labels)) {
-        ret = -1;
-        goto out;
     }
-
-out:
-    return ret;
 }
 
-static int get_cnt_state(const struct list_context *ctx, const container_config_v2_state *cont_state,
-                         const char *name)
+static int compile_filters(struct list_context *ctx)
 {
-    if (cont_state == NULL) {
-        ERROR("Failed to read %s state", name);
+    if (compile_filter_field(ctx->ps_filters, "name", &ctx->names) != 0) {
         return -1;
     }
 
-    if (!cont_state->running && !ctx->list_config->all) {
+    if (compile_filter_field(ctx->ps_filters, "id", &ctx->ids) != 0) {
         return -1;
     }
-    return 0;
-}
 
-static int fill_isuladinfo(container_container *isuladinfo, const container_config_v2_state *cont_state,
-                           const map_t *map_labels, const container_t *cont)
-{
-    int ret = 0;
-    char *image = NULL;
-    char *timestr = NULL;
-    char *defvalue = "-";
-    int64_t created_nanos = 0;
-
-    ret = convert_common_config_info(map_labels, cont->common_config, isuladinfo);
-    if (ret != 0) {
-        goto out;
+    if (compile_label_filters(ctx->ps_filters, ctx) != 0) {
+        return -1;
     }
 
-    isuladinfo->pid = (int32_t)cont_state->pid;
-
-    isuladinfo->status = (int)state_judge_status(cont_state);
+    compile_status_filter(ctx);
 
-    isuladinfo->command = container_get_command(cont);
-    image = container_get_image(cont);
-    isuladinfo->image = image ? image : util_strdup_s("none");
+    return 0;
+}
 
-    isuladinfo->exit_code = (uint32_t)(cont_state->exit_code);
-    timestr = cont_state->started_at ? cont_state->started_at : defvalue;
-    isuladinfo->startat = util_strdup_s(timestr);
+static bool filter_field_match(const struct list_filter_field *field, const char *source)
+{
+    size_t i;
 
-    timestr = cont_state->finished_at ? cont_state->finished_at : defvalue;
-    isuladinfo->finishat = util_strdup_s(timestr);
+    if (field->len == 0) {
+        return true;
+    }
 
-    isuladinfo->runtime = cont->runtime ? util_strdup_s(cont->runtime) : util_strdup_s("none");
+    if (source == NULL) {
+        return false;
+    }
 
-    isuladinfo->health_state = container_get_health_state(cont_state);
-    if (cont->common_config->created != NULL) {
-        ret = to_unix_nanos_from_str(cont->common_config->created, &created_nanos);
-        if (ret != 0) {
-            goto out;
+    for (i = 0; i < field->len; i++) {
+        if (strcmp(field->values[i], source) == 0) {
+            return true;
         }
     }
 
-    isuladinfo->created = created_nanos;
+    for (i = 0; i < field->len; i++) {
+        if (!field->invalid[i] && regexec(&field->regs[i], source, 0, NULL, 0) == 0) {
+            return true;
+        }
+    }
 
-out:
-    return ret;
+    return false;
 }
 
-static void free_isulad_info(container_container **isuladinfo, int ret)
+static const char *search_label(const json_map_string_string *labels, const char *key)
 {
-    if (ret != 0) {
-        free_container_container(*isuladinfo);
-        *isuladinfo = NULL;
-    }
-    return;
-}
+    size_t i;
 
-static void unref_cont(container_t *cont)
-{
-    if (cont != NULL) {
-        container_unref(cont);
+    for (i = 0; i < labels->len; i++) {
+        if (labels->keys[i] != NULL && strcmp(labels->keys[i], key) == 0) {
+            return labels->values[i] != NULL ? labels->values[i] : "";
+        }
     }
-    return;
+
+    return NULL;
 }
 
-static container_container *get_container_info(const char *name, const struct list_context *ctx)
+// Do not include container if any of the labels don't match
+static bool label_filters_match(const struct list_context *ctx, const json_map_string_string *labels)
 {
-    int ret = 0;
-    container_container *isuladinfo = NULL;
-    container_t *cont = NULL;
-    container_config_v2_state *cont_state = NULL;
-    map_t *map_labels = NULL;
+    size_t i;
+    const char *value = NULL;
 
-    cont = containers_store_get(name);
-    if (cont == NULL) {
-        ERROR("Container '%s' already removed", name);
-        return NULL;
+    if (ctx->labels_len == 0) {
+        return true;
     }
-    cont_state = state_get_info(cont->state);
 
-    if (get_cnt_state(ctx, cont_state, name) != 0) {
-        ret = -1;
-        goto cleanup;
+    if (labels == NULL) {
+        return false;
     }
 
-    map_labels = map_new(MAP_STR_STR, MAP_DEFAULT_CMP_FUNC, MAP_DEFAULT_FREE_FUNC);
-    if (map_labels == NULL) {
-        ERROR("Out of memory");
-        ret = -1;
-        goto cleanup;
+    for (i = 0; i < ctx->labels_len; i++) {
+        value = search_label(labels, ctx->labels[i].key);
+        if (value == NULL) {
+            return false;
+        }
+        if (ctx->labels[i].value != NULL && strcmp(ctx->labels[i].value, value) != 0) {
+            return false;
+        }
     }
 
-    isuladinfo = util_common_calloc_s(sizeof(container_container));
-    if (isuladinfo == NULL) {
-        ERROR("Out of memory");
-        ret = -1;
-        goto cleanup;
+    return true;
+}
+
+static bool list_view_match(const struct list_context *ctx, const container_list_view_t *view)
+{
+    if (!view->running && !ctx->list_config->all) {
+        return false;
     }
 
-    ret = fill_isuladinfo(isuladinfo, cont_state, map_labels, cont);
-    if (ret != 0) {
-        goto cleanup;
+    if (!filter_field_match(&ctx->names, view->name)) {
+        return false;
     }
 
-    ret = container_info_match(ctx, map_labels, isuladinfo, cont_state);
-    if (ret != 0) {
-        goto cleanup;
+    if (!filter_field_match(&ctx->ids, view->id)) {
+        return false;
     }
 
-cleanup:
-    unref_cont(cont);
-    map_free(map_labels);
-    free_container_config_v2_state(cont_state);
-    free_isulad_info(&isuladinfo, ret);
-    return isuladinfo;
-}
+    if ((int)view->status < 0 || (int)view->status >= CONTAINER_STATUS_MAX_STATE ||
+        !ctx->status_matched[view->status]) {
+        return false;
+    }
 
+    return label_filters_match(ctx, view->labels);
+}
 static int do_add_filters(const char *filter_key, const json_map_string_bool *filter_value, struct list_context *ctx)
 {
     int ret = 0;
@@ -597,11 +428,7 @@ static struct list_context *fold_filter(const container_list_request *request)
         return NULL;
     }
 
-    if (request->filters == NULL) {
-        return ctx;
-    }
-
-    for (i = 0; i < request->filters->len; i++) {
+    for (i = 0; request->filters != NULL && i < request->filters->len; i++) {
         if (!filters_args_valid_key(accepted_ps_filter_tags, sizeof(accepted_ps_filter_tags) / sizeof(char *),
                                     request->filters->keys[i])) {
             ERROR("Invalid filter '%s'", request->filters->keys[i]);
@@ -613,55 +440,168 @@ static struct list_context *fold_filter(const container_list_request *request)
         }
     }
 
+    if (compile_filters(ctx) != 0) {
+        goto error_out;
+    }
+
     return ctx;
 error_out:
     free_list_context(ctx);
     return NULL;
 }
 
-static int pack_list_containers(char **idsarray, const struct list_context *ctx, container_list_response *response)
+static json_map_string_string *dup_labels_map(const json_map_string_string *src)
 {
-    int ret = 0;
-    int j = 0;
-    size_t container_nums = 0;
+    json_map_string_string *dest = NULL;
 
-    container_nums = util_array_len((const char **)idsarray);
-    if (container_nums == 0) {
-        goto out;
+    dest = util_common_calloc_s(sizeof(json_map_string_string));
+    if (dest == NULL) {
+        ERROR("Out of memory");
+        return NULL;
     }
 
-    if (container_nums > (SIZE_MAX / sizeof(container_container *))) {
-        ERROR("Get too many containers:%d", container_nums);
-        ret = -1;
-        goto out;
+    if (dup_json_map_string_string(src, dest) != 0) {
+        free_json_map_string_string(dest);
+        return NULL;
+    }
+
+    return dest;
+}
+
+static container_container *pack_container_info(const container_list_view_t *view)
+{
+    container_container *isuladinfo = NULL;
+
+    isuladinfo = util_common_calloc_s(sizeof(container_container));
+    if (isuladinfo == NULL) {
+        ERROR("Out of memory");
+        return NULL;
+    }
+
+    if (view->labels != NULL) {
+        isuladinfo->labels = dup_labels_map(view->labels);
+        if (isuladinfo->labels == NULL) {
+            goto error_out;
+        }
     }
 
-    response->containers = util_common_calloc_s(container_nums * sizeof(container_container *));
+    if (view->annotations != NULL) {
+        isuladinfo->annotations = dup_labels_map(view->annotations);
+        if (isuladinfo->annotations == NULL) {
+            goto error_out;
+        }
+    }
+
+    isuladinfo->id = util_strdup_s(view->id);
+    isuladinfo->name = util_strdup_s(view->name);
+    isuladinfo->pid = (int32_t)view->pid;
+    isuladinfo->status = (int)view->status;
+    isuladinfo->command = util_strdup_s(view->command);
+    isuladinfo->image = util_strdup_s(view->image);
+    isuladinfo->exit_code = view->exit_code;
+    isuladinfo->startat = util_strdup_s(view->started_at);
+    isuladinfo->finishat = util_strdup_s(view->finished_at);
+    isuladinfo->runtime = util_strdup_s(view->runtime);
+    isuladinfo->health_state = util_strdup_s(view->health_state);
+    isuladinfo->created = view->created;
+    isuladinfo->restartcount = view->restart_count;
+
+    return isuladinfo;
+
+error_out:
+    free_container_container(isuladinfo);
+    return NULL;
+}
+
+static int pack_list_containers(container_list_view_t **views, size_t views_len, const struct list_context *ctx,
+                                container_list_response *response)
+{
+    size_t i;
+    container_container *info = NULL;
+
+    if (views_len == 0) {
+        return 0;
+    }
+
+    if (views_len > (SIZE_MAX / sizeof(container_container *))) {
+        ERROR("Get too many containers:%zu", views_len);
+        return -1;
+    }
+
+    response->containers = util_common_calloc_s(views_len * sizeof(container_container *));
     if (response->containers == NULL) {
+        ERROR("Out of memory");
+        return -1;
+    }
+
+    for (i = 0; i < views_len; i++) {
+        if (!list_view_match(ctx, views[i])) {
+            continue;
+        }
+        info = pack_container_info(views[i]);
+        if (info == NULL) {
+            return -1;
+        }
+        response->containers[response->containers_len] = info;
+        response->containers_len++;
+    }
+
+    return 0;
+}
+
+/* label filters with value are looked up in label index of store, the others are only matched */
+static int list_candidate_views(const struct list_context *ctx, container_list_view_t ***views, size_t *views_len)
+{
+    int ret = 0;
+    size_t i;
+    size_t len = 0;
+    const char **keys = NULL;
+    const char **values = NULL;
+
+    if (ctx->labels_len == 0) {
+        return containers_store_list_views(views, views_len);
+    }
+
+    keys = util_common_calloc_s(ctx->labels_len * sizeof(char *));
+    values = util_common_calloc_s(ctx->labels_len * sizeof(char *));
+    if (keys == NULL || values == NULL) {
         ERROR("Out of memory");
         ret = -1;
         goto out;
     }
 
-    while (idsarray != NULL && idsarray[j] != NULL) {
-        response->containers[response->containers_len] = get_container_info(idsarray[j], ctx);
-        if (response->containers[response->containers_len] == NULL) {
-            j++;
+    for (i = 0; i < ctx->labels_len; i++) {
+        if (ctx->labels[i].value == NULL) {
             continue;
         }
-        j++;
-        response->containers_len++;
+        keys[len] = ctx->labels[i].key;
+        values[len] = ctx->labels[i].value;
+        len++;
     }
+
+    ret = containers_store_list_views_by_labels(keys, values, len, views, views_len);
+
 out:
+    free(keys);
+    free(values);
     return ret;
 }
 
+static void free_list_views(container_list_view_t **views, size_t views_len)
+{
+    size_t i;
+
+    for (i = 0; i < views_len; i++) {
+        container_list_view_unref(views[i]);
+    }
+    free(views);
+}
 int container_list_cb(const container_list_request *request, container_list_response **response)
 {
-    char **idsarray = NULL;
-    map_t *map_id_name = NULL;
     uint32_t cc = ISULAD_SUCCESS;
     struct list_context *ctx = NULL;
+    container_list_view_t **views = NULL;
+    size_t views_len = 0;
 
     DAEMON_CLEAR_ERRMSG();
 
@@ -683,26 +623,19 @@ int container_list_cb(const container_list_request *request, container_list_resp
         goto pack_response;
     }
 
-    map_id_name = name_index_get_all();
-    if (map_id_name == NULL) {
+    // list views are immutable snapshots of containers, so filtering and
+    // packing them needs neither lock of container nor lookup of store
+    if (list_candidate_views(ctx, &views, &views_len) != 0) {
         cc = ISULAD_ERR_EXEC;
         goto pack_response;
     }
-    if (map_size(map_id_name) == 0) {
-        goto pack_response;
-    }
-    // fastpath to only look at a subset of containers if specific name
-    // or ID matches were provided by the user--otherwise we potentially
-    // end up querying many more containers than intended
-    idsarray = filter_by_name_id_matches(ctx, map_id_name);
 
-    if (pack_list_containers(idsarray, ctx, (*response)) != 0) {
+    if (pack_list_containers(views, views_len, ctx, (*response)) != 0) {
         cc = ISULAD_ERR_EXEC;
         goto pack_response;
     }
 
 pack_response:
-    map_free(map_id_name);
     if (*response != NULL) {
         (*response)->cc = cc;
         if (g_isulad_errmsg != NULL) {
@@ -710,9 +643,8 @@ pack_response:
             DAEMON_CLEAR_ERRMSG();
         }
     }
-    util_free_array(idsarray);
+    free_list_views(views, views_len);
     free_list_context(ctx);
 
     return (cc == ISULAD_SUCCESS) ? 0 : -1;
 }
-
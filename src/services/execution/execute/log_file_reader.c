@@ -0,0 +1,676 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-04-10
+ * Description: provide container json log file reader
+ ******************************************************************************/
+#define _GNU_SOURCE
+#include "log_file_reader.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+#include "log.h"
+#include "utils.h"
+#include "constants.h"
+#include "types_def.h"
+#include "log_index.h"
+
+/*
+ * Files are read by pread instead of mmap. A log file may be truncated while
+ * it is read, which makes access to a mapping beyond the new end raise SIGBUS,
+ * while pread just returns less data.
+ */
+#define LOG_READ_BUF_SIZE (64 * 1024)
+
+/* pread until count bytes or end of file */
+static ssize_t pread_full(int fd, char *buf, size_t count, off_t offset)
+{
+    size_t total = 0;
+    ssize_t nret;
+
+    while (total < count) {
+        nret = pread(fd, buf + total, count - total, offset + (off_t)total);
+        if (nret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (nret == 0) {
+            break;
+        }
+        total += (size_t)nret;
+    }
+
+    return (ssize_t)total;
+}
+
+static int open_log_file(const char *path, bool retry_noent)
+{
+    int fd = -1;
+    int retries = 0;
+    int saved_errno = 0;
+
+    for (retries = 0; retries <= LOG_MAX_RETRIES; retries++) {
+        fd = util_open(path, O_RDONLY | O_CLOEXEC, 0);
+        if (fd >= 0 || errno != ENOENT || !retry_noent) {
+            break;
+        }
+        /* open is too fast, need wait rename operator finish */
+        usleep_nointerupt(1000);
+    }
+    if (fd < 0) {
+        saved_errno = errno;
+        ERROR("open file: %s failed: %s", path, strerror(errno));
+        errno = saved_errno;
+    }
+
+    return fd;
+}
+
+/* read whole index file, it is small as one entry is added for LOG_INDEX_INTERVAL bytes of log */
+static log_index_entry *read_index_entries(const char *path, size_t *count)
+{
+    int fd = -1;
+    ssize_t nret;
+    struct stat st;
+    log_index_entry *entries = NULL;
+
+    *count = 0;
+    fd = util_open(path, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(log_index_entry)) {
+        goto out;
+    }
+
+    entries = util_common_calloc_s((size_t)st.st_size);
+    if (entries == NULL) {
+        ERROR("Out of memory");
+        goto out;
+    }
+    nret = pread_full(fd, (char *)entries, (size_t)st.st_size, 0);
+    if (nret < 0) {
+        free(entries);
+        entries = NULL;
+        goto out;
+    }
+    /* a torn tail entry is ignored */
+    *count = (size_t)nret / sizeof(log_index_entry);
+
+out:
+    close(fd);
+    return entries;
+}
+
+size_t log_file_index_seek(const char *path, int fd, int64_t since)
+{
+    int nret;
+    char c = 0;
+    size_t lo, hi, mid;
+    size_t count = 0;
+    size_t offset = 0;
+    struct stat st;
+    char index_path[PATH_MAX] = { 0 };
+    log_index_entry *entries = NULL;
+
+    nret = snprintf(index_path, PATH_MAX, "%s%s", path, LOG_INDEX_SUFFIX);
+    if (nret < 0 || nret >= PATH_MAX) {
+        return 0;
+    }
+    if (!util_file_exists(index_path) || fstat(fd, &st) != 0) {
+        return 0;
+    }
+    entries = read_index_entries(index_path, &count);
+    if (entries == NULL || count == 0) {
+        goto out;
+    }
+
+    /* last entry older than since */
+    lo = 0;
+    hi = count;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (entries[mid].timestamp < since) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == 0 || entries[lo - 1].offset >= (uint64_t)st.st_size) {
+        goto out;
+    }
+    offset = (size_t)entries[lo - 1].offset;
+    /* index of a rotated file may be renamed a bit later than the file */
+    if (offset != 0 && (pread_full(fd, &c, 1, (off_t)offset - 1) != 1 || c != '\n')) {
+        offset = 0;
+    }
+
+out:
+    free(entries);
+    return offset;
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/* unescape json string started at *pos into out, stop after the closing quote */
+static bool unescape_json_string(const char *line, size_t len, size_t *pos, char **out)
+{
+    size_t i = *pos;
+    char *p = *out;
+    unsigned int code;
+    int j, v;
+
+    while (i < len && line[i] != '"') {
+        if (line[i] != '\\') {
+            *p++ = line[i++];
+            continue;
+        }
+        if (i + 1 >= len) {
+            return false;
+        }
+        switch (line[i + 1]) {
+            case '"':
+            case '\\':
+            case '/':
+                *p++ = line[i + 1];
+                break;
+            case 'b':
+                *p++ = '\b';
+                break;
+            case 'f':
+                *p++ = '\f';
+                break;
+            case 'n':
+                *p++ = '\n';
+                break;
+            case 'r':
+                *p++ = '\r';
+                break;
+            case 't':
+                *p++ = '\t';
+                break;
+            case 'u':
+                if (i + 6 > len) {
+                    return false;
+                }
+                code = 0;
+                for (j = 2; j < 6; j++) {
+                    v = hex_value(line[i + j]);
+                    if (v < 0) {
+                        return false;
+                    }
+                    code = (code << 4) | (unsigned int)v;
+                }
+                /* surrogate pairs are left to yajl */
+                if (code >= 0xd800 && code <= 0xdfff) {
+                    return false;
+                }
+                if (code < 0x80) {
+                    *p++ = (char)code;
+                } else if (code < 0x800) {
+                    *p++ = (char)(0xc0 | (code >> 6));
+                    *p++ = (char)(0x80 | (code & 0x3f));
+                } else {
+                    *p++ = (char)(0xe0 | (code >> 12));
+                    *p++ = (char)(0x80 | ((code >> 6) & 0x3f));
+                    *p++ = (char)(0x80 | (code & 0x3f));
+                }
+                i += 4;
+                break;
+            default:
+                return false;
+        }
+        i += 2;
+    }
+    if (i >= len) {
+        return false;
+    }
+
+    *pos = i + 1;
+    *out = p;
+    return true;
+}
+
+static bool match_json_literal(const char *line, size_t len, size_t *pos, const char *literal)
+{
+    size_t n = strlen(literal);
+
+    if (len - *pos < n || memcmp(line + *pos, literal, n) != 0) {
+        return false;
+    }
+    *pos += n;
+    return true;
+}
+
+bool log_file_decode_line(const char *line, size_t len, char *buf, logger_json_file *entry)
+{
+    size_t pos = 0;
+    char *p = buf;
+
+    if (!match_json_literal(line, len, &pos, "{\"log\":\"")) {
+        return false;
+    }
+    entry->log = (uint8_t *)p;
+    if (!unescape_json_string(line, len, &pos, &p)) {
+        return false;
+    }
+    entry->log_len = (size_t)(p - (char *)entry->log);
+    *p++ = '\0';
+
+    if (!match_json_literal(line, len, &pos, ",\"stream\":\"")) {
+        return false;
+    }
+    entry->stream = p;
+    if (!unescape_json_string(line, len, &pos, &p)) {
+        return false;
+    }
+    *p++ = '\0';
+
+    entry->time = NULL;
+    if (match_json_literal(line, len, &pos, ",\"time\":\"")) {
+        entry->time = p;
+        if (!unescape_json_string(line, len, &pos, &p)) {
+            return false;
+        }
+        *p++ = '\0';
+    }
+
+    return match_json_literal(line, len, &pos, "}") && pos == len;
+}
+
+static bool parse_fixed_digits(const char *s, size_t n, int64_t *value)
+{
+    size_t i;
+
+    *value = 0;
+    for (i = 0; i < n; i++) {
+        if (s[i] < '0' || s[i] > '9') {
+            return false;
+        }
+        *value = *value * 10 + (s[i] - '0');
+    }
+    return true;
+}
+
+/* days since 1970-01-01 of a proleptic gregorian date */
+static int64_t days_from_civil(int64_t y, int64_t m, int64_t d)
+{
+    int64_t era, yoe, doy, doe;
+
+    y -= (m <= 2) ? 1 : 0;
+    era = (y >= 0 ? y : y - 399) / 400;
+    yoe = y - era * 400;
+    doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+/* parse Z or +hh:mm / -hh:mm zone at str, return offset to utc in seconds */
+static bool parse_zone_offset(const char *str, size_t len, int64_t *offset)
+{
+    int64_t hour, minute;
+
+    *offset = 0;
+    if (len == 1 && str[0] == 'Z') {
+        return true;
+    }
+    if (len != 6 || (str[0] != '+' && str[0] != '-') || str[3] != ':' || !parse_fixed_digits(str + 1, 2, &hour) ||
+        !parse_fixed_digits(str + 4, 2, &minute) || hour > 23 || minute > 59) {
+        return false;
+    }
+    *offset = (hour * 60 + minute) * 60;
+    if (str[0] == '-') {
+        *offset = -*offset;
+    }
+    return true;
+}
+
+/* fast path for 2006-01-02T15:04:05.999999999Z written by isulad-shim, and its +hh:mm variant */
+bool log_file_parse_time(const char *str, int64_t *nanos)
+{
+#define LOG_TIME_ZONE_START 29
+    size_t len;
+    int64_t year, month, day, hour, minute, second, nano, offset;
+
+    if (str == NULL || nanos == NULL) {
+        return false;
+    }
+
+    len = strlen(str);
+    if (len > LOG_TIME_ZONE_START && str[4] == '-' && str[7] == '-' && str[10] == 'T' && str[13] == ':' &&
+        str[16] == ':' && str[19] == '.' && parse_fixed_digits(str, 4, &year) &&
+        parse_fixed_digits(str + 5, 2, &month) && parse_fixed_digits(str + 8, 2, &day) &&
+        parse_fixed_digits(str + 11, 2, &hour) && parse_fixed_digits(str + 14, 2, &minute) &&
+        parse_fixed_digits(str + 17, 2, &second) && parse_fixed_digits(str + 20, 9, &nano) && month >= 1 &&
+        month <= 12 && parse_zone_offset(str + LOG_TIME_ZONE_START, len - LOG_TIME_ZONE_START, &offset)) {
+        *nanos = ((days_from_civil(year, month, day) * 24 + hour) * 60 + minute) * 60 + second - offset;
+        *nanos = *nanos * Time_Second + nano;
+        return true;
+    }
+
+    return to_unix_nanos_from_str(str, nanos) == 0;
+}
+
+static bool log_entry_before(const logger_json_file *entry, int64_t since)
+{
+    int64_t nanos = 0;
+
+    if (since <= 0) {
+        return false;
+    }
+    /* entry without time is treated as the oldest one */
+    if (entry->time == NULL || !log_file_parse_time(entry->time, &nanos)) {
+        return true;
+    }
+    return nanos < since;
+}
+
+/* scratch of a log reader, reused for every line */
+struct log_decode_buffer {
+    char *data;
+    size_t cap;
+};
+
+static int log_decode_buffer_reserve(struct log_decode_buffer *buf, size_t need)
+{
+    size_t cap;
+    char *tmp = NULL;
+
+    if (buf->cap >= need) {
+        return 0;
+    }
+    cap = buf->cap != 0 ? buf->cap : MAXLINE;
+    while (cap < need) {
+        cap *= 2;
+    }
+    tmp = util_common_calloc_s(cap);
+    if (tmp == NULL) {
+        ERROR("Out of memory");
+        return -1;
+    }
+    free(buf->data);
+    buf->data = tmp;
+    buf->cap = cap;
+    return 0;
+}
+
+/*
+ * return:
+ *      0, line is sent or skipped by since
+ *      -1, line is not a valid log entry
+ *      -2, send to client failed
+ * */
+static int do_decode_write_log_line(const char *line, size_t len, int64_t since, struct log_decode_buffer *buf,
+                                    const stream_func_wrapper *stream)
+{
+    int ret = 0;
+    parser_error jerr = NULL;
+    logger_json_file fast_entry = { 0 };
+    logger_json_file *entry = &fast_entry;
+    logger_json_file *parsed = NULL;
+    struct parser_context ctx = { OPT_GEN_SIMPLIFY | OPT_GEN_NO_VALIDATE_UTF8, stderr };
+
+    /* decoded fields are never longer than the line, plus terminators */
+    if (log_decode_buffer_reserve(buf, len + 4) != 0) {
+        return -2;
+    }
+
+    if (!log_file_decode_line(line, len, buf->data, &fast_entry)) {
+        (void)memcpy(buf->data, line, len);
+        buf->data[len] = '\0';
+        parsed = logger_json_file_parse_data(buf->data, &ctx, &jerr);
+        if (parsed == NULL) {
+            ERROR("parse logentry: %s, failed: %s", buf->data, jerr);
+            ret = -1;
+            goto out;
+        }
+        entry = parsed;
+    }
+
+    if (log_entry_before(entry, since)) {
+        goto out;
+    }
+
+    /* send to client */
+    if (!stream->write_func(stream->writer, entry)) {
+        ERROR("Send log to client failed");
+        ret = -2;
+        goto out;
+    }
+
+out:
+    free_logger_json_file(parsed);
+    free(jerr);
+    return ret;
+}
+
+/* window of file read by pread, data[0] is at offset of file */
+struct log_read_window {
+    char *data;
+    size_t len;
+    size_t cap;
+    size_t offset;
+};
+
+/* drop consumed bytes and read more, grow window for a line longer than it. Return bytes read */
+static ssize_t log_read_window_fill(int fd, struct log_read_window *win, size_t consumed)
+{
+    char *tmp = NULL;
+    ssize_t nret;
+
+    if (consumed > 0) {
+        (void)memmove(win->data, win->data + consumed, win->len - consumed);
+        win->len -= consumed;
+        win->offset += consumed;
+    }
+
+    if (win->len == win->cap) {
+        if (win->cap > SIZE_MAX / 2) {
+            return -1;
+        }
+        tmp = util_common_calloc_s(win->cap * 2);
+        if (tmp == NULL) {
+            ERROR("Out of memory");
+            return -1;
+        }
+        (void)memcpy(tmp, win->data, win->len);
+        free(win->data);
+        win->data = tmp;
+        win->cap *= 2;
+    }
+
+    nret = pread_full(fd, win->data + win->len, win->cap - win->len, (off_t)(win->offset + win->len));
+    if (nret > 0) {
+        win->len += (size_t)nret;
+    }
+    return nret;
+}
+
+int64_t log_file_read_lines(const char *path, int64_t require_line, long pos, int64_t since,
+                            const stream_func_wrapper *stream, long *last_pos)
+{
+#define MAX_JSON_DECODE_RETRY 20
+    int fd = -1;
+    int ret = 0;
+    int saved_errno = 0;
+    int decode_retries = 0;
+    int64_t read_lines = 0;
+    size_t start, next;
+    ssize_t nread;
+    const char *eol = NULL;
+    struct log_read_window win = { 0 };
+    struct log_decode_buffer buf = { 0 };
+
+    fd = open_log_file(path, true);
+    if (fd < 0) {
+        return -1;
+    }
+    *last_pos = pos;
+    if (pos < 0) {
+        goto out;
+    }
+
+    win.offset = (size_t)pos;
+    if (since > 0) {
+        next = log_file_index_seek(path, fd, since);
+        if (next > win.offset) {
+            win.offset = next;
+            *last_pos = (long)next;
+        }
+    }
+
+    win.cap = LOG_READ_BUF_SIZE;
+    win.data = util_common_calloc_s(win.cap);
+    if (win.data == NULL) {
+        ERROR("Out of memory");
+        read_lines = -1;
+        goto out;
+    }
+
+    start = 0;
+    for (;;) {
+        nread = log_read_window_fill(fd, &win, start);
+        if (nread < 0) {
+            saved_errno = errno;
+            ERROR("read file: %s failed: %s", path, strerror(errno));
+            read_lines = -1;
+            goto out;
+        }
+        if (nread == 0) {
+            /* end of file, a line without newline is still being written */
+            break;
+        }
+
+        start = 0;
+        while (start < win.len) {
+            eol = memchr(win.data + start, '\n', win.len - start);
+            if (eol == NULL) {
+                break;
+            }
+            next = (size_t)(eol - win.data) + 1;
+
+            ret = do_decode_write_log_line(win.data + start, (size_t)(eol - win.data) - start, since, &buf, stream);
+            start = next;
+            *last_pos = (long)(win.offset + next);
+            if (ret == -2) {
+                read_lines = -1;
+                goto out;
+            }
+            if (ret != 0) {
+                /* skip broken lines, but give up if the file is not a json log at all */
+                decode_retries++;
+                if (decode_retries < MAX_JSON_DECODE_RETRY) {
+                    continue;
+                }
+                read_lines = -1;
+                goto out;
+            }
+            decode_retries = 0;
+
+            read_lines++;
+            if (read_lines == require_line) {
+                goto out;
+            }
+        }
+    }
+
+out:
+    free(buf.data);
+    free(win.data);
+    close(fd);
+    errno = saved_errno;
+    return read_lines;
+}
+
+int log_file_find_tail_position(const char *file_name, int64_t require_line, int64_t *get_line, long *pos)
+{
+    int fd = -1;
+    int ret = 0;
+    size_t n, end;
+    ssize_t nread;
+    const char *nl = NULL;
+    char *buf = NULL;
+    struct stat st;
+
+    if (file_name == NULL) {
+        return 0;
+    }
+    if (get_line == NULL || pos == NULL) {
+        ERROR("Invalid Arguments");
+        return -1;
+    }
+
+    fd = open_log_file(file_name, false);
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &st) != 0) {
+        ERROR("stat file: %s failed: %s", file_name, strerror(errno));
+        ret = -1;
+        goto out;
+    }
+
+    buf = util_common_calloc_s(LOG_READ_BUF_SIZE);
+    if (buf == NULL) {
+        ERROR("Out of memory");
+        ret = -1;
+        goto out;
+    }
+
+    /* count newlines backwards, the line after the (require_line + 1)th one is the first to show */
+    for (end = (size_t)st.st_size; end > 0; end -= n) {
+        n = end < LOG_READ_BUF_SIZE ? end : LOG_READ_BUF_SIZE;
+        nread = pread_full(fd, buf, n, (off_t)(end - n));
+        if (nread < 0) {
+            ERROR("read file: %s failed: %s", file_name, strerror(errno));
+            ret = -1;
+            goto out;
+        }
+        if ((size_t)nread != n) {
+            /* truncated while reading, nothing before is valid any more */
+            break;
+        }
+        nl = buf + n;
+        while ((nl = memrchr(buf, '\n', (size_t)(nl - buf))) != NULL) {
+            (*get_line) += 1;
+            if ((*get_line) > require_line) {
+                (*pos) = (long)(end - n + (size_t)(nl - buf)) + 1;
+                (*get_line) = require_line;
+                goto out;
+            }
+        }
+    }
+
+out:
+    free(buf);
+    close(fd);
+    return ret;
+}
@@ -0,0 +1,69 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-04-10
+ * Description: provide container json log file reader definition
+ ******************************************************************************/
+
+#ifndef __EXECUTION_LOG_FILE_READER_H_
+#define __EXECUTION_LOG_FILE_READER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "libisulad.h"
+#include "logger_json_file.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Read lines of json log file path from pos and send them to stream, lines older
+ * than since are skipped. At most require_line lines are read if it is positive.
+ * last_pos is set to the start of the first line not consumed, a line still being
+ * written is not consumed.
+ * return:
+ *      <  0, mean read failed
+ *      == 0, mean read zero line
+ *      >  0, mean read many lines
+ */
+int64_t log_file_read_lines(const char *path, int64_t require_line, long pos, int64_t since,
+                            const stream_func_wrapper *stream, long *last_pos);
+
+/*
+ * Find start of the last require_line lines of file. get_line is increased by the
+ * number of lines found, pos is set only if the file has more than require_line lines.
+ */
+int log_file_find_tail_position(const char *file_name, int64_t require_line, int64_t *get_line, long *pos);
+
+/*
+ * Find a line start of fd, before which all lines are older than since, by the
+ * index of path written by isulad-shim. Return 0 if index is missing or invalid.
+ */
+size_t log_file_index_seek(const char *path, int fd, int64_t since);
+
+/*
+ * Decode {"log":"...","stream":"...","time":"..."} written by isulad-shim,
+ * fields of entry point into buf, which has at least len + 4 bytes.
+ * Other layouts are left to yajl.
+ */
+bool log_file_decode_line(const char *line, size_t len, char *buf, logger_json_file *entry);
+
+/* parse time of log entry to unix nanoseconds */
+bool log_file_parse_time(const char *str, int64_t *nanos);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __EXECUTION_LOG_FILE_READER_H_ */
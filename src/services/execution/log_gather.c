@@ -22,7 +22,12 @@
 #include <stdlib.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/inotify.h>
+#include <sys/prctl.h>
 #include <limits.h>
+#include <poll.h>
+#include <libgen.h>
+#include <dirent.h>
 
 #include "log.h"
 #include "utils.h"
@@ -41,6 +46,42 @@ static mode_t g_log_mode = S_IRUSR | S_IWUSR;
 
 static int log_file_open();
 
+/*
+ * Rotation on gather thread only renames log file to a staging name and
+ * reopens it, the compressor thread shifts the rotated files and gzips the
+ * staged one in order, so reading of fifo never waits for gzip.
+ */
+struct log_rotate_job {
+    char *staged_path;
+    struct log_rotate_job *next;
+};
+
+struct log_compressor {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    struct log_rotate_job *head;
+    struct log_rotate_job *tail;
+    uint64_t seq;
+    bool started;
+};
+
+static struct log_compressor g_compressor = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .head = NULL,
+    .tail = NULL,
+    .seq = 0,
+    .started = false,
+};
+
+#define LOG_ROTATING_SUFFIX ".rotating."
+/* wait before reopen fifo again if it keeps failing */
+#define LOG_FIFO_REOPEN_DELAY_US (100 * 1000)
+
+/* watch directory of log file, to find out the file is removed or moved by others */
+static int g_inotify_fd = -1;
+static bool g_log_file_gone = false;
+
 static int file_rotate_gz(const char *file_name, int i)
 {
     int ret = 0;
@@ -67,19 +108,27 @@ static int file_rotate_gz(const char *file_name, int i)
     return 0;
 }
 
-static int file_rotate_me(const char *file_name)
+/* run on compressor thread */
+static int file_rotate_staged(const char *file_name, const char *staged_path, int max_files)
 {
+    int i = 0;
     int ret = 0;
     char tmp_path[PATH_MAX] = { 0 };
 
+    for (i = max_files - 1; i > 1; i--) {
+        if (file_rotate_gz(file_name, i)) {
+            return -1;
+        }
+    }
+
     ret = snprintf(tmp_path, PATH_MAX, "%s.1", file_name);
     if (ret >= PATH_MAX || ret < 0) {
         ERROR("Out of memory");
         return -1;
     }
 
-    if (rename(file_name, tmp_path) < 0 && errno != ENOENT) {
-        WARN("Rename file: %s error: %s", file_name, strerror(errno));
+    if (rename(staged_path, tmp_path) < 0) {
+        WARN("Rename file: %s error: %s", staged_path, strerror(errno));
         return -1;
     }
 
@@ -91,21 +140,255 @@ static int file_rotate_me(const char *file_name)
     return 0;
 }
 
+static void *log_compressor_routine(void *arg)
+{
+    struct log_rotate_job *job = NULL;
+
+    (void)arg;
+    if (pthread_detach(pthread_self()) != 0) {
+        CRIT("Set log compressor thread detach fail");
+    }
+    prctl(PR_SET_NAME, "Log_compress");
+
+    for (;;) {
+        pthread_mutex_lock(&g_compressor.lock);
+        while (g_compressor.head == NULL) {
+            pthread_cond_wait(&g_compressor.cond, &g_compressor.lock);
+        }
+        job = g_compressor.head;
+        g_compressor.head = job->next;
+        if (g_compressor.head == NULL) {
+            g_compressor.tail = NULL;
+        }
+        pthread_mutex_unlock(&g_compressor.lock);
+
+        if (file_rotate_staged(g_log_file, job->staged_path, g_max_file) == -1) {
+            COMMAND_ERROR("Rotate log file %s failed", job->staged_path);
+        }
+        free(job->staged_path);
+        free(job);
+    }
+
+    return NULL;
+}
+
+static int log_compressor_start()
+{
+    pthread_t thread;
+
+    if (g_compressor.started) {
+        return 0;
+    }
+
+    if (pthread_create(&thread, NULL, log_compressor_routine, NULL) != 0) {
+        COMMAND_ERROR("Create log compressor thread failed");
+        return -1;
+    }
+    g_compressor.started = true;
+
+    return 0;
+}
+
+static void log_compressor_queue(char *staged_path)
+{
+    struct log_rotate_job *job = NULL;
+
+    job = util_common_calloc_s(sizeof(struct log_rotate_job));
+    if (job == NULL) {
+        COMMAND_ERROR("Out of memory");
+        free(staged_path);
+        return;
+    }
+    job->staged_path = staged_path;
+
+    pthread_mutex_lock(&g_compressor.lock);
+    if (g_compressor.tail != NULL) {
+        g_compressor.tail->next = job;
+    } else {
+        g_compressor.head = job;
+    }
+    g_compressor.tail = job;
+    pthread_cond_signal(&g_compressor.cond);
+    pthread_mutex_unlock(&g_compressor.lock);
+}
+
+static int compare_seq(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* get seq of staged file name, which is base of log file followed by .rotating.N */
+static bool parse_staged_seq(const char *name, const char *base, uint64_t *seq)
+{
+    long long value = 0;
+    size_t base_len = strlen(base);
+
+    if (strncmp(name, base, base_len) != 0) {
+        return false;
+    }
+    name += base_len;
+    if (strncmp(name, LOG_ROTATING_SUFFIX, strlen(LOG_ROTATING_SUFFIX)) != 0) {
+        return false;
+    }
+    name += strlen(LOG_ROTATING_SUFFIX);
+    if (name[0] < '0' || name[0] > '9' || util_safe_llong(name, &value) != 0 || value < 0) {
+        return false;
+    }
+
+    *seq = (uint64_t)value;
+    return true;
+}
+
+/*
+ * staged files are left if daemon exits before they are compressed, queue them
+ * by the order they were rotated, and name new staged files after them.
+ */
+static int log_compressor_queue_leftovers(const char *file_name)
+{
+    int ret = 0;
+    int nret = 0;
+    size_t i = 0;
+    size_t len = 0;
+    size_t cap = 0;
+    uint64_t seq = 0;
+    uint64_t *seqs = NULL;
+    char *dir_path = NULL;
+    const char *base = NULL;
+    DIR *dir = NULL;
+    struct dirent *entry = NULL;
+    char staged_path[PATH_MAX] = { 0 };
+
+    base = strrchr(file_name, '/');
+    base = (base != NULL) ? base + 1 : file_name;
+    dir_path = util_strdup_s(file_name);
+    dir = opendir(dirname(dir_path));
+    if (dir == NULL) {
+        /* log directory is not created yet */
+        goto out;
+    }
+
+    while ((entry = readdir(dir)) != NULL) {
+        if (!parse_staged_seq(entry->d_name, base, &seq)) {
+            continue;
+        }
+        if (len == cap) {
+            uint64_t *new_seqs = NULL;
+            size_t new_cap = (cap == 0) ? 8 : cap * 2;
+            if (mem_realloc((void **)&new_seqs, new_cap * sizeof(uint64_t), seqs, cap * sizeof(uint64_t)) != 0) {
+                COMMAND_ERROR("Out of memory");
+                ret = -1;
+                goto out;
+            }
+            seqs = new_seqs;
+            cap = new_cap;
+        }
+        seqs[len++] = seq;
+    }
+
+    if (len == 0) {
+        goto out;
+    }
+    qsort(seqs, len, sizeof(uint64_t), compare_seq);
+    for (i = 0; i < len; i++) {
+        nret = snprintf(staged_path, PATH_MAX, "%s" LOG_ROTATING_SUFFIX "%lu", file_name, (unsigned long)seqs[i]);
+        if (nret >= PATH_MAX || nret < 0) {
+            ERROR("Out of memory");
+            continue;
+        }
+        INFO("Compress log file %s left by last run", staged_path);
+        log_compressor_queue(util_strdup_s(staged_path));
+    }
+    g_compressor.seq = seqs[len - 1] + 1;
+
+out:
+    if (dir != NULL) {
+        closedir(dir);
+    }
+    free(seqs);
+    free(dir_path);
+    return ret;
+}
+
+/* only renames log file on caller thread */
 static int file_rotate(const char *file_name, int max_files)
 {
-    int i = 0;
+    int ret = 0;
+    char staged_path[PATH_MAX] = { 0 };
 
     if (file_name == NULL || max_files < 2) {
         return 0;
     }
 
-    for (i = max_files - 1; i > 1; i--) {
-        if (file_rotate_gz(file_name, i)) {
-            return -1;
+    ret = snprintf(staged_path, PATH_MAX, "%s" LOG_ROTATING_SUFFIX "%lu", file_name,
+                   (unsigned long)(g_compressor.seq++));
+    if (ret >= PATH_MAX || ret < 0) {
+        ERROR("Out of memory");
+        return -1;
+    }
+
+    if (rename(file_name, staged_path) < 0) {
+        if (errno == ENOENT) {
+            return 0;
         }
+        WARN("Rename file: %s error: %s", file_name, strerror(errno));
+        return -1;
+    }
+
+    log_compressor_queue(util_strdup_s(staged_path));
+
+    return 0;
+}
+
+static int log_file_watch_init()
+{
+    int ret = 0;
+    char *dir = NULL;
+
+    g_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (g_inotify_fd < 0) {
+        COMMAND_ERROR("Init inotify failed: %s", strerror(errno));
+        return -1;
+    }
+
+    dir = util_strdup_s(g_log_file);
+    if (inotify_add_watch(g_inotify_fd, dirname(dir), IN_DELETE | IN_MOVED_FROM) < 0) {
+        COMMAND_ERROR("Watch directory of log file %s failed: %s", g_log_file, strerror(errno));
+        close(g_inotify_fd);
+        g_inotify_fd = -1;
+        ret = -1;
     }
+    free(dir);
 
-    return file_rotate_me(file_name);
+    return ret;
+}
+
+/* events of log file itself, including rotation of us, mark it to be reopened before next write */
+static void log_file_watch_handle()
+{
+    ssize_t len;
+    size_t i;
+    const char *base = NULL;
+    const struct inotify_event *event = NULL;
+    char buf[REV_BUF_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    base = strrchr(g_log_file, '/');
+    base = (base != NULL) ? base + 1 : g_log_file;
+
+    for (;;) {
+        len = read(g_inotify_fd, buf, sizeof(buf));
+        if (len <= 0) {
+            return;
+        }
+        for (i = 0; i < (size_t)len; i += sizeof(struct inotify_event) + event->len) {
+            event = (const struct inotify_event *)(&buf[i]);
+            if (event->len > 0 && strcmp(event->name, base) == 0) {
+                g_log_file_gone = true;
+            }
+        }
+    }
 }
 
 /* get driver */
@@ -170,13 +453,14 @@ static int write_into_file(const void *buf, size_t g_log_size)
     int ret = 0;
     static int64_t write_size = 0;
 
-    if (!util_file_exists(g_log_file)) {
+    if (g_log_file_gone && !util_file_exists(g_log_file)) {
         COMMAND_ERROR("Log file: %s delete by someone.", g_log_file);
         if (log_file_open()) {
             COMMAND_ERROR("Reopen log file failed.");
             return -1;
         }
     }
+    g_log_file_gone = false;
     ret = (int)write(g_log_fd, buf, g_log_size);
     if (ret <= 0) {
         return ret;
@@ -236,6 +520,45 @@ static int write_into_stdout(const void *buf, size_t g_log_size)
     return ret;
 }
 
+/* handle events of log file while waiting, returns true if fifo is readable */
+static bool wait_fifo_readable()
+{
+    struct pollfd fds[2] = {
+        { .fd = g_fifo_fd, .events = POLLIN, .revents = 0 },
+        { .fd = g_inotify_fd, .events = POLLIN, .revents = 0 },
+    };
+
+    if (g_inotify_fd < 0) {
+        return true;
+    }
+
+    if (poll(fds, 2, -1) < 0) {
+        if (errno != EINTR) {
+            COMMAND_ERROR("Poll log fifo failed: %s", strerror(errno));
+            usleep_nointerupt(LOG_FIFO_REOPEN_DELAY_US);
+        }
+        return false;
+    }
+
+    if (fds[1].revents & POLLIN) {
+        log_file_watch_handle();
+    }
+
+    if (fds[0].revents & POLLIN) {
+        return true;
+    }
+
+    /* poll keeps returning at once for a broken fifo, reopen it instead of spinning */
+    if (fds[0].revents & (POLLHUP | POLLERR | POLLNVAL)) {
+        COMMAND_ERROR("Log fifo %s is broken, reopen it", g_fifo_path);
+        if (create_fifo() != 0 || open_log(false) < 0) {
+            usleep_nointerupt(LOG_FIFO_REOPEN_DELAY_US);
+        }
+    }
+
+    return false;
+}
+
 /* main loop */
 void main_loop()
 {
@@ -248,6 +571,9 @@ void main_loop()
     }
 
     for (;;) {
+        if (!wait_fifo_readable()) {
+            continue;
+        }
         int len = (int)util_read_nointr(g_fifo_fd, rev_buf, REV_BUF_SIZE);
         if (len < 0) {
             if (ecount < 2) {
@@ -322,6 +648,12 @@ static int init_log(const struct log_gather_conf *lgconf)
             g_max_size = lgconf->max_size;
             g_max_file = lgconf->max_file;
             g_log_file = util_strdup_s(lgconf->log_path);
+            if (log_compressor_queue_leftovers(g_log_file)) {
+                goto err_out;
+            }
+            if (log_compressor_start()) {
+                goto err_out;
+            }
             if (check_log_file()) {
                 goto err_out;
             }
@@ -332,6 +664,10 @@ static int init_log(const struct log_gather_conf *lgconf)
             if (log_file_open()) {
                 goto err_out;
             }
+            if (log_file_watch_init()) {
+                /* still works, but deletion of log file is not found out */
+                COMMAND_ERROR("Watch log file %s failed", g_log_file);
+            }
             g_save_log_op = write_into_file;
             break;
         case LOG_GATHER_DRIVER_NOSET:
@@ -0,0 +1,279 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-04-14
+ * Description: provide immutable list view of container
+ ******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+
+#include "container_list_view.h"
+#include "list.h"
+#include "log.h"
+#include "utils.h"
+#include "types_def.h"
+
+static void container_list_view_free(container_list_view_t *view)
+{
+    if (view == NULL) {
+        return;
+    }
+
+    container_unref(view->cont);
+    view->cont = NULL;
+    free(view->id);
+    free(view->name);
+    free(view->image);
+    free(view->command);
+    free(view->runtime);
+    free_json_map_string_string(view->labels);
+    free_json_map_string_string(view->annotations);
+    free(view->started_at);
+    free(view->finished_at);
+    free(view->health_state);
+    free(view);
+}
+
+void container_list_view_refinc(container_list_view_t *view)
+{
+    if (view == NULL) {
+        return;
+    }
+    atomic_int_inc(&view->refcnt);
+}
+
+void container_list_view_unref(container_list_view_t *view)
+{
+    if (view == NULL) {
+        return;
+    }
+
+    if (!atomic_int_dec_test(&view->refcnt)) {
+        return;
+    }
+
+    container_list_view_free(view);
+}
+
+static json_map_string_string *dup_nonempty_map(const json_map_string_string *src)
+{
+    json_map_string_string *dest = NULL;
+
+    if (src == NULL || src->len == 0) {
+        return NULL;
+    }
+
+    dest = util_common_calloc_s(sizeof(json_map_string_string));
+    if (dest == NULL) {
+        ERROR("Out of memory");
+        return NULL;
+    }
+
+    if (dup_json_map_string_string(src, dest) != 0) {
+        free_json_map_string_string(dest);
+        return NULL;
+    }
+
+    return dest;
+}
+
+static char *get_health_state(const container_config_v2_state *cont_state)
+{
+    if (cont_state->health == NULL || cont_state->health->status == NULL) {
+        return NULL;
+    }
+
+    if (strcmp(cont_state->health->status, HEALTH_STARTING) == 0) {
+        return util_strdup_s("health: starting");
+    }
+
+    return util_strdup_s(cont_state->health->status);
+}
+
+static int fill_config_view(container_list_view_t *view, const container_t *cont)
+{
+    const container_config_v2_common_config *common_config = cont->common_config;
+    const char *defvalue = "none";
+
+    view->id = util_strdup_s(common_config->id);
+    view->name = util_strdup_s(common_config->name);
+    view->image = container_get_image(cont);
+    if (view->image == NULL) {
+        view->image = util_strdup_s(defvalue);
+    }
+    view->command = container_get_command(cont);
+    view->runtime = util_strdup_s(cont->runtime ? cont->runtime : defvalue);
+
+    if (common_config->created != NULL && to_unix_nanos_from_str(common_config->created, &view->created) != 0) {
+        ERROR("Failed to parse created time of container %s", common_config->id);
+        return -1;
+    }
+
+    if (common_config->config == NULL) {
+        return 0;
+    }
+
+    if (common_config->config->labels != NULL && common_config->config->labels->len != 0) {
+        view->labels = dup_nonempty_map(common_config->config->labels);
+        if (view->labels == NULL) {
+            return -1;
+        }
+    }
+
+    if (common_config->config->annotations != NULL && common_config->config->annotations->len != 0) {
+        view->annotations = dup_nonempty_map(common_config->config->annotations);
+        if (view->annotations == NULL) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* restart count is changed with state locked as well, see container_inc_restart_count */
+static int fill_state_view(container_list_view_t *view, const container_t *cont)
+{
+    int ret = 0;
+    const char *defvalue = "-";
+    container_state_t *s = cont->state;
+
+    container_state_lock(s);
+
+    if (s->state == NULL) {
+        ERROR("Failed to read %s state", view->id);
+        ret = -1;
+        goto out;
+    }
+
+    view->state_seq = atomic_int_get(&s->seq);
+
+    view->restart_count = (uint64_t)cont->common_config->restart_count;
+    view->running = s->state->running;
+    view->status = state_judge_status(s->state);
+    view->pid = s->state->pid;
+    view->exit_code = (uint32_t)s->state->exit_code;
+    view->started_at = util_strdup_s(s->state->started_at ? s->state->started_at : defvalue);
+    view->finished_at = util_strdup_s(s->state->finished_at ? s->state->finished_at : defvalue);
+    view->health_state = get_health_state(s->state);
+
+out:
+    container_state_unlock(s);
+    return ret;
+}
+
+static container_list_view_t *alloc_list_view(container_t *cont)
+{
+    container_list_view_t *view = NULL;
+
+    view = util_common_calloc_s(sizeof(container_list_view_t));
+    if (view == NULL) {
+        ERROR("Out of memory");
+        return NULL;
+    }
+    view->refcnt = 1;
+    container_refinc(cont);
+    view->cont = cont;
+
+    return view;
+}
+
+/* container list view new */
+container_list_view_t *container_list_view_new(container_t *cont)
+{
+    container_list_view_t *view = NULL;
+
+    if (cont == NULL || cont->common_config == NULL || cont->state == NULL) {
+        return NULL;
+    }
+
+    view = alloc_list_view(cont);
+    if (view == NULL) {
+        return NULL;
+    }
+
+    if (fill_config_view(view, cont) != 0) {
+        goto error_out;
+    }
+
+    if (fill_state_view(view, cont) != 0) {
+        goto error_out;
+    }
+
+    return view;
+
+error_out:
+    container_list_view_free(view);
+    return NULL;
+}
+
+static int copy_config_view(container_list_view_t *view, const container_list_view_t *old)
+{
+    view->id = util_strdup_s(old->id);
+    view->name = util_strdup_s(old->name);
+    view->image = util_strdup_s(old->image);
+    view->command = util_strdup_s(old->command);
+    view->runtime = util_strdup_s(old->runtime);
+    view->created = old->created;
+
+    if (old->labels != NULL) {
+        view->labels = dup_nonempty_map(old->labels);
+        if (view->labels == NULL) {
+            return -1;
+        }
+    }
+
+    if (old->annotations != NULL) {
+        view->annotations = dup_nonempty_map(old->annotations);
+        if (view->annotations == NULL) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* container list view refresh */
+container_list_view_t *container_list_view_refresh(const container_list_view_t *old)
+{
+    container_list_view_t *view = NULL;
+
+    if (old == NULL || old->cont == NULL || old->cont->state == NULL) {
+        return NULL;
+    }
+
+    view = alloc_list_view(old->cont);
+    if (view == NULL) {
+        return NULL;
+    }
+
+    if (copy_config_view(view, old) != 0) {
+        goto error_out;
+    }
+
+    if (fill_state_view(view, old->cont) != 0) {
+        goto error_out;
+    }
+
+    return view;
+
+error_out:
+    container_list_view_free(view);
+    return NULL;
+}
+
+bool container_list_view_is_stale(const container_list_view_t *view)
+{
+    if (view == NULL || view->cont == NULL) {
+        return false;
+    }
+
+    return container_state_get_seq(view->cont->state) != view->state_seq;
+}
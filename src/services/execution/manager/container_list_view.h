@@ -0,0 +1,76 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-04-14
+ * Description: provide immutable list view of container
+ ******************************************************************************/
+#ifndef __ISULAD_CONTAINER_LIST_VIEW_H__
+#define __ISULAD_CONTAINER_LIST_VIEW_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "container_unix.h"
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+/*
+ * Everything list of containers needs, copied out of container under its
+ * lock. A view is never changed after built, a newer one replaces it in the
+ * store when container changed, so readers only hold a reference.
+ */
+typedef struct _container_list_view_t_ {
+    uint64_t refcnt;
+    /* referenced by view, to rebuild the view when it is stale */
+    container_t *cont;
+    /* state seq of container when the view was built */
+    uint64_t state_seq;
+
+    char *id;
+    char *name;
+    char *image;
+    char *command;
+    char *runtime;
+    json_map_string_string *labels;
+    json_map_string_string *annotations;
+    int64_t created;
+
+    /* runtime state, rebuilt on every refresh */
+    uint64_t restart_count;
+    bool running;
+    Container_Status status;
+    int pid;
+    uint32_t exit_code;
+    char *started_at;
+    char *finished_at;
+    char *health_state;
+} container_list_view_t;
+
+/* called with container locked, config of container is only changed under its lock */
+container_list_view_t *container_list_view_new(container_t *cont);
+
+/* rebuild state of view under state lock, config is copied from the old view */
+container_list_view_t *container_list_view_refresh(const container_list_view_t *old);
+
+void container_list_view_refinc(container_list_view_t *view);
+
+void container_list_view_unref(container_list_view_t *view);
+
+/* state of container was changed after the view was built */
+bool container_list_view_is_stale(const container_list_view_t *view);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif
+
+#endif /* __ISULAD_CONTAINER_LIST_VIEW_H__ */
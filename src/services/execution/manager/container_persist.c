@@ -0,0 +1,454 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-04-15
+ * Description: provide crash safe group commit of container metadata files
+ ******************************************************************************/
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <linux/limits.h>
+
+#include "container_persist.h"
+#include "constants.h"
+#include "log.h"
+#include "utils.h"
+#include "map.h"
+
+/* waiters of records committed together share a batch */
+struct persist_batch {
+    int refcnt;
+    bool done;
+    int ret;
+};
+
+struct persist_record {
+    const char *path;
+    const char *content;
+    /* tmp file was written, or file was renamed */
+    bool done;
+};
+
+static struct {
+    pthread_mutex_t lock;
+    /* wake up committer */
+    pthread_cond_t cond;
+    /* wake up waiters of a done batch */
+    pthread_cond_t done_cond;
+    /* path -> content, to be committed in batch */
+    map_t *pending;
+    struct persist_batch *batch;
+    bool started;
+} g_persister = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .done_cond = PTHREAD_COND_INITIALIZER,
+};
+
+static pthread_once_t g_persister_once = PTHREAD_ONCE_INIT;
+
+static void persist_map_kvfree(void *key, void *value)
+{
+    free(key);
+    free(value);
+}
+
+static struct persist_batch *persist_batch_new(void)
+{
+    struct persist_batch *batch = util_common_calloc_s(sizeof(struct persist_batch));
+
+    if (batch == NULL) {
+        ERROR("Out of memory");
+        return NULL;
+    }
+    batch->refcnt = 1;
+    return batch;
+}
+
+/* called with g_persister.lock held */
+static void persist_batch_unref(struct persist_batch *batch)
+{
+    batch->refcnt--;
+    if (batch->refcnt == 0) {
+        free(batch);
+    }
+}
+
+static int tmp_file_path(const char *path, char *tmp, size_t len)
+{
+    int nret = snprintf(tmp, len, "%s.tmp", path);
+
+    if (nret < 0 || (size_t)nret >= len) {
+        ERROR("Failed to sprintf tmp file name for %s", path);
+        return -1;
+    }
+    return 0;
+}
+
+/* return 1 if directory of file is gone, the container was removed */
+static int write_tmp_file(const char *path, const char *content)
+{
+    int ret = 0;
+    int fd = -1;
+    ssize_t len = 0;
+    size_t content_len = strlen(content);
+    char tmp[PATH_MAX] = { 0 };
+
+    if (tmp_file_path(path, tmp, sizeof(tmp)) != 0) {
+        return -1;
+    }
+
+    fd = util_open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, CONFIG_FILE_MODE);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return 1;
+        }
+        ERROR("Create file %s failed: %s", tmp, strerror(errno));
+        return -1;
+    }
+
+    len = util_write_nointr(fd, content, content_len);
+    if (len < 0 || (size_t)len != content_len) {
+        ERROR("Write file %s failed: %s", tmp, strerror(errno));
+        ret = -1;
+    } else if (fsync(fd) != 0) {
+        /* data must be on disk before tmp file replaces the old one */
+        ERROR("Sync file %s failed: %s", tmp, strerror(errno));
+        ret = -1;
+    }
+    close(fd);
+
+    if (ret != 0) {
+        (void)unlink(tmp);
+    }
+    return ret;
+}
+
+static int rename_tmp_file(const char *path)
+{
+    char tmp[PATH_MAX] = { 0 };
+
+    if (tmp_file_path(path, tmp, sizeof(tmp)) != 0) {
+        return -1;
+    }
+
+    if (rename(tmp, path) != 0) {
+        if (errno == ENOENT) {
+            return 1;
+        }
+        ERROR("Rename %s to %s failed: %s", tmp, path, strerror(errno));
+        (void)unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+/* make renames of done records durable, with one fsync per directory */
+static int sync_records_dirs(const struct persist_record *records, size_t len)
+{
+    int ret = 0;
+    int fd = -1;
+    size_t i, j;
+    size_t synced_len = 0;
+    char **synced = NULL;
+    char *dir = NULL;
+
+    synced = util_common_calloc_s(sizeof(char *) * len);
+    if (synced == NULL) {
+        ERROR("Out of memory");
+        return -1;
+    }
+
+    for (i = 0; i < len; i++) {
+        if (!records[i].done) {
+            continue;
+        }
+        dir = util_path_dir(records[i].path);
+        if (dir == NULL) {
+            ret = -1;
+            continue;
+        }
+        for (j = 0; j < synced_len; j++) {
+            if (strcmp(synced[j], dir) == 0) {
+                break;
+            }
+        }
+        if (j < synced_len) {
+            free(dir);
+            continue;
+        }
+
+        fd = util_open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC, 0);
+        if (fd < 0) {
+            /* removed together with the container */
+            free(dir);
+            continue;
+        }
+        if (fsync(fd) != 0) {
+            ERROR("Failed to sync directory %s: %s", dir, strerror(errno));
+            ret = -1;
+        }
+        close(fd);
+        synced[synced_len++] = dir;
+    }
+
+    for (j = 0; j < synced_len; j++) {
+        free(synced[j]);
+    }
+    free(synced);
+    return ret;
+}
+
+static int commit_records(struct persist_record *records, size_t len)
+{
+    int ret = 0;
+    int nret = 0;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        nret = write_tmp_file(records[i].path, records[i].content);
+        if (nret < 0) {
+            ret = -1;
+        }
+        records[i].done = (nret == 0);
+    }
+
+    for (i = 0; i < len; i++) {
+        if (!records[i].done) {
+            continue;
+        }
+        nret = rename_tmp_file(records[i].path);
+        if (nret < 0) {
+            ret = -1;
+        }
+        records[i].done = (nret == 0);
+    }
+
+    if (sync_records_dirs(records, len) != 0) {
+        ret = -1;
+    }
+
+    return ret;
+}
+
+static int commit_pending(const map_t *pending)
+{
+    int ret = 0;
+    size_t len = map_size(pending);
+    size_t i = 0;
+    map_itor *itor = NULL;
+    struct persist_record *records = NULL;
+
+    records = util_common_calloc_s(sizeof(struct persist_record) * len);
+    if (records == NULL) {
+        ERROR("Out of memory");
+        return -1;
+    }
+
+    itor = map_itor_new(pending);
+    if (itor == NULL) {
+        ERROR("Out of memory");
+        ret = -1;
+        goto out;
+    }
+    for (; map_itor_valid(itor) && i < len; map_itor_next(itor)) {
+        records[i].path = map_itor_key(itor);
+        records[i].content = map_itor_value(itor);
+        i++;
+    }
+    map_itor_free(itor);
+
+    ret = commit_records(records, i);
+
+out:
+    free(records);
+    return ret;
+}
+
+static void *persister_routine(void *arg)
+{
+    int ret = 0;
+    map_t *next_pending = NULL;
+    map_t *pending = NULL;
+    struct persist_batch *next_batch = NULL;
+    struct persist_batch *batch = NULL;
+
+    (void)arg;
+    if (pthread_detach(pthread_self()) != 0) {
+        CRIT("Set container persister thread detach fail");
+    }
+    prctl(PR_SET_NAME, "ContainerSync");
+
+    for (;;) {
+        if (next_pending == NULL) {
+            next_pending = map_new(MAP_STR_PTR, MAP_DEFAULT_CMP_FUNC, persist_map_kvfree);
+        }
+        if (next_batch == NULL) {
+            next_batch = persist_batch_new();
+        }
+        if (next_pending == NULL || next_batch == NULL) {
+            ERROR("Out of memory, retry to commit container files later");
+            sleep(1);
+            continue;
+        }
+
+        pthread_mutex_lock(&g_persister.lock);
+        while (map_size(g_persister.pending) == 0) {
+            pthread_cond_wait(&g_persister.cond, &g_persister.lock);
+        }
+        /* records queued from now on go to the next batch */
+        pending = g_persister.pending;
+        batch = g_persister.batch;
+        g_persister.pending = next_pending;
+        g_persister.batch = next_batch;
+        next_pending = NULL;
+        next_batch = NULL;
+        pthread_mutex_unlock(&g_persister.lock);
+
+        ret = commit_pending(pending);
+        map_free(pending);
+
+        pthread_mutex_lock(&g_persister.lock);
+        batch->ret = ret;
+        batch->done = true;
+        persist_batch_unref(batch);
+        pthread_cond_broadcast(&g_persister.done_cond);
+        pthread_mutex_unlock(&g_persister.lock);
+    }
+
+    return NULL;
+}
+
+static void persister_init(void)
+{
+    pthread_t thread;
+
+    g_persister.pending = map_new(MAP_STR_PTR, MAP_DEFAULT_CMP_FUNC, persist_map_kvfree);
+    g_persister.batch = persist_batch_new();
+    if (g_persister.pending == NULL || g_persister.batch == NULL) {
+        goto err_out;
+    }
+
+    if (pthread_create(&thread, NULL, persister_routine, NULL) != 0) {
+        ERROR("Failed to create container persister thread");
+        goto err_out;
+    }
+
+    g_persister.started = true;
+    return;
+
+err_out:
+    map_free(g_persister.pending);
+    g_persister.pending = NULL;
+    free(g_persister.batch);
+    g_persister.batch = NULL;
+}
+
+static int persist_files_directly(const char **paths, const char **contents, size_t len)
+{
+    int ret = 0;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        if (util_atomic_write_file(paths[i], contents[i], strlen(contents[i]), CONFIG_FILE_MODE, true) != 0) {
+            ret = -1;
+        }
+    }
+    return ret;
+}
+
+int container_persist_queue(const char **paths, const char **contents, size_t len,
+                            container_persist_ticket **ticket)
+{
+    int ret = 0;
+    size_t i;
+    char *content = NULL;
+
+    if (paths == NULL || contents == NULL) {
+        return -1;
+    }
+    if (ticket != NULL) {
+        *ticket = NULL;
+    }
+
+    (void)pthread_once(&g_persister_once, persister_init);
+    if (!g_persister.started) {
+        return persist_files_directly(paths, contents, len);
+    }
+
+    pthread_mutex_lock(&g_persister.lock);
+    for (i = 0; i < len; i++) {
+        content = util_strdup_s(contents[i]);
+        if (!map_replace(g_persister.pending, (void *)paths[i], content)) {
+            ERROR("Failed to queue file %s", paths[i]);
+            free(content);
+            ret = -1;
+        }
+    }
+    pthread_cond_signal(&g_persister.cond);
+
+    if (ret == 0 && ticket != NULL) {
+        *ticket = g_persister.batch;
+        g_persister.batch->refcnt++;
+    }
+    pthread_mutex_unlock(&g_persister.lock);
+
+    return ret;
+}
+
+int container_persist_wait(container_persist_ticket *ticket)
+{
+    int ret = 0;
+
+    if (ticket == NULL) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&g_persister.lock);
+    while (!ticket->done) {
+        pthread_cond_wait(&g_persister.done_cond, &g_persister.lock);
+    }
+    ret = ticket->ret;
+    persist_batch_unref(ticket);
+    pthread_mutex_unlock(&g_persister.lock);
+
+    return ret;
+}
+
+void container_persist_release(container_persist_ticket *ticket)
+{
+    if (ticket == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&g_persister.lock);
+    persist_batch_unref(ticket);
+    pthread_mutex_unlock(&g_persister.lock);
+}
+
+int container_persist_files(const char **paths, const char **contents, size_t len, bool wait)
+{
+    int ret = 0;
+    container_persist_ticket *ticket = NULL;
+
+    ret = container_persist_queue(paths, contents, len, wait ? &ticket : NULL);
+    if (ret != 0) {
+        return ret;
+    }
+
+    return container_persist_wait(ticket);
+}
@@ -0,0 +1,57 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-04-15
+ * Description: provide crash safe group commit of container metadata files
+ ******************************************************************************/
+#ifndef __ISULAD_CONTAINER_PERSIST_H__
+#define __ISULAD_CONTAINER_PERSIST_H__
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+/* files queued together, to wait for their commit */
+typedef struct persist_batch container_persist_ticket;
+
+/*
+ * Files are queued to one committer thread, which writes and syncs every queued
+ * file to a temporary file, renames them over the old ones and syncs each of
+ * their directories once. A newer content of a queued file replaces the older
+ * one, so a burst of updates of a container costs one write and one fsync.
+ * Files of a removed container are skipped silently.
+ *
+ * If ticket is not NULL, it is set to wait for the commit by
+ * container_persist_wait, or to release by container_persist_release.
+ * It may be set to NULL if files were already committed.
+ */
+int container_persist_queue(const char **paths, const char **contents, size_t len,
+                            container_persist_ticket **ticket);
+
+/* wait files of ticket were committed and release ticket, return result of the commit */
+int container_persist_wait(container_persist_ticket *ticket);
+
+void container_persist_release(container_persist_ticket *ticket);
+
+/*
+ * If wait is true, return after the files were committed, with the result of
+ * the commit, otherwise return after they were queued.
+ */
+int container_persist_files(const char **paths, const char **contents, size_t len, bool wait);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif
+
+#endif /* __ISULAD_CONTAINER_PERSIST_H__ */
@@ -21,6 +21,48 @@
 #include "utils.h"
 #include "error.h"
 
+/*
+ * Number of containers in the store by status. Every state transition below
+ * moves its container between the counters, so they are never recounted.
+ */
+static uint64_t g_state_counters[CONTAINER_STATUS_MAX_STATE];
+static pthread_mutex_t g_state_counters_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void state_counters_move(int from, int to)
+{
+    if (pthread_mutex_lock(&g_state_counters_lock) != 0) {
+        ERROR("Failed to lock state counters");
+        return;
+    }
+    if (from >= 0 && from < CONTAINER_STATUS_MAX_STATE && g_state_counters[from] > 0) {
+        g_state_counters[from]--;
+    }
+    if (to >= 0 && to < CONTAINER_STATUS_MAX_STATE) {
+        g_state_counters[to]++;
+    }
+    if (pthread_mutex_unlock(&g_state_counters_lock) != 0) {
+        ERROR("Failed to unlock state counters");
+    }
+}
+
+/* called with state locked, after state was changed */
+static void state_update_counters(container_state_t *s)
+{
+    Container_Status status;
+
+    (void)atomic_int_inc(&s->seq);
+
+    if (!s->counted) {
+        return;
+    }
+
+    status = state_judge_status(s->state);
+    if (status != s->counted_status) {
+        state_counters_move((int)s->counted_status, (int)status);
+        s->counted_status = status;
+    }
+}
+
 /* container state lock */
 void container_state_lock(container_state_t *state)
 {
@@ -94,6 +136,8 @@ void state_set_starting(container_state_t *s)
 
     s->state->starting = true;
 
+    state_update_counters(s);
+
     container_state_unlock(s);
 }
 
@@ -122,6 +166,8 @@ void state_reset_starting(container_state_t *s)
 
     s->state->starting = false;
 
+    state_update_counters(s);
+
     container_state_unlock(s);
 }
 
@@ -166,6 +212,8 @@ void state_set_running(container_state_t *s, const container_pid_t *pid_info, bo
     free(state->started_at);
     state->started_at = util_strdup_s(timebuffer);
 
+    state_update_counters(s);
+
     container_state_unlock(s);
 }
 
@@ -197,6 +245,8 @@ void state_set_stopped(container_state_t *s, int exit_code)
     free(state->finished_at);
     state->finished_at = util_strdup_s(timebuffer);
 
+    state_update_counters(s);
+
     container_state_unlock(s);
 }
 
@@ -214,6 +264,8 @@ void state_set_paused(container_state_t *s)
     state = s->state;
     state->paused = true;
 
+    state_update_counters(s);
+
     container_state_unlock(s);
 }
 
@@ -231,6 +283,8 @@ void state_reset_paused(container_state_t *s)
     state = s->state;
     state->paused = false;
 
+    state_update_counters(s);
+
     container_state_unlock(s);
 }
 
@@ -260,6 +314,8 @@ void update_start_and_finish_time(container_state_t *s, const char *finish_at)
     free(state->started_at);
     state->started_at = util_strdup_s(timebuffer);
 
+    state_update_counters(s);
+
     container_state_unlock(s);
 
     return;
@@ -293,6 +349,8 @@ void state_set_restarting(container_state_t *s, int exit_code)
     free(state->finished_at);
     state->finished_at = util_strdup_s(timebuffer);
 
+    state_update_counters(s);
+
     container_state_unlock(s);
 
     return;
@@ -692,3 +750,78 @@ bool is_valid_state_string(const char *state)
     return true;
 }
 
+void container_state_start_counting(container_state_t *s)
+{
+    if (s == NULL) {
+        return;
+    }
+
+    container_state_lock(s);
+    if (!s->counted) {
+        s->counted = true;
+        s->counted_status = state_judge_status(s->state);
+        state_counters_move(-1, (int)s->counted_status);
+    }
+    container_state_unlock(s);
+}
+
+void container_state_stop_counting(container_state_t *s)
+{
+    if (s == NULL) {
+        return;
+    }
+
+    container_state_lock(s);
+    if (s->counted) {
+        s->counted = false;
+        state_counters_move((int)s->counted_status, -1);
+    }
+    container_state_unlock(s);
+}
+
+/* paused containers are not counted as running, the same as docker */
+void container_state_get_counters(container_state_counters_t *counters)
+{
+    int i;
+
+    if (counters == NULL) {
+        return;
+    }
+
+    (void)memset(counters, 0, sizeof(container_state_counters_t));
+
+    if (pthread_mutex_lock(&g_state_counters_lock) != 0) {
+        ERROR("Failed to lock state counters");
+        return;
+    }
+    for (i = 0; i < CONTAINER_STATUS_MAX_STATE; i++) {
+        counters->total += g_state_counters[i];
+    }
+    counters->running = g_state_counters[CONTAINER_STATUS_RUNNING] + g_state_counters[CONTAINER_STATUS_RESTARTING];
+    counters->paused = g_state_counters[CONTAINER_STATUS_PAUSED];
+    if (pthread_mutex_unlock(&g_state_counters_lock) != 0) {
+        ERROR("Failed to unlock state counters");
+    }
+
+    counters->stopped = counters->total - counters->running - counters->paused;
+}
+
+/* called with state locked, after runtime state kept out of state, like restart count, was changed */
+void container_state_bump_seq(container_state_t *s)
+{
+    if (s == NULL) {
+        return;
+    }
+
+    (void)atomic_int_inc(&s->seq);
+}
+
+/* no state lock needed, list views compare it to find out they are stale */
+uint64_t container_state_get_seq(container_state_t *s)
+{
+    if (s == NULL) {
+        return 0;
+    }
+
+    return atomic_int_get(&s->seq);
+}
@@ -28,8 +28,20 @@ extern "C" {
 typedef struct _container_state_t_ {
     pthread_mutex_t mutex;
     container_config_v2_state *state;
+    /* status this container is accounted as in the global state counters */
+    bool counted;
+    Container_Status counted_status;
+    /* bumped on every change of state, list views built from an older one are stale */
+    uint64_t seq;
 } container_state_t;
 
+typedef struct {
+    uint64_t total;
+    uint64_t running;
+    uint64_t paused;
+    uint64_t stopped;
+} container_state_counters_t;
+
 
 container_state_t *container_state_new(void);
 
@@ -92,6 +104,17 @@ bool is_valid_state_string(const char *state);
 
 int dup_health_check_status(defs_health **dst, const defs_health *src);
 
+/* account container in the global state counters, until stop counting */
+void container_state_start_counting(container_state_t *s);
+
+void container_state_stop_counting(container_state_t *s);
+
+void container_state_get_counters(container_state_counters_t *counters);
+
+uint64_t container_state_get_seq(container_state_t *s);
+
+void container_state_bump_seq(container_state_t *s);
+
 #if defined(__cplusplus) || defined(c_plusplus)
 }
 #endif
@@ -21,6 +21,9 @@
 #include "container_unix.h"
 #include "log.h"
 #include "utils.h"
+#include "container_runtime_state.h"
+#include "container_persist.h"
+#include "containers_store.h"
 
 static int parse_container_log_configs(container_t *cont);
 
@@ -157,6 +160,9 @@ void container_free(container_t *container)
     free(container->log_path);
     container->log_path = NULL;
 
+    container_persist_release(container->persist_ticket);
+    container->persist_ticket = NULL;
+
     free_host_config(container->hostconfig);
 
     restart_manager_unref(container->rm);
@@ -243,6 +249,35 @@ int container_timedlock(container_t *cont, int timeout)
 }
 
 
+/* container unlock */
+/* unlock container, then wait state saved under lock to be committed and publish it */
+static int container_unlock_and_wait(container_t *cont)
+{
+    int ret = 0;
+    container_persist_ticket *ticket = NULL;
+
+    ticket = cont->persist_ticket;
+    cont->persist_ticket = NULL;
+
+    if (pthread_mutex_unlock(&cont->mutex) != 0) {
+        ERROR("Failed to unlock container '%s'", cont->common_config->id);
+    }
+
+    if (ticket == NULL) {
+        return 0;
+    }
+
+    ret = container_persist_wait(ticket);
+    if (ret != 0) {
+        ERROR("Failed to save container '%s' to disk", cont->common_config->id);
+        return ret;
+    }
+
+    /* state is saved after every change, it is the time to publish its list view */
+    containers_store_refresh_list_view(cont->common_config->id);
+    return 0;
+}
+
 /* container unlock */
 void container_unlock(container_t *cont)
 {
@@ -251,9 +286,7 @@ void container_unlock(container_t *cont)
         return;
     }
 
-    if (pthread_mutex_unlock(&cont->mutex) != 0) {
-        ERROR("Failed to unlock container '%s'", cont->common_config->id);
-    }
+    (void)container_unlock_and_wait(cont);
 }
 
 /* container wait stop cond broadcast */
@@ -448,44 +481,42 @@ out:
     return ret;
 }
 
+static int container_file_path(const char *id, const char *rootpath, const char *fname, char *path, size_t len)
+{
+    int nret;
+
+    nret = snprintf(path, len, "%s/%s/%s", rootpath, id, fname);
+    if (nret < 0 || (size_t)nret >= len) {
+        ERROR("Failed to print string");
+        return -1;
+    }
+
+    return 0;
+}
+
 /* save json config file */
 static int save_json_config_file(const char *id, const char *rootpath,
                                  const char *json_data, const char *fname)
 {
-    int ret = 0;
-    int nret;
-    int fd = -1;
-    ssize_t len = 0;
     char filename[PATH_MAX] = { 0 };
+    const char *paths[] = { filename };
+    const char *contents[] = { json_data };
 
     if (json_data == NULL || strlen(json_data) == 0) {
         return 0;
     }
-    nret = snprintf(filename, sizeof(filename), "%s/%s/%s", rootpath, id, fname);
-    if (nret < 0 || (size_t)nret >= sizeof(filename)) {
-        ERROR("Failed to print string");
-        ret = -1;
-        goto out;
-    }
 
-    fd = util_open(filename, O_CREAT | O_TRUNC | O_CLOEXEC | O_WRONLY, CONFIG_FILE_MODE);
-    if (fd == -1) {
-        ERROR("Create file %s failed: %s", filename, strerror(errno));
-        isulad_set_error_message("Create file '%s' failed: %s", filename, strerror(errno));
-        ret = -1;
-        goto out;
+    if (container_file_path(id, rootpath, fname, filename, sizeof(filename)) != 0) {
+        return -1;
     }
 
-    len = util_write_nointr(fd, json_data, strlen(json_data));
-    if (len < 0 || ((size_t)len) != strlen(json_data)) {
-        ERROR("Write file %s failed: %s", filename, strerror(errno));
-        isulad_set_error_message("Write file '%s' failed: %s", filename, strerror(errno));
-        ret = -1;
+    if (container_persist_files(paths, contents, 1, true) != 0) {
+        ERROR("Save file %s failed", filename);
+        isulad_set_error_message("Save file '%s' failed", filename);
+        return -1;
     }
-    close(fd);
 
-out:
-    return ret;
+    return 0;
 }
 
 #define CONFIG_V2_JSON "config.v2.json"
@@ -558,51 +589,89 @@ out:
     return hostconfig;
 }
 
-/* container save host config */
-static int container_save_host_config(const container_t *cont)
+/* generate host config json of container */
+static char *container_host_config_json(const container_t *cont)
 {
-    int ret = 0;
     parser_error err = NULL;
     char *json_host_config = NULL;
 
-    if (cont == NULL) {
-        return -1;
-    }
-
     json_host_config = host_config_generate_json(cont->hostconfig, NULL, &err);
     if (json_host_config == NULL) {
         ERROR("Failed to generate container host config json string:%s", err ? err : " ");
-        ret = -1;
-        goto out;
     }
 
-    ret = save_host_config(cont->common_config->id, cont->root_path, json_host_config);
-    if (ret != 0) {
-        ERROR("Failed to save container host config json to file");
-        ret = -1;
+    free(err);
+    return json_host_config;
+}
+
+#define RUNTIME_STATE_JSON "runtime-state.json"
+
+/* runtime state is saved apart from config v2 on every change of state, it is newer if exists */
+static int load_runtime_state(container_t *cont)
+{
+    int ret = 0;
+    char filename[PATH_MAX] = { 0x00 };
+    parser_error err = NULL;
+    container_runtime_state *rstate = NULL;
+
+    if (container_file_path(cont->common_config->id, cont->root_path, RUNTIME_STATE_JSON, filename,
+                            sizeof(filename)) != 0) {
+        return -1;
+    }
+
+    if (!util_file_exists(filename)) {
+        return 0;
+    }
+
+    rstate = container_runtime_state_parse_file(filename, NULL, &err);
+    if (rstate == NULL) {
+        /* config v2 still has an older state, keep it */
+        WARN("Failed to parse runtime state file:%s", err);
         goto out;
     }
 
+    if (rstate->state != NULL) {
+        free_container_config_v2_state(cont->state->state);
+        cont->state->state = rstate->state;
+        rstate->state = NULL;
+    }
+    cont->common_config->restart_count = rstate->restart_count;
+    cont->common_config->has_been_started_before = rstate->has_been_started_before;
+    cont->common_config->has_been_manually_stopped = rstate->has_been_manually_stopped;
+
 out:
-    free(json_host_config);
     free(err);
-
+    free_container_runtime_state(rstate);
     return ret;
 }
 
-/* container save config v2 */
-static int container_save_config_v2(const container_t *cont)
+/* generate runtime state json of container, with state lock held */
+static char *container_runtime_state_json(const container_t *cont)
 {
-    int ret = 0;
-    char *json_v2 = NULL;
+    char *json = NULL;
     parser_error err = NULL;
-    container_config_v2 config_v2;
+    container_runtime_state rstate = { 0 };
 
-    if (cont == NULL) {
-        return -1;
+    rstate.state = cont->state->state;
+    rstate.restart_count = cont->common_config->restart_count;
+    rstate.has_been_started_before = cont->common_config->has_been_started_before;
+    rstate.has_been_manually_stopped = cont->common_config->has_been_manually_stopped;
+
+    json = container_runtime_state_generate_json(&rstate, NULL, &err);
+    if (json == NULL) {
+        ERROR("Failed to generate container runtime state json string:%s", err ? err : " ");
     }
 
-    container_state_lock(cont->state);
+    free(err);
+    return json;
+}
+
+/* generate config v2 json of container, with state lock held */
+static char *container_config_v2_json(const container_t *cont)
+{
+    char *json_v2 = NULL;
+    parser_error err = NULL;
+    container_config_v2 config_v2 = { 0 };
 
     config_v2.common_config = cont->common_config;
 
@@ -613,43 +682,117 @@ static int container_save_config_v2(const container_t *cont)
     json_v2 = container_config_v2_generate_json(&config_v2, NULL, &err);
     if (json_v2 == NULL) {
         ERROR("Failed to generate container config V2 json string:%s", err ? err : " ");
-        ret = -1;
-        goto out;
     }
 
-    ret = save_config_v2_json(cont->common_config->id, cont->root_path, json_v2);
-    if (ret != 0) {
-        ERROR("Failed to save container config V2 json to file");
+    free(err);
+    return json_v2;
+}
+
+/* queue runtime state of container to be saved, ticket is set to wait for it if not NULL */
+static int save_runtime_state(const container_t *cont, container_persist_ticket **ticket)
+{
+    int ret = 0;
+    char filename[PATH_MAX] = { 0x00 };
+    char *json = NULL;
+    const char *paths[] = { filename };
+    const char *contents[] = { NULL };
+
+    if (container_file_path(cont->common_config->id, cont->root_path, RUNTIME_STATE_JSON, filename,
+                            sizeof(filename)) != 0) {
+        return -1;
+    }
+
+    /* queue with state locked, so an older snapshot never replaces a newer queued one */
+    container_state_lock(cont->state);
+    json = container_runtime_state_json(cont);
+    if (json == NULL) {
         ret = -1;
-        goto out;
+        goto unlock_out;
+    }
+    contents[0] = json;
+    ret = container_persist_queue(paths, contents, 1, ticket);
+    if (ret != 0) {
+        ERROR("Failed to save container runtime state to file %s", filename);
     }
 
-out:
-    free(json_v2);
-    free(err);
+unlock_out:
     container_state_unlock(cont->state);
+    free(json);
     return ret;
 }
 
-/* container to disk */
-int container_to_disk(const container_t *cont)
+/* save health of container with the rest of runtime state, without waiting it to be synced */
+int container_save_health(const container_t *cont)
+{
+    if (cont == NULL) {
+        return -1;
+    }
+
+    return save_runtime_state(cont, NULL);
+}
+
+/*
+ * container to disk, save config v2, host config and runtime state of container.
+ * Config is changed only at create, rename and update, container_state_to_disk
+ * is enough for everything else.
+ */
+int container_to_disk(container_t *cont)
 {
     int ret = 0;
+    size_t i;
+    char v2_path[PATH_MAX] = { 0x00 };
+    char host_path[PATH_MAX] = { 0x00 };
+    char state_path[PATH_MAX] = { 0x00 };
+    const char *paths[] = { v2_path, host_path, state_path };
+    char *contents[] = { NULL, NULL, NULL };
+    container_persist_ticket *ticket = NULL;
 
     if (cont == NULL) {
         return -1;
     }
 
-    ret = container_save_config_v2(cont);
-    if (ret != 0) {
-        return ret;
+    if (container_file_path(cont->common_config->id, cont->root_path, CONFIG_V2_JSON, v2_path,
+                            sizeof(v2_path)) != 0 ||
+        container_file_path(cont->common_config->id, cont->root_path, HOSTCONFIGJSON, host_path,
+                            sizeof(host_path)) != 0 ||
+        container_file_path(cont->common_config->id, cont->root_path, RUNTIME_STATE_JSON, state_path,
+                            sizeof(state_path)) != 0) {
+        return -1;
     }
 
-    ret = container_save_host_config(cont);
+    contents[1] = container_host_config_json(cont);
+    if (contents[1] == NULL) {
+        ret = -1;
+        goto out;
+    }
+
+    /* all of them are committed together, queued with state locked like save_runtime_state */
+    container_state_lock(cont->state);
+    contents[0] = container_config_v2_json(cont);
+    contents[2] = container_runtime_state_json(cont);
+    if (contents[0] == NULL || contents[2] == NULL) {
+        container_state_unlock(cont->state);
+        ret = -1;
+        goto out;
+    }
+    ret = container_persist_queue(paths, (const char **)contents, sizeof(paths) / sizeof(paths[0]), &ticket);
+    container_state_unlock(cont->state);
+    if (ret == 0) {
+        ret = container_persist_wait(ticket);
+    }
     if (ret != 0) {
-        return ret;
+        ERROR("Failed to save container %s to disk", cont->common_config->id);
+        isulad_set_error_message("Failed to save container '%s' to disk", cont->common_config->id);
+        goto out;
     }
 
+    /* container is saved after every change, it is the time to publish its list view */
+    containers_store_update_list_view(cont);
+
+out:
+    for (i = 0; i < sizeof(contents) / sizeof(contents[0]); i++) {
+        free(contents[i]);
+    }
     return ret;
 }
 
@@ -670,6 +813,49 @@ int container_to_disk_locking(container_t *cont)
     return ret;
 }
 
+/*
+ * container state to disk, save runtime state of container only.
+ * Called with container locked, the state is snapshotted and queued here,
+ * container_unlock waits for it to be synced and publishes its list view,
+ * so syncing the disk does not block other users of the container.
+ */
+int container_state_to_disk(container_t *cont)
+{
+    container_persist_ticket *ticket = NULL;
+
+    if (cont == NULL) {
+        return -1;
+    }
+
+    if (save_runtime_state(cont, &ticket) != 0) {
+        return -1;
+    }
+
+    /* newer state replaces the queued one, waiting for it is enough */
+    container_persist_release(cont->persist_ticket);
+    cont->persist_ticket = ticket;
+    return 0;
+}
+
+/* container state to disk locking */
+int container_state_to_disk_locking(container_t *cont)
+{
+    int ret = 0;
+
+    if (cont == NULL) {
+        return -1;
+    }
+
+    container_lock(cont);
+
+    ret = container_state_to_disk(cont);
+
+    if (container_unlock_and_wait(cont) != 0) {
+        ret = -1;
+    }
+    return ret;
+}
+
 static int do_parse_container_log_config(const char *key, const char *value, container_t *cont)
 {
     if (strcmp(key, CONTAINER_LOG_CONFIG_KEY_FILE) == 0) {
@@ -754,6 +940,10 @@ container_t *container_load(const char *runtime, const char *rootpath, const cha
 
     free_container_config_v2(v2config);
 
+    if (cont->state->state != NULL && load_runtime_state(cont) != 0) {
+        ERROR("Failed to load runtime state of container '%s'", id);
+    }
+
     return cont;
 
 error_out:
@@ -884,12 +1074,29 @@ bool reset_restart_manager(container_t *cont, bool reset_count)
         restart_manager_unref(cont->rm);
     }
     if (reset_count) {
+        container_state_lock(cont->state);
         cont->common_config->restart_count = 0;
+        container_state_bump_seq(cont->state);
+        container_state_unlock(cont->state);
     }
     cont->rm = NULL;
     return true;
 }
 
+/* restart count is runtime state, change it with state locked, so list views pick it up */
+void container_inc_restart_count(container_t *cont)
+{
+    if (cont == NULL) {
+        ERROR("Invalid input arguments");
+        return;
+    }
+
+    container_state_lock(cont->state);
+    cont->common_config->restart_count++;
+    container_state_bump_seq(cont->state);
+    container_state_unlock(cont->state);
+}
+
 /* get restart manager */
 restart_manager_t *get_restart_manager(container_t *cont)
 {
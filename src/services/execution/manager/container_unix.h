@@ -26,6 +26,7 @@
 #include "restartmanager.h"
 #include "events_handler.h"
 #include "health_check.h"
+#include "container_persist.h"
 
 #if defined(__cplusplus) || defined(c_plusplus)
 extern "C" {
@@ -54,6 +55,9 @@ typedef struct _container_t_ {
     char *log_path;
     int log_rotate;
     int64_t log_maxsize;
+
+    /* state saved under lock, waited by container_unlock */
+    container_persist_ticket *persist_ticket;
 } container_t;
 
 void container_refinc(container_t *cont);
@@ -65,10 +69,16 @@ container_t *container_new(const char *runtime, const char *rootpath, const char
 
 container_t *container_load(const char *runtime, const char *rootpath, const char *statepath, const char *id);
 
-int container_to_disk(const container_t *cont);
+int container_to_disk(container_t *cont);
 
 int container_to_disk_locking(container_t *cont);
 
+int container_state_to_disk(container_t *cont);
+
+int container_state_to_disk_locking(container_t *cont);
+
+int container_save_health(const container_t *cont);
+
 void container_lock(container_t *cont);
 
 int container_timedlock(container_t *cont, int timeout);
@@ -92,6 +102,8 @@ restart_manager_t *get_restart_manager(container_t *cont);
 
 bool reset_restart_manager(container_t *cont, bool reset_count);
 
+void container_inc_restart_count(container_t *cont);
+
 void container_update_restart_manager(container_t *cont, const host_config_restart_policy *policy);
 
 void container_reset_manually_stopped(container_t *cont);
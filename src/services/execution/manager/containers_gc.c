@@ -26,8 +26,33 @@
 #include "execution.h"
 #include "containers_store.h"
 #include "runtime.h"
+#include "utils_thread_pool.h"
 
-static containers_gc_t g_gc_containers;
+#define GCCONFIGJSON "garbage.json"
+#define GCJOURNAL "garbage.journal"
+#define GC_JOURNAL_ADD 'A'
+#define GC_JOURNAL_DEL 'D'
+/* rewrite the snapshot and truncate the journal after this many records */
+#define GC_JOURNAL_COMPACT_RECORDS 1024
+#define GC_DEFAULT_PARALLELISM 4
+#define GC_MAX_PARALLELISM 32
+#define GC_RETRY_INTERVAL (100 * Time_Milli)
+
+typedef struct {
+    container_garbage_config_gc_containers_element *cont;
+    /* newer record of the same container added while cont is being processed */
+    container_garbage_config_gc_containers_element *next_cont;
+    /* the container is being processed by a gc worker */
+    bool in_progress;
+    /* monotonic time before which the container should not be retried */
+    int64_t retry_at;
+} gc_container_item;
+
+static containers_gc_t g_gc_containers = { .journal_fd = -1 };
+
+static thread_pool_t *g_gc_workers = NULL;
+
+static size_t g_gc_parallelism = GC_DEFAULT_PARALLELISM;
 
 /* gc containers lock */
 static void gc_containers_lock()
@@ -45,46 +70,115 @@ static void gc_containers_unlock()
     }
 }
 
-#define GCCONFIGJSON "garbage.json"
-/* save gc config */
-static int save_gc_config(const char *json_gc_config)
+static int64_t gc_monotonic_nanos(void)
+{
+    struct timespec ts = { 0 };
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        return 0;
+    }
+
+    return (int64_t)ts.tv_sec * Time_Second + ts.tv_nsec;
+}
+
+static void free_gc_container_item(gc_container_item *item)
+{
+    if (item == NULL) {
+        return;
+    }
+    free_container_garbage_config_gc_containers_element(item->cont);
+    free_container_garbage_config_gc_containers_element(item->next_cont);
+    free(item);
+}
+
+static struct linked_list *new_gc_container_node(container_garbage_config_gc_containers_element *cont)
+{
+    struct linked_list *node = NULL;
+    gc_container_item *item = NULL;
+
+    node = util_common_calloc_s(sizeof(struct linked_list));
+    if (node == NULL) {
+        return NULL;
+    }
+    item = util_common_calloc_s(sizeof(gc_container_item));
+    if (item == NULL) {
+        free(node);
+        return NULL;
+    }
+    item->cont = cont;
+    linked_list_add_elem(node, item);
+
+    return node;
+}
+
+/* notes: this funciton must be called with gc_containers_lock */
+static struct linked_list *gc_find_container_node(const char *id)
+{
+    struct linked_list *it = NULL;
+    struct linked_list *next = NULL;
+    gc_container_item *item = NULL;
+
+    linked_list_for_each_safe(it, &g_gc_containers.containers_list, next) {
+        item = (gc_container_item *)it->elem;
+        if (strcmp(id, item->cont->id) == 0) {
+            return it;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * list has one item for each container, a newer record replaces the old one. If the
+ * old one is being processed, the newer one is kept until the gc job is done.
+ * notes: this funciton must be called with gc_containers_lock
+ */
+static void gc_update_container_item(gc_container_item *item, container_garbage_config_gc_containers_element *cont)
+{
+    if (item->in_progress) {
+        free_container_garbage_config_gc_containers_element(item->next_cont);
+        item->next_cont = cont;
+        return;
+    }
+
+    free_container_garbage_config_gc_containers_element(item->cont);
+    item->cont = cont;
+    item->retry_at = 0;
+}
+
+static int gc_file_path(const char *name, char *path, size_t len)
 {
     int ret = 0;
     int nret;
-    char filename[PATH_MAX] = { 0 };
     char *rootpath = NULL;
-    int fd = -1;
 
     rootpath = conf_get_isulad_rootdir();
     if (rootpath == NULL) {
         ERROR("Root path is NULL");
-        ret = -1;
-        goto out;
+        return -1;
     }
 
-    nret = snprintf(filename, sizeof(filename), "%s/%s", rootpath, GCCONFIGJSON);
-    if (nret < 0 || (size_t)nret >= sizeof(filename)) {
+    nret = snprintf(path, len, "%s/%s", rootpath, name);
+    if (nret < 0 || (size_t)nret >= len) {
         ERROR("Failed to print string");
         ret = -1;
-        goto out;
     }
 
-    fd = util_open(filename, O_CREAT | O_TRUNC | O_CLOEXEC | O_WRONLY, CONFIG_FILE_MODE);
-    if (fd == -1) {
-        ERROR("Create file %s failed: %s", filename, strerror(errno));
-        ret = -1;
-        goto out;
-    }
+    free(rootpath);
+    return ret;
+}
 
-    if (write(fd, json_gc_config, strlen(json_gc_config)) == -1) {
-        ERROR("write %s failed: %s", filename, strerror(errno));
-        ret = -1;
+/* save gc config */
+static int save_gc_config(const char *json_gc_config)
+{
+    char filename[PATH_MAX] = { 0 };
+
+    if (gc_file_path(GCCONFIGJSON, filename, sizeof(filename)) != 0) {
+        return -1;
     }
-    close(fd);
 
-out:
-    free(rootpath);
-    return ret;
+    /* journal is truncated after the snapshot is saved, so snapshot must be on disk first */
+    return util_atomic_write_file(filename, json_gc_config, strlen(json_gc_config), CONFIG_FILE_MODE, true);
 }
 
 /* gc save containers config */
@@ -142,7 +236,8 @@ static int gc_containers_to_disk()
             return -1;
         }
         linked_list_for_each_safe(it, &g_gc_containers.containers_list, next) {
-            conts[i] = (container_garbage_config_gc_containers_element *)it->elem;
+            gc_container_item *item = (gc_container_item *)it->elem;
+            conts[i] = item->next_cont != NULL ? item->next_cont : item->cont;
             i++;
         }
     }
@@ -152,29 +247,136 @@ static int gc_containers_to_disk()
 
 
     ret = gc_save_containers_config(&saves);
+    if (ret == 0 && g_gc_containers.journal_fd >= 0) {
+        /* all records are in snapshot now */
+        if (ftruncate(g_gc_containers.journal_fd, 0) != 0) {
+            ERROR("Failed to truncate gc journal: %s", strerror(errno));
+        }
+        g_gc_containers.journal_records = 0;
+    }
 
     free(conts);
 
     return ret;
 }
 
+static char *gc_journal_add_record(const container_garbage_config_gc_containers_element *cont)
+{
+    int nret;
+    size_t len;
+    char *json = NULL;
+    char *record = NULL;
+    parser_error err = NULL;
+    struct parser_context ctx = { OPT_GEN_SIMPLIFY, 0 };
+    container_garbage_config_gc_containers_element *conts[1] = { NULL };
+    container_garbage_config saves = { 0 };
+
+    conts[0] = (container_garbage_config_gc_containers_element *)cont;
+    saves.gc_containers = conts;
+    saves.gc_containers_len = 1;
+
+    json = container_garbage_config_generate_json(&saves, &ctx, &err);
+    if (json == NULL) {
+        ERROR("Failed to generate gc journal record:%s", err ? err : " ");
+        goto out;
+    }
+
+    len = strlen(json) + 4;
+    record = util_common_calloc_s(len);
+    if (record == NULL) {
+        ERROR("Out of memory");
+        goto out;
+    }
+    nret = snprintf(record, len, "%c %s\n", GC_JOURNAL_ADD, json);
+    if (nret < 0 || (size_t)nret >= len) {
+        ERROR("Failed to print gc journal record");
+        free(record);
+        record = NULL;
+    }
+
+out:
+    free(json);
+    free(err);
+    return record;
+}
+
+static char *gc_journal_del_record(const char *id)
+{
+    int nret;
+    size_t len;
+    char *record = NULL;
+
+    len = strlen(id) + 4;
+    record = util_common_calloc_s(len);
+    if (record == NULL) {
+        ERROR("Out of memory");
+        return NULL;
+    }
+    nret = snprintf(record, len, "%c %s\n", GC_JOURNAL_DEL, id);
+    if (nret < 0 || (size_t)nret >= len) {
+        ERROR("Failed to print gc journal record");
+        free(record);
+        return NULL;
+    }
+
+    return record;
+}
+
+/*
+ * persist one change of the gc list, the change must already be applied to the list.
+ * notes: this funciton must be called with gc_containers_lock
+ */
+static int gc_journal_append(char op, const container_garbage_config_gc_containers_element *cont)
+{
+    ssize_t len = 0;
+    char *record = NULL;
+
+    if (g_gc_containers.journal_fd < 0 || g_gc_containers.journal_records >= GC_JOURNAL_COMPACT_RECORDS) {
+        return gc_containers_to_disk();
+    }
+
+    record = (op == GC_JOURNAL_ADD) ? gc_journal_add_record(cont) : gc_journal_del_record(cont->id);
+    if (record == NULL) {
+        return gc_containers_to_disk();
+    }
+
+    len = util_write_nointr(g_gc_containers.journal_fd, record, strlen(record));
+    if (len < 0 || (size_t)len != strlen(record)) {
+        ERROR("Failed to write gc journal: %s, save full gc list instead", strerror(errno));
+        free(record);
+        return gc_containers_to_disk();
+    }
+    g_gc_containers.journal_records++;
+
+    free(record);
+    return 0;
+}
+
+static int gc_journal_open()
+{
+    char filename[PATH_MAX] = { 0 };
+
+    if (gc_file_path(GCJOURNAL, filename, sizeof(filename)) != 0) {
+        return -1;
+    }
+
+    g_gc_containers.journal_fd = util_open(filename, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, CONFIG_FILE_MODE);
+    if (g_gc_containers.journal_fd < 0) {
+        ERROR("Failed to open gc journal %s: %s", filename, strerror(errno));
+        return -1;
+    }
+
+    return 0;
+}
+
 /* gc is gc progress */
 bool gc_is_gc_progress(const char *id)
 {
     bool ret = false;
-    struct linked_list *it = NULL;
-    struct linked_list *next = NULL;
-    container_garbage_config_gc_containers_element *cont = NULL;
 
     gc_containers_lock();
 
-    linked_list_for_each_safe(it, &g_gc_containers.containers_list, next) {
-        cont = (container_garbage_config_gc_containers_element *)it->elem;
-        if (strcmp(id, cont->id) == 0) {
-            ret = true;
-            break;
-        }
-    }
+    ret = gc_find_container_node(id) != NULL;
 
     gc_containers_unlock();
 
@@ -184,6 +386,7 @@ bool gc_is_gc_progress(const char *id)
 /* gc add container */
 int gc_add_container(const char *id, const char *runtime, const container_pid_t *pid_info)
 {
+    struct linked_list *node = NULL;
     struct linked_list *newnode = NULL;
     container_garbage_config_gc_containers_element *gc_cont = NULL;
 
@@ -192,16 +395,9 @@ int gc_add_container(const char *id, const char *runtime, const container_pid_t
         return -1;
     }
 
-    newnode = util_common_calloc_s(sizeof(struct linked_list));
-    if (newnode == NULL) {
-        CRIT("Memory allocation error.");
-        return -1;
-    }
-
     gc_cont = util_common_calloc_s(sizeof(container_garbage_config_gc_containers_element));
     if (gc_cont == NULL) {
         CRIT("Memory allocation error.");
-        free(newnode);
         return -1;
     }
 
@@ -212,11 +408,27 @@ int gc_add_container(const char *id, const char *runtime, const container_pid_t
     gc_cont->ppid = pid_info->ppid;
     gc_cont->p_start_time = pid_info->pstart_time;
 
+    newnode = new_gc_container_node(gc_cont);
+    if (newnode == NULL) {
+        CRIT("Memory allocation error.");
+        free_container_garbage_config_gc_containers_element(gc_cont);
+        return -1;
+    }
+
     gc_containers_lock();
 
-    linked_list_add_elem(newnode, gc_cont);
-    linked_list_add_tail(&g_gc_containers.containers_list, newnode);
-    (void)gc_containers_to_disk();
+    node = gc_find_container_node(id);
+    if (node != NULL) {
+        gc_update_container_item((gc_container_item *)node->elem, gc_cont);
+        ((gc_container_item *)newnode->elem)->cont = NULL;
+        free_gc_container_item((gc_container_item *)newnode->elem);
+        free(newnode);
+    } else {
+        linked_list_add_tail(&g_gc_containers.containers_list, newnode);
+    }
+    /* replay keeps the last record of each container */
+    (void)gc_journal_append(GC_JOURNAL_ADD, gc_cont);
+    (void)pthread_cond_signal(&g_gc_containers.cond);
 
     gc_containers_unlock();
 
@@ -226,21 +438,11 @@ int gc_add_container(const char *id, const char *runtime, const container_pid_t
 /* read gc config */
 container_garbage_config *read_gc_config()
 {
-    int nret;
     char filename[PATH_MAX] = { 0x00 };
     parser_error err = NULL;
     container_garbage_config *gcconfig = NULL;
-    char *rootpath = NULL;
-
-    rootpath = conf_get_isulad_rootdir();
-    if (rootpath == NULL) {
-        ERROR("Root path is NULL");
-        goto out;
-    }
 
-    nret = snprintf(filename, sizeof(filename), "%s/%s", rootpath, GCCONFIGJSON);
-    if (nret < 0 || (size_t)nret >= sizeof(filename)) {
-        ERROR("Failed to print string");
+    if (gc_file_path(GCCONFIGJSON, filename, sizeof(filename)) != 0) {
         goto out;
     }
 
@@ -251,40 +453,161 @@ container_garbage_config *read_gc_config()
     }
 out:
     free(err);
-    free(rootpath);
     return gcconfig;
 }
 
+/* notes: this funciton must be called with gc_containers_lock */
+static int gc_restore_add(container_garbage_config_gc_containers_element *cont)
+{
+    struct linked_list *node = NULL;
+    struct linked_list *newnode = NULL;
+
+    /* records in journal are newer than the snapshot and earlier records */
+    node = gc_find_container_node(cont->id);
+    if (node != NULL) {
+        gc_update_container_item((gc_container_item *)node->elem, cont);
+        return 0;
+    }
+
+    newnode = new_gc_container_node(cont);
+    if (newnode == NULL) {
+        free_container_garbage_config_gc_containers_element(cont);
+        return -1;
+    }
+    linked_list_add_tail(&g_gc_containers.containers_list, newnode);
+
+    return 0;
+}
+
+/* notes: this funciton must be called with gc_containers_lock */
+static void gc_restore_del(const char *id)
+{
+    struct linked_list *node = NULL;
+
+    node = gc_find_container_node(id);
+    if (node == NULL) {
+        return;
+    }
+    linked_list_del(node);
+    free_gc_container_item((gc_container_item *)node->elem);
+    free(node);
+}
+
+/* notes: this funciton must be called with gc_containers_lock */
+static int gc_replay_journal_record(const char *record)
+{
+    int ret = 0;
+    size_t i;
+    parser_error err = NULL;
+    container_garbage_config *gcconfig = NULL;
+
+    if (strlen(record) < 3 || record[1] != ' ') {
+        WARN("Skip invalid gc journal record: %s", record);
+        return 0;
+    }
+
+    if (record[0] == GC_JOURNAL_DEL) {
+        gc_restore_del(record + 2);
+        return 0;
+    }
+    if (record[0] != GC_JOURNAL_ADD) {
+        WARN("Skip invalid gc journal record: %s", record);
+        return 0;
+    }
+
+    gcconfig = container_garbage_config_parse_data(record + 2, NULL, &err);
+    if (gcconfig == NULL) {
+        /* the last record may be partially written when daemon crashed */
+        WARN("Skip invalid gc journal record %s: %s", record, err);
+        goto out;
+    }
+
+    for (i = 0; i < gcconfig->gc_containers_len; i++) {
+        if (gc_restore_add(gcconfig->gc_containers[i]) != 0) {
+            CRIT("Memory allocation error, failed to replay gc journal.");
+            ret = -1;
+        }
+        gcconfig->gc_containers[i] = NULL;
+    }
+    gcconfig->gc_containers_len = 0;
+
+out:
+    free(err);
+    free_container_garbage_config(gcconfig);
+    return ret;
+}
+
+/* notes: this funciton must be called with gc_containers_lock */
+static int gc_replay_journal()
+{
+    int ret = 0;
+    char filename[PATH_MAX] = { 0 };
+    char *content = NULL;
+    char *record = NULL;
+    char *saveptr = NULL;
+
+    if (gc_file_path(GCJOURNAL, filename, sizeof(filename)) != 0) {
+        return -1;
+    }
+
+    if (!util_file_exists(filename)) {
+        return 0;
+    }
+
+    content = util_read_text_file(filename);
+    if (content == NULL) {
+        ERROR("Failed to read gc journal %s", filename);
+        return -1;
+    }
+
+    for (record = strtok_r(content, "\n", &saveptr); record != NULL; record = strtok_r(NULL, "\n", &saveptr)) {
+        if (gc_replay_journal_record(record) != 0) {
+            ret = -1;
+            break;
+        }
+    }
+
+    free(content);
+    return ret;
+}
+
 /* gc restore */
 int gc_restore()
 {
     int ret = 0;
     size_t i = 0;
     container_garbage_config *gcconfig = NULL;
-    struct linked_list *newnode = NULL;
 
     gcconfig = read_gc_config();
-    if (gcconfig == NULL) {
-        goto out;
-    }
 
     gc_containers_lock();
 
-    for (i = 0; i < gcconfig->gc_containers_len; i++) {
-        newnode = util_common_calloc_s(sizeof(struct linked_list));
-        if (newnode == NULL) {
+    for (i = 0; gcconfig != NULL && i < gcconfig->gc_containers_len; i++) {
+        if (gc_restore_add(gcconfig->gc_containers[i]) != 0) {
+            gcconfig->gc_containers[i] = NULL;
             gc_containers_unlock();
             CRIT("Memory allocation error, failed to restore garbage collector.");
             ret = -1;
             goto out;
         }
-
-        linked_list_add_elem(newnode, gcconfig->gc_containers[i]);
-        linked_list_add_tail(&g_gc_containers.containers_list, newnode);
         gcconfig->gc_containers[i] = NULL;
     }
-    gcconfig->gc_containers_len = 0;
+    if (gcconfig != NULL) {
+        gcconfig->gc_containers_len = 0;
+    }
 
+    if (gc_replay_journal() != 0) {
+        gc_containers_unlock();
+        ERROR("Failed to replay gc journal");
+        ret = -1;
+        goto out;
+    }
+
+    if (gc_journal_open() != 0) {
+        WARN("Failed to open gc journal, gc list will be saved in full for every change");
+    }
+
+    /* compact snapshot and journal */
     (void)gc_containers_to_disk();
     gc_containers_unlock();
 
@@ -349,11 +672,11 @@ static void apply_restart_policy_after_gc(const char *id)
     free(started_at);
 
     if (should_restart) {
-        cont->common_config->restart_count++;
+        container_inc_restart_count(cont);
         state_set_restarting(cont->state, (int)exit_code);
         INFO("Try to restart container %s after %.2fs", id, (double)timeout / Time_Second);
         (void)container_restart_in_thread(id, timeout, (int)exit_code);
-        if (container_to_disk(cont)) {
+        if (container_state_to_disk(cont)) {
             ERROR("Failed to save container \"%s\" to disk", id);
             goto unlock_out;
         }
@@ -378,15 +701,39 @@ static void gc_monitor_process(const char *id, pid_t pid, unsigned long long sta
     }
 }
 
+/*
+ * switch to the newer record added while the job was running, which is processed
+ * by a later job.
+ * notes: this funciton must be called with gc_containers_lock
+ */
+static void gc_job_done(gc_container_item *item)
+{
+    item->in_progress = false;
+    if (item->next_cont != NULL) {
+        free_container_garbage_config_gc_containers_element(item->cont);
+        item->cont = item->next_cont;
+        item->next_cont = NULL;
+        item->retry_at = 0;
+    }
+    if (g_gc_containers.running > 0) {
+        g_gc_containers.running--;
+    }
+    (void)pthread_cond_signal(&g_gc_containers.cond);
+}
+
 static void add_to_list_tail_to_retry_gc(struct linked_list *it)
 {
+    gc_container_item *item = (gc_container_item *)it->elem;
+
     gc_containers_lock();
     linked_list_del(it);
     linked_list_add_tail(&g_gc_containers.containers_list, it);
+    item->retry_at = gc_monotonic_nanos() + GC_RETRY_INTERVAL;
+    gc_job_done(item);
     gc_containers_unlock();
 }
 
-static int do_runtime_resume_container(const container_t *cont)
+static int do_runtime_resume_container(container_t *cont)
 {
     int ret = 0;
     rt_resume_params_t params = { 0 };
@@ -402,7 +749,7 @@ static int do_runtime_resume_container(const container_t *cont)
 
     state_reset_paused(cont->state);
 
-    if (container_to_disk(cont)) {
+    if (container_state_to_disk_locking(cont)) {
         ERROR("Failed to save container \"%s\" to disk", id);
         ret = -1;
         goto out;
@@ -444,9 +791,11 @@ static void gc_container_process(struct linked_list *it)
     unsigned long long start_time = 0;
     char *runtime = NULL;
     char *id = NULL;
+    gc_container_item *item = NULL;
     container_garbage_config_gc_containers_element *gc_cont = NULL;
 
-    gc_cont = (container_garbage_config_gc_containers_element *)it->elem;
+    item = (gc_container_item *)it->elem;
+    gc_cont = item->cont;
     id = gc_cont->id;
     runtime = gc_cont->runtime;
     pid = gc_cont->pid;
@@ -463,8 +812,15 @@ static void gc_container_process(struct linked_list *it)
         /* remove container from gc list */
         gc_containers_lock();
 
+        if (item->next_cont != NULL) {
+            /* container exited again during gc, keep it for the newer record */
+            gc_job_done(item);
+            gc_containers_unlock();
+            return;
+        }
         linked_list_del(it);
-        (void)gc_containers_to_disk();
+        (void)gc_journal_append(GC_JOURNAL_DEL, gc_cont);
+        gc_job_done(item);
 
         gc_containers_unlock();
 
@@ -473,7 +829,7 @@ static void gc_container_process(struct linked_list *it)
 
         apply_auto_remove_after_gc(id);
 
-        free_container_garbage_config_gc_containers_element(gc_cont);
+        free_gc_container_item(item);
         free(it);
     } else {
         try_to_resume_container(id, runtime);
@@ -484,11 +840,14 @@ static void gc_container_process(struct linked_list *it)
         add_to_list_tail_to_retry_gc(it);
     }
 }
-static void do_gc_container(struct linked_list *it)
+
+/* run by gc workers, containers are processed in parallel */
+static void do_gc_container(void *arg)
 {
+    struct linked_list *it = (struct linked_list *)arg;
     container_garbage_config_gc_containers_element *gc_cont = NULL;
 
-    gc_cont = (container_garbage_config_gc_containers_element *)it->elem;
+    gc_cont = ((gc_container_item *)it->elem)->cont;
 
     gc_monitor_process(gc_cont->id, gc_cont->ppid, gc_cont->p_start_time);
 
@@ -497,10 +856,64 @@ static void do_gc_container(struct linked_list *it)
     return;
 }
 
+/*
+ * hand ready containers to gc workers, return the earliest time when a container
+ * waiting for retry becomes ready, or 0 if nothing is waiting.
+ * notes: this funciton must be called with gc_containers_lock
+ */
+static int64_t gc_dispatch_containers(int64_t now)
+{
+    int64_t next_retry = 0;
+    struct linked_list *it = NULL;
+    struct linked_list *next = NULL;
+    gc_container_item *item = NULL;
+
+    linked_list_for_each_safe(it, &g_gc_containers.containers_list, next) {
+        if (g_gc_containers.running >= g_gc_parallelism) {
+            /* a finished worker will wake us up */
+            return 0;
+        }
+        item = (gc_container_item *)it->elem;
+        if (item->in_progress) {
+            continue;
+        }
+        if (item->retry_at <= now) {
+            item->in_progress = true;
+            g_gc_containers.running++;
+            if (thread_pool_submit(g_gc_workers, do_gc_container, it) == 0) {
+                continue;
+            }
+            ERROR("Failed to submit gc job for container %s", item->cont->id);
+            item->in_progress = false;
+            g_gc_containers.running--;
+            item->retry_at = now + GC_RETRY_INTERVAL;
+        }
+        if (next_retry == 0 || item->retry_at < next_retry) {
+            next_retry = item->retry_at;
+        }
+    }
+
+    return next_retry;
+}
+
+static void gc_wait_until(int64_t deadline)
+{
+    struct timespec ts = { 0 };
+
+    if (deadline == 0) {
+        (void)pthread_cond_wait(&g_gc_containers.cond, &g_gc_containers.mutex);
+        return;
+    }
+
+    ts.tv_sec = (time_t)(deadline / Time_Second);
+    ts.tv_nsec = (long)(deadline % Time_Second);
+    (void)pthread_cond_timedwait(&g_gc_containers.cond, &g_gc_containers.mutex, &ts);
+}
+
 static void *gchandler(void *arg)
 {
     int ret = 0;
-    struct linked_list *it = NULL;
+    int64_t next_retry = 0;
 
     ret = pthread_detach(pthread_self());
     if (ret != 0) {
@@ -510,24 +923,49 @@ static void *gchandler(void *arg)
 
     prctl(PR_SET_NAME, "Garbage_collector");
 
+    gc_containers_lock();
     for (;;) {
-        gc_containers_lock();
+        next_retry = gc_dispatch_containers(gc_monotonic_nanos());
+        gc_wait_until(next_retry);
+    }
+    gc_containers_unlock();
 
-        if (linked_list_empty(&g_gc_containers.containers_list)) {
-            gc_containers_unlock();
-            goto wait_continue;
-        }
-        it = linked_list_first_node(&g_gc_containers.containers_list);
+error:
+    return NULL;
+}
 
-        gc_containers_unlock();
+static size_t gc_get_parallelism()
+{
+    int32_t parallelism = conf_get_gc_parallelism();
 
-        do_gc_container(it);
+    if (parallelism <= 0) {
+        return GC_DEFAULT_PARALLELISM;
+    }
+    if (parallelism > GC_MAX_PARALLELISM) {
+        WARN("Gc parallelism %d is too large, use %d instead", parallelism, GC_MAX_PARALLELISM);
+        return GC_MAX_PARALLELISM;
+    }
+
+    return (size_t)parallelism;
+}
+
+static int gc_cond_init()
+{
+    int ret = 0;
+    pthread_condattr_t attr;
 
-wait_continue:
-        usleep_nointerupt(100 * 1000); /* wait 100 millisecond to check next gc container */
+    ret = pthread_condattr_init(&attr);
+    if (ret != 0) {
+        return ret;
     }
-error:
-    return NULL;
+    /* retry deadlines are monotonic, not affected by system time changes */
+    ret = pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    if (ret == 0) {
+        ret = pthread_cond_init(&(g_gc_containers.cond), &attr);
+    }
+    (void)pthread_condattr_destroy(&attr);
+
+    return ret;
 }
 
 /* new gchandler */
@@ -543,11 +981,20 @@ int new_gchandler()
         goto out;
     }
 
+    ret = gc_cond_init();
+    if (ret != 0) {
+        CRIT("Condition initialization failed");
+        pthread_mutex_destroy(&(g_gc_containers.mutex));
+        goto out;
+    }
+
     INFO("Restoring garbage collector...");
 
     if (gc_restore()) {
         ERROR("Failed to restore garbage collector");
+        pthread_cond_destroy(&(g_gc_containers.cond));
         pthread_mutex_destroy(&(g_gc_containers.mutex));
+        ret = -1;
         goto out;
     }
 
@@ -562,11 +1009,21 @@ int start_gchandler()
     int ret = -1;
     pthread_t a_thread;
 
-    INFO("Starting garbage collector...");
+    g_gc_parallelism = gc_get_parallelism();
+
+    INFO("Starting garbage collector with %zu workers...", g_gc_parallelism);
+
+    g_gc_workers = thread_pool_new("GcWorker", g_gc_parallelism);
+    if (g_gc_workers == NULL) {
+        CRIT("Failed to create garbage collector workers");
+        goto out;
+    }
 
     ret = pthread_create(&a_thread, NULL, gchandler, NULL);
     if (ret != 0) {
         CRIT("Thread creation failed");
+        thread_pool_free(g_gc_workers);
+        g_gc_workers = NULL;
         goto out;
     }
 
@@ -574,4 +1031,3 @@ int start_gchandler()
 out:
     return ret;
 }
-
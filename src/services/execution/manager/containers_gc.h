@@ -27,7 +27,14 @@ extern "C" {
 
 typedef struct _containers_gc_t_ {
     pthread_mutex_t mutex;
+    /* signaled when a container is added to gc list or a gc job finished */
+    pthread_cond_t cond;
     struct linked_list containers_list;
+    /* number of containers being processed by gc workers */
+    size_t running;
+    /* append-only journal of gc list changes since last snapshot */
+    int journal_fd;
+    size_t journal_records;
 } containers_gc_t;
 
 int new_gchandler();
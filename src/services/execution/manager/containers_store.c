@@ -14,42 +14,104 @@
  ******************************************************************************/
 #include <stdlib.h>
 #include <pthread.h>
+#include <stdio.h>
+#include <string.h>
 
 #include "containers_store.h"
 #include "log.h"
 #include "utils.h"
+#include "radix_tree.h"
+#include "hash_map.h"
 
-typedef struct memory_store_t {
+#define MEMORY_STORE_SHARDS 16
+
+/*
+ * containers are sharded by the first hex digit of their id, so lookup of
+ * a full id or an id prefix only locks one shard, and walking shards in
+ * order still returns containers sorted by id.
+ */
+typedef struct memory_store_shard_t {
     map_t *map;  // map string container_t
+    radix_tree_t *ids; // prefix index of ids in map
     pthread_rwlock_t rwlock;
+} memory_store_shard;
+
+typedef struct memory_store_t {
+    memory_store_shard shards[MEMORY_STORE_SHARDS];
 } memory_store;
 
 typedef struct name_index_t {
-    map_t *map;
+    hash_map_t *map; // names are only looked up exactly, no need to keep them ordered
     pthread_rwlock_t rwlock;
 } name_index;
 
+/*
+ * newest list view of every container in store, listing takes one read lock
+ * and references the views, instead of locking every container.
+ */
+typedef struct list_view_index_t {
+    map_t *map; // map id container_list_view_t, ordered by id
+    hash_map_t *labels; // map "key=value" to ordered set of ids which have the label
+    pthread_rwlock_t rwlock;
+} list_view_index;
+
 static memory_store *g_containers_store = NULL;
 
 static name_index *g_indexs = NULL;
 
+static list_view_index *g_list_views = NULL;
+
+static void list_view_index_put(container_list_view_t *view, const container_list_view_t *base, bool only_update);
+static void list_view_index_remove(const char *id);
+
 /* memory store map kvfree */
 static void memory_store_map_kvfree(void *key, void *value)
 {
     free(key);
 
+    if (value != NULL) {
+        container_state_stop_counting(((container_t *)value)->state);
+    }
     container_unref((container_t *)value);
 }
 
+static size_t memory_store_shard_index(const char *id)
+{
+    char c = id[0];
+
+    if (c >= '0' && c <= '9') {
+        return (size_t)(c - '0');
+    }
+    if (c >= 'a' && c <= 'f') {
+        return (size_t)(c - 'a' + 10);
+    }
+    if (c >= 'A' && c <= 'F') {
+        return (size_t)(c - 'A' + 10);
+    }
+
+    return (size_t)(unsigned char)c % MEMORY_STORE_SHARDS;
+}
+
+static memory_store_shard *memory_store_get_shard(const char *id)
+{
+    return &g_containers_store->shards[memory_store_shard_index(id)];
+}
+
 /* memory store free */
 static void memory_store_free(memory_store *store)
 {
+    size_t i;
+
     if (store == NULL) {
         return;
     }
-    map_free(store->map);
-    store->map = NULL;
-    pthread_rwlock_destroy(&(store->rwlock));
+    for (i = 0; i < MEMORY_STORE_SHARDS; i++) {
+        radix_tree_free(store->shards[i].ids);
+        store->shards[i].ids = NULL;
+        map_free(store->shards[i].map);
+        store->shards[i].map = NULL;
+        pthread_rwlock_destroy(&(store->shards[i].rwlock));
+    }
     free(store);
 }
 
@@ -57,6 +119,7 @@ static void memory_store_free(memory_store *store)
 static memory_store *memory_store_new(void)
 {
     int ret;
+    size_t i;
     memory_store *store = NULL;
 
     store = util_common_calloc_s(sizeof(memory_store));
@@ -64,16 +127,22 @@ static memory_store *memory_store_new(void)
         ERROR("Out of memory");
         return NULL;
     }
-    ret = pthread_rwlock_init(&(store->rwlock), NULL);
-    if (ret != 0) {
-        ERROR("Failed to init memory store rwlock");
-        free(store);
-        return NULL;
-    }
-    store->map = map_new(MAP_STR_PTR, MAP_DEFAULT_CMP_FUNC, memory_store_map_kvfree);
-    if (store->map == NULL) {
-        ERROR("Out of memory");
-        goto error_out;
+    for (i = 0; i < MEMORY_STORE_SHARDS; i++) {
+        ret = pthread_rwlock_init(&(store->shards[i].rwlock), NULL);
+        if (ret != 0) {
+            ERROR("Failed to init memory store rwlock");
+            goto error_out;
+        }
+        store->shards[i].map = map_new(MAP_STR_PTR, MAP_DEFAULT_CMP_FUNC, memory_store_map_kvfree);
+        if (store->shards[i].map == NULL) {
+            ERROR("Out of memory");
+            goto error_out;
+        }
+        store->shards[i].ids = radix_tree_new();
+        if (store->shards[i].ids == NULL) {
+            ERROR("Out of memory");
+            goto error_out;
+        }
     }
     return store;
 error_out:
@@ -85,16 +154,57 @@ error_out:
 bool containers_store_add(const char *id, container_t *cont)
 {
     bool ret = false;
+    void *old = NULL;
+    memory_store_shard *shard = NULL;
+    container_list_view_t *view = NULL;
+
+    if (id == NULL || id[0] == '\0') {
+        return false;
+    }
+
+    /* nobody else can change container before it is added */
+    view = container_list_view_new(cont);
+    if (view == NULL) {
+        ERROR("Failed to build list view of %s", id);
+    }
 
-    if (pthread_rwlock_wrlock(&g_containers_store->rwlock)) {
+    shard = memory_store_get_shard(id);
+    if (pthread_rwlock_wrlock(&shard->rwlock)) {
         ERROR("lock memory store failed");
+        container_list_view_unref(view);
         return false;
     }
-    ret = map_replace(g_containers_store->map, (void *)id, (void *)cont);
-    if (pthread_rwlock_unlock(&g_containers_store->rwlock)) {
+    old = radix_tree_search(shard->ids, id);
+    if (old != NULL) {
+        (void)radix_tree_remove(shard->ids, id);
+    }
+    if (!radix_tree_insert(shard->ids, id, (void *)cont)) {
+        ERROR("Failed to add %s into id index", id);
+        goto restore_index;
+    }
+    ret = map_replace(shard->map, (void *)id, (void *)cont);
+    if (ret) {
+        container_state_start_counting(cont->state);
+        goto unlock;
+    }
+    (void)radix_tree_remove(shard->ids, id);
+
+restore_index:
+    if (old != NULL) {
+        (void)radix_tree_insert(shard->ids, id, old);
+    }
+
+unlock:
+    if (pthread_rwlock_unlock(&shard->rwlock)) {
         ERROR("unlock memory store failed");
+        container_list_view_unref(view);
         return false;
     }
+    if (ret && view != NULL) {
+        list_view_index_put(view, NULL, false);
+    } else {
+        container_list_view_unref(view);
+    }
     return ret;
 }
 
@@ -102,17 +212,19 @@ bool containers_store_add(const char *id, container_t *cont)
 static container_t *containers_store_get_by_id(const char *id)
 {
     container_t *cont = NULL;
+    memory_store_shard *shard = NULL;
 
-    if (id == NULL) {
+    if (id == NULL || id[0] == '\0') {
         return NULL;
     }
-    if (pthread_rwlock_rdlock(&g_containers_store->rwlock) != 0) {
+    shard = memory_store_get_shard(id);
+    if (pthread_rwlock_rdlock(&shard->rwlock) != 0) {
         ERROR("lock memory store failed");
         return cont;
     }
-    cont = map_search(g_containers_store->map, (void *)id);
+    cont = radix_tree_search(shard->ids, id);
     container_refinc(cont);
-    if (pthread_rwlock_unlock(&g_containers_store->rwlock) != 0) {
+    if (pthread_rwlock_unlock(&shard->rwlock) != 0) {
         ERROR("unlock memory store failed");
         return cont;
     }
@@ -141,55 +253,32 @@ static container_t *containers_store_get_by_name(const char *name)
 /* containers store get container by prefix */
 container_t *containers_store_get_by_prefix(const char *prefix)
 {
-    bool ret = false;
-    char *container_id = NULL;
+    void *value = NULL;
     container_t *cont = NULL;
-    map_itor *itor = NULL;
+    memory_store_shard *shard = NULL;
+    radix_prefix_result_t result;
 
-    if (prefix == NULL) {
+    if (prefix == NULL || prefix[0] == '\0') {
         return NULL;
     }
-    if (pthread_rwlock_rdlock(&g_containers_store->rwlock) != 0) {
+
+    shard = memory_store_get_shard(prefix);
+    if (pthread_rwlock_rdlock(&shard->rwlock) != 0) {
         ERROR("lock memory store failed");
         return NULL;
     }
 
-    itor = map_itor_new(g_containers_store->map);
-    if (itor == NULL) {
-        ERROR("Out of memory");
-        ret = false;
-        goto unlock;
-    }
-
-    for (; map_itor_valid(itor); map_itor_next(itor)) {
-        container_id = map_itor_key(itor);
-        if (container_id == NULL) {
-            ERROR("Out of memory");
-            ret = false;
-            goto unlock;
-        }
-        if (strncmp(container_id, prefix, strlen(prefix)) == 0) {
-            if (cont != NULL) {
-                ERROR("Multiple IDs found with provided prefix: %s", prefix);
-                ret = false;
-                goto unlock;
-            } else {
-                cont = map_itor_value(itor);
-            }
-        }
+    result = radix_tree_search_prefix(shard->ids, prefix, &value);
+    if (result == RADIX_PREFIX_AMBIGUOUS) {
+        ERROR("Multiple IDs found with provided prefix: %s", prefix);
+    } else if (result == RADIX_PREFIX_UNIQUE) {
+        cont = (container_t *)value;
+        container_refinc(cont);
     }
 
-    ret = true;
-    container_refinc(cont);
-
-unlock:
-    if (pthread_rwlock_unlock(&g_containers_store->rwlock) != 0) {
+    if (pthread_rwlock_unlock(&shard->rwlock) != 0) {
         ERROR("unlock memory store failed");
     }
-    map_itor_free(itor);
-    if (!ret) {
-        cont = NULL;
-    }
     return cont;
 }
 
@@ -230,20 +319,64 @@ container_t *containers_store_get(const char *id_or_name)
     return NULL;
 }
 
+static int memory_store_rdlock_all(void)
+{
+    size_t i;
+
+    for (i = 0; i < MEMORY_STORE_SHARDS; i++) {
+        if (pthread_rwlock_rdlock(&g_containers_store->shards[i].rwlock) != 0) {
+            ERROR("lock memory store failed");
+            goto unlock;
+        }
+    }
+    return 0;
+
+unlock:
+    while (i > 0) {
+        i--;
+        (void)pthread_rwlock_unlock(&g_containers_store->shards[i].rwlock);
+    }
+    return -1;
+}
+
+static void memory_store_unlock_all(void)
+{
+    size_t i;
+
+    for (i = 0; i < MEMORY_STORE_SHARDS; i++) {
+        if (pthread_rwlock_unlock(&g_containers_store->shards[i].rwlock)) {
+            ERROR("unlock memory store failed");
+        }
+    }
+}
+
+static size_t memory_store_size(void)
+{
+    size_t i;
+    size_t size = 0;
+
+    for (i = 0; i < MEMORY_STORE_SHARDS; i++) {
+        size += map_size(g_containers_store->shards[i].map);
+    }
+
+    return size;
+}
+
 /* containers store list */
 int containers_store_list(container_t ***out, size_t *size)
 {
     int ret = -1;
-    size_t i;
+    size_t i = 0;
+    size_t j;
     container_t **conts = NULL;
     map_itor *itor = NULL;
 
-    if (pthread_rwlock_rdlock(&g_containers_store->rwlock) != 0) {
-        ERROR("lock memory store failed");
+    /* take all shards so the result is a consistent snapshot */
+    if (memory_store_rdlock_all() != 0) {
         return -1;
     }
 
-    *size = map_size(g_containers_store->map);
+    *size = memory_store_size();
     if (*size == 0) {
         ret = 0;
         goto unlock;
@@ -258,24 +391,27 @@ int containers_store_list(container_t ***out, size_t *size)
         goto unlock;
     }
 
-    itor = map_itor_new(g_containers_store->map);
-    if (itor == NULL) {
-        ERROR("Out of memory");
-        goto unlock;
-    }
+    for (j = 0; j < MEMORY_STORE_SHARDS; j++) {
+        itor = map_itor_new(g_containers_store->shards[j].map);
+        if (itor == NULL) {
+            ERROR("Out of memory");
+            goto unlock;
+        }
 
-    for (i = 0; map_itor_valid(itor) &&
-         i < *size; map_itor_next(itor), i++) {
-        conts[i] = map_itor_value(itor);
-        container_refinc(conts[i]);
+        for (; map_itor_valid(itor) && i < *size; map_itor_next(itor), i++) {
+            conts[i] = map_itor_value(itor);
+            container_refinc(conts[i]);
+        }
+        map_itor_free(itor);
+        itor = NULL;
     }
     ret = 0;
 unlock:
-    if (pthread_rwlock_unlock(&g_containers_store->rwlock)) {
-        ERROR("unlock memory store failed");
-    }
-    map_itor_free(itor);
+    memory_store_unlock_all();
     if (ret != 0) {
+        for (j = 0; j < i; j++) {
+            container_unref(conts[j]);
+        }
         free(conts);
         *size = 0;
         conts = NULL;
@@ -288,37 +424,39 @@ unlock:
 char **containers_store_list_ids(void)
 {
     bool ret = false;
+    size_t i;
     char **idsarray = NULL;
     map_itor *itor = NULL;
 
-    if (pthread_rwlock_rdlock(&g_containers_store->rwlock) != 0) {
-        ERROR("lock memory store failed");
+    if (memory_store_rdlock_all() != 0) {
         return NULL;
     }
 
-    if (map_size(g_containers_store->map) == 0) {
+    if (memory_store_size() == 0) {
         ret = true;
         goto unlock;
     }
 
-    itor = map_itor_new(g_containers_store->map);
-    if (itor == NULL) {
-        ERROR("Out of memory");
-        goto unlock;
-    }
-
-    for (; map_itor_valid(itor); map_itor_next(itor)) {
-        char *id = map_itor_key(itor);
-        if (util_array_append(&idsarray, id ? id : "-")) {
+    for (i = 0; i < MEMORY_STORE_SHARDS; i++) {
+        itor = map_itor_new(g_containers_store->shards[i].map);
+        if (itor == NULL) {
             ERROR("Out of memory");
             goto unlock;
         }
+
+        for (; map_itor_valid(itor); map_itor_next(itor)) {
+            char *id = map_itor_key(itor);
+            if (util_array_append(&idsarray, id ? id : "-")) {
+                ERROR("Out of memory");
+                goto unlock;
+            }
+        }
+        map_itor_free(itor);
+        itor = NULL;
     }
     ret = true;
 unlock:
-    if (pthread_rwlock_unlock(&g_containers_store->rwlock)) {
-        ERROR("unlock memory store failed");
-    }
+    memory_store_unlock_all();
     map_itor_free(itor);
     if (!ret) {
         util_free_array(idsarray);
@@ -331,19 +469,458 @@ unlock:
 bool containers_store_remove(const char *id)
 {
     bool ret = false;
+    memory_store_shard *shard = NULL;
+
+    if (id == NULL || id[0] == '\0') {
+        return false;
+    }
+
+    /* id may belong to the container, drop view first which does not free container */
+    list_view_index_remove(id);
 
-    if (pthread_rwlock_wrlock(&g_containers_store->rwlock) != 0) {
+    shard = memory_store_get_shard(id);
+    if (pthread_rwlock_wrlock(&shard->rwlock) != 0) {
         ERROR("lock memory store failed");
         return false;
     }
-    ret = map_remove(g_containers_store->map, (void *)id);
-    if (pthread_rwlock_unlock(&g_containers_store->rwlock) != 0) {
+    (void)radix_tree_remove(shard->ids, id);
+    ret = map_remove(shard->map, (void *)id);
+    if (pthread_rwlock_unlock(&shard->rwlock) != 0) {
         ERROR("unlock memory store failed");
         return false;
     }
     return ret;
 }
 
+/* list view index map kvfree */
+static void list_view_index_map_kvfree(void *key, void *value)
+{
+    free(key);
+    container_list_view_unref((container_list_view_t *)value);
+}
+
+/* label index map kvfree */
+static void label_index_map_kvfree(void *key, void *value)
+{
+    free(key);
+    map_free((map_t *)value);
+}
+
+static void list_view_index_free(list_view_index *views)
+{
+    if (views == NULL) {
+        return;
+    }
+    hash_map_free(views->labels);
+    views->labels = NULL;
+    map_free(views->map);
+    views->map = NULL;
+    pthread_rwlock_destroy(&(views->rwlock));
+    free(views);
+}
+
+static list_view_index *list_view_index_new(void)
+{
+    list_view_index *views = NULL;
+
+    views = util_common_calloc_s(sizeof(list_view_index));
+    if (views == NULL) {
+        ERROR("Out of memory");
+        return NULL;
+    }
+    if (pthread_rwlock_init(&(views->rwlock), NULL) != 0) {
+        ERROR("Failed to init list views rwlock");
+        free(views);
+        return NULL;
+    }
+    views->map = map_new(MAP_STR_PTR, MAP_DEFAULT_CMP_FUNC, list_view_index_map_kvfree);
+    if (views->map == NULL) {
+        ERROR("Out of memory");
+        list_view_index_free(views);
+        return NULL;
+    }
+    views->labels = hash_map_new(MAP_STR_PTR, label_index_map_kvfree);
+    if (views->labels == NULL) {
+        ERROR("Out of memory");
+        list_view_index_free(views);
+        return NULL;
+    }
+    return views;
+}
+
+static char *label_index_key(const char *key, const char *value)
+{
+    int nret;
+    char *label = NULL;
+    size_t len;
+
+    if (key == NULL) {
+        return NULL;
+    }
+    value = (value != NULL) ? value : "";
+
+    len = strlen(key) + strlen(value) + 2;
+    label = util_common_calloc_s(len);
+    if (label == NULL) {
+        ERROR("Out of memory");
+        return NULL;
+    }
+    nret = snprintf(label, len, "%s=%s", key, value);
+    if (nret < 0 || (size_t)nret >= len) {
+        ERROR("Failed to print string");
+        free(label);
+        return NULL;
+    }
+
+    return label;
+}
+
+/* called with list views write locked */
+static void label_index_add(const container_list_view_t *view)
+{
+    size_t i;
+    bool value = true;
+    char *label = NULL;
+    map_t *ids = NULL;
+
+    for (i = 0; view->labels != NULL && i < view->labels->len; i++) {
+        label = label_index_key(view->labels->keys[i], view->labels->values[i]);
+        if (label == NULL) {
+            continue;
+        }
+        ids = hash_map_search(g_list_views->labels, (void *)label);
+        if (ids == NULL) {
+            ids = map_new(MAP_STR_BOOL, MAP_DEFAULT_CMP_FUNC, MAP_DEFAULT_FREE_FUNC);
+            if (ids == NULL || !hash_map_insert(g_list_views->labels, (void *)label, (void *)ids)) {
+                ERROR("Failed to index label %s of %s", label, view->id);
+                map_free(ids);
+                free(label);
+                continue;
+            }
+        }
+        if (!map_replace(ids, (void *)view->id, (void *)&value)) {
+            ERROR("Failed to index label %s of %s", label, view->id);
+        }
+        free(label);
+    }
+}
+
+/* called with list views write locked */
+static void label_index_del(const container_list_view_t *view)
+{
+    size_t i;
+    char *label = NULL;
+    map_t *ids = NULL;
+
+    for (i = 0; view->labels != NULL && i < view->labels->len; i++) {
+        label = label_index_key(view->labels->keys[i], view->labels->values[i]);
+        if (label == NULL) {
+            continue;
+        }
+        ids = hash_map_search(g_list_views->labels, (void *)label);
+        if (ids != NULL) {
+            (void)map_remove(ids, (void *)view->id);
+            if (map_size(ids) == 0) {
+                (void)hash_map_remove(g_list_views->labels, (void *)label);
+            }
+        }
+        free(label);
+    }
+}
+
+static bool labels_equal(const json_map_string_string *a, const json_map_string_string *b)
+{
+    size_t i;
+    size_t alen = (a != NULL) ? a->len : 0;
+    size_t blen = (b != NULL) ? b->len : 0;
+
+    if (alen != blen) {
+        return false;
+    }
+
+    for (i = 0; i < alen; i++) {
+        if (strcmp(a->keys[i], b->keys[i]) != 0 || strcmp(a->values[i], b->values[i]) != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* labels of container are not expected to change, but keep the index right if they do */
+static void label_index_update(const container_list_view_t *old, const container_list_view_t *view)
+{
+    if (old == NULL) {
+        label_index_add(view);
+        return;
+    }
+
+    if (!labels_equal(old->labels, view->labels)) {
+        label_index_del(old);
+        label_index_add(view);
+    }
+}
+
+/*
+ * put view into index, and the index owns the reference of view. If only update,
+ * the view is dropped unless its container is still in index. A view refreshed
+ * from base is dropped unless base is still in index, so it never replaces a
+ * newer config published by the holder of container lock.
+ */
+static void list_view_index_put(container_list_view_t *view, const container_list_view_t *base, bool only_update)
+{
+    container_list_view_t *old = NULL;
+
+    if (pthread_rwlock_wrlock(&g_list_views->rwlock) != 0) {
+        ERROR("lock list views failed");
+        container_list_view_unref(view);
+        return;
+    }
+
+    old = map_search(g_list_views->map, (void *)view->id);
+    if ((only_update && old == NULL) || (base != NULL && old != base)) {
+        container_list_view_unref(view);
+        goto unlock;
+    }
+
+    label_index_update(old, view);
+    if (!map_replace(g_list_views->map, (void *)view->id, (void *)view)) {
+        ERROR("Failed to update list view of %s", view->id);
+        label_index_del(view);
+        if (old != NULL) {
+            label_index_add(old);
+        }
+        container_list_view_unref(view);
+    }
+
+unlock:
+    if (pthread_rwlock_unlock(&g_list_views->rwlock) != 0) {
+        ERROR("unlock list views failed");
+    }
+}
+
+static void list_view_index_remove(const char *id)
+{
+    container_list_view_t *old = NULL;
+
+    if (pthread_rwlock_wrlock(&g_list_views->rwlock) != 0) {
+        ERROR("lock list views failed");
+        return;
+    }
+    old = map_search(g_list_views->map, (void *)id);
+    if (old != NULL) {
+        label_index_del(old);
+    }
+    (void)map_remove(g_list_views->map, (void *)id);
+    if (pthread_rwlock_unlock(&g_list_views->rwlock) != 0) {
+        ERROR("unlock list views failed");
+    }
+}
+
+/* rebuild list view of container after its config or state changed, called with container locked */
+void containers_store_update_list_view(container_t *cont)
+{
+    container_list_view_t *view = NULL;
+
+    if (cont == NULL || cont->common_config == NULL || g_list_views == NULL) {
+        return;
+    }
+
+    view = container_list_view_new(cont);
+    if (view == NULL) {
+        ERROR("Failed to build list view of %s", cont->common_config->id);
+        return;
+    }
+    list_view_index_put(view, NULL, true);
+}
+
+/* rebuild state of list view of container, without container lock */
+void containers_store_refresh_list_view(const char *id)
+{
+    container_list_view_t *old = NULL;
+    container_list_view_t *fresh = NULL;
+
+    if (id == NULL || g_list_views == NULL) {
+        return;
+    }
+
+    if (pthread_rwlock_rdlock(&g_list_views->rwlock) != 0) {
+        ERROR("lock list views failed");
+        return;
+    }
+    old = map_search(g_list_views->map, (void *)id);
+    container_list_view_refinc(old);
+    if (pthread_rwlock_unlock(&g_list_views->rwlock) != 0) {
+        ERROR("unlock list views failed");
+    }
+
+    if (old == NULL) {
+        return;
+    }
+
+    fresh = container_list_view_refresh(old);
+    if (fresh != NULL) {
+        list_view_index_put(fresh, old, true);
+    }
+    container_list_view_unref(old);
+}
+
+/* views of state changes without publishing are rebuilt here, only takes state locks of those containers */
+static void refresh_stale_list_views(container_list_view_t **views, size_t size)
+{
+    size_t i;
+    container_list_view_t *fresh = NULL;
+
+    for (i = 0; i < size; i++) {
+        if (!container_list_view_is_stale(views[i])) {
+            continue;
+        }
+        fresh = container_list_view_refresh(views[i]);
+        if (fresh == NULL) {
+            continue;
+        }
+        container_list_view_refinc(fresh);
+        list_view_index_put(fresh, views[i], true);
+        container_list_view_unref(views[i]);
+        views[i] = fresh;
+    }
+}
+
+/*
+ * called with list views locked, references views of ids in order, or all
+ * views if ids is NULL.
+ */
+static int collect_list_views(const map_t *ids, container_list_view_t ***out, size_t *size)
+{
+    size_t i = 0;
+    size_t len;
+    container_list_view_t *view = NULL;
+    container_list_view_t **views = NULL;
+    map_itor *itor = NULL;
+
+    len = map_size(ids != NULL ? ids : g_list_views->map);
+    if (len == 0) {
+        return 0;
+    }
+    if (len > SIZE_MAX / sizeof(container_list_view_t *)) {
+        ERROR("List views is too long!");
+        return -1;
+    }
+    views = util_common_calloc_s(sizeof(container_list_view_t *) * len);
+    if (views == NULL) {
+        ERROR("Out of memory");
+        return -1;
+    }
+
+    itor = map_itor_new(ids != NULL ? ids : g_list_views->map);
+    if (itor == NULL) {
+        ERROR("Out of memory");
+        free(views);
+        return -1;
+    }
+    for (; map_itor_valid(itor) && i < len; map_itor_next(itor)) {
+        if (ids != NULL) {
+            view = map_search(g_list_views->map, map_itor_key(itor));
+        } else {
+            view = map_itor_value(itor);
+        }
+        if (view == NULL) {
+            continue;
+        }
+        container_list_view_refinc(view);
+        views[i++] = view;
+    }
+    map_itor_free(itor);
+
+    *out = views;
+    *size = i;
+    return 0;
+}
+
+/* containers store list views, ordered by id, caller unrefs every view and frees the array */
+int containers_store_list_views(container_list_view_t ***out, size_t *size)
+{
+    int ret = 0;
+
+    if (out == NULL || size == NULL) {
+        return -1;
+    }
+    *out = NULL;
+    *size = 0;
+
+    if (pthread_rwlock_rdlock(&g_list_views->rwlock) != 0) {
+        ERROR("lock list views failed");
+        return -1;
+    }
+    ret = collect_list_views(NULL, out, size);
+    if (pthread_rwlock_unlock(&g_list_views->rwlock) != 0) {
+        ERROR("unlock list views failed");
+    }
+
+    if (ret == 0) {
+        refresh_stale_list_views(*out, *size);
+    }
+    return ret;
+}
+
+/*
+ * containers store list views of containers which have all the labels, only
+ * containers of the rarest label are walked, callers still check other labels.
+ */
+int containers_store_list_views_by_labels(const char **keys, const char **values, size_t len,
+                                          container_list_view_t ***out, size_t *size)
+{
+    int ret = 0;
+    size_t i;
+    char *label = NULL;
+    map_t *ids = NULL;
+    map_t *rarest = NULL;
+
+    if (keys == NULL || values == NULL || len == 0) {
+        return containers_store_list_views(out, size);
+    }
+
+    if (out == NULL || size == NULL) {
+        return -1;
+    }
+    *out = NULL;
+    *size = 0;
+
+    if (pthread_rwlock_rdlock(&g_list_views->rwlock) != 0) {
+        ERROR("lock list views failed");
+        return -1;
+    }
+
+    for (i = 0; i < len; i++) {
+        label = label_index_key(keys[i], values[i]);
+        if (label == NULL) {
+            ret = -1;
+            goto unlock;
+        }
+        ids = hash_map_search(g_list_views->labels, (void *)label);
+        free(label);
+        if (ids == NULL) {
+            /* no container has this label */
+            goto unlock;
+        }
+        if (rarest == NULL || map_size(ids) < map_size(rarest)) {
+            rarest = ids;
+        }
+    }
+
+    ret = collect_list_views(rarest, out, size);
+
+unlock:
+    if (pthread_rwlock_unlock(&g_list_views->rwlock) != 0) {
+        ERROR("unlock list views failed");
+    }
+
+    if (ret == 0) {
+        refresh_stale_list_views(*out, *size);
+    }
+    return ret;
+}
+
 /* containers store init */
 int containers_store_init(void)
 {
@@ -351,6 +928,12 @@ int containers_store_init(void)
     if (g_containers_store == NULL) {
         return -1;
     }
+    g_list_views = list_view_index_new();
+    if (g_list_views == NULL) {
+        memory_store_free(g_containers_store);
+        g_containers_store = NULL;
+        return -1;
+    }
     return 0;
 }
 
@@ -360,7 +943,7 @@ static void name_index_free(name_index *indexs)
     if (indexs == NULL) {
         return;
     }
-    map_free(indexs->map);
+    hash_map_free(indexs->map);
     indexs->map = NULL;
     pthread_rwlock_destroy(&(indexs->rwlock));
     free(indexs);
@@ -383,7 +966,7 @@ static name_index *name_index_new(void)
         free(indexs);
         return NULL;
     }
-    indexs->map = map_new(MAP_STR_STR, MAP_DEFAULT_CMP_FUNC, MAP_DEFAULT_FREE_FUNC);
+    indexs->map = hash_map_new(MAP_STR_STR, MAP_DEFAULT_FREE_FUNC);
     if (indexs->map == NULL) {
         ERROR("Out of memory");
         goto error_out;
@@ -403,7 +986,7 @@ bool name_index_add(const char *name, const char *id)
         ERROR("lock name index failed");
         return false;
     }
-    ret = map_insert(g_indexs->map, (void *)name, (void *)id);
+    ret = hash_map_insert(g_indexs->map, (void *)name, (void *)id);
     if (pthread_rwlock_unlock(&g_indexs->rwlock) != 0) {
         ERROR("unlock name index failed");
         return false;
@@ -420,12 +1003,12 @@ bool name_index_rename(const char *new_name, const char *old_name, const char *i
         ERROR("lock name index failed");
         return false;
     }
-    ret = map_insert(g_indexs->map, (void *)new_name, (void *)id);
+    ret = hash_map_insert(g_indexs->map, (void *)new_name, (void *)id);
     if (!ret) {
         goto unlock_out;
     }
 
-    ret = map_remove(g_indexs->map, (void *)old_name);
+    ret = hash_map_remove(g_indexs->map, (void *)old_name);
 
 unlock_out:
     if (pthread_rwlock_unlock(&g_indexs->rwlock) != 0) {
@@ -448,7 +1031,7 @@ char *name_index_get(const char *name)
         ERROR("lock name index failed");
         return id;
     }
-    id = map_search(g_indexs->map, (void *)name);
+    id = hash_map_search(g_indexs->map, (void *)name);
     if (pthread_rwlock_unlock(&g_indexs->rwlock) != 0) {
         ERROR("unlock name index failed");
     }
@@ -464,7 +1047,7 @@ bool name_index_remove(const char *name)
         ERROR("lock name index failed");
         return false;
     }
-    ret = map_remove(g_indexs->map, (void *)name);
+    ret = hash_map_remove(g_indexs->map, (void *)name);
     if (pthread_rwlock_unlock(&g_indexs->rwlock) != 0) {
         ERROR("unlock name index failed");
         return false;
@@ -477,7 +1060,7 @@ map_t *name_index_get_all(void)
 {
     bool ret = false;
     map_t *map_id_name = NULL;
-    map_itor *itor = NULL;
+    hash_map_itor *itor = NULL;
 
     map_id_name = map_new(MAP_STR_STR, MAP_DEFAULT_CMP_FUNC, MAP_DEFAULT_FREE_FUNC);
     if (map_id_name == NULL) {
@@ -490,19 +1073,19 @@ map_t *name_index_get_all(void)
         goto out;
     }
 
-    if (map_size(g_indexs->map) == 0) {
+    if (hash_map_size(g_indexs->map) == 0) {
         ret = true;
         goto unlock;
     }
 
-    itor = map_itor_new(g_indexs->map);
+    itor = hash_map_itor_new(g_indexs->map);
     if (itor == NULL) {
         ERROR("Out of memory");
         goto unlock;
     }
 
-    for (; map_itor_valid(itor); map_itor_next(itor)) {
-        if (!map_insert(map_id_name, map_itor_value(itor), map_itor_key(itor))) {
+    for (; hash_map_itor_valid(itor); hash_map_itor_next(itor)) {
+        if (!map_insert(map_id_name, hash_map_itor_value(itor), hash_map_itor_key(itor))) {
             ERROR("Insert failed");
             goto unlock;
         }
@@ -513,7 +1096,7 @@ unlock:
         ERROR("unlock memory store failed");
     }
 out:
-    map_itor_free(itor);
+    hash_map_itor_free(itor);
     if (!ret) {
         map_free(map_id_name);
         map_id_name = NULL;
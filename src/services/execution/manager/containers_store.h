@@ -16,6 +16,7 @@
 #define __ISULAD_MEMORY_STORE_H__
 
 #include "container_unix.h"
+#include "container_list_view.h"
 #include "map.h"
 
 #if defined(__cplusplus) || defined(c_plusplus)
@@ -36,6 +37,16 @@ int containers_store_list(container_t ***out, size_t *size);
 
 char **containers_store_list_ids(void);
 
+/* list views of containers in store */
+void containers_store_update_list_view(container_t *cont);
+
+void containers_store_refresh_list_view(const char *id);
+
+int containers_store_list_views(container_list_view_t ***out, size_t *size);
+
+int containers_store_list_views_by_labels(const char **keys, const char **values, size_t len,
+                                          container_list_view_t ***out, size_t *size);
+
 /* name indexs */
 int name_index_init(void);
 
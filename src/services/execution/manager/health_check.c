@@ -18,8 +18,11 @@
 #include <errno.h>
 #include <pthread.h>
 #include <stdlib.h>
+#include <stddef.h>
+#include <time.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/prctl.h>
 #include <semaphore.h>
 
 #include "log.h"
@@ -31,7 +34,50 @@
 #include "container_exec_response.h"
 #include "containers_store.h"
 #include "log_gather.h"
+#include "hash_map.h"
+#include "utils_thread_pool.h"
+#include "utils_timer_wheel.h"
+
+#define HEALTH_CHECK_TICK_MS 100
+/* health of probed containers is saved to disk at most once per second */
+#define HEALTH_CHECK_FLUSH_MS 1000
+#define HEALTH_CHECK_PROBE_WORKERS 8
+/* first probes of containers started together are spread over this */
+#define HEALTH_CHECK_MAX_JITTER_MS 5000
+
+/*
+ * One timer wheel schedules probes of all containers, expired probes are run
+ * by a fixed number of probe workers. A container is rescheduled only after
+ * its probe finished, so there is never more than one probe per container.
+ */
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool started;
+    timer_wheel_t *wheel;
+    thread_pool_t *probers;
+    /* id of containers whose health is not saved to disk yet */
+    hash_map_t *dirty;
+} health_check_scheduler_t;
+
+static health_check_scheduler_t g_health_scheduler = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .started = false,
+};
+
+static void health_scheduler_lock(void)
+{
+    if (pthread_mutex_lock(&g_health_scheduler.mutex) != 0) {
+        ERROR("Failed to lock health check scheduler");
+    }
+}
 
+static void health_scheduler_unlock(void)
+{
+    if (pthread_mutex_unlock(&g_health_scheduler.mutex) != 0) {
+        ERROR("Failed to unlock health check scheduler");
+    }
+}
 
 /* container state lock */
 static void container_health_check_lock(health_check_manager_t *health)
@@ -95,11 +141,19 @@ static void set_monitor_stop_status(health_check_manager_t *health)
     container_health_check_unlock(health);
 }
 
-static void set_monitor_interval_timeout_status(health_check_manager_t *health)
+/* return false if monitor was stopped, stop must not be overwritten by probe job */
+static bool set_monitor_status_unless_stopped(health_check_manager_t *health, health_check_monitor_status_t status)
 {
+    bool ret = false;
+
     container_health_check_lock(health);
-    health->monitor_status = MONITOR_INTERVAL;
+    if (health->monitor_status != MONITOR_STOP) {
+        health->monitor_status = status;
+        ret = true;
+    }
     container_health_check_unlock(health);
+
+    return ret;
 }
 
 static health_check_monitor_status_t get_health_check_monitor_state(health_check_manager_t *health)
@@ -120,11 +174,16 @@ static void close_health_check_monitor(const container_t *cont)
     }
     set_monitor_stop_status(cont->health_check);
     set_health_status(cont->state, UNHEALTHY);
+
+    /* a running probe sees the stop status and does not reschedule */
+    health_scheduler_lock();
+    timer_wheel_del(g_health_scheduler.wheel, &cont->health_check->timer);
+    health_scheduler_unlock();
 }
 
 static void open_health_check_monitor(health_check_manager_t *health)
 {
-    set_monitor_interval_timeout_status(health);
+    set_monitor_idle_status(health);
 }
 
 // Called when the container is being stopped (whether because the health check is
@@ -163,14 +222,18 @@ void health_check_manager_free(health_check_manager_t *health_check)
     if (health_check == NULL) {
         return;
     }
+    health_scheduler_lock();
+    timer_wheel_del(g_health_scheduler.wheel, &health_check->timer);
+    health_scheduler_unlock();
     if (health_check->init_mutex) {
         pthread_mutex_destroy(&health_check->mutex);
     }
+    free(health_check->container_id);
     free(health_check);
 }
 
 /* health check manager new */
-static health_check_manager_t *health_check_manager_new()
+static health_check_manager_t *health_check_manager_new(const char *container_id)
 {
     int ret;
     health_check_manager_t *health_check = NULL;
@@ -188,6 +251,8 @@ static health_check_manager_t *health_check_manager_new()
     health_check->init_mutex = true;
 
     health_check->monitor_status = MONITOR_IDLE;
+    timer_wheel_entry_init(&health_check->timer);
+    health_check->container_id = util_strdup_s(container_id);
 
     return health_check;
 cleanup:
@@ -416,6 +481,23 @@ out:
     return ret;
 }
 
+/* health is saved by scheduler in batch, instead of a container_to_disk per probe */
+static void health_check_mark_dirty(const char *container_id)
+{
+    bool dirty = true;
+
+    health_scheduler_lock();
+    if (!g_health_scheduler.started) {
+        health_scheduler_unlock();
+        return;
+    }
+    if (!hash_map_replace(g_health_scheduler.dirty, (void *)container_id, (void *)&dirty)) {
+        ERROR("Failed to mark health of container %s dirty", container_id);
+    }
+    (void)pthread_cond_signal(&g_health_scheduler.cond);
+    health_scheduler_unlock();
+}
+
 // Update the container's Status.Health struct based on the latest probe's result.
 static int handle_probe_result(const char *container_id, const defs_health_log_element *result)
 {
@@ -466,10 +548,7 @@ static int handle_probe_result(const char *container_id, const defs_health_log_e
         // note: event
         EVENT("EVENT: {Object: %s, health_status: %s}", cont->common_config->id, current);
     }
-    if (container_to_disk(cont)) {
-        ERROR("Failed to save container \"%s\" to disk", cont->common_config->id);
-        ret = -1;
-    }
+    health_check_mark_dirty(cont->common_config->id);
 out:
     free(old_state);
     free(current);
@@ -509,7 +588,7 @@ static void health_check_exec_success_handle(const container_exec_response *cont
 
 // exec the healthcheck command in the container.
 // Returns the exit code and probe output (if any)
-void *health_check_run(void *arg)
+static void health_check_run(const char *arg)
 {
     int ret = 0;
     char *container_id = NULL;
@@ -526,10 +605,10 @@ void *health_check_run(void *arg)
 
     if (arg == NULL) {
         ERROR("Invalid input arguments");
-        return NULL;
+        return;
     }
 
-    container_id = util_strdup_s((char *)arg);
+    container_id = util_strdup_s(arg);
 
     cont = containers_store_get(container_id);
     if (cont == NULL) {
@@ -600,7 +679,6 @@ out:
     free_container_exec_request(container_req);
     free_container_exec_response(container_res);
     container_unref(cont);
-    return NULL;
 }
 
 // Get a suitable probe implementation for the container's healthcheck configuration.
@@ -626,116 +704,281 @@ static health_probe_t get_probe(const container_t *cont)
     }
 }
 
-static int do_monitor_interval(const char *container_id,
-                               health_check_manager_t *health_check,
-                               types_timestamp_t *start_timestamp)
+static uint64_t health_check_monotonic_ms(void)
 {
-    int ret = 0;
-    pthread_t exec_tid = { 0 };
+    struct timespec ts = { 0 };
 
-    if (pthread_create(&exec_tid, NULL, health_check_run, (void *)container_id)) {
-        ERROR("Failed to create thread to exec health check");
-        ret = -1;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        return 0;
+    }
+
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static uint64_t health_check_interval_ms(const container_t *cont)
+{
+    return (uint64_t)(timeout_with_default(cont->common_config->config->health_check->interval,
+                                           DEFAULT_PROBE_INTERVAL) / Time_Milli);
+}
+
+/* spread first probes by container id, ids are random already */
+static uint64_t health_check_jitter_ms(const char *container_id, uint64_t interval)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    uint64_t max_jitter = interval / 10;
+    const char *p = NULL;
+
+    if (max_jitter > HEALTH_CHECK_MAX_JITTER_MS) {
+        max_jitter = HEALTH_CHECK_MAX_JITTER_MS;
+    }
+    if (max_jitter == 0) {
+        return 0;
+    }
+
+    for (p = container_id; *p != '\0'; p++) {
+        h ^= (unsigned char)*p;
+        h *= 0x100000001b3ULL;
+    }
+
+    return h % max_jitter;
+}
+
+static void health_check_probe_job(void *arg);
+
+/* called by timer wheel with scheduler locked */
+static void health_check_expired(timer_wheel_entry_t *entry, void *arg)
+{
+    uint64_t now = *(uint64_t *)arg;
+    char *container_id = NULL;
+    health_check_manager_t *health = NULL;
+
+    health = (health_check_manager_t *)((char *)entry - offsetof(health_check_manager_t, timer));
+
+    container_id = util_strdup_s(health->container_id);
+    health->probing = true;
+    if (thread_pool_submit(g_health_scheduler.probers, health_check_probe_job, container_id) != 0) {
+        ERROR("Failed to submit health check of container %s, retry later", health->container_id);
+        free(container_id);
+        health->probing = false;
+        timer_wheel_add(g_health_scheduler.wheel, &health->timer, now + HEALTH_CHECK_FLUSH_MS);
+    }
+}
+
+/* called with scheduler locked */
+static void health_check_arm(health_check_manager_t *health, uint64_t delay_ms)
+{
+    uint64_t now = health_check_monotonic_ms();
+
+    /* catch up first, so the wheel never walks through ticks it was idle */
+    (void)timer_wheel_advance(g_health_scheduler.wheel, now, health_check_expired, &now);
+    timer_wheel_add(g_health_scheduler.wheel, &health->timer, now + delay_ms);
+    (void)pthread_cond_signal(&g_health_scheduler.cond);
+}
+
+static void health_check_probe_job(void *arg)
+{
+    char *container_id = (char *)arg;
+    container_t *cont = NULL;
+    health_check_manager_t *health = NULL;
+
+    cont = containers_store_get(container_id);
+    if (cont == NULL) {
+        DEBUG("Container %s is removed, skip health check", container_id);
         goto out;
     }
-    if (pthread_join(exec_tid, NULL) < 0) {
-        ERROR("Failed to run health check thread");
-        ret = -1;
+    health = cont->health_check;
+    if (health == NULL) {
         goto out;
     }
-    if (get_health_check_monitor_state(health_check) == MONITOR_STOP) {
-        ret = 0;
+
+    if (set_monitor_status_unless_stopped(health, MONITOR_INTERVAL)) {
+        health_check_run(container_id);
+    }
+
+    health_scheduler_lock();
+    health->probing = false;
+    if (set_monitor_status_unless_stopped(health, MONITOR_IDLE)) {
+        health_check_arm(health, health_check_interval_ms(cont));
+    }
+    health_scheduler_unlock();
+
+out:
+    free(container_id);
+    container_unref(cont);
+}
+
+static void health_check_schedule(const container_t *cont)
+{
+    uint64_t interval = health_check_interval_ms(cont);
+    health_check_manager_t *health = cont->health_check;
+
+    health_scheduler_lock();
+    if (!g_health_scheduler.started) {
+        ERROR("Health check scheduler is not started");
         goto out;
     }
-    set_monitor_idle_status(health_check);
-    if (get_now_time_stamp(start_timestamp) == false) {
-        ERROR("Failed to get time stamp");
-        ret = -1;
+    /* a running probe reschedules itself when it is done */
+    if (health->probing || timer_wheel_entry_pending(&health->timer)) {
         goto out;
     }
+    health_check_arm(health, interval + health_check_jitter_ms(health->container_id, interval));
+
 out:
-    return ret;
+    health_scheduler_unlock();
 }
 
-static int do_monitor_default(int64_t probe_interval,
-                              health_check_manager_t *health_check,
-                              const types_timestamp_t *start_timestamp,
-                              types_timestamp_t *last_timestamp)
+static void health_check_flush(hash_map_t *dirty)
 {
-    int64_t time_interval = 0;
+    hash_map_itor *itor = NULL;
+    container_t *cont = NULL;
 
-    if (get_now_time_stamp(last_timestamp) == false) {
-        ERROR("Failed to get time stamp");
-        return -1;
+    itor = hash_map_itor_new(dirty);
+    if (itor == NULL) {
+        ERROR("Out of memory");
+        return;
     }
 
-    if (get_time_interval(*start_timestamp, *last_timestamp, &time_interval)) {
-        ERROR("Failed to get time interval");
-        return -1;
+    for (; hash_map_itor_valid(itor); hash_map_itor_next(itor)) {
+        cont = containers_store_get((const char *)hash_map_itor_key(itor));
+        if (cont == NULL) {
+            continue;
+        }
+        if (container_save_health(cont) != 0) {
+            ERROR("Failed to save health of container %s", cont->common_config->id);
+        }
+        /* health is changed under state lock only, so do not wait for container lock */
+        containers_store_refresh_list_view(cont->common_config->id);
+        container_unref(cont);
+    }
+
+    hash_map_itor_free(itor);
+}
+
+/* called with scheduler locked, sleep until next timer expires or dirty health is due to be saved */
+static void health_check_wait(uint64_t last_flush)
+{
+    uint64_t deadline = timer_wheel_next_expiry(g_health_scheduler.wheel);
+    struct timespec ts = { 0 };
+
+    if (hash_map_size(g_health_scheduler.dirty) > 0 && last_flush + HEALTH_CHECK_FLUSH_MS < deadline) {
+        deadline = last_flush + HEALTH_CHECK_FLUSH_MS;
     }
 
-    if (time_interval >= probe_interval) {
-        set_monitor_interval_timeout_status(health_check);
+    if (deadline == UINT64_MAX) {
+        (void)pthread_cond_wait(&g_health_scheduler.cond, &g_health_scheduler.mutex);
+        return;
     }
-    usleep_nointerupt(500);
 
-    return 0;
+    ts.tv_sec = (time_t)(deadline / 1000);
+    ts.tv_nsec = (long)((deadline % 1000) * 1000000);
+    (void)pthread_cond_timedwait(&g_health_scheduler.cond, &g_health_scheduler.mutex, &ts);
 }
-// Run the container's monitoring thread until notified via "stop".
-// There is never more than one monitor thread running per container at a time.
-static void *health_check_monitor(void *arg)
+
+static void *health_check_scheduler(void *arg)
 {
-    char *container_id = NULL;
-    int64_t probe_interval = 0;
-    container_t *cont = NULL;
-    types_timestamp_t start_timestamp = { 0 };
-    types_timestamp_t last_timestamp = { 0 };
+    int ret = 0;
+    uint64_t now = 0;
+    uint64_t last_flush = 0;
+    hash_map_t *dirty = NULL;
+    hash_map_t *empty = NULL;
 
-    if ((char *)arg == NULL) {
-        ERROR("Container id is empty");
+    ret = pthread_detach(pthread_self());
+    if (ret != 0) {
+        CRIT("Set thread detach fail");
         return NULL;
     }
-    container_id = util_strdup_s((char *)arg);
 
-    cont = containers_store_get(container_id);
-    if (cont == NULL) {
-        ERROR("Failed to get container info");
+    prctl(PR_SET_NAME, "HealthCheck");
+
+    health_scheduler_lock();
+    for (;;) {
+        now = health_check_monotonic_ms();
+        (void)timer_wheel_advance(g_health_scheduler.wheel, now, health_check_expired, &now);
+
+        if (hash_map_size(g_health_scheduler.dirty) > 0 && now - last_flush >= HEALTH_CHECK_FLUSH_MS) {
+            empty = hash_map_new(MAP_STR_BOOL, MAP_DEFAULT_FREE_FUNC);
+            if (empty != NULL) {
+                dirty = g_health_scheduler.dirty;
+                g_health_scheduler.dirty = empty;
+                /* saving takes state lock of containers, never do it with scheduler locked */
+                health_scheduler_unlock();
+                health_check_flush(dirty);
+                hash_map_free(dirty);
+                health_scheduler_lock();
+            }
+            last_flush = now;
+        }
+
+        health_check_wait(last_flush);
+    }
+    health_scheduler_unlock();
+
+    return NULL;
+}
+
+static int health_check_cond_init(void)
+{
+    int ret = 0;
+    pthread_condattr_t attr;
+
+    ret = pthread_condattr_init(&attr);
+    if (ret != 0) {
+        return ret;
+    }
+    ret = pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    if (ret == 0) {
+        ret = pthread_cond_init(&g_health_scheduler.cond, &attr);
+    }
+    (void)pthread_condattr_destroy(&attr);
+
+    return ret;
+}
+
+/* new health check scheduler, must be called before containers are restored */
+int new_health_check_scheduler(void)
+{
+    int ret = -1;
+    pthread_t a_thread;
+
+    if (health_check_cond_init() != 0) {
+        CRIT("Condition initialization failed");
+        return -1;
+    }
+
+    g_health_scheduler.wheel = timer_wheel_new(HEALTH_CHECK_TICK_MS, health_check_monotonic_ms());
+    g_health_scheduler.dirty = hash_map_new(MAP_STR_BOOL, MAP_DEFAULT_FREE_FUNC);
+    if (g_health_scheduler.wheel == NULL || g_health_scheduler.dirty == NULL) {
+        ERROR("Out of memory");
         goto out;
     }
 
-    if (get_now_time_stamp(&start_timestamp) == false) {
-        ERROR("Failed to monitor start time stamp");
+    g_health_scheduler.probers = thread_pool_new("HealthProber", HEALTH_CHECK_PROBE_WORKERS);
+    if (g_health_scheduler.probers == NULL) {
+        CRIT("Failed to create health check workers");
         goto out;
     }
-    probe_interval = timeout_with_default(cont->common_config->config->health_check->interval,
-                                          DEFAULT_PROBE_INTERVAL);
-    set_monitor_idle_status(cont->health_check);
-    while (true) {
-        switch (get_health_check_monitor_state(cont->health_check)) {
-            case MONITOR_STOP:
-                DEBUG("Stop healthcheck monitoring for container %s (received while idle)",
-                      cont->common_config->id);
-                goto out;
-            /* fall-through */
-            case MONITOR_INTERVAL:
-                if (do_monitor_interval(container_id, cont->health_check, &start_timestamp)) {
-                    goto out;
-                }
-                break;
-            case MONITOR_IDLE:
-            /* fall-through */
-            default:
-                if (do_monitor_default(probe_interval, cont->health_check, &start_timestamp, &last_timestamp)) {
-                    goto out;
-                }
-                break;
-        }
+
+    g_health_scheduler.started = true;
+    ret = pthread_create(&a_thread, NULL, health_check_scheduler, NULL);
+    if (ret != 0) {
+        CRIT("Thread creation failed");
+        g_health_scheduler.started = false;
+        ret = -1;
+        goto out;
     }
+
+    ret = 0;
 out:
-    free(container_id);
-    container_id = NULL;
-    container_unref(cont);
-    return NULL;
+    if (ret != 0) {
+        thread_pool_free(g_health_scheduler.probers);
+        g_health_scheduler.probers = NULL;
+        hash_map_free(g_health_scheduler.dirty);
+        g_health_scheduler.dirty = NULL;
+        timer_wheel_free(g_health_scheduler.wheel);
+        g_health_scheduler.wheel = NULL;
+        (void)pthread_cond_destroy(&g_health_scheduler.cond);
+    }
+    return ret;
 }
 
 // Ensure the health-check monitor is running or not, depending on the current
@@ -765,16 +1008,12 @@ void update_health_monitor(const char *container_id)
     want_running = cont->state->state->running && !cont->state->state->paused && probe != HEALTH_NONE;
 
     if (want_running) {
-        open_health_check_monitor(cont->health_check);
-        pthread_t monitor_tid = { 0 };
-        if (pthread_create(&monitor_tid, NULL, health_check_monitor, (void *)container_id)) {
-            ERROR("Failed to create thread to monitor health check...");
-            goto out;
-        }
-        if (pthread_detach(monitor_tid)) {
-            ERROR("Failed to detach the health check monitor thread");
+        if (cont->health_check == NULL) {
+            ERROR("Health check of container %s is not initialized", container_id);
             goto out;
         }
+        open_health_check_monitor(cont->health_check);
+        health_check_schedule(cont);
     } else {
         close_health_check_monitor(cont);
     }
@@ -804,7 +1043,7 @@ void init_health_monitor(const char *id)
     }
 
     if (cont->health_check == NULL) {
-        cont->health_check = health_check_manager_new();
+        cont->health_check = health_check_manager_new(cont->common_config->id);
         if (cont->health_check == NULL) {
             ERROR("Out of memory");
             goto out;
@@ -833,7 +1072,7 @@ void init_health_monitor(const char *id)
         set_health_status(cont->state, HEALTH_STARTING);
     }
 
-    if (container_to_disk(cont)) {
+    if (container_state_to_disk(cont)) {
         ERROR("Failed to save container \"%s\" to disk", id);
         goto out;
     }
@@ -17,6 +17,7 @@
 
 #include "types_def.h"
 #include "container_config_v2.h"
+#include "utils_timer_wheel.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -52,8 +53,13 @@ typedef struct health_check_manager {
     pthread_mutex_t mutex;
     bool init_mutex;
     health_check_monitor_status_t monitor_status;
+    /* fields below are protected by the lock of health check scheduler */
+    timer_wheel_entry_t timer;
+    char *container_id;
+    bool probing;
 } health_check_manager_t;
 
+int new_health_check_scheduler(void);
 void init_health_monitor(const char *id);
 void stop_health_checks(const char *container_id);
 void update_health_monitor(const char *container_id);
@@ -20,6 +20,10 @@
 #include "engine.h"
 #include "host_config.h"
 
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
 struct restart_policy {
     char *name;
     uint64_t max_retry_count;
@@ -59,6 +63,9 @@ int restart_manager_wait_cancel(restart_manager_t *rm, uint64_t timeout);
 
 int container_restart_in_thread(const char *id, uint64_t timeout, int exit_code);
 
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif
 
 #endif /* __RESTARTMANAGER_H */
 
@@ -18,6 +18,7 @@
 #include <unistd.h>
 #include <limits.h>
 #include <pthread.h>
+#include <time.h>
 
 #include "isulad_config.h"
 #include "log.h"
@@ -29,6 +30,7 @@
 #include "error.h"
 #include "image.h"
 #include "runtime.h"
+#include "utils_thread_pool.h"
 
 #ifdef ENABLE_OCI_IMAGE
 #include "oci_images_store.h"
@@ -343,7 +345,7 @@ out:
         state_reset_removal_in_progress(cont->state);
         need_save = true;
     }
-    if (need_save && container_to_disk(cont) != 0) {
+    if (need_save && container_state_to_disk_locking(cont) != 0) {
         ERROR("Failed to re-save container \"%s\" to disk", id);
         ret = -1;
     }
@@ -407,7 +409,7 @@ static void restored_restart_container(container_t *cont)
                                        cont->common_config->has_been_manually_stopped,
                                        time_seconds_since(started_at),
                                        &timeout)) {
-        cont->common_config->restart_count++;
+        container_inc_restart_count(cont);
         INFO("Restart container %s after 5 second", id);
         (void)container_restart_in_thread(id, 5ULL * Time_Second, (int)state_get_exitcode(cont->state));
     }
@@ -462,51 +464,184 @@ static void handle_restored_container()
     return;
 }
 
+#define RESTORE_MAX_WORKERS 32
+
+/* per-phase elapsed nanoseconds, load/state are summed over all workers */
+struct restore_stats {
+    pthread_mutex_t mutex;
+    int64_t load_ns;
+    int64_t state_ns;
+    size_t failed;
+};
+
+struct restore_job {
+    const char *runtime;
+    const char *rootpath;
+    const char *statepath;
+    const char *id;
+    struct restore_stats *stats;
+    /* result of the job, NULL if container is invalid and has been removed */
+    container_t *cont;
+};
+
+static int64_t restore_monotonic_nanos(void)
+{
+    struct timespec ts = { 0 };
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        return 0;
+    }
+
+    return (int64_t)ts.tv_sec * Time_Second + ts.tv_nsec;
+}
+
+static void restore_stats_add(struct restore_stats *stats, int64_t load_ns, int64_t state_ns, bool failed)
+{
+    if (pthread_mutex_lock(&stats->mutex) != 0) {
+        return;
+    }
+    stats->load_ns += load_ns;
+    stats->state_ns += state_ns;
+    if (failed) {
+        stats->failed++;
+    }
+    (void)pthread_mutex_unlock(&stats->mutex);
+}
+
+/* load config and probe runtime state of one container, run in restore worker */
+static void restore_container_job(void *arg)
+{
+    struct restore_job *job = (struct restore_job *)arg;
+    container_t *cont = NULL;
+    int64_t begin = 0;
+    int64_t loaded = 0;
+    int64_t end = 0;
+
+    begin = restore_monotonic_nanos();
+    cont = container_load(job->runtime, job->rootpath, job->statepath, job->id);
+    loaded = restore_monotonic_nanos();
+    if (cont == NULL) {
+        ERROR("Failed to load subdir:%s", job->id);
+        goto error_load;
+    }
+
+    if (restore_state(cont)) {
+        WARN("Failed to restore container %s state", job->id);
+        goto error_load;
+    }
+    end = restore_monotonic_nanos();
+
+    job->cont = cont;
+    restore_stats_add(job->stats, loaded - begin, end - loaded, false);
+    return;
+
+error_load:
+    if (remove_invalid_container(cont, job->runtime, job->rootpath, job->statepath, job->id)) {
+        ERROR("Failed to delete subdir:%s", job->id);
+    }
+    container_unref(cont);
+    end = restore_monotonic_nanos();
+    restore_stats_add(job->stats, loaded - begin, end - loaded, true);
+}
+
+/* add loaded container into name index and store, must be called serially */
+static void add_restored_container_to_store(const struct restore_job *job)
+{
+    bool index_flag = false;
+    container_t *cont = job->cont;
+
+    index_flag = name_index_add(cont->common_config->name, cont->common_config->id);
+    if (!index_flag) {
+        ERROR("Failed add %s into name indexs", job->id);
+        goto error_load;
+    }
+    if (!containers_store_add(cont->common_config->id, cont)) {
+        ERROR("Failed add container %s to store", job->id);
+        goto error_load;
+    }
+
+    return;
+
+error_load:
+    if (remove_invalid_container(cont, job->runtime, job->rootpath, job->statepath, job->id)) {
+        ERROR("Failed to delete subdir:%s", job->id);
+    }
+    container_unref(cont);
+
+    if (index_flag) {
+        name_index_remove(job->id);
+    }
+}
+
+static void run_restore_jobs(struct restore_job *jobs, size_t job_num)
+{
+    size_t i = 0;
+    size_t workers = 0;
+    thread_pool_t *pool = NULL;
+
+    workers = thread_pool_default_workers(job_num, RESTORE_MAX_WORKERS);
+    pool = thread_pool_new("RestoreWorker", workers);
+    if (pool == NULL) {
+        WARN("Failed to create restore workers, restore containers serially");
+        for (i = 0; i < job_num; i++) {
+            restore_container_job(&jobs[i]);
+        }
+        return;
+    }
+
+    for (i = 0; i < job_num; i++) {
+        if (thread_pool_submit(pool, restore_container_job, &jobs[i]) != 0) {
+            restore_container_job(&jobs[i]);
+        }
+    }
+    thread_pool_wait(pool);
+    thread_pool_free(pool);
+}
+
 /* scan dir to add store */
 static void scan_dir_to_add_store(const char *runtime, const char *rootpath, const char *statepath,
                                   const size_t subdir_num, const char **subdir)
 {
     size_t i = 0;
-    container_t *cont = NULL;
+    int64_t begin = 0;
+    int64_t loaded = 0;
+    int64_t end = 0;
+    struct restore_job *jobs = NULL;
+    struct restore_stats stats = { .mutex = PTHREAD_MUTEX_INITIALIZER };
+
+    jobs = util_smart_calloc_s(sizeof(struct restore_job), subdir_num);
+    if (jobs == NULL) {
+        ERROR("Out of memory");
+        return;
+    }
 
     for (i = 0; i < subdir_num; i++) {
-        cont = NULL;
-        bool aret = false;
-        bool index_flag = false;
-        cont = container_load(runtime, rootpath, statepath, subdir[i]);
-        if (cont == NULL) {
-            ERROR("Failed to load subdir:%s", subdir[i]);
-            goto error_load;
-        }
+        jobs[i].runtime = runtime;
+        jobs[i].rootpath = rootpath;
+        jobs[i].statepath = statepath;
+        jobs[i].id = subdir[i];
+        jobs[i].stats = &stats;
+    }
 
-        if (restore_state(cont)) {
-            WARN("Failed to restore container %s state", subdir[i]);
-            goto error_load;
-        }
+    begin = restore_monotonic_nanos();
+    run_restore_jobs(jobs, subdir_num);
+    loaded = restore_monotonic_nanos();
 
-        index_flag = name_index_add(cont->common_config->name, cont->common_config->id);
-        if (!index_flag) {
-            ERROR("Failed add %s into name indexs", subdir[i]);
-            goto error_load;
-        }
-        aret = containers_store_add(cont->common_config->id, cont);
-        if (!aret) {
-            ERROR("Failed add container %s to store", subdir[i]);
-            goto error_load;
+    for (i = 0; i < subdir_num; i++) {
+        if (jobs[i].cont != NULL) {
+            add_restored_container_to_store(&jobs[i]);
         }
+    }
+    end = restore_monotonic_nanos();
 
-        continue;
-error_load:
-        if (remove_invalid_container(cont, runtime, rootpath, statepath, subdir[i])) {
-            ERROR("Failed to delete subdir:%s", subdir[i]);
-        }
-        container_unref(cont);
+    INFO("Restored %zu containers (%zu failed) of runtime %s: load and probe %lld ms (load config %lld ms, "
+         "restore state %lld ms in total of workers), add to store %lld ms",
+         subdir_num, stats.failed, runtime, (long long)((loaded - begin) / Time_Milli),
+         (long long)(stats.load_ns / Time_Milli), (long long)(stats.state_ns / Time_Milli),
+         (long long)((end - loaded) / Time_Milli));
 
-        if (index_flag) {
-            name_index_remove(subdir[i]);
-        }
-        continue;
-    }
+    (void)pthread_mutex_destroy(&stats.mutex);
+    free(jobs);
 }
 
 /* restore container by runtime */
@@ -558,9 +693,13 @@ void containers_restore(void)
     int ret = 0;
     size_t subdir_num = 0;
     size_t i = 0;
+    int64_t begin = 0;
+    int64_t restored = 0;
+    int64_t end = 0;
     char *engines_path = NULL;
     char **subdir = NULL;
 
+    begin = restore_monotonic_nanos();
     engines_path = conf_get_engine_rootpath();
     if (engines_path == NULL) {
         ERROR("Failed to get engines path");
@@ -582,7 +721,13 @@ void containers_restore(void)
         }
     }
 
+    restored = restore_monotonic_nanos();
     handle_restored_container();
+    end = restore_monotonic_nanos();
+
+    INFO("Containers restore finished in %lld ms: restore by runtime %lld ms, handle restored containers %lld ms",
+         (long long)((end - begin) / Time_Milli), (long long)((restored - begin) / Time_Milli),
+         (long long)((end - restored) / Time_Milli));
 
 out:
     free(engines_path);
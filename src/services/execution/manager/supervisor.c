@@ -13,8 +13,11 @@
  * Description: provide container supervisor functions
  ******************************************************************************/
 #define _GNU_SOURCE
+#include <poll.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
 #include <unistd.h>
 
 #include "log.h"
@@ -25,6 +28,17 @@
 #include "collector.h"
 #include "execution.h"
 #include "containers_gc.h"
+#include "utils_thread_pool.h"
+
+#ifndef __NR_pidfd_open
+#define __NR_pidfd_open 434
+#endif
+
+#define CLEAN_MAX_WORKERS 8
+/* give up waiting for killed process and hand it to gc, same as the old 10 * 100ms retries */
+#define CLEAN_WAIT_EXIT_TIMEOUT (1 * Time_Second)
+#define CLEAN_SWEEP_INTERVAL (100 * Time_Milli)
+#define CLEAN_POLL_MAX_RETRY 10
 
 pthread_mutex_t g_supervisor_lock = PTHREAD_MUTEX_INITIALIZER;
 struct epoll_descr g_supervisor_descr;
@@ -35,8 +49,39 @@ struct supervisor_handler_data {
     char *name;
     char *runtime;
     container_pid_t pid_info;
+    /* monotonic time when the monitor exit was noticed */
+    int64_t exit_at;
+    /* pidfd of the killed process while waiting for it to exit */
+    int pidfd;
+    int64_t wait_deadline;
+    bool exited;
+    bool wait_timeout;
+    struct linked_list wait_node;
 };
 
+/* cleanup workers, shared by all container exits */
+static thread_pool_t *g_clean_workers = NULL;
+/* killed processes waiting for exit notification, protected by g_supervisor_lock */
+static struct linked_list g_clean_waiters;
+static int g_clean_timerfd = -1;
+
+/* counters of exit cleanup, logged every CLEAN_STATS_LOG_INTERVAL cleanups */
+#define CLEAN_STATS_LOG_INTERVAL 100
+
+typedef struct {
+    /* container exits waiting for a cleanup worker */
+    uint64_t queued;
+    /* killed processes waiting for exit notification */
+    uint64_t waiting;
+    uint64_t finished;
+    /* time from monitor exit to cleanup finished, in nanoseconds */
+    uint64_t max_latency;
+    uint64_t total_latency;
+} supervisor_clean_stats_t;
+
+static pthread_mutex_t g_clean_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static supervisor_clean_stats_t g_clean_stats;
+
 /* supervisor handler lock */
 static void supervisor_handler_lock()
 {
@@ -139,75 +184,308 @@ static void supervisor_handler_data_free(struct supervisor_handler_data *data)
     if (data->fd >= 0) {
         close(data->fd);
     }
+    if (data->pidfd >= 0) {
+        close(data->pidfd);
+    }
     free(data);
 }
 
-/* clean resources thread */
-static void *clean_resources_thread(void *arg)
+static int64_t supervisor_monotonic_nanos(void)
+{
+    struct timespec ts = { 0 };
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        return 0;
+    }
+
+    return (int64_t)ts.tv_sec * Time_Second + ts.tv_nsec;
+}
+
+static void clean_stats_queued(bool queued)
+{
+    (void)pthread_mutex_lock(&g_clean_stats_lock);
+    if (queued) {
+        g_clean_stats.queued++;
+    } else if (g_clean_stats.queued > 0) {
+        g_clean_stats.queued--;
+    }
+    (void)pthread_mutex_unlock(&g_clean_stats_lock);
+}
+
+static void clean_stats_waiting(bool waiting)
+{
+    (void)pthread_mutex_lock(&g_clean_stats_lock);
+    if (waiting) {
+        g_clean_stats.waiting++;
+    } else if (g_clean_stats.waiting > 0) {
+        g_clean_stats.waiting--;
+    }
+    (void)pthread_mutex_unlock(&g_clean_stats_lock);
+}
+
+static void clean_stats_finished(const struct supervisor_handler_data *data)
+{
+    bool need_log = false;
+    supervisor_clean_stats_t stats;
+    int64_t latency = supervisor_monotonic_nanos() - data->exit_at;
+
+    if (latency < 0) {
+        latency = 0;
+    }
+
+    (void)pthread_mutex_lock(&g_clean_stats_lock);
+    g_clean_stats.finished++;
+    g_clean_stats.total_latency += (uint64_t)latency;
+    if ((uint64_t)latency > g_clean_stats.max_latency) {
+        g_clean_stats.max_latency = (uint64_t)latency;
+    }
+    need_log = (g_clean_stats.finished % CLEAN_STATS_LOG_INTERVAL == 0);
+    stats = g_clean_stats;
+    (void)pthread_mutex_unlock(&g_clean_stats_lock);
+
+    DEBUG("Cleanup of container %s finished in %.3fms", data->name, (double)latency / Time_Milli);
+    if (need_log) {
+        INFO("Container exit cleanup: %lu finished, %lu queued, %lu waiting for exit, average %.3fms, max %.3fms",
+             (unsigned long)stats.finished, (unsigned long)stats.queued, (unsigned long)stats.waiting,
+             (double)stats.total_latency / stats.finished / Time_Milli, (double)stats.max_latency / Time_Milli);
+    }
+}
+
+static void clean_resources_finish(struct supervisor_handler_data *data, bool add_to_gc)
 {
-    int ret = 0;
-    struct supervisor_handler_data *data = arg;
-    char *name = data->name;
-    char *runtime = data->runtime;
-    unsigned long long start_time = data->pid_info.start_time;
     pid_t pid = data->pid_info.pid;
-    int retry_count = 0;
-    int max_retry = 10;
 
-    ret = pthread_detach(pthread_self());
-    if (ret != 0) {
-        CRIT("Set thread detach fail");
+    if (add_to_gc && gc_add_container(data->name, data->runtime, &data->pid_info) != 0) {
+        ERROR("Failed to send container %s to garbage handler", data->name);
     }
 
-    prctl(PR_SET_NAME, "Clean resource");
+    (void)isulad_monitor_send_container_event(data->name, STOPPED, (int)pid, data->exit_code, NULL, NULL);
+
+    clean_stats_finished(data);
+    supervisor_handler_data_free(data);
+}
+
+static void clean_dead_container(struct supervisor_handler_data *data)
+{
+    int ret = 0;
+
+    ret = clean_container_resource(data->name, data->runtime, data->pid_info.pid);
+    // clean_container_resource failed, do not log error message,
+    // just add to gc to retry clean resource.
+    clean_resources_finish(data, ret != 0);
+}
+
+/* used when pidfd is not supported by kernel */
+static void clean_resources_by_polling(struct supervisor_handler_data *data)
+{
+    int ret = 0;
+    int retry_count = 0;
+    pid_t pid = data->pid_info.pid;
 
 retry:
-    if (false == util_process_alive(pid, start_time)) {
-        ret = clean_container_resource(name, runtime, pid);
-        // clean_container_resource failed, do not log error message,
-        // just add to gc to retry clean resource.
-        if (ret != 0 && gc_add_container(name, runtime, &data->pid_info) != 0) {
-            ERROR("Failed to clean resources of container %s", name);
+    if (false == util_process_alive(pid, data->pid_info.start_time)) {
+        clean_dead_container(data);
+        return;
+    }
+
+    ret = kill(pid, SIGKILL);
+    if (ret < 0 && errno != ESRCH) {
+        ERROR("Can not kill process (pid=%d) with SIGKILL for container %s", pid, data->name);
+    }
+
+    if (retry_count < CLEAN_POLL_MAX_RETRY) {
+        usleep_nointerupt(100 * 1000); /* 100 millisecond */
+        retry_count++;
+        goto retry;
+    }
+
+    clean_resources_finish(data, true);
+}
+
+static void clean_timer_set(bool armed)
+{
+    struct itimerspec its = { 0 };
+
+    if (armed) {
+        its.it_value.tv_nsec = CLEAN_SWEEP_INTERVAL;
+        its.it_interval.tv_nsec = CLEAN_SWEEP_INTERVAL;
+    }
+
+    if (timerfd_settime(g_clean_timerfd, 0, &its, NULL) != 0) {
+        ERROR("Failed to set cleanup timer: %s", strerror(errno));
+    }
+}
+
+/* notes: this funciton must be called with supervisor_handler_lock */
+static void clean_waiter_del(struct supervisor_handler_data *data)
+{
+    (void)epoll_loop_del_handler(&g_supervisor_descr, data->pidfd);
+    close(data->pidfd);
+    data->pidfd = -1;
+
+    linked_list_del(&data->wait_node);
+    if (linked_list_empty(&g_clean_waiters)) {
+        clean_timer_set(false);
+    }
+    clean_stats_waiting(false);
+}
+
+static void clean_resources_job(void *arg);
+
+static void clean_resources_submit(struct supervisor_handler_data *data)
+{
+    clean_stats_queued(true);
+
+    if (thread_pool_submit(g_clean_workers, clean_resources_job, data) != 0) {
+        ERROR("Failed to queue cleanup of container %s, send it to garbage handler", data->name);
+        clean_stats_queued(false);
+        clean_resources_finish(data, true);
+    }
+}
+
+/* killed process exited, run by supervisor thread */
+static int clean_pidfd_exit_cb(int fd, uint32_t events, void *cbdata, struct epoll_descr *descr)
+{
+    struct supervisor_handler_data *data = cbdata;
+
+    supervisor_handler_lock();
+    clean_waiter_del(data);
+    supervisor_handler_unlock();
+
+    data->exited = true;
+    clean_resources_submit(data);
+
+    return 0;
+}
+
+static bool clean_pidfd_readable(int pidfd)
+{
+    struct pollfd pfd = { 0 };
+
+    pfd.fd = pidfd;
+    pfd.events = POLLIN;
+
+    return poll(&pfd, 1, 0) > 0;
+}
+
+/* hand the killed processes which do not exit in time to gc, run by supervisor thread */
+static int clean_timer_cb(int fd, uint32_t events, void *cbdata, struct epoll_descr *descr)
+{
+    uint64_t expirations = 0;
+    int64_t now = 0;
+    struct linked_list expired;
+    struct linked_list *it = NULL;
+    struct linked_list *next = NULL;
+    struct supervisor_handler_data *data = NULL;
+
+    (void)util_read_nointr(fd, &expirations, sizeof(expirations));
+
+    linked_list_init(&expired);
+    now = supervisor_monotonic_nanos();
+
+    supervisor_handler_lock();
+    linked_list_for_each_safe(it, &g_clean_waiters, next) {
+        data = it->elem;
+        if (data->wait_deadline > now) {
+            continue;
         }
-    } else {
-        ret = kill(pid, SIGKILL);
-        if (ret < 0 && errno != ESRCH) {
-            ERROR("Can not kill process (pid=%d) with SIGKILL for container %s", pid, name);
+        /*
+         * process exited in time, its handler may be in the same batch of epoll events,
+         * so leave it to clean_pidfd_exit_cb instead of freeing the handler here.
+         */
+        if (clean_pidfd_readable(data->pidfd)) {
+            continue;
         }
+        clean_waiter_del(data);
+        linked_list_add_tail(&expired, &data->wait_node);
+    }
+    supervisor_handler_unlock();
 
-        if (retry_count < max_retry) {
-            usleep_nointerupt(100 * 1000); /* 100 millisecond */
-            retry_count++;
-            goto retry;
-        }
+    linked_list_for_each_safe(it, &expired, next) {
+        data = it->elem;
+        linked_list_del(it);
+        WARN("Process (pid=%d) of container %s does not exit after SIGKILL", data->pid_info.pid, data->name);
+        data->wait_timeout = true;
+        clean_resources_submit(data);
+    }
+
+    return 0;
+}
+
+/* kill the process and wait for its exit in supervisor epoll loop, so no worker is blocked */
+static int clean_wait_exit_by_pidfd(struct supervisor_handler_data *data)
+{
+    int ret = 0;
+    int pidfd = -1;
+    pid_t pid = data->pid_info.pid;
 
-        ret = gc_add_container(name, runtime, &data->pid_info);
-        if (ret != 0) {
-            ERROR("Failed to send container %s to garbage handler", name);
+    pidfd = (int)syscall(__NR_pidfd_open, pid, 0);
+    if (pidfd < 0) {
+        if (errno != ENOSYS && errno != ESRCH) {
+            WARN("Failed to open pidfd of process %d: %s", pid, strerror(errno));
         }
+        return -1;
     }
 
-    (void)isulad_monitor_send_container_event(name, STOPPED, (int)pid, data->exit_code, NULL, NULL);
+    /* make sure pidfd refers to the process of container, not a reused pid */
+    if (false == util_process_alive(pid, data->pid_info.start_time)) {
+        close(pidfd);
+        return -1;
+    }
 
-    supervisor_handler_data_free(data);
+    ret = kill(pid, SIGKILL);
+    if (ret < 0 && errno != ESRCH) {
+        ERROR("Can not kill process (pid=%d) with SIGKILL for container %s", pid, data->name);
+    }
 
-    DAEMON_CLEAR_ERRMSG();
-    return NULL;
+    data->pidfd = pidfd;
+    data->wait_deadline = supervisor_monotonic_nanos() + CLEAN_WAIT_EXIT_TIMEOUT;
+
+    supervisor_handler_lock();
+    if (epoll_loop_add_handler(&g_supervisor_descr, pidfd, clean_pidfd_exit_cb, data) != 0) {
+        supervisor_handler_unlock();
+        ERROR("Failed to add handler for pidfd of process %d", pid);
+        close(pidfd);
+        data->pidfd = -1;
+        return -1;
+    }
+    if (linked_list_empty(&g_clean_waiters)) {
+        clean_timer_set(true);
+    }
+    data->wait_node.elem = data;
+    linked_list_add_tail(&g_clean_waiters, &data->wait_node);
+    clean_stats_waiting(true);
+    supervisor_handler_unlock();
+
+    return 0;
 }
 
-/* new clean resources thread */
-int new_clean_resources_thread(struct supervisor_handler_data *data)
+/* clean resources job, run by cleanup workers */
+static void clean_resources_job(void *arg)
 {
-    int ret = 0;
-    pthread_t clean_thread;
+    struct supervisor_handler_data *data = arg;
 
-    if (pthread_create(&clean_thread, NULL, clean_resources_thread, data)) {
-        ERROR("Create clean resource thread failed");
-        supervisor_handler_data_free(data);
-        ret = -1;
+    clean_stats_queued(false);
+
+    if (data->wait_timeout) {
+        clean_resources_finish(data, true);
+        goto out;
     }
 
-    return ret;
+    /* zombie is still alive for util_process_alive, trust the exit notification */
+    if (data->exited || false == util_process_alive(data->pid_info.pid, data->pid_info.start_time)) {
+        clean_dead_container(data);
+        goto out;
+    }
+
+    if (clean_wait_exit_by_pidfd(data) == 0) {
+        goto out;
+    }
+
+    clean_resources_by_polling(data);
+
+out:
+    DAEMON_CLEAR_ERRMSG();
 }
 
 /* supervisor exit cb */
@@ -225,13 +503,14 @@ static int supervisor_exit_cb(int fd, uint32_t events, void *cbdata,
     }
 
     data->exit_code = exit_code;
+    data->exit_at = supervisor_monotonic_nanos();
 
     INFO("The container %s 's monitor on fd %d has exited", name, fd);
     supervisor_handler_lock();
     epoll_loop_del_handler(&g_supervisor_descr, fd);
     supervisor_handler_unlock();
 
-    (void)new_clean_resources_thread(data);
+    clean_resources_submit(data);
 
     return 0;
 }
@@ -261,6 +540,7 @@ int supervisor_add_exit_monitor(int fd, const container_pid_t *pid_info, const c
     }
 
     data->fd = fd;
+    data->pidfd = -1;
     data->name = util_strdup_s(name);
     data->runtime = util_strdup_s(runtime);
     data->pid_info.pid = pid_info->pid;
@@ -311,6 +591,39 @@ pexit:
     return NULL;
 }
 
+static int clean_workers_init()
+{
+    size_t workers = thread_pool_default_workers(0, CLEAN_MAX_WORKERS);
+
+    linked_list_init(&g_clean_waiters);
+
+    g_clean_timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (g_clean_timerfd < 0) {
+        ERROR("Failed to create cleanup timer: %s", strerror(errno));
+        return -1;
+    }
+
+    if (epoll_loop_add_handler(&g_supervisor_descr, g_clean_timerfd, clean_timer_cb, NULL) != 0) {
+        ERROR("Failed to add handler for cleanup timer");
+        goto err_out;
+    }
+
+    g_clean_workers = thread_pool_new("CleanWorker", workers);
+    if (g_clean_workers == NULL) {
+        ERROR("Failed to create cleanup workers");
+        (void)epoll_loop_del_handler(&g_supervisor_descr, g_clean_timerfd);
+        goto err_out;
+    }
+
+    INFO("Started %zu cleanup workers", workers);
+    return 0;
+
+err_out:
+    close(g_clean_timerfd);
+    g_clean_timerfd = -1;
+    return -1;
+}
+
 /* new supervisor */
 int new_supervisor()
 {
@@ -326,6 +639,12 @@ int new_supervisor()
         goto out;
     }
 
+    ret = clean_workers_init();
+    if (ret != 0) {
+        epoll_loop_close(&g_supervisor_descr);
+        goto out;
+    }
+
     if (pthread_create(&supervisor_thread, NULL, supervisor, NULL) != 0) {
         ERROR("Create supervisor thread failed");
         ret = -1;
@@ -334,4 +653,3 @@ int new_supervisor()
 out:
     return ret;
 }
-
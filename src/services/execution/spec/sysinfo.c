@@ -18,12 +18,17 @@
 #include <stdarg.h>
 #include <limits.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
 
 #include "error.h"
 #include "libisulad.h"
 #include "sysinfo.h"
 #include "log.h"
 #include "read_file.h"
+#include "util_atomic.h"
 
 // Cgroup Item Definition
 #define CGROUP_BLKIO_WEIGHT "blkio.weight"
@@ -1330,3 +1335,224 @@ free_out:
     return minfos;
 }
 
+
+#define CPUS_ONLINE_FILE "/sys/devices/system/cpu/online"
+#define MEMS_ONLINE_FILE "/sys/devices/system/node/online"
+
+typedef struct {
+    /* must be the first member, callers only see this */
+    sysinfo_t info;
+    uint64_t refcnt;
+    /* hash of cgroup lines of mountinfo, when the snapshot was taken */
+    uint64_t cgroup_mounts_hash;
+    char *cpus_online;
+    char *mems_online;
+} sysinfo_snapshot_t;
+
+static pthread_mutex_t g_sysinfo_snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
+static sysinfo_snapshot_t *g_sysinfo_snapshot = NULL;
+/* polled to know whether the mount table has changed */
+static int g_mountinfo_fd = -1;
+
+static void sysinfo_snapshot_unref(sysinfo_snapshot_t *snapshot)
+{
+    if (snapshot == NULL) {
+        return;
+    }
+
+    if (!atomic_int_dec_test(&snapshot->refcnt)) {
+        return;
+    }
+
+    free(snapshot->info.cpusetinfo.cpus);
+    free(snapshot->info.cpusetinfo.mems);
+    free(snapshot->cpus_online);
+    free(snapshot->mems_online);
+    free(snapshot);
+}
+
+static char *read_online_list(const char *fname)
+{
+    char *content = NULL;
+
+    if (!util_file_exists(fname)) {
+        return NULL;
+    }
+
+    content = util_read_text_file(fname);
+    if (content != NULL) {
+        util_trim_newline(content);
+    }
+
+    return content;
+}
+
+static inline bool online_list_equal(const char *a, const char *b)
+{
+    if (a == NULL || b == NULL) {
+        return a == b;
+    }
+    return strcmp(a, b) == 0;
+}
+
+/* hugetlb and other controllers only change with cgroup mounts, so hash cgroup mounts only */
+static int hash_cgroup_mounts(uint64_t *hash)
+{
+    FILE *fp = NULL;
+    size_t length = 0;
+    char *pline = NULL;
+    const char *p = NULL;
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    fp = util_fopen("/proc/self/mountinfo", "r");
+    if (fp == NULL) {
+        ERROR("Failed to open \"/proc/self/mountinfo\"");
+        return -1;
+    }
+
+    while (getline(&pline, &length, fp) != -1) {
+        if (strstr(pline, " - cgroup ") == NULL && strstr(pline, " - cgroup2 ") == NULL) {
+            continue;
+        }
+        for (p = pline; *p != '\0'; p++) {
+            h ^= (unsigned char)*p;
+            h *= 0x100000001b3ULL;
+        }
+    }
+
+    fclose(fp);
+    free(pline);
+    *hash = h;
+    return 0;
+}
+
+static bool mount_table_changed(void)
+{
+    struct pollfd pfd = { 0 };
+
+    if (g_mountinfo_fd < 0) {
+        g_mountinfo_fd = util_open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC, 0);
+        /* can not watch the mount table, always check the cgroup mounts */
+        return true;
+    }
+
+    pfd.fd = g_mountinfo_fd;
+    pfd.events = POLLPRI;
+    if (poll(&pfd, 1, 0) < 0) {
+        return true;
+    }
+
+    /* the kernel reports POLLERR | POLLPRI once for every change of the mount table */
+    return (pfd.revents & (POLLERR | POLLPRI)) != 0;
+}
+
+/* must be called with g_sysinfo_snapshot_lock held */
+static bool sysinfo_snapshot_is_fresh(const sysinfo_snapshot_t *snapshot, const char *cpus_online,
+                                      const char *mems_online)
+{
+    uint64_t hash = 0;
+
+    if (snapshot == NULL) {
+        return false;
+    }
+
+    if (!online_list_equal(snapshot->cpus_online, cpus_online) ||
+        !online_list_equal(snapshot->mems_online, mems_online)) {
+        return false;
+    }
+
+    /* containers mount and umount all the time, only cgroup mounts matter */
+    if (mount_table_changed()) {
+        if (hash_cgroup_mounts(&hash) != 0 || hash != snapshot->cgroup_mounts_hash) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static sysinfo_snapshot_t *sysinfo_snapshot_new(char *cpus_online, char *mems_online)
+{
+    sysinfo_t *sysinfo = NULL;
+    sysinfo_snapshot_t *snapshot = NULL;
+
+    snapshot = util_common_calloc_s(sizeof(sysinfo_snapshot_t));
+    if (snapshot == NULL) {
+        ERROR("Out of memory");
+        return NULL;
+    }
+
+    /* take the hash first, a change during the build will be found next time */
+    (void)mount_table_changed();
+    if (hash_cgroup_mounts(&snapshot->cgroup_mounts_hash) != 0) {
+        free(snapshot);
+        return NULL;
+    }
+
+    sysinfo = get_sys_info(true);
+    if (sysinfo == NULL) {
+        free(snapshot);
+        return NULL;
+    }
+
+    /* move content of sysinfo into snapshot */
+    snapshot->info = *sysinfo;
+    free(sysinfo);
+    snapshot->cpus_online = cpus_online;
+    snapshot->mems_online = mems_online;
+    /* reference of g_sysinfo_snapshot */
+    atomic_int_set(&snapshot->refcnt, 1);
+
+    return snapshot;
+}
+
+const sysinfo_t *get_shared_sys_info(void)
+{
+    char *cpus_online = NULL;
+    char *mems_online = NULL;
+    sysinfo_snapshot_t *snapshot = NULL;
+
+    cpus_online = read_online_list(CPUS_ONLINE_FILE);
+    mems_online = read_online_list(MEMS_ONLINE_FILE);
+
+    if (pthread_mutex_lock(&g_sysinfo_snapshot_lock) != 0) {
+        ERROR("Failed to lock sysinfo snapshot");
+        free(cpus_online);
+        free(mems_online);
+        return NULL;
+    }
+
+    if (!sysinfo_snapshot_is_fresh(g_sysinfo_snapshot, cpus_online, mems_online)) {
+        snapshot = sysinfo_snapshot_new(cpus_online, mems_online);
+        cpus_online = NULL;
+        mems_online = NULL;
+        if (snapshot == NULL) {
+            ERROR("Failed to get system info");
+            goto unlock;
+        }
+        if (g_sysinfo_snapshot != NULL) {
+            DEBUG("Host cgroup mounts or online cpus/mems changed, sysinfo rebuilt");
+        }
+        /* old snapshot is freed when its last user puts it */
+        sysinfo_snapshot_unref(g_sysinfo_snapshot);
+        g_sysinfo_snapshot = snapshot;
+    }
+
+    snapshot = g_sysinfo_snapshot;
+    atomic_int_inc(&snapshot->refcnt);
+
+unlock:
+    (void)pthread_mutex_unlock(&g_sysinfo_snapshot_lock);
+    free(cpus_online);
+    free(mems_online);
+    return snapshot != NULL ? &snapshot->info : NULL;
+}
+
+void put_shared_sys_info(const sysinfo_t *sysinfo)
+{
+    if (sysinfo == NULL) {
+        return;
+    }
+
+    sysinfo_snapshot_unref((sysinfo_snapshot_t *)sysinfo);
+}
@@ -138,6 +138,15 @@ mountinfo_t *find_mount_info(mountinfo_t **minfos, const char *dir);
 
 void free_mounts_info(mountinfo_t **minfos);
 
+/*
+ * Daemon wide sysinfo shared by all callers. It is rebuilt only when the
+ * cgroup mounts or the online cpus/mems of host change, so do not modify
+ * it, and release it by put_shared_sys_info instead of free_sysinfo.
+ */
+const sysinfo_t *get_shared_sys_info(void);
+
+void put_shared_sys_info(const sysinfo_t *sysinfo);
+
 #ifdef __cplusplus
 }
 #endif
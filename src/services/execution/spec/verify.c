@@ -1526,9 +1526,9 @@ out:
 int verify_container_settings(const oci_runtime_spec *container)
 {
     int ret = 0;
-    sysinfo_t *sysinfo = NULL;
+    const sysinfo_t *sysinfo = NULL;
 
-    sysinfo = get_sys_info(true);
+    sysinfo = get_shared_sys_info();
     if (sysinfo == NULL) {
         ERROR("Can not get system info");
         ret = -1;
@@ -1562,7 +1562,7 @@ int verify_container_settings(const oci_runtime_spec *container)
     }
 
 out:
-    free_sysinfo(sysinfo);
+    put_shared_sys_info(sysinfo);
     return ret;
 }
 
@@ -1833,9 +1833,9 @@ static int host_config_settings_restart_policy(const host_config *hostconfig)
 static int host_config_settings_with_sysinfo(host_config *hostconfig, bool update)
 {
     int ret = 0;
-    sysinfo_t *sysinfo = NULL;
+    const sysinfo_t *sysinfo = NULL;
 
-    sysinfo = get_sys_info(true);
+    sysinfo = get_shared_sys_info();
     if (sysinfo == NULL) {
         ERROR("Can not get system info");
         return -1;
@@ -1875,7 +1875,7 @@ static int host_config_settings_with_sysinfo(host_config *hostconfig, bool updat
     }
 
 out:
-    free_sysinfo(sysinfo);
+    put_shared_sys_info(sysinfo);
     return ret;
 }
 
@@ -16,238 +16,526 @@
 #define _GNU_SOURCE             /* See feature_test_macros(7) */
 #include <fcntl.h>              /* Obtain O_* constant definitions */
 #include <unistd.h>
-#include <stdalign.h>
 #include <stdint.h>
 #include <stdlib.h>
-#include <ctype.h>
 #include <string.h>
 #include <errno.h>
-#include <sys/wait.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
 
 #include "sha256.h"
 #include "log.h"
 #include "utils.h"
 
-#define BLKSIZE 32768
+#define BLKSIZE (128 * 1024)
+
+static const uint32_t g_sha256_k[64] __attribute__((aligned(16))) = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint32_t g_sha256_init_state[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+#define ROTR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define CH(x, y, z) (((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x, y, z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define BSIG0(x) (ROTR32(x, 2) ^ ROTR32(x, 13) ^ ROTR32(x, 22))
+#define BSIG1(x) (ROTR32(x, 6) ^ ROTR32(x, 11) ^ ROTR32(x, 25))
+#define SSIG0(x) (ROTR32(x, 7) ^ ROTR32(x, 18) ^ ((x) >> 3))
+#define SSIG1(x) (ROTR32(x, 17) ^ ROTR32(x, 19) ^ ((x) >> 10))
+
+static inline uint32_t load_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
 
-static bool stream_check_eof(void *stream, bool isgzip)
+static inline void store_be32(uint8_t *p, uint32_t v)
 {
-    if (isgzip) {
-        if (gzeof(stream)) {
-            return true;
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static void sha256_blocks_generic(uint32_t *state, const uint8_t *data, size_t blocks)
+{
+    uint32_t w[64];
+    uint32_t a, b, c, d, e, f, g, h, t1, t2;
+    int i;
+
+    while (blocks-- > 0) {
+        for (i = 0; i < 16; i++) {
+            w[i] = load_be32(data + i * 4);
         }
-    } else {
-        if (feof(stream)) {
-            return true;
+        for (i = 16; i < 64; i++) {
+            w[i] = SSIG1(w[i - 2]) + w[i - 7] + SSIG0(w[i - 15]) + w[i - 16];
+        }
+
+        a = state[0];
+        b = state[1];
+        c = state[2];
+        d = state[3];
+        e = state[4];
+        f = state[5];
+        g = state[6];
+        h = state[7];
+
+        for (i = 0; i < 64; i++) {
+            t1 = h + BSIG1(e) + CH(e, f, g) + g_sha256_k[i] + w[i];
+            t2 = BSIG0(a) + MAJ(a, b, c);
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
         }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+
+        data += SHA256_BLOCK_BYTES;
     }
-    return false;
 }
 
-static bool stream_check_error(void *stream, bool isgzip)
+#if defined(__x86_64__)
+/*
+ * SHA extensions, 4 rounds per group g, the message schedule of next groups
+ * is done by sha256msg1/sha256msg2 in w[], which holds 16 words of schedule.
+ */
+#define SHANI_GROUP(g)                                                                               \
+    do {                                                                                             \
+        if ((g) < 4) {                                                                               \
+            w[g] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + (g) * 16)), mask);      \
+        }                                                                                            \
+        msg = _mm_add_epi32(w[(g) & 3], _mm_load_si128((const __m128i *)&g_sha256_k[(g) * 4]));      \
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);                                         \
+        if ((g) >= 3 && (g) <= 14) {                                                                 \
+            tmp = _mm_alignr_epi8(w[(g) & 3], w[((g) + 3) & 3], 4);                                  \
+            w[((g) + 1) & 3] = _mm_add_epi32(w[((g) + 1) & 3], tmp);                                 \
+            w[((g) + 1) & 3] = _mm_sha256msg2_epu32(w[((g) + 1) & 3], w[(g) & 3]);                   \
+        }                                                                                            \
+        msg = _mm_shuffle_epi32(msg, 0x0E);                                                          \
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);                                         \
+        if ((g) >= 1 && (g) <= 12) {                                                                 \
+            w[((g) + 3) & 3] = _mm_sha256msg1_epu32(w[((g) + 3) & 3], w[(g) & 3]);                   \
+        }                                                                                            \
+    } while (0)
+
+__attribute__((target("sha,sse4.1")))
+static void sha256_blocks_shani(uint32_t *state, const uint8_t *data, size_t blocks)
 {
-    const char *gzerr = NULL;
-    if (isgzip) {
-        int errnum;
-        gzerr = gzerror(stream, &errnum);
-    } else if (ferror(stream)) {
-        return true;
+    __m128i state0, state1, msg, tmp, abef_save, cdgh_save;
+    __m128i w[4];
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    tmp = _mm_loadu_si128((const __m128i *)&state[0]);
+    state1 = _mm_loadu_si128((const __m128i *)&state[4]);
+    /* CDAB and EFGH to ABEF and CDGH */
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);
+    state1 = _mm_shuffle_epi32(state1, 0x1B);
+    state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    while (blocks-- > 0) {
+        abef_save = state0;
+        cdgh_save = state1;
+
+        /* unrolled, so indexes of w[] are constants and it lives in registers */
+        SHANI_GROUP(0);
+        SHANI_GROUP(1);
+        SHANI_GROUP(2);
+        SHANI_GROUP(3);
+        SHANI_GROUP(4);
+        SHANI_GROUP(5);
+        SHANI_GROUP(6);
+        SHANI_GROUP(7);
+        SHANI_GROUP(8);
+        SHANI_GROUP(9);
+        SHANI_GROUP(10);
+        SHANI_GROUP(11);
+        SHANI_GROUP(12);
+        SHANI_GROUP(13);
+        SHANI_GROUP(14);
+        SHANI_GROUP(15);
+
+        state0 = _mm_add_epi32(state0, abef_save);
+        state1 = _mm_add_epi32(state1, cdgh_save);
+        data += SHA256_BLOCK_BYTES;
+    }
+
+    /* ABEF and CDGH back to DCBA and HGFE */
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+
+    _mm_storeu_si128((__m128i *)&state[0], state0);
+    _mm_storeu_si128((__m128i *)&state[4], state1);
+}
+
+static bool cpu_has_sha_ni(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0) {
+        return false;
     }
-    if (gzerr != NULL && strcmp(gzerr, "") != 0) {
-        return true;
+    /* SSSE3 and SSE4.1 */
+    if ((ecx & (1U << 9)) == 0 || (ecx & (1U << 19)) == 0) {
+        return false;
     }
-    return false;
+
+    if (__get_cpuid_max(0, NULL) < 7) {
+        return false;
+    }
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    /* SHA */
+    return (ebx & (1U << 29)) != 0;
 }
+#endif
+
+static sha256_blocks_func g_sha256_blocks = sha256_blocks_generic;
+static const char *g_sha256_impl = "generic";
+static pthread_once_t g_sha256_once = PTHREAD_ONCE_INIT;
 
-int stream_read(void *stream, int fd, bool isgzip)
+static void sha256_dispatch(void)
 {
-    size_t n = 0;
+#if defined(__x86_64__)
+    if (cpu_has_sha_ni()) {
+        g_sha256_blocks = sha256_blocks_shani;
+        g_sha256_impl = "sha-ni";
+    }
+#endif
+}
+
+const char *sha256_implementation(void)
+{
+    (void)pthread_once(&g_sha256_once, sha256_dispatch);
+    return g_sha256_impl;
+}
+
+static void sha256_init_with(sha256_context *ctx, sha256_blocks_func blocks)
+{
+    (void)memcpy(ctx->state, g_sha256_init_state, sizeof(ctx->state));
+    ctx->total = 0;
+    ctx->buf_len = 0;
+    ctx->blocks = blocks;
+}
+
+void sha256_init(sha256_context *ctx)
+{
+    (void)pthread_once(&g_sha256_once, sha256_dispatch);
+    sha256_init_with(ctx, g_sha256_blocks);
+}
+
+void sha256_init_generic(sha256_context *ctx)
+{
+    sha256_init_with(ctx, sha256_blocks_generic);
+}
+
+void sha256_update(sha256_context *ctx, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    size_t fill = 0;
+    size_t blocks = 0;
+
+    if (len == 0) {
+        return;
+    }
+    ctx->total += len;
+
+    if (ctx->buf_len > 0) {
+        fill = SHA256_BLOCK_BYTES - ctx->buf_len;
+        if (len < fill) {
+            (void)memcpy(ctx->buf + ctx->buf_len, p, len);
+            ctx->buf_len += len;
+            return;
+        }
+        (void)memcpy(ctx->buf + ctx->buf_len, p, fill);
+        ctx->blocks(ctx->state, ctx->buf, 1);
+        ctx->buf_len = 0;
+        p += fill;
+        len -= fill;
+    }
+
+    /* full blocks are compressed directly from input, without copy */
+    blocks = len / SHA256_BLOCK_BYTES;
+    if (blocks > 0) {
+        ctx->blocks(ctx->state, p, blocks);
+        p += blocks * SHA256_BLOCK_BYTES;
+        len -= blocks * SHA256_BLOCK_BYTES;
+    }
+
+    if (len > 0) {
+        (void)memcpy(ctx->buf, p, len);
+        ctx->buf_len = len;
+    }
+}
+
+void sha256_final(sha256_context *ctx, uint8_t digest[SHA256_DIGEST_BYTES])
+{
+    uint64_t bits = ctx->total * 8;
+    int i;
+
+    ctx->buf[ctx->buf_len++] = 0x80;
+    if (ctx->buf_len > SHA256_BLOCK_BYTES - 8) {
+        (void)memset(ctx->buf + ctx->buf_len, 0, SHA256_BLOCK_BYTES - ctx->buf_len);
+        ctx->blocks(ctx->state, ctx->buf, 1);
+        ctx->buf_len = 0;
+    }
+    (void)memset(ctx->buf + ctx->buf_len, 0, SHA256_BLOCK_BYTES - 8 - ctx->buf_len);
+    store_be32(ctx->buf + SHA256_BLOCK_BYTES - 8, (uint32_t)(bits >> 32));
+    store_be32(ctx->buf + SHA256_BLOCK_BYTES - 4, (uint32_t)bits);
+    ctx->blocks(ctx->state, ctx->buf, 1);
+    ctx->buf_len = 0;
+
+    for (i = 0; i < 8; i++) {
+        store_be32(digest + i * 4, ctx->state[i]);
+    }
+}
+
+void sha256_final_hex(sha256_context *ctx, char *out)
+{
+    static const char hex[] = "0123456789abcdef";
+    uint8_t digest[SHA256_DIGEST_BYTES] = { 0 };
+    int i;
+
+    sha256_final(ctx, digest);
+
+    /* translate from binary to hex string */
+    for (i = 0; i < SHA256_DIGEST_BYTES; i++) {
+        out[i * 2] = hex[digest[i] >> 4];
+        out[i * 2 + 1] = hex[digest[i] & 0x0f];
+    }
+    out[SHA256_SIZE] = '\0';
+}
+
+int sha256_update_fd(sha256_context *ctx, int fd)
+{
+    int ret = 0;
+    ssize_t n = 0;
     char *buffer = NULL;
 
-    buffer = util_common_calloc_s(BLKSIZE + 72);
+    buffer = util_common_calloc_s(BLKSIZE);
     if (buffer == NULL) {
         ERROR("Malloc BLKSIZE memory error");
         return -1;
     }
 
-    /* Read block.  Take care for partial reads. */
-    while (1) {
-        if (isgzip) {
-            n = (size_t)gzread((gzFile)stream, buffer, BLKSIZE);
-        } else {
-            n = fread(buffer, 1, BLKSIZE, (FILE *)stream);
-        }
-
-        if (n == BLKSIZE) {
-            if (write(fd, buffer, BLKSIZE) == -1) {
-                ERROR("Write pipe failed: %s", strerror(errno));
-                goto free_out;
-            }
-            n = 0;
-            continue;
+    for (;;) {
+        n = util_read_nointr(fd, buffer, BLKSIZE);
+        if (n < 0) {
+            ERROR("Read fd failed: %s", strerror(errno));
+            ret = -1;
+            break;
         }
-
         if (n == 0) {
-            if (stream_check_error(stream, isgzip)) {
-                goto free_out;
-            }
-            goto end_send;
+            break;
         }
+        sha256_update(ctx, buffer, (size_t)n);
+    }
 
-        if (stream_check_eof(stream, isgzip)) {
-            goto end_send;
-        }
+    free(buffer);
+    return ret;
+}
+
+int sha256_update_gz(sha256_context *ctx, gzFile gzstream)
+{
+    int ret = 0;
+    int n = 0;
+    int errnum = 0;
+    char *buffer = NULL;
+
+    buffer = util_common_calloc_s(BLKSIZE);
+    if (buffer == NULL) {
+        ERROR("Malloc BLKSIZE memory error");
+        return -1;
     }
 
-end_send:
-    /* Process any remaining bytes. */
-    if (n > 0) {
-        if (write(fd, buffer, n) == -1) {
-            ERROR("Write pipe_for_write failed: %s", strerror(errno));
-            goto free_out;
+    for (;;) {
+        n = gzread(gzstream, buffer, BLKSIZE);
+        if (n < 0) {
+            ERROR("Read gzip stream failed: %s", gzerror(gzstream, &errnum));
+            ret = -1;
+            break;
         }
+        if (n == 0) {
+            break;
+        }
+        sha256_update(ctx, buffer, (size_t)n);
     }
-    free(buffer);
-    return 0;
 
-free_out:
     free(buffer);
-    return -1;
+    return ret;
 }
 
-static int sha256sum_calculate_parent_handle(pid_t pid, int pipe_for_read[], int pipe_for_write[], bool isfile,
-                                             bool isgzip, void *stream, char *buffer_out, size_t len)
+int sha256_update_stream(sha256_context *ctx, FILE *stream)
 {
-    ssize_t size_pipe_read;
-
-    close(pipe_for_read[1]);
-    pipe_for_read[1] = -1;
-    close(pipe_for_write[0]);
-    pipe_for_write[0] = -1;
-
-    if (isfile) {
-        int ret = stream_read((gzFile)stream, pipe_for_write[1], isgzip);
-        if (ret != 0) {
-            close(pipe_for_read[0]);
-            pipe_for_read[0] = -1;
-            close(pipe_for_write[1]);
-            pipe_for_write[1] = -1;
-            ERROR("Read buffer error");
-            return -1;
-        }
-    } else if (write(pipe_for_write[1], (char *)stream, len) == -1) {
-        close(pipe_for_read[0]);
-        pipe_for_read[0] = -1;
-        close(pipe_for_write[1]);
-        pipe_for_write[1] = -1;
-        ERROR("Write pipe_for_write failed: %s", strerror(errno));
+    int ret = 0;
+    size_t n = 0;
+    char *buffer = NULL;
+
+    buffer = util_common_calloc_s(BLKSIZE);
+    if (buffer == NULL) {
+        ERROR("Malloc BLKSIZE memory error");
         return -1;
     }
 
-    close(pipe_for_write[1]);
-    pipe_for_write[1] = -1;
-    if (wait_for_pid(pid)) {
-        char buffer_errmsg[BUFSIZ] = { 0 };
-        size_t size_read = (size_t)read(pipe_for_read[0], buffer_errmsg, BUFSIZ);
-        if (size_read != 0) {
-            ERROR("Sha256sum run error: %s", buffer_errmsg);
+    for (;;) {
+        n = fread(buffer, 1, BLKSIZE, stream);
+        if (n > 0) {
+            sha256_update(ctx, buffer, n);
+        }
+        if (n < BLKSIZE) {
+            if (ferror(stream)) {
+                ERROR("Read file stream failed");
+                ret = -1;
+            }
+            break;
         }
-        close(pipe_for_read[0]);
-        pipe_for_read[0] = -1;
-        return -1;
     }
 
-    size_pipe_read = read(pipe_for_read[0], buffer_out, SHA256_SIZE);
-    close(pipe_for_read[0]);
-    pipe_for_read[0] = -1;
-    if (size_pipe_read <= 0) {
-        ERROR("Read sha256 buffer failed");
-        return -1;
-    }
-    buffer_out[SHA256_SIZE] = '\0';
-    return 0;
+    free(buffer);
+    return ret;
 }
 
-int sha256sum_calculate(void *stream, char *buffer_out, size_t len, bool isfile,
-                        bool isgzip)
+int sha256_update_file(sha256_context *ctx, const char *path)
 {
     int ret = 0;
-    pid_t pid;
-    int pipe_for_read[2] = { -1, -1 };
-    int pipe_for_write[2] = { -1, -1 };
+    int fd = -1;
+    void *addr = MAP_FAILED;
+    struct stat st;
 
-    if (!stream || !buffer_out) {
-        ERROR("Param Error");
-        ret = -1;
-        goto out;
-    }
-    if (pipe2(pipe_for_read, O_CLOEXEC) != 0) {
-        ERROR("Failed to create pipe");
-        ret = -1;
-        goto out;
+    fd = util_open(path, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        ERROR("Open file %s failed: %s", path, strerror(errno));
+        return -1;
     }
 
-    if (pipe2(pipe_for_write, O_CLOEXEC) != 0) {
-        ERROR("Failed to create pipe");
+    if (fstat(fd, &st) != 0) {
+        ERROR("Stat file %s failed: %s", path, strerror(errno));
         ret = -1;
         goto out;
     }
 
-    pid = fork();
-    if (pid == (pid_t) - 1) {
-        ERROR("Failed to fork()");
-        ret = -1;
-        close(pipe_for_read[0]);
-        close(pipe_for_read[1]);
-        close(pipe_for_write[0]);
-        close(pipe_for_write[1]);
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+        addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    if (addr == MAP_FAILED) {
+        ret = sha256_update_fd(ctx, fd);
         goto out;
     }
 
-    if (pid == (pid_t)0) {
-        // child process, dup2 pipe_for_read[1] to stdout,
-        // pipe_for_write[1] to stdin
-        close(pipe_for_read[0]);
-        close(pipe_for_write[1]);
-        if (dup2(pipe_for_read[1], 1) < 0) {
-            fprintf(stdout, "Dup fd error: %s", strerror(errno));
-            exit(EXIT_FAILURE);
-        }
-        if (dup2(pipe_for_write[0], 0)) {
-            fprintf(stdout, "Dup fd error: %s", strerror(errno));
-            exit(EXIT_FAILURE);
-        }
+    (void)madvise(addr, (size_t)st.st_size, MADV_SEQUENTIAL);
+    sha256_update(ctx, addr, (size_t)st.st_size);
+    (void)munmap(addr, (size_t)st.st_size);
 
-        if (util_check_inherited(true, -1)) {
-            fprintf(stdout, "Failed to close fds.");
-            exit(EXIT_FAILURE);
-        }
-        execlp("sha256sum", "sha256sum", NULL);
+out:
+    close(fd);
+    return ret;
+}
+
+int sha256sum_calculate(void *stream, char *buffer_out, size_t len, bool isfile,
+                        bool isgzip)
+{
+    int ret = 0;
+    sha256_context ctx;
 
-        fprintf(stdout, "Failed to exec sha256sum program");
-        exit(EXIT_FAILURE);
+    if (!stream || !buffer_out) {
+        ERROR("Param Error");
+        return -1;
     }
 
-    ret = sha256sum_calculate_parent_handle(pid, pipe_for_read, pipe_for_write,
-                                            isfile, isgzip, stream, buffer_out, len);
+    sha256_init(&ctx);
 
-out:
-    return ret;
+    if (!isfile) {
+        sha256_update(&ctx, stream, len);
+    } else if (isgzip) {
+        ret = sha256_update_gz(&ctx, (gzFile)stream);
+    } else {
+        ret = sha256_update_stream(&ctx, (FILE *)stream);
+    }
+    if (ret != 0) {
+        ERROR("Read buffer error");
+        return -1;
+    }
+
+    sha256_final_hex(&ctx, buffer_out);
+    return 0;
 }
 
 char *sha256_digest(void *stream, bool isgzip)
 {
     int ret = 0;
-    int cnt;
-    char buffer_out[SHA256_SIZE + 1];
     char *digest = NULL;
 
     if (stream == NULL) {
         return NULL;
     }
 
-    ret = sha256sum_calculate(stream, buffer_out, 0, true, isgzip);
+    digest = (char *)util_common_calloc_s(SHA256_SIZE + 1);
+    if (digest == NULL) {
+        return NULL;
+    }
+
+    ret = sha256sum_calculate(stream, digest, 0, true, isgzip);
     if (ret != 0) {
+        free(digest);
+        return NULL;
+    }
+
+    return digest;
+}
+
+char *sha256_digest_file(const char *filename, bool isgzip)
+{
+    int ret = 0;
+    gzFile gzstream = NULL;
+    char *digest = NULL;
+    sha256_context ctx;
+
+    if (filename == NULL) {
+        return NULL;
+    }
+
+    sha256_init(&ctx);
+
+    if (isgzip) {
+        gzstream = gzopen(filename, "rb");
+        if (gzstream == NULL) {
+            ERROR("Open gzip file %s failed: %s", filename, strerror(errno));
+            return NULL;
+        }
+        ret = sha256_update_gz(&ctx, gzstream);
+        gzclose(gzstream);
+    } else {
+        ret = sha256_update_file(&ctx, filename);
+    }
+    if (ret != 0) {
+        ERROR("Calc sha256 digest of file %s failed", filename);
         return NULL;
     }
 
@@ -255,12 +543,7 @@ char *sha256_digest(void *stream, bool isgzip)
     if (digest == NULL) {
         return NULL;
     }
-    digest[SHA256_SIZE] = 0;
 
-    /* translate from binary to hex string */
-    for (cnt = 0; cnt < SHA256_SIZE; ++cnt) {
-        digest[cnt] = buffer_out[cnt];
-    }
+    sha256_final_hex(&ctx, digest);
     return digest;
 }
-
@@ -28,12 +28,45 @@ enum { SHA224_SIZE = 224 / 8 };
 enum { SHA224_ALIGN = 4 };
 enum { SHA256_SIZE = 256 / 4 };
 enum { SHA256_ALIGN = 4 };
+enum { SHA256_DIGEST_BYTES = 256 / 8 };
+enum { SHA256_BLOCK_BYTES = 64 };
 
-/* read file stream buffer */
-extern int fstream_read(FILE *stream, int fd);
+typedef void (*sha256_blocks_func)(uint32_t *state, const uint8_t *data, size_t blocks);
 
-/* read gzfile stream buffer.  */
-extern int gzstream_read(gzFile gzstream, int fd);
+typedef struct {
+    uint32_t state[8];
+    uint64_t total;
+    uint8_t buf[SHA256_BLOCK_BYTES];
+    size_t buf_len;
+    /* compress function chosen by cpu features */
+    sha256_blocks_func blocks;
+} sha256_context;
+
+/* init context with the fastest implementation this cpu supports */
+void sha256_init(sha256_context *ctx);
+
+/* init context with the portable implementation, to check the accelerated ones against it */
+void sha256_init_generic(sha256_context *ctx);
+
+/* name of implementation sha256_init chooses */
+const char *sha256_implementation(void);
+
+void sha256_update(sha256_context *ctx, const void *data, size_t len);
+
+void sha256_final(sha256_context *ctx, uint8_t digest[SHA256_DIGEST_BYTES]);
+
+/* final digest as 64 characters hex string, out must have SHA256_SIZE + 1 bytes */
+void sha256_final_hex(sha256_context *ctx, char *out);
+
+/* feed all bytes read from fd, gzfile or file stream until eof */
+int sha256_update_fd(sha256_context *ctx, int fd);
+
+int sha256_update_gz(sha256_context *ctx, gzFile gzstream);
+
+int sha256_update_stream(sha256_context *ctx, FILE *stream);
+
+/* feed a regular file by mmap, fallback to read if it can not be mapped */
+int sha256_update_file(sha256_context *ctx, const char *path);
 
 extern int sha256sum_calculate(void *stream, char *buffer_out, size_t len,
                                bool isfile,
@@ -42,6 +75,9 @@ extern int sha256sum_calculate(void *stream, char *buffer_out, size_t len,
    The result is a 64 characters string without prefix "sha256:"  */
 char *sha256_digest(void *stream, bool isgzip);
 
+/* Compute SHA256 message digest of file, gunzip it first if isgzip.
+   The result is a 64 characters string without prefix "sha256:"  */
+char *sha256_digest_file(const char *filename, bool isgzip);
 
 # ifdef __cplusplus
 }
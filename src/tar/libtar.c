@@ -20,26 +20,20 @@
 #include <string.h>
 #include "stdbool.h"
 #include <sys/types.h>
-#include <sys/wait.h>
 #include <libgen.h>
 #include <limits.h>
-#include <signal.h>
+#include <pthread.h>
 #include <sys/stat.h>
+#include <zlib.h>
 
 #include "libtar.h"
+#include "tar_stream.h"
 #include "utils.h"
 #include "path.h"
 #include "log.h"
 #include "error.h"
-#include "json_common.h"
 
-#define TAR_MAX_OPTS 50
-#define TAR_CMD "tar"
-#define TAR_TRANSFORM_OPT "--transform"
-#define TAR_CREATE_OPT "-c"
-#define TAR_EXACT_OPT "-x"
-#define TAR_CHDIR_OPT "-C"
-#define TAR_GZIP_OPT "-z"
+#define GZIP_BUF_SIZE (128 * 1024)
 
 static void set_char_to_separator(char *p)
 {
@@ -58,16 +52,70 @@ void free_archive_copy_info(struct archive_copy_info *info)
     free(info);
 }
 
+static int gzip_to_file(int srcfd, const char *dstpath, mode_t mode)
+{
+    int ret = -1;
+    int fd = -1;
+    ssize_t size_read;
+    char *buf = NULL;
+    gzFile stream = NULL;
+
+    buf = util_common_calloc_s(GZIP_BUF_SIZE);
+    if (buf == NULL) {
+        ERROR("Out of memory");
+        return -1;
+    }
+
+    fd = util_open(dstpath, O_WRONLY | O_CREAT | O_TRUNC, mode);
+    if (fd < 0) {
+        ERROR("Failed to create %s: %s", dstpath, strerror(errno));
+        goto out;
+    }
+    stream = gzdopen(fd, "wb");
+    if (stream == NULL) {
+        ERROR("Failed to open gzip stream of %s", dstpath);
+        close(fd);
+        goto out;
+    }
+
+    for (;;) {
+        size_read = util_read_nointr(srcfd, buf, GZIP_BUF_SIZE);
+        if (size_read < 0) {
+            ERROR("Failed to read file: %s", strerror(errno));
+            goto out;
+        }
+        if (size_read == 0) {
+            break;
+        }
+        if (gzwrite(stream, buf, (unsigned int)size_read) != (int)size_read) {
+            ERROR("Failed to write %s", dstpath);
+            goto out;
+        }
+    }
+    ret = 0;
+
+out:
+    if (stream != NULL && gzclose(stream) != Z_OK) {
+        ERROR("Failed to close %s", dstpath);
+        ret = -1;
+    }
+    free(buf);
+    return ret;
+}
+
 /*
- * compress file.
+ * compress file to filename.gz and remove it, as "gzip -f" does.
  * param filename:      archive file to compres.
  * return:              zero if compress success, non-zero if not.
  */
 int gzip(const char *filename, size_t len)
 {
-    int pipefd[2] = { -1, -1 };
-    int status = 0;
-    pid_t pid = 0;
+    int ret = -1;
+    int nret;
+    int srcfd = -1;
+    struct stat st;
+    char gz_path[PATH_MAX] = { 0 };
+    char tmp_path[PATH_MAX] = { 0 };
 
     if (filename == NULL) {
         return -1;
@@ -76,157 +124,126 @@ int gzip(const char *filename, size_t len)
         return -1;
     }
 
-    if (pipe2(pipefd, O_CLOEXEC) != 0) {
-        ERROR("Failed to create pipe\n");
+    nret = snprintf(gz_path, sizeof(gz_path), "%s.gz", filename);
+    if (nret < 0 || (size_t)nret >= sizeof(gz_path)) {
+        ERROR("Path is too long");
         return -1;
     }
-
-    pid = fork();
-    if (pid == -1) {
-        ERROR("Failed to fork()\n");
-        close(pipefd[0]);
-        close(pipefd[1]);
+    nret = snprintf(tmp_path, sizeof(tmp_path), "%s.gz.tmp", filename);
+    if (nret < 0 || (size_t)nret >= sizeof(tmp_path)) {
+        ERROR("Path is too long");
         return -1;
     }
 
-    if (pid == 0) {
-        // child process, dup2 pipefd[1] to stderr
-        close(pipefd[0]);
-        dup2(pipefd[1], 2);
-
-        if (!util_valid_cmd_arg(filename)) {
-            fprintf(stderr, "Invalid filename: %s\n", filename);
-            exit(EXIT_FAILURE);
-        }
-
-        execlp("gzip", "gzip", "-f", filename, NULL);
-
-        fprintf(stderr, "Failed to exec gzip");
-        exit(EXIT_FAILURE);
-    }
-
-    ssize_t size_read = 0;
-    char buffer[BUFSIZ] = { 0 };
-
-    close(pipefd[1]);
-
-    if (waitpid(pid, &status, 0) != pid) {
-        close(pipefd[0]);
+    srcfd = util_open(filename, O_RDONLY, 0);
+    if (srcfd < 0) {
+        ERROR("Failed to open %s: %s", filename, strerror(errno));
         return -1;
     }
+    if (fstat(srcfd, &st) != 0) {
+        ERROR("Failed to stat %s: %s", filename, strerror(errno));
+        goto out;
+    }
 
-    size_read = read(pipefd[0], buffer, BUFSIZ);
-    close(pipefd[0]);
-
-    if (size_read) {
-        ERROR("Received error:\n%s", buffer);
+    // util_open ignores mode 0
+    if (gzip_to_file(srcfd, tmp_path, ((st.st_mode & 0777) != 0) ? (st.st_mode & 0777) : 0600) != 0) {
+        (void)unlink(tmp_path);
+        goto out;
+    }
+    if (rename(tmp_path, gz_path) != 0) {
+        ERROR("Failed to rename %s to %s: %s", tmp_path, gz_path, strerror(errno));
+        (void)unlink(tmp_path);
+        goto out;
+    }
+    if (unlink(filename) != 0) {
+        WARN("Failed to remove %s: %s", filename, strerror(errno));
     }
-    return status;
+    ret = 0;
+
+out:
+    close(srcfd);
+    return ret;
 }
 
 struct archive_context {
-    int stdin_fd;
-    int stdout_fd;
-    int stderr_fd;
-    pid_t pid;
+    int read_fd;
+    int write_fd;
+    pthread_t writer;
+    char *srcdir;
+    char *srcbase;
+    char *rebase_name;
+    bool compression;
+    int ret;
+    char *err;
 };
 
-static ssize_t archive_context_read(void *context, void *buf, size_t len)
+static void free_archive_context(struct archive_context *ctx)
 {
-    struct archive_context *ctx = (struct archive_context *)context;
     if (ctx == NULL) {
-        return -1;
+        return;
     }
-    if (ctx->stdout_fd >= 0) {
-        return util_read_nointr(ctx->stdout_fd, buf, len);
+    if (ctx->read_fd >= 0) {
+        close(ctx->read_fd);
     }
-    return 0;
+    if (ctx->write_fd >= 0) {
+        close(ctx->write_fd);
+    }
+    free(ctx->srcdir);
+    free(ctx->srcbase);
+    free(ctx->rebase_name);
+    free(ctx->err);
+    free(ctx);
+}
+
+static void *archive_writer_routine(void *arg)
+{
+    struct archive_context *ctx = (struct archive_context *)arg;
+
+    prctl(PR_SET_NAME, "ArchiveWriter");
+    ctx->ret = tar_stream_write_path(ctx->write_fd, ctx->srcdir, ctx->srcbase, ctx->rebase_name,
+                                     ctx->compression, &ctx->err);
+    // reader gets EOF after the whole archive is written
+    close(ctx->write_fd);
+    ctx->write_fd = -1;
+    return NULL;
 }
 
-static ssize_t archive_context_write(const void *context, const void *buf, size_t len)
+static ssize_t archive_context_read(void *context, void *buf, size_t len)
 {
     struct archive_context *ctx = (struct archive_context *)context;
     if (ctx == NULL) {
         return -1;
     }
-    if (ctx->stdin_fd >= 0) {
-        return util_write_nointr(ctx->stdin_fd, buf, len);
+    if (ctx->read_fd >= 0) {
+        return util_read_nointr(ctx->read_fd, buf, len);
     }
     return 0;
 }
 
-static int close_wait_pid(struct archive_context *ctx, int *status)
-{
-    int ret = 0;
-
-    // close stdin and stdout first, this will make sure the process of tar exit.
-    if (ctx->stdin_fd >= 0) {
-        close(ctx->stdin_fd);
-    }
-
-    if (ctx->stdout_fd >= 0) {
-        close(ctx->stdout_fd);
-    }
-
-    if (ctx->pid > 0) {
-        if (waitpid(ctx->pid, status, 0) != ctx->pid) {
-            ERROR("Failed to wait pid %u", ctx->pid);
-            ret = -1;
-        }
-    }
-
-    return ret;
-}
-
 static int archive_context_close(void *context, char **err)
 {
     int ret = 0;
-    int status = 0;
-    char *reason = NULL;
-    ssize_t size_read = 0;
-    char buffer[BUFSIZ + 1] = { 0 };
     struct archive_context *ctx = (struct archive_context *)context;
-    char *marshaled = NULL;
 
     if (ctx == NULL) {
         return 0;
     }
 
-    ret = close_wait_pid(ctx, &status);
-
-    if (WIFSIGNALED((unsigned int)status)) {
-        status = WTERMSIG(status);
-        reason = "signaled";
-    } else if (WIFEXITED(status)) {
-        status = WEXITSTATUS(status);
-        reason = "exited";
-    } else {
-        reason = "unknown";
-    }
-
-    if (ctx->stderr_fd >= 0) {
-        size_read = util_read_nointr(ctx->stderr_fd, buffer, BUFSIZ);
-        if (size_read > 0) {
-            reason = buffer;
-            char *err_info = NULL;
-            marshaled = json_marshal_string(buffer, (size_t)size_read, NULL, &err_info);
-            if (marshaled == NULL) {
-                ERROR("Can not marshal json buffer: %s", err_info);
-            } else {
-                reason = marshaled;
-            }
-            free(err_info);
-        }
-        close(ctx->stderr_fd);
+    // close read end first, writer blocked on a pipe no one reads fails with EPIPE and exits.
+    close(ctx->read_fd);
+    ctx->read_fd = -1;
+    if (pthread_join(ctx->writer, NULL) != 0) {
+        ERROR("Failed to join archive writer");
+        ret = -1;
     }
-
-    if (size_read > 0 || status != 0) {
-        format_errorf(err, "tar exited with status %d: %s", status, reason);
+    if (ctx->ret != 0) {
+        if (err != NULL) {
+            format_errorf(err, "%s", (ctx->err != NULL) ? ctx->err : "Failed to archive");
+        }
         ret = -1;
     }
 
-    free(marshaled);
-    free(ctx);
+    free_archive_context(ctx);
     return ret;
 }
 
@@ -504,50 +521,9 @@ static bool asserts_directory(const char *path)
     return has_trailing_path_separator(path) || specify_current_dir(path);
 }
 
-static char *format_transform_of_tar(const char *srcbase, const char *dstbase)
-{
-    char *transform = NULL;
-    const char *src_escaped = srcbase;
-    const char *dst_escaped = dstbase;
-    int nret;
-    size_t len;
-
-    if (srcbase == NULL || dstbase == NULL) {
-        return NULL;
-    }
-
-    // escape "/" by "." to avoid generating leading / in tar archive which is dangerous to host when untar.
-    // this means tar or untar with leading / is forbidden and may got error, take care of this when coding.
-    if (strcmp(srcbase, "/") == 0) {
-        src_escaped = ".";
-    }
-
-    if (strcmp(dstbase, "/") == 0) {
-        dst_escaped = ".";
-    }
-
-    len = strlen(src_escaped) + strlen(dst_escaped) + 5;
-    if (len > PATH_MAX) {
-        ERROR("Invalid path length");
-        return NULL;
-    }
-
-    transform = util_common_calloc_s(len);
-    if (transform == NULL) {
-        ERROR("Out of memory");
-        return NULL;
-    }
-    nret = snprintf(transform, len, "s/%s/%s/", src_escaped, dst_escaped);
-    if (nret < 0 || (size_t)nret >= len) {
-        ERROR("Failed to print string");
-        free(transform);
-        return NULL;
-    }
-    return transform;
-}
-
+/* bases are NULL if entries of archive are not renamed */
 char *prepare_archive_copy(const struct archive_copy_info *srcinfo, const struct archive_copy_info *dstinfo,
-                           char **transform, char **err)
+                           char **src_base, char **dst_base, char **err)
 {
     char *dstdir = NULL;
     char *srcbase = NULL;
@@ -569,34 +545,21 @@ char *prepare_archive_copy(const struct archive_copy_info *srcinfo, const struct
         format_errorf(err, "cannot copy directory to file");
         free(dstdir);
         dstdir = NULL;
-    } else if (dstinfo->exists) {
-        // dst exists and is a file, src is a file, rename basename of src name to dest's basename.
-        if (srcinfo->rebase_name != NULL) {
-            free(srcbase);
-            srcbase = util_strdup_s(srcinfo->rebase_name);
-        }
-        *transform = format_transform_of_tar(srcbase, dstbase);
-    } else if (srcinfo->isdir) {
-        // dst does not exist and src is a directory, untar the content to parent of dest,
-        // and rename basename of src name to dest's basename.
-        if (srcinfo->rebase_name != NULL) {
-            free(srcbase);
-            srcbase = util_strdup_s(srcinfo->rebase_name);
-        }
-        *transform = format_transform_of_tar(srcbase, dstbase);
-    } else if (asserts_directory(dstinfo->path)) {
+    } else if (!dstinfo->exists && !srcinfo->isdir && asserts_directory(dstinfo->path)) {
         // dst does not exist and is want to be created as a directory, but src is not a directory, report error.
         format_errorf(err, "no such directory, can not copy file");
         free(dstdir);
         dstdir = NULL;
     } else {
-        // dst does not exist and is not want to be created as a directory, and the src is not a directory,
-        // create the dst file and renamed src content to basename of dst.
+        // dst is a file or does not exist, rename basename of src name to dest's basename.
         if (srcinfo->rebase_name != NULL) {
             free(srcbase);
             srcbase = util_strdup_s(srcinfo->rebase_name);
         }
-        *transform = format_transform_of_tar(srcbase, dstbase);
+        *src_base = srcbase;
+        srcbase = NULL;
+        *dst_base = dstbase;
+        dstbase = NULL;
     }
 
 cleanup:
@@ -605,115 +568,19 @@ cleanup:
     return dstdir;
 }
 
-static void close_pipe_fd(int pipe_fd[])
-{
-    if (pipe_fd[0] != -1) {
-        close(pipe_fd[0]);
-        pipe_fd[0] = -1;
-    }
-    if (pipe_fd[1] != -1) {
-        close(pipe_fd[1]);
-        pipe_fd[1] = -1;
-    }
-}
-
 int archive_untar(const struct io_read_wrapper *content, bool compression, const char *dstdir,
-                  const char *transform, char **err)
+                  const char *src_base, const char *dst_base, char **err)
 {
-    int stdin_pipe[2] = { -1, -1 };
-    int stderr_pipe[2] = { -1, -1 };
-    int ret = -1;
-    int cret = 0;
-    pid_t pid;
-    struct archive_context *ctx = NULL;
-    char *buf = NULL;
-    size_t buf_len = ARCHIVE_BLOCK_SIZE;
-    ssize_t read_len;
-    const char *params[TAR_MAX_OPTS] = { NULL };
+    int ret;
 
-    buf = util_common_calloc_s(buf_len);
-    if (buf == NULL) {
-        ERROR("Out of memory");
+    if (content == NULL || dstdir == NULL || err == NULL) {
         return -1;
     }
 
-    if (pipe(stderr_pipe) != 0) {
-        ERROR("Failed to create pipe: %s", strerror(errno));
-        goto cleanup;
-    }
-    if (pipe(stdin_pipe) != 0) {
-        ERROR("Failed to create pipe: %s", strerror(errno));
-        goto cleanup;
-    }
-
-    pid = fork();
-    if (pid == (pid_t) - 1) {
-        ERROR("Failed to fork: %s", strerror(errno));
-        goto cleanup;
-    }
-
-    if (pid == (pid_t)0) {
-        int i = 0;
-        // child process, dup2 stderr[1] to stderr, stdout[0] to stdin.
-        close(stderr_pipe[0]);
-        dup2(stderr_pipe[1], 2);
-        close(stdin_pipe[1]);
-        dup2(stdin_pipe[0], 0);
-
-        params[i++] = TAR_CMD;
-        params[i++] = TAR_EXACT_OPT;
-        if (compression) {
-            params[i++] = TAR_GZIP_OPT;
-        }
-        params[i++] = TAR_CHDIR_OPT;
-        params[i++] = dstdir;
-        if (transform != NULL) {
-            params[i++] = TAR_TRANSFORM_OPT;
-            params[i++] = transform;
-        }
-
-        execvp(TAR_CMD, (char * const *)params);
-
-        fprintf(stderr, "Failed to exec tar: %s", strerror(errno));
-        exit(EXIT_FAILURE);
-    }
-
-    close(stderr_pipe[1]);
-    stderr_pipe[1] = -1;
-    close(stdin_pipe[0]);
-    stdin_pipe[0] = -1;
-
-    ctx = util_common_calloc_s(sizeof(struct archive_context));
-    if (ctx == NULL) {
-        goto cleanup;
-    }
-
-    ctx->pid = pid;
-    ctx->stdin_fd = stdin_pipe[1];
-    stdin_pipe[1] = -1;
-    ctx->stdout_fd = -1;
-    ctx->stderr_fd = stderr_pipe[0];
-    stderr_pipe[0] = -1;
-
-    read_len = content->read(content->context, buf, buf_len);
-    while (read_len > 0) {
-        ssize_t writed_len = archive_context_write(ctx, buf, (size_t)read_len);
-        if (writed_len < 0) {
-            DEBUG("Tar may exited: %s", strerror(errno));
-            break;
-        }
-        read_len = content->read(content->context, buf, buf_len);
+    ret = tar_stream_extract(content, compression, dstdir, src_base, dst_base, err);
+    if (ret != 0) {
+        ERROR("Failed to extract archive to %s: %s", dstdir, (*err != NULL) ? *err : "unknown");
     }
-
-    ret = 0;
-
-cleanup:
-    free(buf);
-    cret = archive_context_close(ctx, err);
-    ret = (cret != 0) ? cret : ret;
-    close_pipe_fd(stderr_pipe);
-    close_pipe_fd(stdin_pipe);
-
     return ret;
 }
 
@@ -723,7 +590,8 @@ int archive_copy_to(const struct io_read_wrapper *content, bool compression, con
     int ret = -1;
     struct archive_copy_info *dstinfo = NULL;
     char *dstdir = NULL;
-    char *transform = NULL;
+    char *src_base = NULL;
+    char *dst_base = NULL;
 
     dstinfo = copy_info_destination_path(dstpath, err);
     if (dstinfo == NULL) {
@@ -731,125 +599,69 @@ int archive_copy_to(const struct io_read_wrapper *content, bool compression, con
         return -1;
     }
 
-    dstdir = prepare_archive_copy(srcinfo, dstinfo, &transform, err);
+    dstdir = prepare_archive_copy(srcinfo, dstinfo, &src_base, &dst_base, err);
     if (dstdir == NULL) {
         ERROR("Can not prepare archive copy");
         goto cleanup;
     }
 
-    ret = archive_untar(content, compression, dstdir, transform, err);
+    ret = archive_untar(content, compression, dstdir, src_base, dst_base, err);
 
 cleanup:
     free_archive_copy_info(dstinfo);
     free(dstdir);
-    free(transform);
+    free(src_base);
+    free(dst_base);
     return ret;
 }
 
-static void close_archive_pipes_fd(int *pipes, size_t pipe_size)
-{
-    size_t i = 0;
-
-    for (i = 0; i < pipe_size; i++) {
-        if (pipes[i] >= 0) {
-            close(pipes[i]);
-            pipes[i] = -1;
-        }
-    }
-}
-
 /*
- * Archive file or directory.
- * param src		:	file or directory to compression.
+ * Archive file or directory, the archive is written by a writer thread and read by archive_reader.
+ * param srcdir		:	directory of file or directory to archive.
+ * param srcbase	:	base name of file or directory to archive.
+ * param rebase_name	:	archive srcbase as rebase_name if not NULL.
  * param compression	:	using gzip compression or not
- * param exclude_base	:	exclude source basename in the archived file or not
  * return		:	zero if archive success, non-zero if not.
  */
 int archive_path(const char *srcdir, const char *srcbase, const char *rebase_name,
                  bool compression, struct io_read_wrapper *archive_reader)
 {
-    int stderr_pipe[2] = { -1, -1 };
-    int stdout_pipe[2] = { -1, -1 };
-    int ret = -1;
-    pid_t pid;
+    int pipe_fd[2] = { -1, -1 };
     struct archive_context *ctx = NULL;
-    char *transform = NULL;
-    const char *params[TAR_MAX_OPTS] = { NULL };
-
-    transform = format_transform_of_tar(srcbase, rebase_name);
 
-    if (pipe(stderr_pipe) != 0) {
-        ERROR("Failed to create pipe: %s", strerror(errno));
-        goto free_out;
-    }
-    if (pipe(stdout_pipe) != 0) {
-        ERROR("Failed to create pipe: %s", strerror(errno));
-        goto free_out;
+    if (srcdir == NULL || srcbase == NULL || archive_reader == NULL) {
+        return -1;
     }
 
-    pid = fork();
-    if (pid == (pid_t) - 1) {
-        ERROR("Failed to fork: %s", strerror(errno));
-        goto free_out;
+    ctx = util_common_calloc_s(sizeof(struct archive_context));
+    if (ctx == NULL) {
+        ERROR("Out of memory");
+        return -1;
     }
-
-    if (pid == (pid_t)0) {
-        int i = 0;
-        // child process, dup2 stderr[1] to stderr, stdout[1] to stdout.
-        close(stderr_pipe[0]);
-        close(stdout_pipe[0]);
-        dup2(stderr_pipe[1], 2);
-        dup2(stdout_pipe[1], 1);
-
-        params[i++] = TAR_CMD;
-        params[i++] = TAR_CREATE_OPT;
-        if (compression) {
-            params[i++] = TAR_GZIP_OPT;
-        }
-        params[i++] = TAR_CHDIR_OPT;
-        params[i++] = srcdir;
-        if (transform != NULL) {
-            params[i++] = TAR_TRANSFORM_OPT;
-            params[i++] = transform;
-        }
-        params[i++] = srcbase;
-
-        execvp(TAR_CMD, (char * const *)params);
-
-        fprintf(stderr, "Failed to exec tar: %s", strerror(errno));
-        exit(EXIT_FAILURE);
+    if (pipe2(pipe_fd, O_CLOEXEC) != 0) {
+        ERROR("Failed to create pipe: %s", strerror(errno));
+        free(ctx);
+        return -1;
     }
 
-    close(stderr_pipe[1]);
-    stderr_pipe[1] = -1;
-    close(stdout_pipe[1]);
-    stdout_pipe[1] = -1;
+    ctx->read_fd = pipe_fd[0];
+    ctx->write_fd = pipe_fd[1];
+    ctx->srcdir = util_strdup_s(srcdir);
+    ctx->srcbase = util_strdup_s(srcbase);
+    ctx->rebase_name = (rebase_name != NULL) ? util_strdup_s(rebase_name) : NULL;
+    ctx->compression = compression;
 
-    ctx = util_common_calloc_s(sizeof(struct archive_context));
-    if (ctx == NULL) {
-        goto free_out;
+    if (pthread_create(&ctx->writer, NULL, archive_writer_routine, ctx) != 0) {
+        ERROR("Failed to create archive writer thread");
+        free_archive_context(ctx);
+        return -1;
     }
 
-    ctx->stdin_fd = -1;
-    ctx->stdout_fd = stdout_pipe[0];
-    stdout_pipe[0] = -1;
-    ctx->stderr_fd = stderr_pipe[0];
-    stderr_pipe[0] = -1;
-    ctx->pid = pid;
-
     archive_reader->close = archive_context_close;
     archive_reader->context = ctx;
-    ctx = NULL;
     archive_reader->read = archive_context_read;
 
-    ret = 0;
-free_out:
-    free(transform);
-    close_archive_pipes_fd(stderr_pipe, 2);
-    close_archive_pipes_fd(stdout_pipe, 2);
-    free(ctx);
-
-    return ret;
+    return 0;
 }
 
 int tar_resource_rebase(const char *path, const char *rebase, struct io_read_wrapper *archive_reader, char **err)
@@ -47,7 +47,7 @@ struct archive_tar_resource_rebase_opts {
 };
 
 /*
- * compress file.
+ * compress file to filename.gz and remove it.
  * param filename   :   archive file to compres.
  * return:              zero if compress success, non-zero if not.
  */
@@ -55,13 +55,17 @@ int gzip(const char *filename, size_t len);
 
 struct archive_copy_info *copy_info_source_path(const char *path, bool follow_link, char **err);
 
+/*
+ * return directory to extract archive of srcinfo to, src_base and dst_base are set
+ * if entries under src_base should be extracted under dst_base.
+ */
 char *prepare_archive_copy(const struct archive_copy_info *srcinfo, const struct archive_copy_info *dstinfo,
-                           char **transform, char **err);
+                           char **src_base, char **dst_base, char **err);
 
 int tar_resource(const struct archive_copy_info *info, struct io_read_wrapper *archive_reader, char **err);
 
 int archive_untar(const struct io_read_wrapper *content, bool compression, const char *dstdir,
-                  const char *transform, char **err);
+                  const char *src_base, const char *dst_base, char **err);
 
 int archive_copy_to(const struct io_read_wrapper *content, bool compression, const struct archive_copy_info *srcinfo,
                     const char *dstpath, char **err);
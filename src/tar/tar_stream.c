@@ -0,0 +1,2242 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-04-15
+ * Description: provide in process tar archive writer and extractor
+ ******************************************************************************/
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/types.h>
+#include <zlib.h>
+
+#include "tar_stream.h"
+#include "libtar.h"
+#include "utils.h"
+#include "utils_thread_pool.h"
+#include "path.h"
+#include "log.h"
+#include "error.h"
+
+#define TAR_BLOCK_SIZE 512
+#define TAR_NAME_SIZE 100
+#define TAR_PREFIX_SIZE 155
+/* must not be smaller than ARCHIVE_BLOCK_SIZE, the size readers of grpc stream require */
+#define TAR_IO_BUF_SIZE (4 * ARCHIVE_BLOCK_SIZE)
+#define TAR_PAX_BUF_SIZE (2 * PATH_MAX + 64)
+/* max size of pax records and gnu long names */
+#define TAR_MAX_META_SIZE (1024 * 1024)
+#define TAR_LINK_BUCKETS 1024
+/* smaller files are copied into write buffer, to write headers and data of many files at once */
+#define TAR_SPLICE_MIN_SIZE (64 * 1024)
+
+/* data of files not larger than this is written by workers */
+#define TAR_JOB_FILE_MAX (1024 * 1024)
+#define TAR_JOB_MAX_BYTES (64 * 1024 * 1024)
+#define TAR_JOB_MAX_COUNT 512
+#define TAR_JOB_MAX_WORKERS 4
+
+#define TAR_TYPE_REG '0'
+#define TAR_TYPE_LINK '1'
+#define TAR_TYPE_SYMLINK '2'
+#define TAR_TYPE_CHR '3'
+#define TAR_TYPE_BLK '4'
+#define TAR_TYPE_DIR '5'
+#define TAR_TYPE_FIFO '6'
+#define TAR_TYPE_CONT '7'
+#define TAR_TYPE_PAX 'x'
+#define TAR_TYPE_PAX_GLOBAL 'g'
+#define TAR_TYPE_GNU_LONGNAME 'L'
+#define TAR_TYPE_GNU_LONGLINK 'K'
+
+#define TAR_PAX_HEADER_NAME "././@PaxHeader"
+
+struct tar_header {
+    char name[TAR_NAME_SIZE];
+    char mode[8];
+    char uid[8];
+    char gid[8];
+    char size[12];
+    char mtime[12];
+    char chksum[8];
+    char typeflag;
+    char linkname[TAR_NAME_SIZE];
+    char magic[6];
+    char version[2];
+    char uname[32];
+    char gname[32];
+    char devmajor[8];
+    char devminor[8];
+    char prefix[TAR_PREFIX_SIZE];
+    char pad[12];
+};
+
+static const char g_zero_block[TAR_BLOCK_SIZE] = { 0 };
+
+/* keep the first error, later ones are usually caused by it */
+static void tar_set_error(char **err, const char *format, ...)
+{
+    int nret;
+    char errbuf[BUFSIZ + 1] = { 0 };
+    va_list argp;
+
+    if (err == NULL || *err != NULL) {
+        return;
+    }
+
+    va_start(argp, format);
+    nret = vsnprintf(errbuf, BUFSIZ, format, argp);
+    va_end(argp);
+    if (nret < 0 || nret >= BUFSIZ) {
+        *err = util_strdup_s("Error is too long!!!");
+        return;
+    }
+    *err = util_strdup_s(errbuf);
+}
+
+static void format_number(char *field, size_t size, uint64_t value)
+{
+    size_t i;
+
+    if (value < ((uint64_t)1 << (3 * (size - 1)))) {
+        // size - 1 octal digits terminated by NUL
+        field[size - 1] = '\0';
+        for (i = size - 1; i > 0; i--) {
+            field[i - 1] = (char)('0' + (value & 07));
+            value >>= 3;
+        }
+        return;
+    }
+
+    // base-256 for values which overflow the octal field, as gnu tar does
+    for (i = size - 1; i > 0; i--) {
+        field[i] = (char)(value & 0xff);
+        value >>= 8;
+    }
+    field[0] = (char)0x80;
+}
+
+static int parse_number(const char *field, size_t size, uint64_t *value)
+{
+    size_t i = 0;
+    uint64_t result = 0;
+
+    if (((unsigned char)field[0] & 0x80) != 0) {
+        if ((unsigned char)field[0] == 0xff) {
+            // negative number
+            return -1;
+        }
+        result = (unsigned char)field[0] & 0x7f;
+        for (i = 1; i < size; i++) {
+            if ((result >> 56) != 0) {
+                return -1;
+            }
+            result = (result << 8) | (unsigned char)field[i];
+        }
+        *value = result;
+        return 0;
+    }
+
+    while (i < size && field[i] == ' ') {
+        i++;
+    }
+    for (; i < size && field[i] >= '0' && field[i] <= '7'; i++) {
+        result = (result << 3) | (uint64_t)(field[i] - '0');
+    }
+    if (i < size && field[i] != ' ' && field[i] != '\0') {
+        return -1;
+    }
+    *value = result;
+    return 0;
+}
+
+static unsigned int header_checksum(const struct tar_header *hdr, int *signed_sum)
+{
+    const unsigned char *p = (const unsigned char *)hdr;
+    size_t begin = offsetof(struct tar_header, chksum);
+    size_t end = begin + sizeof(hdr->chksum);
+    unsigned int sum = 0;
+    int ssum = 0;
+    size_t i;
+
+    for (i = 0; i < TAR_BLOCK_SIZE; i++) {
+        unsigned char c = (i >= begin && i < end) ? ' ' : p[i];
+        sum += c;
+        ssum += (signed char)c;
+    }
+    if (signed_sum != NULL) {
+        *signed_sum = ssum;
+    }
+    return sum;
+}
+
+static void header_set_checksum(struct tar_header *hdr)
+{
+    unsigned int sum = header_checksum(hdr, NULL);
+
+    (void)snprintf(hdr->chksum, sizeof(hdr->chksum), "%06o", sum);
+    hdr->chksum[sizeof(hdr->chksum) - 1] = ' ';
+}
+
+/* writer */
+
+struct tar_link {
+    dev_t dev;
+    ino_t ino;
+    char *name;
+    struct tar_link *next;
+};
+
+struct tar_writer {
+    int fd;
+    bool compression;
+    /* output is a pipe, move file data by splice */
+    bool splice_out;
+    bool zs_inited;
+    z_stream zs;
+    unsigned char *buf;
+    size_t len;
+    unsigned char *zbuf;
+    struct tar_link *links[TAR_LINK_BUCKETS];
+    char **err;
+};
+
+static int writer_output(struct tar_writer *w, const void *data, size_t len)
+{
+    const char *p = data;
+    ssize_t nret;
+
+    while (len > 0) {
+        nret = util_write_nointr(w->fd, p, len);
+        if (nret <= 0) {
+            ERROR("Failed to write archive: %s", strerror(errno));
+            tar_set_error(w->err, "Failed to write archive: %s", strerror(errno));
+            return -1;
+        }
+        p += nret;
+        len -= (size_t)nret;
+    }
+    return 0;
+}
+
+static int writer_deflate(struct tar_writer *w, const unsigned char *data, size_t len, int flush)
+{
+    int zret;
+
+    w->zs.next_in = (Bytef *)data;
+    w->zs.avail_in = (uInt)len;
+    do {
+        w->zs.next_out = w->zbuf;
+        w->zs.avail_out = TAR_IO_BUF_SIZE;
+        zret = deflate(&w->zs, flush);
+        if (zret == Z_STREAM_ERROR) {
+            ERROR("Failed to compress archive");
+            tar_set_error(w->err, "Failed to compress archive");
+            return -1;
+        }
+        if (writer_output(w, w->zbuf, TAR_IO_BUF_SIZE - w->zs.avail_out) != 0) {
+            return -1;
+        }
+    } while (w->zs.avail_out == 0);
+
+    return 0;
+}
+
+static int writer_flush(struct tar_writer *w)
+{
+    int ret = 0;
+
+    if (w->len == 0) {
+        return 0;
+    }
+    if (w->compression) {
+        ret = writer_deflate(w, w->buf, w->len, Z_NO_FLUSH);
+    } else {
+        ret = writer_output(w, w->buf, w->len);
+    }
+    w->len = 0;
+    return ret;
+}
+
+static int writer_write(struct tar_writer *w, const void *data, size_t len)
+{
+    const char *p = data;
+    size_t n;
+
+    while (len > 0) {
+        n = TAR_IO_BUF_SIZE - w->len;
+        if (n > len) {
+            n = len;
+        }
+        (void)memcpy(w->buf + w->len, p, n);
+        w->len += n;
+        p += n;
+        len -= n;
+        if (w->len == TAR_IO_BUF_SIZE && writer_flush(w) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int writer_zeros(struct tar_writer *w, uint64_t len)
+{
+    size_t n;
+
+    while (len > 0) {
+        n = len > TAR_BLOCK_SIZE ? TAR_BLOCK_SIZE : (size_t)len;
+        if (writer_write(w, g_zero_block, n) != 0) {
+            return -1;
+        }
+        len -= n;
+    }
+    return 0;
+}
+
+static int writer_pad(struct tar_writer *w, uint64_t size)
+{
+    return writer_zeros(w, (TAR_BLOCK_SIZE - size % TAR_BLOCK_SIZE) % TAR_BLOCK_SIZE);
+}
+
+static int pax_append(char *pax, size_t *pax_len, const char *key, const char *value)
+{
+    // length of record counts its own digits
+    size_t body = strlen(key) + strlen(value) + 3;
+    size_t total = body + 1;
+    char digits[32] = { 0 };
+    int nret;
+
+    for (;;) {
+        nret = snprintf(digits, sizeof(digits), "%zu", total);
+        if (nret < 0 || body + (size_t)nret == total) {
+            break;
+        }
+        total = body + (size_t)nret;
+    }
+
+    if (*pax_len + total >= TAR_PAX_BUF_SIZE) {
+        return -1;
+    }
+    nret = snprintf(pax + *pax_len, TAR_PAX_BUF_SIZE - *pax_len, "%zu %s=%s\n", total, key, value);
+    if (nret < 0 || (size_t)nret != total) {
+        return -1;
+    }
+    *pax_len += total;
+    return 0;
+}
+
+/* split name into ustar prefix and name fields, return -1 if it does not fit */
+static int header_set_name(struct tar_header *hdr, const char *name)
+{
+    size_t len = strlen(name);
+    size_t i;
+
+    if (len <= TAR_NAME_SIZE) {
+        (void)memcpy(hdr->name, name, len);
+        return 0;
+    }
+
+    for (i = 0; i < len && i <= TAR_PREFIX_SIZE; i++) {
+        if (name[i] == '/' && len - i - 1 <= TAR_NAME_SIZE && len - i - 1 > 0) {
+            (void)memcpy(hdr->prefix, name, i);
+            (void)memcpy(hdr->name, name + i + 1, len - i - 1);
+            return 0;
+        }
+    }
+
+    (void)memcpy(hdr->name, name, TAR_NAME_SIZE);
+    return -1;
+}
+
+static int writer_pax_header(struct tar_writer *w, const char *pax, size_t pax_len, const struct stat *st)
+{
+    struct tar_header hdr;
+
+    (void)memset(&hdr, 0, sizeof(hdr));
+    (void)memcpy(hdr.name, TAR_PAX_HEADER_NAME, strlen(TAR_PAX_HEADER_NAME));
+    format_number(hdr.mode, sizeof(hdr.mode), 0644);
+    format_number(hdr.uid, sizeof(hdr.uid), 0);
+    format_number(hdr.gid, sizeof(hdr.gid), 0);
+    format_number(hdr.size, sizeof(hdr.size), pax_len);
+    format_number(hdr.mtime, sizeof(hdr.mtime), (uint64_t)st->st_mtime);
+    hdr.typeflag = TAR_TYPE_PAX;
+    (void)memcpy(hdr.magic, "ustar", 6);
+    (void)memcpy(hdr.version, "00", 2);
+    header_set_checksum(&hdr);
+
+    if (writer_write(w, &hdr, sizeof(hdr)) != 0 || writer_write(w, pax, pax_len) != 0) {
+        return -1;
+    }
+    return writer_pad(w, pax_len);
+}
+
+static int writer_header(struct tar_writer *w, const char *name, const char *linkname, const struct stat *st,
+                         char type, uint64_t size)
+{
+    struct tar_header hdr;
+    char pax[TAR_PAX_BUF_SIZE] = { 0 };
+    size_t pax_len = 0;
+    size_t link_len = 0;
+
+    (void)memset(&hdr, 0, sizeof(hdr));
+    if (header_set_name(&hdr, name) != 0 && pax_append(pax, &pax_len, "path", name) != 0) {
+        ERROR("Name too long: %s", name);
+        tar_set_error(w->err, "Name too long: %s", name);
+        return -1;
+    }
+    if (linkname != NULL) {
+        link_len = strlen(linkname);
+        if (link_len > TAR_NAME_SIZE) {
+            link_len = TAR_NAME_SIZE;
+            if (pax_append(pax, &pax_len, "linkpath", linkname) != 0) {
+                ERROR("Link name too long: %s", linkname);
+                tar_set_error(w->err, "Link name too long: %s", linkname);
+                return -1;
+            }
+        }
+        (void)memcpy(hdr.linkname, linkname, link_len);
+    }
+    if (pax_len > 0 && writer_pax_header(w, pax, pax_len, st) != 0) {
+        return -1;
+    }
+
+    format_number(hdr.mode, sizeof(hdr.mode), st->st_mode & 07777);
+    format_number(hdr.uid, sizeof(hdr.uid), st->st_uid);
+    format_number(hdr.gid, sizeof(hdr.gid), st->st_gid);
+    format_number(hdr.size, sizeof(hdr.size), size);
+    format_number(hdr.mtime, sizeof(hdr.mtime), st->st_mtime < 0 ? 0 : (uint64_t)st->st_mtime);
+    hdr.typeflag = type;
+    (void)memcpy(hdr.magic, "ustar", 6);
+    (void)memcpy(hdr.version, "00", 2);
+    if (type == TAR_TYPE_CHR || type == TAR_TYPE_BLK) {
+        format_number(hdr.devmajor, sizeof(hdr.devmajor), major(st->st_rdev));
+        format_number(hdr.devminor, sizeof(hdr.devminor), minor(st->st_rdev));
+    }
+    header_set_checksum(&hdr);
+
+    return writer_write(w, &hdr, sizeof(hdr));
+}
+
+/* return name of the first archived link of inode, or record name as the first one */
+static const char *writer_find_link(struct tar_writer *w, const struct stat *st, const char *name)
+{
+    size_t bucket = (size_t)((st->st_ino ^ st->st_dev) % TAR_LINK_BUCKETS);
+    struct tar_link *link = NULL;
+
+    for (link = w->links[bucket]; link != NULL; link = link->next) {
+        if (link->ino == st->st_ino && link->dev == st->st_dev) {
+            return link->name;
+        }
+    }
+
+    link = util_common_calloc_s(sizeof(struct tar_link));
+    if (link == NULL) {
+        // archive the file again instead of as a link
+        ERROR("Out of memory");
+        return NULL;
+    }
+    link->dev = st->st_dev;
+    link->ino = st->st_ino;
+    link->name = util_strdup_s(name);
+    link->next = w->links[bucket];
+    w->links[bucket] = link;
+    return NULL;
+}
+
+static int writer_file_data(struct tar_writer *w, int fd, const char *name, uint64_t size)
+{
+    uint64_t left = size;
+    ssize_t nret;
+    size_t n;
+
+    if (w->splice_out && size >= TAR_SPLICE_MIN_SIZE) {
+        if (writer_flush(w) != 0) {
+            return -1;
+        }
+        while (left > 0) {
+            n = left > (uint64_t)SSIZE_MAX ? (size_t)SSIZE_MAX : (size_t)left;
+            nret = splice(fd, NULL, w->fd, NULL, n, SPLICE_F_MOVE | SPLICE_F_MORE);
+            if (nret < 0 && errno == EINTR) {
+                continue;
+            }
+            if (nret < 0 && (errno == EINVAL || errno == ENOSYS)) {
+                // file system does not support splice, fall back to read
+                break;
+            }
+            if (nret < 0) {
+                ERROR("Failed to archive %s: %s", name, strerror(errno));
+                tar_set_error(w->err, "Failed to archive %s: %s", name, strerror(errno));
+                return -1;
+            }
+            if (nret == 0) {
+                break;
+            }
+            left -= (uint64_t)nret;
+        }
+    }
+
+    while (left > 0) {
+        n = TAR_IO_BUF_SIZE - w->len;
+        if ((uint64_t)n > left) {
+            n = (size_t)left;
+        }
+        nret = util_read_nointr(fd, w->buf + w->len, n);
+        if (nret < 0) {
+            ERROR("Failed to read %s: %s", name, strerror(errno));
+            tar_set_error(w->err, "Failed to read %s: %s", name, strerror(errno));
+            return -1;
+        }
+        if (nret == 0) {
+            break;
+        }
+        w->len += (size_t)nret;
+        left -= (uint64_t)nret;
+        if (w->len == TAR_IO_BUF_SIZE && writer_flush(w) != 0) {
+            return -1;
+        }
+    }
+
+    if (left > 0) {
+        // size in header was written already, keep the archive valid
+        WARN("File %s shrank by %llu bytes while archiving, padding with zeros", name, (unsigned long long)left);
+        if (writer_zeros(w, left) != 0) {
+            return -1;
+        }
+    }
+
+    return writer_pad(w, size);
+}
+
+static int writer_regular(struct tar_writer *w, int parent_fd, const char *entry, const char *name,
+                          const struct stat *st)
+{
+    int ret = -1;
+    int fd = -1;
+    const char *link = NULL;
+
+    if (st->st_nlink > 1) {
+        link = writer_find_link(w, st, name);
+        if (link != NULL) {
+            return writer_header(w, name, link, st, TAR_TYPE_LINK, 0);
+        }
+    }
+
+    fd = openat(parent_fd, entry, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) {
+        ERROR("Failed to open %s: %s", name, strerror(errno));
+        tar_set_error(w->err, "Failed to open %s: %s", name, strerror(errno));
+        return -1;
+    }
+
+    if (writer_header(w, name, NULL, st, TAR_TYPE_REG, (uint64_t)st->st_size) != 0) {
+        goto out;
+    }
+    ret = writer_file_data(w, fd, name, (uint64_t)st->st_size);
+
+out:
+    close(fd);
+    return ret;
+}
+
+static int writer_entry(struct tar_writer *w, int parent_fd, const char *entry, char *name, size_t name_len,
+                        bool missing_ok);
+
+static int writer_dir(struct tar_writer *w, int parent_fd, const char *entry, char *name, size_t name_len,
+                      const struct stat *st)
+{
+    int ret = 0;
+    int fd = -1;
+    int nret;
+    DIR *dir = NULL;
+    struct dirent *de = NULL;
+
+    if (name_len + 1 >= PATH_MAX) {
+        ERROR("Name too long: %s", name);
+        tar_set_error(w->err, "Name too long: %s", name);
+        return -1;
+    }
+    name[name_len] = '/';
+    name[name_len + 1] = '\0';
+    ret = writer_header(w, name, NULL, st, TAR_TYPE_DIR, 0);
+    name[name_len] = '\0';
+    if (ret != 0) {
+        return -1;
+    }
+
+    fd = openat(parent_fd, entry, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) {
+        ERROR("Failed to open directory %s: %s", name, strerror(errno));
+        tar_set_error(w->err, "Failed to open directory %s: %s", name, strerror(errno));
+        return -1;
+    }
+    dir = fdopendir(fd);
+    if (dir == NULL) {
+        ERROR("Failed to open directory %s: %s", name, strerror(errno));
+        tar_set_error(w->err, "Failed to open directory %s: %s", name, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    for (;;) {
+        errno = 0;
+        de = readdir(dir);
+        if (de == NULL) {
+            if (errno != 0) {
+                ERROR("Failed to read directory %s: %s", name, strerror(errno));
+                tar_set_error(w->err, "Failed to read directory %s: %s", name, strerror(errno));
+                ret = -1;
+            }
+            break;
+        }
+        if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0) {
+            continue;
+        }
+        nret = snprintf(name + name_len, PATH_MAX - name_len, "/%s", de->d_name);
+        if (nret < 0 || (size_t)nret >= PATH_MAX - name_len) {
+            name[name_len] = '\0';
+            ERROR("Name too long: %s/%s", name, de->d_name);
+            tar_set_error(w->err, "Name too long: %s/%s", name, de->d_name);
+            ret = -1;
+            break;
+        }
+        ret = writer_entry(w, dirfd(dir), de->d_name, name, name_len + (size_t)nret, true);
+        name[name_len] = '\0';
+        if (ret != 0) {
+            break;
+        }
+    }
+
+    closedir(dir);
+    return ret;
+}
+
+static int writer_entry(struct tar_writer *w, int parent_fd, const char *entry, char *name, size_t name_len,
+                        bool missing_ok)
+{
+    struct stat st;
+    char target[PATH_MAX] = { 0 };
+    ssize_t nret;
+
+    if (fstatat(parent_fd, entry, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+        if (errno == ENOENT && missing_ok) {
+            WARN("File %s removed before archived", name);
+            return 0;
+        }
+        ERROR("Failed to stat %s: %s", name, strerror(errno));
+        tar_set_error(w->err, "Failed to stat %s: %s", name, strerror(errno));
+        return -1;
+    }
+
+    switch (st.st_mode & S_IFMT) {
+        case S_IFDIR:
+            return writer_dir(w, parent_fd, entry, name, name_len, &st);
+        case S_IFREG:
+            return writer_regular(w, parent_fd, entry, name, &st);
+        case S_IFLNK:
+            nret = readlinkat(parent_fd, entry, target, sizeof(target) - 1);
+            if (nret < 0) {
+                ERROR("Failed to read link %s: %s", name, strerror(errno));
+                tar_set_error(w->err, "Failed to read link %s: %s", name, strerror(errno));
+                return -1;
+            }
+            target[nret] = '\0';
+            return writer_header(w, name, target, &st, TAR_TYPE_SYMLINK, 0);
+        case S_IFCHR:
+            return writer_header(w, name, NULL, &st, TAR_TYPE_CHR, 0);
+        case S_IFBLK:
+            return writer_header(w, name, NULL, &st, TAR_TYPE_BLK, 0);
+        case S_IFIFO:
+            return writer_header(w, name, NULL, &st, TAR_TYPE_FIFO, 0);
+        default:
+            WARN("Socket %s ignored", name);
+            return 0;
+    }
+}
+
+static int writer_init(struct tar_writer *w, int fd, bool compression, char **err)
+{
+    struct stat st;
+
+    w->fd = fd;
+    w->err = err;
+    w->compression = compression;
+    w->splice_out = !compression && fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+    w->buf = util_common_calloc_s(TAR_IO_BUF_SIZE);
+    if (w->buf == NULL) {
+        ERROR("Out of memory");
+        return -1;
+    }
+    if (!compression) {
+        return 0;
+    }
+
+    w->zbuf = util_common_calloc_s(TAR_IO_BUF_SIZE);
+    if (w->zbuf == NULL) {
+        ERROR("Out of memory");
+        return -1;
+    }
+    // 16 + max window bits for gzip wrapper
+    if (deflateInit2(&w->zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        ERROR("Failed to init compression");
+        tar_set_error(err, "Failed to init compression");
+        return -1;
+    }
+    w->zs_inited = true;
+    return 0;
+}
+
+static int writer_finish(struct tar_writer *w)
+{
+    // end of archive is two zero blocks
+    if (writer_zeros(w, 2 * TAR_BLOCK_SIZE) != 0 || writer_flush(w) != 0) {
+        return -1;
+    }
+    if (w->compression) {
+        return writer_deflate(w, NULL, 0, Z_FINISH);
+    }
+    return 0;
+}
+
+static void writer_free(struct tar_writer *w)
+{
+    size_t i;
+    struct tar_link *link = NULL;
+    struct tar_link *next = NULL;
+
+    for (i = 0; i < TAR_LINK_BUCKETS; i++) {
+        for (link = w->links[i]; link != NULL; link = next) {
+            next = link->next;
+            free(link->name);
+            free(link);
+        }
+        w->links[i] = NULL;
+    }
+    if (w->zs_inited) {
+        (void)deflateEnd(&w->zs);
+        w->zs_inited = false;
+    }
+    free(w->buf);
+    w->buf = NULL;
+    free(w->zbuf);
+    w->zbuf = NULL;
+}
+
+int tar_stream_write_path(int fd, const char *srcdir, const char *srcbase, const char *rebase_name,
+                          bool compression, char **err)
+{
+    int ret = -1;
+    int dir_fd = -1;
+    int nret;
+    const char *entry = srcbase;
+    const char *top = NULL;
+    char *name = NULL;
+    struct tar_writer *w = NULL;
+
+    if (fd < 0 || srcdir == NULL || srcbase == NULL || err == NULL) {
+        return -1;
+    }
+
+    w = util_common_calloc_s(sizeof(struct tar_writer));
+    name = util_common_calloc_s(PATH_MAX);
+    if (w == NULL || name == NULL) {
+        ERROR("Out of memory");
+        goto out;
+    }
+    if (writer_init(w, fd, compression, err) != 0) {
+        goto out;
+    }
+
+    // escape "/" by "." to avoid generating leading / in tar archive which is dangerous to host when untar.
+    if (strcmp(srcbase, "/") == 0) {
+        entry = ".";
+    }
+    top = (rebase_name != NULL) ? rebase_name : srcbase;
+    if (strcmp(top, "/") == 0) {
+        top = ".";
+    }
+    nret = snprintf(name, PATH_MAX, "%s", top);
+    if (nret < 0 || nret >= PATH_MAX) {
+        ERROR("Name too long: %s", top);
+        goto out;
+    }
+
+    dir_fd = open(srcdir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) {
+        ERROR("Failed to open directory %s: %s", srcdir, strerror(errno));
+        tar_set_error(err, "Failed to open directory %s: %s", srcdir, strerror(errno));
+        goto out;
+    }
+
+    if (writer_entry(w, dir_fd, entry, name, (size_t)nret, false) != 0) {
+        goto out;
+    }
+    ret = writer_finish(w);
+
+out:
+    if (dir_fd >= 0) {
+        close(dir_fd);
+    }
+    if (w != NULL) {
+        writer_free(w);
+    }
+    free(w);
+    free(name);
+    return ret;
+}
+
+/* extractor */
+
+struct tar_reader {
+    const struct io_read_wrapper *content;
+    bool compression;
+    bool zs_inited;
+    /* no more data can be read from content */
+    bool eof;
+    z_stream zs;
+    unsigned char *raw;
+    unsigned char *buf;
+    size_t pos;
+    size_t len;
+};
+
+struct tar_attr {
+    mode_t mode;
+    uid_t uid;
+    gid_t gid;
+    struct timespec mtime;
+};
+
+struct tar_entry {
+    char type;
+    /* cleaned and rebased names */
+    char *name;
+    char *linkname;
+    uint64_t size;
+    dev_t rdev;
+    struct tar_attr attr;
+};
+
+/* overrides of next entry, from pax records or gnu long names */
+struct tar_meta {
+    char *path;
+    char *linkpath;
+    bool has_size;
+    uint64_t size;
+    bool has_uid;
+    uint64_t uid;
+    bool has_gid;
+    uint64_t gid;
+    bool has_mtime;
+    struct timespec mtime;
+};
+
+struct tar_dir_attr {
+    char *name;
+    /* identity of the created directory, entries after it may replace it */
+    dev_t dev;
+    ino_t ino;
+    struct tar_attr attr;
+};
+
+struct tar_extractor {
+    struct tar_reader reader;
+    const char *dstdir;
+    int root_fd;
+    char *src_base;
+    char *dst_base;
+    bool is_root;
+    mode_t umask;
+
+    /* last resolved parent directory */
+    char *parent_name;
+    int parent_fd;
+
+    /* attributes of directories are set after their entries are extracted */
+    struct tar_dir_attr *dirs;
+    size_t dirs_len;
+    size_t dirs_cap;
+
+    thread_pool_t *pool;
+    bool pool_failed;
+    uint64_t job_bytes;
+    size_t job_count;
+    pthread_mutex_t job_lock;
+    int job_ret;
+    char *job_err;
+
+    char **err;
+};
+
+struct tar_file_job {
+    struct tar_extractor *x;
+    int fd;
+    char *name;
+    char *data;
+    size_t len;
+    struct tar_attr attr;
+};
+
+/* return bytes read, 0 if content is end, -1 if failed */
+static ssize_t reader_fill(struct tar_reader *r)
+{
+    ssize_t nret;
+    int zret;
+    size_t produced;
+
+    r->pos = 0;
+    r->len = 0;
+    if (r->eof) {
+        return 0;
+    }
+
+    if (!r->compression) {
+        nret = r->content->read(r->content->context, r->buf, TAR_IO_BUF_SIZE);
+        if (nret <= 0) {
+            r->eof = true;
+            return 0;
+        }
+        r->len = (size_t)nret;
+        return nret;
+    }
+
+    for (;;) {
+        if (r->zs.avail_in == 0) {
+            nret = r->content->read(r->content->context, r->raw, TAR_IO_BUF_SIZE);
+            if (nret <= 0) {
+                r->eof = true;
+                return 0;
+            }
+            r->zs.next_in = r->raw;
+            r->zs.avail_in = (uInt)nret;
+        }
+        r->zs.next_out = r->buf;
+        r->zs.avail_out = TAR_IO_BUF_SIZE;
+        zret = inflate(&r->zs, Z_NO_FLUSH);
+        if (zret != Z_OK && zret != Z_STREAM_END && zret != Z_BUF_ERROR) {
+            ERROR("Failed to decompress archive: %s", r->zs.msg != NULL ? r->zs.msg : "unknown");
+            return -1;
+        }
+        produced = TAR_IO_BUF_SIZE - r->zs.avail_out;
+        if (zret == Z_STREAM_END) {
+            r->eof = true;
+            r->len = produced;
+            return (ssize_t)produced;
+        }
+        if (produced > 0) {
+            r->len = produced;
+            return (ssize_t)produced;
+        }
+    }
+}
+
+/* get up to len bytes without copy, return 0 if content is end, -1 if failed */
+static ssize_t reader_next(struct tar_reader *r, size_t len, const unsigned char **data)
+{
+    size_t avail;
+    ssize_t nret;
+
+    if (r->pos == r->len) {
+        nret = reader_fill(r);
+        if (nret <= 0) {
+            return nret;
+        }
+    }
+    avail = r->len - r->pos;
+    if (avail > len) {
+        avail = len;
+    }
+    *data = r->buf + r->pos;
+    r->pos += avail;
+    return (ssize_t)avail;
+}
+
+/* return 0 if read len bytes, 1 if content is end before any byte read, -1 otherwise */
+static int reader_read(struct tar_reader *r, void *dst, size_t len)
+{
+    char *p = dst;
+    size_t total = len;
+    const unsigned char *data = NULL;
+    ssize_t nret;
+
+    while (len > 0) {
+        nret = reader_next(r, len, &data);
+        if (nret <= 0) {
+            return (nret == 0 && len == total) ? 1 : -1;
+        }
+        (void)memcpy(p, data, (size_t)nret);
+        p += nret;
+        len -= (size_t)nret;
+    }
+    return 0;
+}
+
+static int reader_skip(struct tar_reader *r, uint64_t len)
+{
+    const unsigned char *data = NULL;
+    ssize_t nret;
+
+    while (len > 0) {
+        nret = reader_next(r, len > TAR_IO_BUF_SIZE ? TAR_IO_BUF_SIZE : (size_t)len, &data);
+        if (nret <= 0) {
+            return -1;
+        }
+        len -= (uint64_t)nret;
+    }
+    return 0;
+}
+
+static uint64_t padded_size(uint64_t size)
+{
+    return (size + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE * TAR_BLOCK_SIZE;
+}
+
+/* read the rest of content, so the peer does not see a broken stream */
+static void reader_drain(struct tar_reader *r)
+{
+    unsigned char *buf = r->compression ? r->raw : r->buf;
+
+    while (r->content->read(r->content->context, buf, TAR_IO_BUF_SIZE) > 0) {
+    }
+    r->eof = true;
+}
+
+static int reader_init(struct tar_reader *r, const struct io_read_wrapper *content, bool compression)
+{
+    r->content = content;
+    r->compression = compression;
+    r->buf = util_common_calloc_s(TAR_IO_BUF_SIZE);
+    if (r->buf == NULL) {
+        ERROR("Out of memory");
+        return -1;
+    }
+    if (!compression) {
+        return 0;
+    }
+
+    r->raw = util_common_calloc_s(TAR_IO_BUF_SIZE);
+    if (r->raw == NULL) {
+        ERROR("Out of memory");
+        return -1;
+    }
+    // 32 + max window bits to detect gzip or zlib wrapper
+    if (inflateInit2(&r->zs, 15 + 32) != Z_OK) {
+        ERROR("Failed to init decompression");
+        return -1;
+    }
+    r->zs_inited = true;
+    return 0;
+}
+
+static void reader_free(struct tar_reader *r)
+{
+    if (r->zs_inited) {
+        (void)inflateEnd(&r->zs);
+        r->zs_inited = false;
+    }
+    free(r->buf);
+    r->buf = NULL;
+    free(r->raw);
+    r->raw = NULL;
+}
+
+/* clean name to relative path without empty and "." components, return 1 if it contains ".." */
+static int clean_entry_name(const char *name, char **cleaned)
+{
+    char *res = NULL;
+    const char *p = name;
+    const char *end = NULL;
+    size_t len = 0;
+    size_t n;
+
+    res = util_common_calloc_s(strlen(name) + 1);
+    if (res == NULL) {
+        ERROR("Out of memory");
+        return -1;
+    }
+
+    while (*p != '\0') {
+        end = strchrnul(p, '/');
+        n = (size_t)(end - p);
+        if (n == 2 && p[0] == '.' && p[1] == '.') {
+            free(res);
+            return 1;
+        }
+        if (n > 0 && !(n == 1 && p[0] == '.')) {
+            if (len > 0) {
+                res[len++] = '/';
+            }
+            (void)memcpy(res + len, p, n);
+            len += n;
+        }
+        p = (*end == '/') ? end + 1 : end;
+    }
+
+    *cleaned = res;
+    return 0;
+}
+
+/* replace leading src_base component of name by dst_base */
+static char *rebase_entry_name(const struct tar_extractor *x, const char *name)
+{
+    size_t src_len;
+    const char *rest = name;
+    char *res = NULL;
+    size_t len;
+
+    if (x->src_base == NULL || x->dst_base == NULL) {
+        return util_strdup_s(name);
+    }
+
+    src_len = strlen(x->src_base);
+    if (src_len > 0) {
+        if (strncmp(name, x->src_base, src_len) != 0 || (name[src_len] != '\0' && name[src_len] != '/')) {
+            return util_strdup_s(name);
+        }
+        rest = name + src_len;
+        if (*rest == '/') {
+            rest++;
+        }
+    }
+
+    if (x->dst_base[0] == '\0') {
+        return util_strdup_s(rest);
+    }
+    if (*rest == '\0') {
+        return util_strdup_s(x->dst_base);
+    }
+
+    len = strlen(x->dst_base) + strlen(rest) + 2;
+    res = util_common_calloc_s(len);
+    if (res == NULL) {
+        ERROR("Out of memory");
+        return NULL;
+    }
+    (void)snprintf(res, len, "%s/%s", x->dst_base, rest);
+    return res;
+}
+
+/* return 1 if entry should be skipped */
+static int entry_name(const struct tar_extractor *x, const char *raw, char **name)
+{
+    int nret;
+    char *cleaned = NULL;
+
+    nret = clean_entry_name(raw, &cleaned);
+    if (nret != 0) {
+        if (nret > 0) {
+            WARN("Skip entry %s which contains \"..\"", raw);
+        }
+        return nret;
+    }
+
+    *name = rebase_entry_name(x, cleaned);
+    free(cleaned);
+    return (*name == NULL) ? -1 : 0;
+}
+
+static void tar_meta_free(struct tar_meta *meta)
+{
+    free(meta->path);
+    free(meta->linkpath);
+    (void)memset(meta, 0, sizeof(*meta));
+}
+
+static void tar_entry_free(struct tar_entry *e)
+{
+    free(e->name);
+    free(e->linkname);
+    (void)memset(e, 0, sizeof(*e));
+}
+
+static void parse_pax_time(const char *value, struct timespec *ts)
+{
+    char *end = NULL;
+    long nsec = 0;
+    int digits = 0;
+
+    ts->tv_sec = (time_t)strtoll(value, &end, 10);
+    ts->tv_nsec = 0;
+    if (end == NULL || *end != '.') {
+        return;
+    }
+    for (end++; *end >= '0' && *end <= '9' && digits < 9; end++, digits++) {
+        nsec = nsec * 10 + (*end - '0');
+    }
+    for (; digits < 9; digits++) {
+        nsec *= 10;
+    }
+    ts->tv_nsec = nsec;
+}
+
+static int parse_pax_records(char *data, size_t len, struct tar_meta *meta)
+{
+    char *end = NULL;
+    char *key = NULL;
+    char *value = NULL;
+    unsigned long long rec_len;
+
+    while (len > 0) {
+        errno = 0;
+        rec_len = strtoull(data, &end, 10);
+        if (errno != 0 || end == data || *end != ' ' || rec_len > len || rec_len <= (size_t)(end - data) + 1 ||
+            data[rec_len - 1] != '\n') {
+            return -1;
+        }
+        data[rec_len - 1] = '\0';
+        key = end + 1;
+        value = strchr(key, '=');
+        if (value == NULL) {
+            return -1;
+        }
+        *value++ = '\0';
+
+        if (strcmp(key, "path") == 0) {
+            free(meta->path);
+            meta->path = util_strdup_s(value);
+        } else if (strcmp(key, "linkpath") == 0) {
+            free(meta->linkpath);
+            meta->linkpath = util_strdup_s(value);
+        } else if (strcmp(key, "size") == 0) {
+            meta->has_size = true;
+            meta->size = strtoull(value, NULL, 10);
+        } else if (strcmp(key, "uid") == 0) {
+            meta->has_uid = true;
+            meta->uid = strtoull(value, NULL, 10);
+        } else if (strcmp(key, "gid") == 0) {
+            meta->has_gid = true;
+            meta->gid = strtoull(value, NULL, 10);
+        } else if (strcmp(key, "mtime") == 0) {
+            meta->has_mtime = true;
+            parse_pax_time(value, &meta->mtime);
+        }
+
+        data += rec_len;
+        len -= rec_len;
+    }
+    return 0;
+}
+
+/* read data of a pax header or gnu long name entry */
+static char *read_meta_data(struct tar_extractor *x, uint64_t size)
+{
+    char *data = NULL;
+
+    if (size > TAR_MAX_META_SIZE) {
+        ERROR("Too large tar header entry: %llu", (unsigned long long)size);
+        tar_set_error(x->err, "Too large tar header entry: %llu", (unsigned long long)size);
+        return NULL;
+    }
+    data = util_common_calloc_s((size_t)size + 1);
+    if (data == NULL) {
+        ERROR("Out of memory");
+        return NULL;
+    }
+    if (reader_read(&x->reader, data, (size_t)size) != 0 ||
+        reader_skip(&x->reader, padded_size(size) - size) != 0) {
+        ERROR("Unexpected EOF in archive");
+        tar_set_error(x->err, "Unexpected EOF in archive");
+        free(data);
+        return NULL;
+    }
+    return data;
+}
+
+static char *header_field_string(const char *field, size_t size)
+{
+    size_t len = strnlen(field, size);
+    char *res = util_common_calloc_s(len + 1);
+
+    if (res != NULL) {
+        (void)memcpy(res, field, len);
+    }
+    return res;
+}
+
+static char *header_raw_name(const struct tar_header *hdr)
+{
+    size_t prefix_len = strnlen(hdr->prefix, sizeof(hdr->prefix));
+    size_t name_len = strnlen(hdr->name, sizeof(hdr->name));
+    char *res = NULL;
+
+    // only posix ustar has prefix, gnu tar stores other fields there
+    if (memcmp(hdr->magic, "ustar", 6) != 0 || prefix_len == 0) {
+        return header_field_string(hdr->name, sizeof(hdr->name));
+    }
+
+    res = util_common_calloc_s(prefix_len + name_len + 2);
+    if (res == NULL) {
+        return NULL;
+    }
+    (void)memcpy(res, hdr->prefix, prefix_len);
+    res[prefix_len] = '/';
+    (void)memcpy(res + prefix_len + 1, hdr->name, name_len);
+    return res;
+}
+
+/* return 1 if entry should be skipped */
+static int parse_entry(struct tar_extractor *x, const struct tar_header *hdr, const struct tar_meta *meta,
+                       struct tar_entry *e)
+{
+    int ret = -1;
+    uint64_t mode = 0;
+    uint64_t uid = 0;
+    uint64_t gid = 0;
+    uint64_t mtime = 0;
+    uint64_t dev_major = 0;
+    uint64_t dev_minor = 0;
+    char *raw = NULL;
+    char *raw_link = NULL;
+
+    if (parse_number(hdr->mode, sizeof(hdr->mode), &mode) != 0 ||
+        parse_number(hdr->uid, sizeof(hdr->uid), &uid) != 0 ||
+        parse_number(hdr->gid, sizeof(hdr->gid), &gid) != 0 ||
+        parse_number(hdr->size, sizeof(hdr->size), &e->size) != 0 ||
+        parse_number(hdr->mtime, sizeof(hdr->mtime), &mtime) != 0) {
+        ERROR("Invalid tar header");
+        tar_set_error(x->err, "Invalid tar header");
+        return -1;
+    }
+    e->type = hdr->typeflag;
+    if (e->type == TAR_TYPE_CHR || e->type == TAR_TYPE_BLK) {
+        if (parse_number(hdr->devmajor, sizeof(hdr->devmajor), &dev_major) != 0 ||
+            parse_number(hdr->devminor, sizeof(hdr->devminor), &dev_minor) != 0) {
+            ERROR("Invalid tar header");
+            tar_set_error(x->err, "Invalid tar header");
+            return -1;
+        }
+        e->rdev = makedev((unsigned int)dev_major, (unsigned int)dev_minor);
+    }
+
+    e->attr.mode = (mode_t)(mode & 07777);
+    e->attr.uid = (uid_t)(meta->has_uid ? meta->uid : uid);
+    e->attr.gid = (gid_t)(meta->has_gid ? meta->gid : gid);
+    e->attr.mtime.tv_sec = (time_t)mtime;
+    if (meta->has_mtime) {
+        e->attr.mtime = meta->mtime;
+    }
+    if (meta->has_size) {
+        e->size = meta->size;
+    }
+
+    raw = (meta->path != NULL) ? util_strdup_s(meta->path) : header_raw_name(hdr);
+    raw_link = (meta->linkpath != NULL) ? util_strdup_s(meta->linkpath) :
+               header_field_string(hdr->linkname, sizeof(hdr->linkname));
+    if (raw == NULL || raw_link == NULL) {
+        ERROR("Out of memory");
+        goto out;
+    }
+
+    if (e->type == '\0' || e->type == TAR_TYPE_CONT) {
+        e->type = TAR_TYPE_REG;
+    }
+    // old archives mark directories by trailing slash only
+    if (e->type == TAR_TYPE_REG && strlen(raw) > 0 && raw[strlen(raw) - 1] == '/') {
+        e->type = TAR_TYPE_DIR;
+    }
+
+    ret = entry_name(x, raw, &e->name);
+    if (ret != 0) {
+        goto out;
+    }
+    if (e->type == TAR_TYPE_LINK) {
+        // hard link target is an entry of the archive too
+        ret = entry_name(x, raw_link, &e->linkname);
+    } else {
+        e->linkname = raw_link;
+        raw_link = NULL;
+    }
+
+out:
+    free(raw);
+    free(raw_link);
+    return ret;
+}
+
+static int open_dirs(const struct tar_extractor *x, const char *dir)
+{
+    int fd = x->root_fd;
+    int next = -1;
+    int saved_errno = 0;
+    char *dup = NULL;
+    char *comp = NULL;
+    char *saveptr = NULL;
+
+    dup = util_strdup_s(dir);
+    for (comp = strtok_r(dup, "/", &saveptr); comp != NULL; comp = strtok_r(NULL, "/", &saveptr)) {
+        next = openat(fd, comp, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (next < 0 && errno == ENOENT) {
+            if (mkdirat(fd, comp, 0755) != 0 && errno != EEXIST) {
+                saved_errno = errno;
+                goto err_out;
+            }
+            next = openat(fd, comp, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        }
+        if (next < 0) {
+            saved_errno = errno;
+            goto err_out;
+        }
+        if (fd != x->root_fd) {
+            close(fd);
+        }
+        fd = next;
+    }
+    free(dup);
+    return fd;
+
+err_out:
+    if (fd != x->root_fd) {
+        close(fd);
+    }
+    free(dup);
+    errno = saved_errno;
+    return -1;
+}
+
+/* open dir in dstdir, following symlinks in it in scope of dstdir */
+static int open_dirs_in_scope(const struct tar_extractor *x, const char *dir)
+{
+    int fd = -1;
+    char *full = NULL;
+    char *resolved = NULL;
+    const char *rel = NULL;
+    char root[PATH_MAX] = { 0 };
+
+    fd = open_dirs(x, dir);
+    if (fd >= 0 || (errno != ELOOP && errno != ENOTDIR)) {
+        return fd;
+    }
+
+    if (cleanpath(x->dstdir, root, sizeof(root)) == NULL) {
+        return -1;
+    }
+    full = util_path_join(root, dir);
+    if (full == NULL) {
+        return -1;
+    }
+    resolved = follow_symlink_in_scope(full, root);
+    free(full);
+    if (resolved == NULL || strncmp(resolved, root, strlen(root)) != 0) {
+        free(resolved);
+        errno = ENOTDIR;
+        return -1;
+    }
+
+    rel = resolved + strlen(root);
+    while (*rel == '/') {
+        rel++;
+    }
+    fd = (*rel == '\0') ? fcntl(x->root_fd, F_DUPFD_CLOEXEC, 0) : open_dirs(x, rel);
+    free(resolved);
+    return fd;
+}
+
+/* return fd of parent directory of name, which is owned by extractor, and set base to last component of name */
+static int resolve_parent(struct tar_extractor *x, const char *name, const char **base)
+{
+    const char *slash = strrchr(name, '/');
+    size_t dir_len;
+    char *dir = NULL;
+    int fd = -1;
+
+    if (slash == NULL) {
+        *base = name;
+        return x->root_fd;
+    }
+    *base = slash + 1;
+    dir_len = (size_t)(slash - name);
+
+    if (x->parent_name != NULL && strlen(x->parent_name) == dir_len && strncmp(x->parent_name, name, dir_len) == 0) {
+        return x->parent_fd;
+    }
+
+    dir = util_common_calloc_s(dir_len + 1);
+    if (dir == NULL) {
+        ERROR("Out of memory");
+        return -1;
+    }
+    (void)memcpy(dir, name, dir_len);
+
+    fd = open_dirs_in_scope(x, dir);
+    if (fd < 0) {
+        ERROR("Failed to open directory %s: %s", dir, strerror(errno));
+        tar_set_error(x->err, "Failed to open directory %s: %s", dir, strerror(errno));
+        free(dir);
+        return -1;
+    }
+
+    if (x->parent_fd >= 0) {
+        close(x->parent_fd);
+    }
+    free(x->parent_name);
+    x->parent_name = dir;
+    x->parent_fd = fd;
+    return fd;
+}
+
+static void invalidate_parent(struct tar_extractor *x)
+{
+    if (x->parent_fd >= 0) {
+        close(x->parent_fd);
+        x->parent_fd = -1;
+    }
+    free(x->parent_name);
+    x->parent_name = NULL;
+}
+
+/* remove existing entry to be replaced by entry of archive */
+static int remove_existing(struct tar_extractor *x, int parent_fd, const char *base, const char *name)
+{
+    struct stat st;
+    int flags = 0;
+
+    if (fstatat(parent_fd, base, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+        return (errno == ENOENT) ? 0 : -1;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        flags = AT_REMOVEDIR;
+        invalidate_parent(x);
+    }
+    if (unlinkat(parent_fd, base, flags) != 0) {
+        ERROR("Failed to remove existing %s: %s", name, strerror(errno));
+        tar_set_error(x->err, "Failed to remove existing %s: %s", name, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+static void set_job_error(struct tar_extractor *x, const char *name, int err_no)
+{
+    ERROR("Failed to extract %s: %s", name, strerror(err_no));
+    pthread_mutex_lock(&x->job_lock);
+    if (x->job_ret == 0) {
+        x->job_ret = -1;
+        tar_set_error(&x->job_err, "Failed to extract %s: %s", name, strerror(err_no));
+    }
+    pthread_mutex_unlock(&x->job_lock);
+}
+
+static int write_all(int fd, const void *data, size_t len)
+{
+    const char *p = data;
+    ssize_t nret;
+
+    while (len > 0) {
+        nret = util_write_nointr(fd, p, len);
+        if (nret <= 0) {
+            return -1;
+        }
+        p += nret;
+        len -= (size_t)nret;
+    }
+    return 0;
+}
+
+static int set_fd_attr(const struct tar_extractor *x, int fd, const struct tar_attr *attr)
+{
+    struct timespec times[2] = { { 0, UTIME_OMIT }, attr->mtime };
+
+    if (x->is_root) {
+        if (fchown(fd, attr->uid, attr->gid) != 0) {
+            return -1;
+        }
+        // after chown, which clears set-user-ID and set-group-ID bits
+        if (fchmod(fd, attr->mode) != 0) {
+            return -1;
+        }
+    }
+    return futimens(fd, times);
+}
+
+static void file_job_run(void *arg)
+{
+    struct tar_file_job *job = arg;
+
+    if (write_all(job->fd, job->data, job->len) != 0 || set_fd_attr(job->x, job->fd, &job->attr) != 0) {
+        set_job_error(job->x, job->name, errno);
+    }
+    close(job->fd);
+    free(job->data);
+    free(job->name);
+    free(job);
+}
+
+/* wait for workers if too many data is in flight */
+static void throttle_jobs(struct tar_extractor *x, size_t len)
+{
+    x->job_bytes += len;
+    x->job_count++;
+    if (x->job_bytes > TAR_JOB_MAX_BYTES || x->job_count > TAR_JOB_MAX_COUNT) {
+        thread_pool_wait(x->pool);
+        x->job_bytes = 0;
+        x->job_count = 0;
+    }
+}
+
+static bool use_file_job(struct tar_extractor *x, uint64_t size)
+{
+    if (size > TAR_JOB_FILE_MAX || x->pool_failed) {
+        return false;
+    }
+    if (x->pool == NULL) {
+        x->pool = thread_pool_new("TarExtract", thread_pool_default_workers(0, TAR_JOB_MAX_WORKERS));
+        if (x->pool == NULL) {
+            WARN("Failed to create extract workers, extract files sequentially");
+            x->pool_failed = true;
+            return false;
+        }
+    }
+    return true;
+}
+
+static int submit_file_job(struct tar_extractor *x, const struct tar_entry *e, int fd)
+{
+    struct tar_file_job *job = NULL;
+
+    job = util_common_calloc_s(sizeof(struct tar_file_job));
+    if (job == NULL) {
+        ERROR("Out of memory");
+        return -1;
+    }
+    job->len = (size_t)e->size;
+    if (job->len > 0) {
+        job->data = util_common_calloc_s(job->len);
+        if (job->data == NULL) {
+            ERROR("Out of memory");
+            free(job);
+            return -1;
+        }
+        if (reader_read(&x->reader, job->data, job->len) != 0) {
+            ERROR("Unexpected EOF in archive");
+            tar_set_error(x->err, "Unexpected EOF in archive");
+            free(job->data);
+            free(job);
+            return -1;
+        }
+    }
+    job->x = x;
+    job->fd = fd;
+    job->name = util_strdup_s(e->name);
+    job->attr = e->attr;
+
+    if (thread_pool_submit(x->pool, file_job_run, job) != 0) {
+        ERROR("Failed to submit extract job of %s", e->name);
+        free(job->data);
+        free(job->name);
+        free(job);
+        return -1;
+    }
+    // job may be freed by worker already
+    throttle_jobs(x, (size_t)e->size);
+    return 0;
+}
+
+static int write_file_data(struct tar_extractor *x, const struct tar_entry *e, int fd)
+{
+    uint64_t left = e->size;
+    const unsigned char *data = NULL;
+    ssize_t nret;
+
+    while (left > 0) {
+        nret = reader_next(&x->reader, left > TAR_IO_BUF_SIZE ? TAR_IO_BUF_SIZE : (size_t)left, &data);
+        if (nret <= 0) {
+            ERROR("Unexpected EOF in archive");
+            tar_set_error(x->err, "Unexpected EOF in archive");
+            return -1;
+        }
+        if (write_all(fd, data, (size_t)nret) != 0) {
+            ERROR("Failed to write %s: %s", e->name, strerror(errno));
+            tar_set_error(x->err, "Failed to write %s: %s", e->name, strerror(errno));
+            return -1;
+        }
+        left -= (uint64_t)nret;
+    }
+    if (set_fd_attr(x, fd, &e->attr) != 0) {
+        ERROR("Failed to set attributes of %s: %s", e->name, strerror(errno));
+        tar_set_error(x->err, "Failed to set attributes of %s: %s", e->name, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+static int extract_regular(struct tar_extractor *x, const struct tar_entry *e, int parent_fd, const char *base)
+{
+    int ret = -1;
+    int fd = -1;
+    int flags = O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC;
+    mode_t mode = x->is_root ? 0600 : (e->attr.mode & 0777);
+
+    fd = openat(parent_fd, base, flags, mode);
+    if (fd < 0 && errno == EEXIST) {
+        if (remove_existing(x, parent_fd, base, e->name) != 0) {
+            return -1;
+        }
+        fd = openat(parent_fd, base, flags, mode);
+    }
+    if (fd < 0) {
+        ERROR("Failed to create %s: %s", e->name, strerror(errno));
+        tar_set_error(x->err, "Failed to create %s: %s", e->name, strerror(errno));
+        return -1;
+    }
+
+    if (use_file_job(x, e->size)) {
+        // worker owns fd from now on
+        ret = submit_file_job(x, e, fd);
+        if (ret != 0) {
+            close(fd);
+            return -1;
+        }
+        return reader_skip(&x->reader, padded_size(e->size) - e->size);
+    }
+
+    ret = write_file_data(x, e, fd);
+    close(fd);
+    if (ret != 0) {
+        return -1;
+    }
+    return reader_skip(&x->reader, padded_size(e->size) - e->size);
+}
+
+static int add_dir_attr(struct tar_extractor *x, const struct tar_entry *e, const struct stat *st)
+{
+    struct tar_dir_attr *dirs = NULL;
+    size_t cap;
+
+    if (x->dirs_len == x->dirs_cap) {
+        cap = (x->dirs_cap == 0) ? 64 : x->dirs_cap * 2;
+        dirs = util_common_calloc_s(cap * sizeof(struct tar_dir_attr));
+        if (dirs == NULL) {
+            ERROR("Out of memory");
+            return -1;
+        }
+        if (x->dirs_len > 0) {
+            (void)memcpy(dirs, x->dirs, x->dirs_len * sizeof(struct tar_dir_attr));
+        }
+        free(x->dirs);
+        x->dirs = dirs;
+        x->dirs_cap = cap;
+    }
+
+    x->dirs[x->dirs_len].name = util_strdup_s(e->name);
+    x->dirs[x->dirs_len].dev = st->st_dev;
+    x->dirs[x->dirs_len].ino = st->st_ino;
+    x->dirs[x->dirs_len].attr = e->attr;
+    x->dirs_len++;
+    return 0;
+}
+
+static int extract_dir(struct tar_extractor *x, const struct tar_entry *e, int parent_fd, const char *base)
+{
+    struct stat st;
+
+    // entries can be created in directory before its permission is set
+    if (mkdirat(parent_fd, base, 0700) != 0) {
+        if (errno != EEXIST) {
+            ERROR("Failed to create directory %s: %s", e->name, strerror(errno));
+            tar_set_error(x->err, "Failed to create directory %s: %s", e->name, strerror(errno));
+            return -1;
+        }
+        if (fstatat(parent_fd, base, &st, AT_SYMLINK_NOFOLLOW) != 0 || !S_ISDIR(st.st_mode)) {
+            if (remove_existing(x, parent_fd, base, e->name) != 0) {
+                return -1;
+            }
+            if (mkdirat(parent_fd, base, 0700) != 0) {
+                ERROR("Failed to create directory %s: %s", e->name, strerror(errno));
+                tar_set_error(x->err, "Failed to create directory %s: %s", e->name, strerror(errno));
+                return -1;
+            }
+        }
+    }
+    if (fstatat(parent_fd, base, &st, AT_SYMLINK_NOFOLLOW) != 0 || !S_ISDIR(st.st_mode)) {
+        ERROR("Failed to stat directory %s: %s", e->name, strerror(errno));
+        tar_set_error(x->err, "Failed to stat directory %s: %s", e->name, strerror(errno));
+        return -1;
+    }
+    return add_dir_attr(x, e, &st);
+}
+
+static int set_path_attr(const struct tar_extractor *x, int parent_fd, const char *base, const struct tar_attr *attr,
+                         bool set_mode)
+{
+    struct timespec times[2] = { { 0, UTIME_OMIT }, attr->mtime };
+    mode_t mode = attr->mode;
+
+    if (x->is_root && fchownat(parent_fd, base, attr->uid, attr->gid, AT_SYMLINK_NOFOLLOW) != 0) {
+        return -1;
+    }
+    if (set_mode) {
+        if (!x->is_root) {
+            mode &= (0777 & ~x->umask);
+        }
+        if (fchmodat(parent_fd, base, mode, 0) != 0) {
+            return -1;
+        }
+    }
+    return utimensat(parent_fd, base, times, AT_SYMLINK_NOFOLLOW);
+}
+
+static int extract_symlink(struct tar_extractor *x, const struct tar_entry *e, int parent_fd, const char *base)
+{
+    int nret;
+
+    nret = symlinkat(e->linkname, parent_fd, base);
+    if (nret != 0 && errno == EEXIST) {
+        if (remove_existing(x, parent_fd, base, e->name) != 0) {
+            return -1;
+        }
+        nret = symlinkat(e->linkname, parent_fd, base);
+    }
+    if (nret != 0 || set_path_attr(x, parent_fd, base, &e->attr, false) != 0) {
+        ERROR("Failed to create symlink %s: %s", e->name, strerror(errno));
+        tar_set_error(x->err, "Failed to create symlink %s: %s", e->name, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+static int extract_hardlink(struct tar_extractor *x, const struct tar_entry *e)
+{
+    int ret = -1;
+    int nret;
+    int target_fd = -1;
+    int parent_fd = -1;
+    const char *target_base = NULL;
+    const char *base = NULL;
+
+    target_fd = resolve_parent(x, e->linkname, &target_base);
+    if (target_fd < 0) {
+        return -1;
+    }
+    // cached parent may be replaced by resolving parent of the link
+    target_fd = fcntl(target_fd, F_DUPFD_CLOEXEC, 0);
+    if (target_fd < 0) {
+        ERROR("Failed to dup fd: %s", strerror(errno));
+        return -1;
+    }
+
+    parent_fd = resolve_parent(x, e->name, &base);
+    if (parent_fd < 0) {
+        goto out;
+    }
+    nret = linkat(target_fd, target_base, parent_fd, base, 0);
+    if (nret != 0 && errno == EEXIST) {
+        if (remove_existing(x, parent_fd, base, e->name) != 0) {
+            goto out;
+        }
+        // removing a directory invalidates cached parent
+        parent_fd = resolve_parent(x, e->name, &base);
+        if (parent_fd < 0) {
+            goto out;
+        }
+        nret = linkat(target_fd, target_base, parent_fd, base, 0);
+    }
+    if (nret != 0) {
+        ERROR("Failed to link %s to %s: %s", e->name, e->linkname, strerror(errno));
+        tar_set_error(x->err, "Failed to link %s to %s: %s", e->name, e->linkname, strerror(errno));
+        goto out;
+    }
+    ret = 0;
+
+out:
+    close(target_fd);
+    return ret;
+}
+
+static int extract_node(struct tar_extractor *x, const struct tar_entry *e, int parent_fd, const char *base)
+{
+    mode_t type = S_IFIFO;
+    int nret;
+
+    if (e->type == TAR_TYPE_CHR) {
+        type = S_IFCHR;
+    } else if (e->type == TAR_TYPE_BLK) {
+        type = S_IFBLK;
+    }
+
+    nret = mknodat(parent_fd, base, type | (e->attr.mode & 0777), e->rdev);
+    if (nret != 0 && errno == EEXIST) {
+        if (remove_existing(x, parent_fd, base, e->name) != 0) {
+            return -1;
+        }
+        nret = mknodat(parent_fd, base, type | (e->attr.mode & 0777), e->rdev);
+    }
+    if (nret != 0 || set_path_attr(x, parent_fd, base, &e->attr, x->is_root) != 0) {
+        ERROR("Failed to create %s: %s", e->name, strerror(errno));
+        tar_set_error(x->err, "Failed to create %s: %s", e->name, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+static int extract_entry(struct tar_extractor *x, const struct tar_entry *e)
+{
+    int parent_fd = -1;
+    const char *base = NULL;
+    uint64_t skip = padded_size(e->size);
+
+    if (e->name[0] == '\0') {
+        // the destination itself, keep it as it is
+        if (e->type != TAR_TYPE_DIR) {
+            ERROR("Can not extract %c entry to destination directory itself", e->type);
+            tar_set_error(x->err, "Can not extract non directory entry to destination directory itself");
+            return -1;
+        }
+        return reader_skip(&x->reader, skip);
+    }
+
+    if (e->type == TAR_TYPE_LINK) {
+        if (extract_hardlink(x, e) != 0) {
+            return -1;
+        }
+        return reader_skip(&x->reader, skip);
+    }
+
+    parent_fd = resolve_parent(x, e->name, &base);
+    if (parent_fd < 0) {
+        return -1;
+    }
+
+    switch (e->type) {
+        case TAR_TYPE_REG:
+            return extract_regular(x, e, parent_fd, base);
+        case TAR_TYPE_DIR:
+            if (extract_dir(x, e, parent_fd, base) != 0) {
+                return -1;
+            }
+            break;
+        case TAR_TYPE_SYMLINK:
+            if (extract_symlink(x, e, parent_fd, base) != 0) {
+                return -1;
+            }
+            break;
+        case TAR_TYPE_CHR:
+        case TAR_TYPE_BLK:
+        case TAR_TYPE_FIFO:
+            if (extract_node(x, e, parent_fd, base) != 0) {
+                return -1;
+            }
+            break;
+        default:
+            WARN("Skip entry %s of unsupported type %c", e->name, e->type);
+            break;
+    }
+    return reader_skip(&x->reader, skip);
+}
+
+static bool is_zero_block(const struct tar_header *hdr)
+{
+    return memcmp(hdr, g_zero_block, TAR_BLOCK_SIZE) == 0;
+}
+
+static bool header_valid(const struct tar_header *hdr)
+{
+    uint64_t chksum = 0;
+    int ssum = 0;
+    unsigned int sum = header_checksum(hdr, &ssum);
+
+    if (parse_number(hdr->chksum, sizeof(hdr->chksum), &chksum) != 0) {
+        return false;
+    }
+    // old tars computed checksum by signed char
+    return chksum == sum || (int64_t)chksum == (int64_t)ssum;
+}
+
+static int read_meta_entry(struct tar_extractor *x, const struct tar_header *hdr, struct tar_meta *meta)
+{
+    uint64_t size = 0;
+    char *data = NULL;
+    int ret = 0;
+
+    if (parse_number(hdr->size, sizeof(hdr->size), &size) != 0) {
+        ERROR("Invalid tar header");
+        tar_set_error(x->err, "Invalid tar header");
+        return -1;
+    }
+    if (hdr->typeflag == TAR_TYPE_PAX_GLOBAL) {
+        return reader_skip(&x->reader, padded_size(size));
+    }
+
+    data = read_meta_data(x, size);
+    if (data == NULL) {
+        return -1;
+    }
+    if (hdr->typeflag == TAR_TYPE_PAX) {
+        if (parse_pax_records(data, (size_t)size, meta) != 0) {
+            ERROR("Invalid pax header");
+            tar_set_error(x->err, "Invalid pax header");
+            ret = -1;
+        }
+        free(data);
+    } else if (hdr->typeflag == TAR_TYPE_GNU_LONGNAME) {
+        free(meta->path);
+        meta->path = data;
+    } else {
+        free(meta->linkpath);
+        meta->linkpath = data;
+    }
+    return ret;
+}
+
+static int extract_entries(struct tar_extractor *x)
+{
+    int ret = 0;
+    int nret;
+    struct tar_header hdr;
+    struct tar_meta meta = { 0 };
+    struct tar_entry e = { 0 };
+
+    for (;;) {
+        nret = reader_read(&x->reader, &hdr, sizeof(hdr));
+        if (nret != 0) {
+            ERROR("Unexpected EOF in archive");
+            tar_set_error(x->err, "Unexpected EOF in archive");
+            ret = -1;
+            break;
+        }
+        if (is_zero_block(&hdr)) {
+            break;
+        }
+        if (!header_valid(&hdr)) {
+            ERROR("Invalid tar header checksum, this does not look like a tar archive");
+            tar_set_error(x->err, "Invalid tar header checksum, this does not look like a tar archive");
+            ret = -1;
+            break;
+        }
+
+        if (hdr.typeflag == TAR_TYPE_PAX || hdr.typeflag == TAR_TYPE_PAX_GLOBAL ||
+            hdr.typeflag == TAR_TYPE_GNU_LONGNAME || hdr.typeflag == TAR_TYPE_GNU_LONGLINK) {
+            if (read_meta_entry(x, &hdr, &meta) != 0) {
+                ret = -1;
+                break;
+            }
+            continue;
+        }
+
+        nret = parse_entry(x, &hdr, &meta, &e);
+        if (nret == 0) {
+            nret = extract_entry(x, &e);
+        } else if (nret > 0) {
+            nret = reader_skip(&x->reader, padded_size(e.size));
+        }
+        tar_meta_free(&meta);
+        tar_entry_free(&e);
+        if (nret != 0) {
+            tar_set_error(x->err, "Failed to extract archive");
+            ret = -1;
+            break;
+        }
+    }
+
+    tar_meta_free(&meta);
+    return ret;
+}
+
+static int set_dir_attr(const struct tar_extractor *x, int fd, const struct tar_attr *attr)
+{
+    // owner is kept as is if not root, so only apply umask to mode like tar does
+    if (!x->is_root && fchmod(fd, attr->mode & (0777 & ~x->umask)) != 0) {
+        return -1;
+    }
+    return set_fd_attr(x, fd, attr);
+}
+
+/*
+ * A directory may be replaced by later entries, e.g. by a symlink to a path out of dstdir,
+ * so open it without following symlinks and set attributes only if it is still the one created.
+ */
+static int finish_dir(struct tar_extractor *x, const struct tar_dir_attr *dir)
+{
+    int ret = -1;
+    int fd = -1;
+    int parent_fd = -1;
+    const char *base = NULL;
+    struct stat st;
+
+    parent_fd = resolve_parent(x, dir->name, &base);
+    if (parent_fd < 0) {
+        return -1;
+    }
+
+    fd = openat(parent_fd, base, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT || errno == ENOTDIR || errno == ELOOP) {
+            WARN("Directory %s is replaced, skip setting its attributes", dir->name);
+            return 0;
+        }
+        ERROR("Failed to open directory %s: %s", dir->name, strerror(errno));
+        return -1;
+    }
+
+    if (fstat(fd, &st) != 0) {
+        ERROR("Failed to stat directory %s: %s", dir->name, strerror(errno));
+        goto out;
+    }
+    if (st.st_dev != dir->dev || st.st_ino != dir->ino) {
+        WARN("Directory %s is replaced, skip setting its attributes", dir->name);
+        ret = 0;
+        goto out;
+    }
+
+    if (set_dir_attr(x, fd, &dir->attr) != 0) {
+        ERROR("Failed to set attributes of directory %s: %s", dir->name, strerror(errno));
+        goto out;
+    }
+    ret = 0;
+
+out:
+    close(fd);
+    return ret;
+}
+
+/* set attributes of directories after all entries are extracted, deepest first */
+static int finish_dirs(struct tar_extractor *x)
+{
+    int ret = 0;
+    size_t i;
+
+    for (i = x->dirs_len; i > 0; i--) {
+        if (finish_dir(x, &x->dirs[i - 1]) != 0) {
+            tar_set_error(x->err, "Failed to set attributes of directory %s", x->dirs[i - 1].name);
+            ret = -1;
+        }
+    }
+    return ret;
+}
+
+static mode_t current_umask(void)
+{
+    FILE *fp = NULL;
+    char *line = NULL;
+    size_t len = 0;
+    unsigned int mask = 022;
+
+    // umask(2) can only get it by setting it, which races with other threads
+    fp = fopen("/proc/self/status", "re");
+    if (fp == NULL) {
+        return (mode_t)mask;
+    }
+    while (getline(&line, &len, fp) != -1) {
+        if (sscanf(line, "Umask: %o", &mask) == 1) {
+            break;
+        }
+    }
+    free(line);
+    fclose(fp);
+    return (mode_t)mask;
+}
+
+static int extractor_init(struct tar_extractor *x, const struct io_read_wrapper *content, bool compression,
+                          const char *dstdir, const char *src_base, const char *dst_base, char **err)
+{
+    x->err = err;
+    x->dstdir = dstdir;
+    x->root_fd = -1;
+    x->parent_fd = -1;
+    x->is_root = (geteuid() == 0);
+    if (!x->is_root) {
+        x->umask = current_umask();
+    }
+    if (pthread_mutex_init(&x->job_lock, NULL) != 0) {
+        ERROR("Failed to init mutex");
+        return -1;
+    }
+
+    if (src_base != NULL && dst_base != NULL) {
+        if (clean_entry_name(src_base, &x->src_base) != 0 || clean_entry_name(dst_base, &x->dst_base) != 0) {
+            ERROR("Invalid rebase from %s to %s", src_base, dst_base);
+            tar_set_error(err, "Invalid rebase from %s to %s", src_base, dst_base);
+            return -1;
+        }
+    }
+
+    x->root_fd = open(dstdir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (x->root_fd < 0) {
+        ERROR("Failed to open directory %s: %s", dstdir, strerror(errno));
+        tar_set_error(err, "Failed to open directory %s: %s", dstdir, strerror(errno));
+        return -1;
+    }
+
+    return reader_init(&x->reader, content, compression);
+}
+
+static void extractor_free(struct tar_extractor *x)
+{
+    size_t i;
+
+    if (x->pool != NULL) {
+        thread_pool_free(x->pool);
+        x->pool = NULL;
+    }
+    for (i = 0; i < x->dirs_len; i++) {
+        free(x->dirs[i].name);
+    }
+    free(x->dirs);
+    invalidate_parent(x);
+    if (x->root_fd >= 0) {
+        close(x->root_fd);
+    }
+    reader_free(&x->reader);
+    free(x->src_base);
+    free(x->dst_base);
+    free(x->job_err);
+    (void)pthread_mutex_destroy(&x->job_lock);
+}
+
+int tar_stream_extract(const struct io_read_wrapper *content, bool compression, const char *dstdir,
+                       const char *src_base, const char *dst_base, char **err)
+{
+    int ret = -1;
+    struct tar_extractor *x = NULL;
+
+    if (content == NULL || content->read == NULL || dstdir == NULL || err == NULL) {
+        return -1;
+    }
+
+    x = util_common_calloc_s(sizeof(struct tar_extractor));
+    if (x == NULL) {
+        ERROR("Out of memory");
+        return -1;
+    }
+    if (extractor_init(x, content, compression, dstdir, src_base, dst_base, err) != 0) {
+        goto out;
+    }
+
+    ret = extract_entries(x);
+    if (x->pool != NULL) {
+        thread_pool_wait(x->pool);
+    }
+    if (x->job_ret != 0) {
+        tar_set_error(err, "%s", x->job_err);
+        ret = -1;
+    }
+    if (finish_dirs(x) != 0 && ret == 0) {
+        ret = -1;
+    }
+    if (ret == 0) {
+        reader_drain(&x->reader);
+    }
+
+out:
+    extractor_free(x);
+    free(x);
+    return ret;
+}
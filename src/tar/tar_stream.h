@@ -0,0 +1,45 @@
+/******************************************************************************
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Author: tanyifeng
+ * Create: 2020-04-15
+ * Description: provide in process tar archive writer and extractor definition
+ ******************************************************************************/
+#ifndef __ISULAD_TAR_STREAM_H_
+#define __ISULAD_TAR_STREAM_H_
+
+#include <stdbool.h>
+#include "console.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Write a tar archive of srcdir/srcbase to fd, gzip compressed if compression is true.
+ * Entries are named under rebase_name instead of srcbase if rebase_name is not NULL.
+ * Archive is written in ustar format, with pax records for names which do not fit.
+ */
+int tar_stream_write_path(int fd, const char *srcdir, const char *srcbase, const char *rebase_name,
+                          bool compression, char **err);
+
+/*
+ * Extract tar archive read from content into dstdir, gunzip it first if compression is true.
+ * If src_base and dst_base are not NULL, entries under src_base are extracted under dst_base.
+ * Entries which contain ".." are skipped, symlinks in dstdir are followed in scope of dstdir.
+ */
+int tar_stream_extract(const struct io_read_wrapper *content, bool compression, const char *dstdir,
+                       const char *src_base, const char *dst_base, char **err);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * Description: throughput benchmark of isulad-shim fifo to fifo io copy
+ * Author: leizhongkai
+ * Create: 2020-03-27
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+
+int g_log_fd = -1;
+
+#define BENCH_TOTAL_BYTES (1024UL * 1024 * 1024)
+#define BENCH_WRITE_CHUNK (4 * 1024)
+#define BENCH_COPY_BUF (16 * 1024)
+
+struct bench_pipe {
+    int fd;
+    size_t total;
+};
+
+static void *bench_producer(void *arg)
+{
+    struct bench_pipe *p = (struct bench_pipe *)arg;
+    char buf[BENCH_WRITE_CHUNK];
+    size_t left = p->total;
+    size_t len;
+
+    memset(buf, 'x', sizeof(buf));
+    buf[sizeof(buf) - 1] = '\n';
+    while (left > 0) {
+        len = left > sizeof(buf) ? sizeof(buf) : left;
+        if (write_nointr(p->fd, buf, len) < 0) {
+            break;
+        }
+        left -= len;
+    }
+    close(p->fd);
+
+    return NULL;
+}
+
+static void *bench_consumer(void *arg)
+{
+    struct bench_pipe *p = (struct bench_pipe *)arg;
+    char *buf = (char *)malloc(SHIM_SPLICE_CHUNK);
+    ssize_t n;
+
+    if (buf == NULL) {
+        return NULL;
+    }
+    for (;;) {
+        n = read(p->fd, buf, SHIM_SPLICE_CHUNK);
+        if (n > 0) {
+            p->total += (size_t)n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        break;
+    }
+    free(buf);
+
+    return NULL;
+}
+
+// the io copy loop of isulad-shim before splice: read into user buffer and write it out
+static void copy_by_read_write(int from, int to)
+{
+    char *buf = (char *)malloc(BENCH_COPY_BUF);
+    struct pollfd pfd = { from, POLLIN, 0 };
+    ssize_t n;
+
+    if (buf == NULL) {
+        return;
+    }
+    for (;;) {
+        (void)poll(&pfd, 1, -1);
+        n = read(from, buf, BENCH_COPY_BUF);
+        if (n > 0) {
+            if (write_nointr(to, buf, (size_t)n) < 0) {
+                break;
+            }
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+            continue;
+        }
+        break;
+    }
+    free(buf);
+}
+
+static void copy_by_splice(int from, int to)
+{
+    struct pollfd pfd = { from, POLLIN, 0 };
+    bool eof = false;
+
+    for (;;) {
+        (void)poll(&pfd, 1, -1);
+        if (splice_pipe_drain(from, to, &eof) < 0 || eof) {
+            break;
+        }
+    }
+}
+
+static double now_seconds()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int run_bench(const char *name, void (*copy)(int, int))
+{
+    int src[2] = { -1, -1 };
+    int dst[2] = { -1, -1 };
+    pthread_t producer;
+    pthread_t consumer;
+    struct bench_pipe in = { 0 };
+    struct bench_pipe out = { 0 };
+    double start;
+    double cost;
+
+    // same as shim: container side pipe is nonblocking, isulad fifo is opened nonblocking
+    if (pipe2(src, O_CLOEXEC | O_NONBLOCK) != 0 || pipe2(dst, O_CLOEXEC) != 0) {
+        perror("pipe2");
+        return -1;
+    }
+    (void)fcntl(src[1], F_SETFL, 0);
+    (void)fcntl(dst[1], F_SETFL, O_NONBLOCK);
+
+    in.fd = src[1];
+    in.total = BENCH_TOTAL_BYTES;
+    out.fd = dst[0];
+
+    start = now_seconds();
+    pthread_create(&producer, NULL, bench_producer, &in);
+    pthread_create(&consumer, NULL, bench_consumer, &out);
+    copy(src[0], dst[1]);
+    close(dst[1]);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+    cost = now_seconds() - start;
+
+    close(src[0]);
+    close(dst[0]);
+
+    printf("%-12s %10zu bytes %8.3f s %10.1f MB/s\n", name, out.total, cost,
+           (double)out.total / (1024 * 1024) / cost);
+
+    return out.total == BENCH_TOTAL_BYTES ? 0 : -1;
+}
+
+int main()
+{
+    int ret = 0;
+
+    ret |= run_bench("read/write", copy_by_read_write);
+    ret |= run_bench("splice", copy_by_splice);
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
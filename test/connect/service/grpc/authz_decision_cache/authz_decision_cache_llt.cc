@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Description: authz_decision_cache llt
+ * Author: tanyifeng
+ * Create: 2020-04-16
+ */
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include "authz_decision_cache.h"
+
+class AuthzDecisionCacheUnitTest : public testing::Test {
+protected:
+    AuthzDecisionCache *cache { AuthzDecisionCache::GetInstance() };
+
+    void SetUp() override
+    {
+        // also drops decisions cached by previous test
+        cache->Configure(60, 60, { "container_list", "container_inspect" });
+    }
+
+    bool Lookup(const std::string &user, const std::string &action, bool &allowed, std::string &errmsg)
+    {
+        allowed = false;
+        errmsg.clear();
+        return cache->Lookup(user, action, allowed, errmsg);
+    }
+};
+
+TEST_F(AuthzDecisionCacheUnitTest, test_cacheable)
+{
+    EXPECT_TRUE(cache->Cacheable("container_list"));
+    EXPECT_TRUE(cache->Cacheable("container_inspect"));
+    EXPECT_FALSE(cache->Cacheable("container_create"));
+
+    // disable both ttl
+    cache->Configure(-1, -1, {});
+    EXPECT_FALSE(cache->Cacheable("container_list"));
+}
+
+TEST_F(AuthzDecisionCacheUnitTest, test_lookup_allowed_and_denied)
+{
+    bool allowed = false;
+    std::string errmsg;
+
+    EXPECT_FALSE(Lookup("alice", "container_list", allowed, errmsg));
+
+    cache->Insert("alice", "container_list", true, "ignored");
+    cache->Insert("bob", "container_list", false, "permission denied");
+
+    ASSERT_TRUE(Lookup("alice", "container_list", allowed, errmsg));
+    EXPECT_TRUE(allowed);
+    EXPECT_EQ(errmsg, "");
+
+    ASSERT_TRUE(Lookup("bob", "container_list", allowed, errmsg));
+    EXPECT_FALSE(allowed);
+    EXPECT_EQ(errmsg, "permission denied");
+
+    // newer decision replaces the old one
+    cache->Insert("bob", "container_list", true, "");
+    ASSERT_TRUE(Lookup("bob", "container_list", allowed, errmsg));
+    EXPECT_TRUE(allowed);
+}
+
+TEST_F(AuthzDecisionCacheUnitTest, test_key)
+{
+    bool allowed = false;
+    std::string errmsg;
+
+    cache->Insert("alice", "b:container_list", true, "");
+
+    EXPECT_FALSE(Lookup("alice:b", "container_list", allowed, errmsg));
+    EXPECT_FALSE(Lookup("alice", "container_list", allowed, errmsg));
+    EXPECT_FALSE(Lookup("bob", "b:container_list", allowed, errmsg));
+    EXPECT_TRUE(Lookup("alice", "b:container_list", allowed, errmsg));
+}
+
+TEST_F(AuthzDecisionCacheUnitTest, test_ttl)
+{
+    bool allowed = false;
+    std::string errmsg;
+
+    cache->Configure(60, 1, {});
+    cache->Insert("alice", "container_list", true, "");
+    cache->Insert("bob", "container_list", false, "permission denied");
+    ASSERT_TRUE(Lookup("bob", "container_list", allowed, errmsg));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+
+    EXPECT_TRUE(Lookup("alice", "container_list", allowed, errmsg));
+    EXPECT_FALSE(Lookup("bob", "container_list", allowed, errmsg));
+}
+
+TEST_F(AuthzDecisionCacheUnitTest, test_disabled_ttl)
+{
+    bool allowed = false;
+    std::string errmsg;
+
+    // deny decisions are not cached, allow decisions are
+    cache->Configure(60, -1, {});
+    cache->Insert("alice", "container_list", true, "");
+    cache->Insert("bob", "container_list", false, "permission denied");
+
+    EXPECT_TRUE(Lookup("alice", "container_list", allowed, errmsg));
+    EXPECT_FALSE(Lookup("bob", "container_list", allowed, errmsg));
+}
+
+TEST_F(AuthzDecisionCacheUnitTest, test_evict_expired_when_full)
+{
+    bool allowed = false;
+    std::string errmsg;
+    const int maxEntries = 4096;
+
+    cache->Configure(60, 1, {});
+    cache->Insert("keep", "container_list", true, "");
+    for (int i = 1; i < maxEntries; i++) {
+        cache->Insert("user" + std::to_string(i), "container_list", false, "permission denied");
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+
+    // cache is full, expired decisions are collected and live one is kept
+    cache->Insert("new", "container_list", true, "");
+    EXPECT_TRUE(Lookup("keep", "container_list", allowed, errmsg));
+    EXPECT_TRUE(Lookup("new", "container_list", allowed, errmsg));
+    EXPECT_FALSE(Lookup("user1", "container_list", allowed, errmsg));
+}
+
+TEST_F(AuthzDecisionCacheUnitTest, test_drop_all_when_full)
+{
+    bool allowed = false;
+    std::string errmsg;
+    const int maxEntries = 4096;
+
+    for (int i = 0; i < maxEntries; i++) {
+        cache->Insert("user" + std::to_string(i), "container_list", true, "");
+    }
+    EXPECT_TRUE(Lookup("user0", "container_list", allowed, errmsg));
+    EXPECT_TRUE(Lookup("user4095", "container_list", allowed, errmsg));
+
+    // nothing expired, all decisions are dropped to make room
+    cache->Insert("new", "container_list", true, "");
+    EXPECT_TRUE(Lookup("new", "container_list", allowed, errmsg));
+    EXPECT_FALSE(Lookup("user0", "container_list", allowed, errmsg));
+    EXPECT_FALSE(Lookup("user4095", "container_list", allowed, errmsg));
+}
+
+TEST_F(AuthzDecisionCacheUnitTest, test_configure_drops_decisions)
+{
+    bool allowed = false;
+    std::string errmsg;
+
+    cache->Insert("alice", "container_list", true, "");
+    cache->Configure(60, 60, {});
+    EXPECT_FALSE(Lookup("alice", "container_list", allowed, errmsg));
+}
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Description: utils_thread_pool llt
+ * Author: tanyifeng
+ * Create: 2020-04-16
+ */
+
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <gtest/gtest.h>
+#include "utils_thread_pool.h"
+
+/* jobs block on the gate until it is opened */
+struct gate {
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool open { false };
+    int entered { 0 };
+    std::atomic<int> done { 0 };
+
+    void Enter()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        entered++;
+        cond.notify_all();
+        cond.wait(lock, [this]() { return open; });
+    }
+
+    bool WaitEntered(int count)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cond.wait_for(lock, std::chrono::seconds(10), [this, count]() { return entered >= count; });
+    }
+
+    void Open()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        open = true;
+        cond.notify_all();
+    }
+};
+
+static void count_job(void *arg)
+{
+    std::atomic<int> *count = (std::atomic<int> *)arg;
+
+    (*count)++;
+}
+
+static void slow_count_job(void *arg)
+{
+    std::atomic<int> *count = (std::atomic<int> *)arg;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    (*count)++;
+}
+
+static void gate_job(void *arg)
+{
+    struct gate *g = (struct gate *)arg;
+
+    g->Enter();
+    g->done++;
+}
+
+TEST(utils_thread_pool, test_default_workers)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t expect = cpus > 0 ? (size_t)cpus : 1;
+
+    if (expect > THREAD_POOL_MAX_WORKERS) {
+        expect = THREAD_POOL_MAX_WORKERS;
+    }
+    EXPECT_EQ(thread_pool_default_workers(0, 0), expect);
+    EXPECT_EQ(thread_pool_default_workers(0, THREAD_POOL_MAX_WORKERS + 1), expect);
+    EXPECT_EQ(thread_pool_default_workers(1, 0), (size_t)1);
+    EXPECT_EQ(thread_pool_default_workers(1000, 1), (size_t)1);
+    EXPECT_GE(thread_pool_default_workers(1000, 2), (size_t)1);
+    EXPECT_LE(thread_pool_default_workers(1000, 2), (size_t)2);
+}
+
+TEST(utils_thread_pool, test_new_invalid)
+{
+    EXPECT_EQ(thread_pool_new("test", 0), nullptr);
+    EXPECT_EQ(thread_pool_new("test", THREAD_POOL_MAX_WORKERS + 1), nullptr);
+}
+
+TEST(utils_thread_pool, test_submit_invalid)
+{
+    std::atomic<int> count { 0 };
+    thread_pool_t *pool = thread_pool_new("test", 1);
+
+    ASSERT_NE(pool, nullptr);
+    EXPECT_NE(thread_pool_submit(nullptr, count_job, &count), 0);
+    EXPECT_NE(thread_pool_submit(pool, nullptr, &count), 0);
+    thread_pool_free(pool);
+
+    // NULL pool is ignored
+    thread_pool_wait(nullptr);
+    EXPECT_EQ(thread_pool_pending(nullptr), (size_t)0);
+    EXPECT_EQ(thread_pool_finished(nullptr), (uint64_t)0);
+    thread_pool_free(nullptr);
+}
+
+TEST(utils_thread_pool, test_submit_and_wait)
+{
+    const int jobs = 1000;
+    std::atomic<int> count { 0 };
+    thread_pool_t *pool = thread_pool_new("test", 4);
+
+    ASSERT_NE(pool, nullptr);
+
+    // idle pool does not block
+    thread_pool_wait(pool);
+
+    for (int i = 0; i < jobs; i++) {
+        ASSERT_EQ(thread_pool_submit(pool, count_job, &count), 0);
+    }
+    thread_pool_wait(pool);
+    EXPECT_EQ(count.load(), jobs);
+    EXPECT_EQ(thread_pool_pending(pool), (size_t)0);
+    EXPECT_EQ(thread_pool_finished(pool), (uint64_t)jobs);
+
+    // pool is reusable after wait
+    for (int i = 0; i < jobs; i++) {
+        ASSERT_EQ(thread_pool_submit(pool, count_job, &count), 0);
+    }
+    thread_pool_wait(pool);
+    EXPECT_EQ(count.load(), 2 * jobs);
+    EXPECT_EQ(thread_pool_finished(pool), (uint64_t)(2 * jobs));
+
+    thread_pool_free(pool);
+}
+
+TEST(utils_thread_pool, test_workers_run_in_parallel)
+{
+    const int workers = 4;
+    struct gate g;
+    thread_pool_t *pool = thread_pool_new("test", workers);
+
+    ASSERT_NE(pool, nullptr);
+    for (int i = 0; i < workers; i++) {
+        ASSERT_EQ(thread_pool_submit(pool, gate_job, &g), 0);
+    }
+
+    // all jobs are running at the same time
+    EXPECT_TRUE(g.WaitEntered(workers));
+    g.Open();
+    thread_pool_wait(pool);
+    EXPECT_EQ(g.done.load(), workers);
+
+    thread_pool_free(pool);
+}
+
+TEST(utils_thread_pool, test_pending)
+{
+    struct gate g;
+    std::atomic<int> count { 0 };
+    thread_pool_t *pool = thread_pool_new("test", 1);
+
+    ASSERT_NE(pool, nullptr);
+    ASSERT_EQ(thread_pool_submit(pool, gate_job, &g), 0);
+    ASSERT_TRUE(g.WaitEntered(1));
+
+    // the only worker is busy, others are queued
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(thread_pool_submit(pool, count_job, &count), 0);
+    }
+    EXPECT_EQ(thread_pool_pending(pool), (size_t)3);
+    EXPECT_EQ(thread_pool_finished(pool), (uint64_t)0);
+
+    g.Open();
+    thread_pool_wait(pool);
+    EXPECT_EQ(thread_pool_pending(pool), (size_t)0);
+    EXPECT_EQ(thread_pool_finished(pool), (uint64_t)4);
+    EXPECT_EQ(count.load(), 3);
+
+    thread_pool_free(pool);
+}
+
+TEST(utils_thread_pool, test_free_runs_queued_jobs)
+{
+    const int jobs = 50;
+    std::atomic<int> count { 0 };
+    thread_pool_t *pool = thread_pool_new("test", 2);
+
+    ASSERT_NE(pool, nullptr);
+    for (int i = 0; i < jobs; i++) {
+        ASSERT_EQ(thread_pool_submit(pool, slow_count_job, &count), 0);
+    }
+
+    // shutdown without wait, queued jobs are still run
+    thread_pool_free(pool);
+    EXPECT_EQ(count.load(), jobs);
+}
+
+TEST(utils_thread_pool, test_concurrent_submitters)
+{
+    const int submitters = 8;
+    const int jobs = 500;
+    std::atomic<int> count { 0 };
+    std::thread threads[submitters];
+    thread_pool_t *pool = thread_pool_new("test", 4);
+
+    ASSERT_NE(pool, nullptr);
+    for (int i = 0; i < submitters; i++) {
+        threads[i] = std::thread([pool, &count]() {
+            for (int j = 0; j < jobs; j++) {
+                (void)thread_pool_submit(pool, count_job, &count);
+            }
+        });
+    }
+    for (int i = 0; i < submitters; i++) {
+        threads[i].join();
+    }
+    thread_pool_wait(pool);
+    EXPECT_EQ(count.load(), submitters * jobs);
+    EXPECT_EQ(thread_pool_finished(pool), (uint64_t)(submitters * jobs));
+
+    thread_pool_free(pool);
+}
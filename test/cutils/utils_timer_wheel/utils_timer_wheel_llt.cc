@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Description: utils_timer_wheel llt
+ * Author: tanyifeng
+ * Create: 2020-04-08
+ */
+
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+#include <gtest/gtest.h>
+#include "utils_timer_wheel.h"
+
+struct test_timer {
+    timer_wheel_entry_t entry;
+    uint64_t expires_ms;
+    uint64_t fired_ms;
+};
+
+struct advance_ctx {
+    uint64_t now_ms;
+    std::vector<test_timer *> fired;
+};
+
+static void record_expired(timer_wheel_entry_t *entry, void *arg)
+{
+    advance_ctx *ctx = (advance_ctx *)arg;
+    test_timer *t = (test_timer *)entry;
+
+    t->fired_ms = ctx->now_ms;
+    ctx->fired.push_back(t);
+}
+
+TEST(utils_timer_wheel, test_timer_wheel_expire_in_order)
+{
+    timer_wheel_t *wheel = nullptr;
+    advance_ctx ctx;
+    std::vector<test_timer> timers(2000);
+    uint64_t now;
+    size_t i;
+
+    wheel = timer_wheel_new(10, 12345);
+    ASSERT_NE(wheel, nullptr);
+
+    srand(1);
+    for (i = 0; i < timers.size(); i++) {
+        timer_wheel_entry_init(&timers[i].entry);
+        /* spread over the first three levels of the wheel */
+        timers[i].expires_ms = 12345 + (uint64_t)(rand() % 3000000);
+        timers[i].fired_ms = 0;
+        timer_wheel_add(wheel, &timers[i].entry, timers[i].expires_ms);
+    }
+    ASSERT_EQ(timer_wheel_size(wheel), timers.size());
+
+    for (now = 12345; now <= 12345 + 3000000 + 10; now += 7) {
+        ctx.now_ms = now;
+        timer_wheel_advance(wheel, now, record_expired, &ctx);
+    }
+
+    ASSERT_EQ(ctx.fired.size(), timers.size());
+    ASSERT_EQ(timer_wheel_size(wheel), 0);
+    for (i = 0; i < timers.size(); i++) {
+        ASSERT_FALSE(timer_wheel_entry_pending(&timers[i].entry));
+        /* never early, and late by less than one tick plus one advance step */
+        ASSERT_GE(timers[i].fired_ms, timers[i].expires_ms);
+        ASSERT_LT(timers[i].fired_ms, timers[i].expires_ms + 10 + 7);
+    }
+
+    timer_wheel_free(wheel);
+}
+
+TEST(utils_timer_wheel, test_timer_wheel_del_and_rearm)
+{
+    timer_wheel_t *wheel = nullptr;
+    advance_ctx ctx;
+    test_timer a;
+    test_timer b;
+
+    wheel = timer_wheel_new(100, 0);
+    ASSERT_NE(wheel, nullptr);
+
+    timer_wheel_entry_init(&a.entry);
+    timer_wheel_entry_init(&b.entry);
+    ASSERT_FALSE(timer_wheel_entry_pending(&a.entry));
+
+    timer_wheel_add(wheel, &a.entry, 1000);
+    timer_wheel_add(wheel, &b.entry, 500000);
+    ASSERT_TRUE(timer_wheel_entry_pending(&a.entry));
+    ASSERT_EQ(timer_wheel_size(wheel), 2);
+
+    timer_wheel_del(wheel, &b.entry);
+    timer_wheel_del(wheel, &b.entry);
+    ASSERT_FALSE(timer_wheel_entry_pending(&b.entry));
+    ASSERT_EQ(timer_wheel_size(wheel), 1);
+
+    /* rearming moves the timer */
+    timer_wheel_add(wheel, &a.entry, 2000);
+    ASSERT_EQ(timer_wheel_size(wheel), 1);
+
+    ctx.now_ms = 1999;
+    ASSERT_EQ(timer_wheel_advance(wheel, ctx.now_ms, record_expired, &ctx), 0);
+    ctx.now_ms = 2000;
+    ASSERT_EQ(timer_wheel_advance(wheel, ctx.now_ms, record_expired, &ctx), 1);
+    ASSERT_EQ(ctx.fired[0], &a);
+
+    /* timers in the past fire on next tick */
+    timer_wheel_add(wheel, &a.entry, 10);
+    ctx.now_ms = 2100;
+    ASSERT_EQ(timer_wheel_advance(wheel, ctx.now_ms, record_expired, &ctx), 1);
+    ASSERT_EQ(timer_wheel_size(wheel), 0);
+
+    timer_wheel_free(wheel);
+}
+
+static uint64_t pending_min_expiry(const std::vector<test_timer> &timers, uint64_t tick)
+{
+    uint64_t next = UINT64_MAX;
+
+    for (const auto &t : timers) {
+        if (timer_wheel_entry_pending(&t.entry)) {
+            next = std::min(next, (t.expires_ms + tick - 1) / tick * tick);
+        }
+    }
+    return next;
+}
+
+TEST(utils_timer_wheel, test_timer_wheel_next_expiry)
+{
+    timer_wheel_t *wheel = nullptr;
+    advance_ctx ctx;
+    std::vector<test_timer> timers(500);
+    uint64_t now;
+    size_t i;
+
+    wheel = timer_wheel_new(10, 12345);
+    ASSERT_NE(wheel, nullptr);
+    ASSERT_EQ(timer_wheel_next_expiry(wheel), UINT64_MAX);
+
+    srand(2);
+    for (i = 0; i < timers.size(); i++) {
+        timer_wheel_entry_init(&timers[i].entry);
+        /* every level, including timers close to the range of the wheel */
+        timers[i].expires_ms = 12345 + 1 + (uint64_t)(rand() % 160000000);
+        timer_wheel_add(wheel, &timers[i].entry, timers[i].expires_ms);
+        ASSERT_EQ(timer_wheel_next_expiry(wheel), pending_min_expiry(timers, 10));
+    }
+
+    /* jump to each next expiry like the health check scheduler does */
+    now = 12345;
+    while (timer_wheel_size(wheel) > 0) {
+        now = timer_wheel_next_expiry(wheel);
+        ASSERT_EQ(now, pending_min_expiry(timers, 10));
+        ctx.now_ms = now;
+        ctx.fired.clear();
+        ASSERT_GT(timer_wheel_advance(wheel, now, record_expired, &ctx), 0);
+        ASSERT_EQ(timer_wheel_next_expiry(wheel), pending_min_expiry(timers, 10));
+    }
+    ASSERT_EQ(timer_wheel_next_expiry(wheel), UINT64_MAX);
+
+    timer_wheel_free(wheel);
+}
@@ -0,0 +1,350 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Description: http_pool llt
+ * Author: tanyifeng
+ * Create: 2020-04-16
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include "http_pool.h"
+#include "buffer.h"
+
+#define TEST_URL "http://localhost/Test.Echo"
+
+/* http server on unix socket, which keeps connections alive unless told not to */
+class TestServer {
+public:
+    std::atomic<int> accepted { 0 };
+    std::atomic<int> requests { 0 };
+    /* delay before each response */
+    std::atomic<int> delay_ms { 0 };
+    /* close connection after response without telling client */
+    std::atomic<bool> close_after_response { false };
+    /* close connection without response for next n requests */
+    std::atomic<int> drop_requests { 0 };
+    std::string path;
+
+    bool Start()
+    {
+        struct sockaddr_un addr;
+        char tmpl[] = "/tmp/http_pool_llt_XXXXXX";
+
+        if (mkdtemp(tmpl) == nullptr) {
+            return false;
+        }
+        m_dir = tmpl;
+        path = m_dir + "/test.sock";
+
+        m_listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (m_listen_fd < 0) {
+            return false;
+        }
+        (void)memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        (void)strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        if (bind(m_listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(m_listen_fd, 16) != 0) {
+            return false;
+        }
+        m_accept_thread = std::thread(&TestServer::AcceptLoop, this);
+        return true;
+    }
+
+    void Stop()
+    {
+        m_stop = true;
+        if (m_accept_thread.joinable()) {
+            m_accept_thread.join();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (int fd : m_conn_fds) {
+                (void)shutdown(fd, SHUT_RDWR);
+            }
+        }
+        for (auto &t : m_conn_threads) {
+            t.join();
+        }
+        if (m_listen_fd >= 0) {
+            close(m_listen_fd);
+        }
+        (void)unlink(path.c_str());
+        (void)rmdir(m_dir.c_str());
+    }
+
+private:
+    std::string m_dir;
+    int m_listen_fd { -1 };
+    std::atomic<bool> m_stop { false };
+    std::thread m_accept_thread;
+    std::mutex m_mutex;
+    std::vector<int> m_conn_fds;
+    std::vector<std::thread> m_conn_threads;
+
+    void AcceptLoop()
+    {
+        struct pollfd pfd = { m_listen_fd, POLLIN, 0 };
+
+        while (!m_stop) {
+            if (poll(&pfd, 1, 50) <= 0) {
+                continue;
+            }
+            int fd = accept4(m_listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd < 0) {
+                continue;
+            }
+            accepted++;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_conn_fds.push_back(fd);
+            m_conn_threads.emplace_back(&TestServer::Serve, this, fd);
+        }
+    }
+
+    /* read one request, return false if connection is closed */
+    static bool ReadRequest(int fd, std::string &pending)
+    {
+        char buf[4096];
+        size_t header_end;
+        size_t body_len = 0;
+
+        while ((header_end = pending.find("\r\n\r\n")) == std::string::npos) {
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n <= 0) {
+                return false;
+            }
+            pending.append(buf, (size_t)n);
+        }
+        size_t pos = pending.find("Content-Length:");
+        if (pos != std::string::npos && pos < header_end) {
+            body_len = strtoul(pending.c_str() + pos + strlen("Content-Length:"), nullptr, 10);
+        }
+        while (pending.size() < header_end + 4 + body_len) {
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n <= 0) {
+                return false;
+            }
+            pending.append(buf, (size_t)n);
+        }
+        pending.erase(0, header_end + 4 + body_len);
+        return true;
+    }
+
+    void Serve(int fd)
+    {
+        const std::string resp = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 2\r\n\r\n{}";
+        std::string pending;
+
+        while (ReadRequest(fd, pending)) {
+            requests++;
+            int drop = drop_requests.load();
+            if (drop > 0 && drop_requests.compare_exchange_strong(drop, drop - 1)) {
+                break;
+            }
+            if (delay_ms > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms.load()));
+            }
+            if (write(fd, resp.c_str(), resp.size()) != (ssize_t)resp.size()) {
+                break;
+            }
+            if (close_after_response) {
+                break;
+            }
+        }
+        (void)shutdown(fd, SHUT_RDWR);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_conn_fds.begin(); it != m_conn_fds.end(); ++it) {
+            if (*it == fd) {
+                m_conn_fds.erase(it);
+                break;
+            }
+        }
+        close(fd);
+    }
+};
+
+class HttpPoolUnitTest : public testing::Test {
+protected:
+    TestServer server;
+
+    void SetUp() override
+    {
+        ASSERT_TRUE(server.Start());
+    }
+
+    void TearDown() override
+    {
+        server.Stop();
+    }
+
+    void InitRequest(struct http_pool_request *req, const char *socket_path)
+    {
+        (void)memset(req, 0, sizeof(*req));
+        req->url = TEST_URL;
+        req->unix_socket_path = socket_path;
+        req->body = "{}";
+        req->body_len = strlen(req->body);
+    }
+
+    void ExpectOK(const struct http_pool_request *req)
+    {
+        EXPECT_EQ(req->result, 0);
+        EXPECT_EQ(req->response_code, 200);
+        ASSERT_NE(req->output, nullptr);
+        ASSERT_NE(req->output->contents, nullptr);
+        EXPECT_NE(strstr(req->output->contents, "HTTP/1.1 200"), nullptr);
+        EXPECT_NE(strstr(req->output->contents, "{}"), nullptr);
+    }
+};
+
+TEST_F(HttpPoolUnitTest, test_reuse_connection)
+{
+    struct http_pool_request req;
+
+    for (int i = 0; i < 5; i++) {
+        InitRequest(&req, server.path.c_str());
+        ASSERT_EQ(http_pool_perform(&req, 1), 0);
+        ExpectOK(&req);
+        buffer_free(req.output);
+    }
+
+    EXPECT_EQ(server.requests.load(), 5);
+    EXPECT_EQ(server.accepted.load(), 1);
+}
+
+TEST_F(HttpPoolUnitTest, test_evict_closed_connection)
+{
+    struct http_pool_request req;
+
+    server.close_after_response = true;
+    for (int i = 0; i < 3; i++) {
+        InitRequest(&req, server.path.c_str());
+        ASSERT_EQ(http_pool_perform(&req, 1), 0);
+        ExpectOK(&req);
+        buffer_free(req.output);
+    }
+
+    EXPECT_EQ(server.requests.load(), 3);
+    EXPECT_EQ(server.accepted.load(), 3);
+}
+
+TEST_F(HttpPoolUnitTest, test_evict_failed_connection)
+{
+    struct http_pool_request req;
+
+    InitRequest(&req, server.path.c_str());
+    ASSERT_EQ(http_pool_perform(&req, 1), 0);
+    ExpectOK(&req);
+    buffer_free(req.output);
+
+    /*
+     * kept alive connection is closed without response, curl retries once on a
+     * new connection, which is closed too. Neither of them may be reused.
+     */
+    server.drop_requests = 2;
+    InitRequest(&req, server.path.c_str());
+    EXPECT_NE(http_pool_perform(&req, 1), 0);
+    EXPECT_NE(req.result, 0);
+    buffer_free(req.output);
+
+    InitRequest(&req, server.path.c_str());
+    ASSERT_EQ(http_pool_perform(&req, 1), 0);
+    ExpectOK(&req);
+    buffer_free(req.output);
+
+    EXPECT_EQ(server.requests.load(), 4);
+    EXPECT_EQ(server.accepted.load(), 3);
+}
+
+TEST_F(HttpPoolUnitTest, test_failed_request_in_batch)
+{
+    struct http_pool_request reqs[2];
+    std::string missing = server.path + ".missing";
+
+    InitRequest(&reqs[0], missing.c_str());
+    InitRequest(&reqs[1], server.path.c_str());
+    EXPECT_NE(http_pool_perform(reqs, 2), 0);
+
+    EXPECT_NE(reqs[0].result, 0);
+    ExpectOK(&reqs[1]);
+    buffer_free(reqs[0].output);
+    buffer_free(reqs[1].output);
+
+    /* pool still works after a failed batch */
+    InitRequest(&reqs[1], server.path.c_str());
+    ASSERT_EQ(http_pool_perform(&reqs[1], 1), 0);
+    ExpectOK(&reqs[1]);
+    buffer_free(reqs[1].output);
+}
+
+TEST_F(HttpPoolUnitTest, test_parallel_requests_in_batch)
+{
+    const int count = 4;
+    const int delay_ms = 300;
+    struct http_pool_request reqs[count];
+
+    server.delay_ms = delay_ms;
+    for (int i = 0; i < count; i++) {
+        InitRequest(&reqs[i], server.path.c_str());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(http_pool_perform(reqs, count), 0);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    for (int i = 0; i < count; i++) {
+        ExpectOK(&reqs[i]);
+        EXPECT_GE(reqs[i].elapsed_us, (uint64_t)delay_ms * 1000);
+        buffer_free(reqs[i].output);
+    }
+    /* requests are in flight at the same time, each on its own connection */
+    EXPECT_LT(elapsed.count(), count * delay_ms);
+    EXPECT_EQ(server.accepted.load(), count);
+}
+
+TEST_F(HttpPoolUnitTest, test_parallel_callers)
+{
+    const int count = 4;
+    const int delay_ms = 300;
+    std::vector<std::thread> callers;
+    std::atomic<int> ok { 0 };
+
+    server.delay_ms = delay_ms;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++) {
+        callers.emplace_back([&]() {
+            struct http_pool_request req;
+
+            InitRequest(&req, server.path.c_str());
+            if (http_pool_perform(&req, 1) == 0 && req.response_code == 200) {
+                ok++;
+            }
+            buffer_free(req.output);
+        });
+    }
+    for (auto &t : callers) {
+        t.join();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    EXPECT_EQ(ok.load(), count);
+    EXPECT_LT(elapsed.count(), count * delay_ms);
+}
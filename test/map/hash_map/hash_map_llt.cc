@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Description: hash map llt
+ * Author: tanyifeng
+ * Create: 2020-03-25
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <gtest/gtest.h>
+#include "hash_map.h"
+
+TEST(hash_map, test_hash_map_str_str)
+{
+    hash_map_t *map = nullptr;
+
+    map = hash_map_new(MAP_STR_STR, MAP_DEFAULT_FREE_FUNC);
+    ASSERT_NE(map, nullptr);
+
+    ASSERT_TRUE(hash_map_insert(map, (void *)"name", (void *)"id1"));
+    ASSERT_FALSE(hash_map_insert(map, (void *)"name", (void *)"id2"));
+    ASSERT_STREQ((char *)hash_map_search(map, (void *)"name"), "id1");
+
+    ASSERT_TRUE(hash_map_replace(map, (void *)"name", (void *)"id2"));
+    ASSERT_STREQ((char *)hash_map_search(map, (void *)"name"), "id2");
+    ASSERT_EQ(hash_map_size(map), 1);
+
+    ASSERT_TRUE(hash_map_remove(map, (void *)"name"));
+    ASSERT_FALSE(hash_map_remove(map, (void *)"name"));
+    ASSERT_EQ(hash_map_search(map, (void *)"name"), nullptr);
+    ASSERT_EQ(hash_map_size(map), 0);
+
+    hash_map_free(map);
+}
+
+TEST(hash_map, test_hash_map_int_int_grow_and_remove)
+{
+    hash_map_t *map = nullptr;
+    int i;
+    int *value = nullptr;
+
+    map = hash_map_new(MAP_INT_INT, MAP_DEFAULT_FREE_FUNC);
+    ASSERT_NE(map, nullptr);
+
+    for (i = 0; i < 10000; i++) {
+        int v = i * 2;
+        ASSERT_TRUE(hash_map_insert(map, &i, &v));
+    }
+    ASSERT_EQ(hash_map_size(map), 10000);
+
+    for (i = 0; i < 10000; i += 2) {
+        ASSERT_TRUE(hash_map_remove(map, &i));
+    }
+    ASSERT_EQ(hash_map_size(map), 5000);
+
+    for (i = 0; i < 10000; i++) {
+        value = (int *)hash_map_search(map, &i);
+        if (i % 2 == 0) {
+            ASSERT_EQ(value, nullptr);
+        } else {
+            ASSERT_NE(value, nullptr);
+            ASSERT_EQ(*value, i * 2);
+        }
+    }
+
+    hash_map_clear(map);
+    ASSERT_EQ(hash_map_size(map), 0);
+
+    hash_map_free(map);
+}
+
+TEST(hash_map, test_hash_map_itor)
+{
+    hash_map_t *map = nullptr;
+    hash_map_itor *itor = nullptr;
+    bool seen[3] = { false, false, false };
+    const char *keys[] = { "a", "b", "c" };
+    size_t count = 0;
+    size_t i;
+    bool value = true;
+
+    map = hash_map_new(MAP_STR_BOOL, MAP_DEFAULT_FREE_FUNC);
+    ASSERT_NE(map, nullptr);
+
+    itor = hash_map_itor_new(map);
+    ASSERT_NE(itor, nullptr);
+    ASSERT_FALSE(hash_map_itor_valid(itor));
+    hash_map_itor_free(itor);
+
+    for (i = 0; i < 3; i++) {
+        ASSERT_TRUE(hash_map_insert(map, (void *)keys[i], &value));
+    }
+
+    itor = hash_map_itor_new(map);
+    ASSERT_NE(itor, nullptr);
+    for (; hash_map_itor_valid(itor); hash_map_itor_next(itor)) {
+        const char *key = (const char *)hash_map_itor_key(itor);
+        ASSERT_TRUE(*(bool *)hash_map_itor_value(itor));
+        for (i = 0; i < 3; i++) {
+            if (strcmp(key, keys[i]) == 0) {
+                seen[i] = true;
+            }
+        }
+        count++;
+    }
+    hash_map_itor_free(itor);
+
+    ASSERT_EQ(count, 3);
+    ASSERT_TRUE(seen[0] && seen[1] && seen[2]);
+
+    hash_map_free(map);
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Description: microbenchmark of hash_map_t against rb_tree based map_t
+ * Author: tanyifeng
+ * Create: 2020-03-25
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include "map.h"
+#include "hash_map.h"
+
+struct map_ops {
+    const char *name;
+    void *(*create)();
+    void (*destroy)(void *map);
+    bool (*insert)(void *map, void *key, void *value);
+    void *(*search)(void *map, void *key);
+    size_t (*iterate)(void *map);
+};
+
+static void *rb_create()
+{
+    return map_new(MAP_STR_STR, MAP_DEFAULT_CMP_FUNC, MAP_DEFAULT_FREE_FUNC);
+}
+
+static void rb_destroy(void *map)
+{
+    map_free((map_t *)map);
+}
+
+static bool rb_insert(void *map, void *key, void *value)
+{
+    return map_insert((map_t *)map, key, value);
+}
+
+static void *rb_search(void *map, void *key)
+{
+    return map_search((map_t *)map, key);
+}
+
+static size_t rb_iterate(void *map)
+{
+    size_t n = 0;
+    map_itor *itor = map_itor_new((map_t *)map);
+
+    for (; map_itor_valid(itor); map_itor_next(itor)) {
+        n += (map_itor_value(itor) != nullptr);
+    }
+    map_itor_free(itor);
+    return n;
+}
+
+static void *hash_create()
+{
+    return hash_map_new(MAP_STR_STR, MAP_DEFAULT_FREE_FUNC);
+}
+
+static void hash_destroy(void *map)
+{
+    hash_map_free((hash_map_t *)map);
+}
+
+static bool hash_insert(void *map, void *key, void *value)
+{
+    return hash_map_insert((hash_map_t *)map, key, value);
+}
+
+static void *hash_search(void *map, void *key)
+{
+    return hash_map_search((hash_map_t *)map, key);
+}
+
+static size_t hash_iterate(void *map)
+{
+    size_t n = 0;
+    hash_map_itor *itor = hash_map_itor_new((hash_map_t *)map);
+
+    for (; hash_map_itor_valid(itor); hash_map_itor_next(itor)) {
+        n += (hash_map_itor_value(itor) != nullptr);
+    }
+    hash_map_itor_free(itor);
+    return n;
+}
+
+static double now_ms()
+{
+    struct timespec ts = { 0 };
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+static void run(const map_ops &ops, const std::vector<std::string> &keys)
+{
+    double begin, inserted, searched, iterated;
+    size_t found = 0;
+    void *map = ops.create();
+
+    begin = now_ms();
+    for (const auto &k : keys) {
+        (void)ops.insert(map, (void *)k.c_str(), (void *)k.c_str());
+    }
+    inserted = now_ms();
+    for (const auto &k : keys) {
+        found += (ops.search(map, (void *)k.c_str()) != nullptr);
+    }
+    searched = now_ms();
+    found += ops.iterate(map);
+    iterated = now_ms();
+
+    printf("%-8s %8zu entries: insert %9.3f ms, search %9.3f ms, iterate %9.3f ms (%zu)\n", ops.name, keys.size(),
+           inserted - begin, searched - inserted, iterated - searched, found);
+    ops.destroy(map);
+}
+
+int main(int argc, char **argv)
+{
+    const map_ops rb = { "rb_tree", rb_create, rb_destroy, rb_insert, rb_search, rb_iterate };
+    const map_ops hash = { "hash", hash_create, hash_destroy, hash_insert, hash_search, hash_iterate };
+    const size_t sizes[] = { 1000, 10000, 100000 };
+    char buf[65] = { 0 };
+
+    (void)argc;
+    (void)argv;
+    srand(1);
+    for (size_t n : sizes) {
+        std::vector<std::string> keys;
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < 64; j++) {
+                buf[j] = "0123456789abcdef"[rand() % 16];
+            }
+            keys.push_back(buf);
+        }
+        run(rb, keys);
+        run(hash, keys);
+    }
+
+    return 0;
+}
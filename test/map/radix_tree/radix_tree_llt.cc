@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Description: radix tree llt
+ * Author: tanyifeng
+ * Create: 2020-03-23
+ */
+
+#include <stdlib.h>
+#include <gtest/gtest.h>
+#include "radix_tree.h"
+
+TEST(radix_tree, test_radix_tree_insert_search)
+{
+    radix_tree_t *tree = nullptr;
+    int a = 1;
+    int b = 2;
+
+    tree = radix_tree_new();
+    ASSERT_NE(tree, nullptr);
+
+    ASSERT_TRUE(radix_tree_insert(tree, "abcdef", &a));
+    ASSERT_TRUE(radix_tree_insert(tree, "abc123", &b));
+    ASSERT_FALSE(radix_tree_insert(tree, "abcdef", &b));
+    ASSERT_FALSE(radix_tree_insert(tree, "", &b));
+    ASSERT_FALSE(radix_tree_insert(tree, nullptr, &b));
+    ASSERT_EQ(radix_tree_size(tree), 2);
+
+    ASSERT_EQ(radix_tree_search(tree, "abcdef"), &a);
+    ASSERT_EQ(radix_tree_search(tree, "abc123"), &b);
+    ASSERT_EQ(radix_tree_search(tree, "abc"), nullptr);
+    ASSERT_EQ(radix_tree_search(tree, "abcdefg"), nullptr);
+
+    radix_tree_free(tree);
+}
+
+TEST(radix_tree, test_radix_tree_search_prefix)
+{
+    radix_tree_t *tree = nullptr;
+    void *value = nullptr;
+    int a = 1;
+    int b = 2;
+    int c = 3;
+
+    tree = radix_tree_new();
+    ASSERT_NE(tree, nullptr);
+
+    ASSERT_TRUE(radix_tree_insert(tree, "abcdef", &a));
+    ASSERT_TRUE(radix_tree_insert(tree, "abc123", &b));
+    ASSERT_TRUE(radix_tree_insert(tree, "abc", &c));
+
+    ASSERT_EQ(radix_tree_search_prefix(tree, "a", &value), RADIX_PREFIX_AMBIGUOUS);
+    ASSERT_EQ(radix_tree_search_prefix(tree, "abc", &value), RADIX_PREFIX_AMBIGUOUS);
+    ASSERT_EQ(radix_tree_search_prefix(tree, "abcd", &value), RADIX_PREFIX_UNIQUE);
+    ASSERT_EQ(value, &a);
+    ASSERT_EQ(radix_tree_search_prefix(tree, "abc1", &value), RADIX_PREFIX_UNIQUE);
+    ASSERT_EQ(value, &b);
+    ASSERT_EQ(radix_tree_search_prefix(tree, "abx", &value), RADIX_PREFIX_NOT_FOUND);
+    ASSERT_EQ(radix_tree_search_prefix(tree, "abcdefg", &value), RADIX_PREFIX_NOT_FOUND);
+
+    radix_tree_free(tree);
+}
+
+TEST(radix_tree, test_radix_tree_remove)
+{
+    radix_tree_t *tree = nullptr;
+    void *value = nullptr;
+    int a = 1;
+    int b = 2;
+
+    tree = radix_tree_new();
+    ASSERT_NE(tree, nullptr);
+
+    ASSERT_TRUE(radix_tree_insert(tree, "abcdef", &a));
+    ASSERT_TRUE(radix_tree_insert(tree, "abc123", &b));
+
+    ASSERT_FALSE(radix_tree_remove(tree, "abc"));
+    ASSERT_TRUE(radix_tree_remove(tree, "abcdef"));
+    ASSERT_FALSE(radix_tree_remove(tree, "abcdef"));
+    ASSERT_EQ(radix_tree_size(tree), 1);
+
+    ASSERT_EQ(radix_tree_search_prefix(tree, "a", &value), RADIX_PREFIX_UNIQUE);
+    ASSERT_EQ(value, &b);
+
+    ASSERT_TRUE(radix_tree_remove(tree, "abc123"));
+    ASSERT_EQ(radix_tree_size(tree), 0);
+    ASSERT_EQ(radix_tree_search_prefix(tree, "a", &value), RADIX_PREFIX_NOT_FOUND);
+
+    radix_tree_free(tree);
+}
@@ -25,6 +25,11 @@ void MockContainerUnix_SetMock(MockContainerUnix* mock)
 }
 
 
+void container_refinc(container_t *cont)
+{
+    return;
+}
+
 /* container unref */
 void container_unref(container_t *cont)
 {
@@ -47,7 +52,7 @@ int container_read_proc(uint32_t pid, container_pid_t *pid_info)
     return 0;
 }
 
-int container_to_disk(const container_t *cont)
+int container_to_disk(container_t *cont)
 {
     if (g_container_unix_mock != nullptr) {
         return g_container_unix_mock->ContainerToDisk(cont);
@@ -55,6 +60,14 @@ int container_to_disk(const container_t *cont)
     return 0;
 }
 
+int container_state_to_disk(container_t *cont)
+{
+    if (g_container_unix_mock != nullptr) {
+        return g_container_unix_mock->ContainerStateToDisk(cont);
+    }
+    return 0;
+}
+
 void container_unlock(container_t *cont)
 {
     if (g_container_unix_mock != nullptr) {
@@ -76,3 +89,12 @@ void container_update_restart_manager(container_t *cont, const host_config_resta
     }
 }
 
+char *container_get_command(const container_t *cont)
+{
+    return nullptr;
+}
+
+char *container_get_image(const container_t *cont)
+{
+    return nullptr;
+}
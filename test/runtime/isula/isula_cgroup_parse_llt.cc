@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Description: parsers of cgroup files llt
+ * Author: tanyifeng
+ * Create: 2020-04-02
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <gtest/gtest.h>
+#include "isula_cgroup_parse.h"
+#include "utils.h"
+
+static std::string parse_path(const char *content, const char *subsystem)
+{
+    char *path = cgroup_parse_path(content, subsystem);
+    std::string result = path != nullptr ? path : "<null>";
+
+    free(path);
+    return result;
+}
+
+TEST(isula_cgroup_parse_llt, test_parse_path)
+{
+    const char *v1 = "12:pids:/docker/abc\n"
+                     "11:cpu,cpuacct:/docker/abc\n"
+                     "10:memory:/docker/abc\n"
+                     "9:blkio:/docker/abc\n"
+                     "1:name=systemd:/system.slice/docker-abc.scope\n";
+    const char *v2 = "0::/system.slice/docker-abc.scope\n";
+    const char *hybrid = "3:cpuacct:/a\n0::/unified/a\n";
+
+    ASSERT_EQ(parse_path(v1, "cpuacct"), "/docker/abc");
+    ASSERT_EQ(parse_path(v1, "cpu"), "/docker/abc");
+    ASSERT_EQ(parse_path(v1, "memory"), "/docker/abc");
+    ASSERT_EQ(parse_path(v1, "systemd"), "<null>");
+    ASSERT_EQ(parse_path(v1, "name=systemd"), "/system.slice/docker-abc.scope");
+    ASSERT_EQ(parse_path(v1, "cpuset"), "<null>");
+    ASSERT_EQ(parse_path(v1, nullptr), "<null>");
+
+    ASSERT_EQ(parse_path(v2, nullptr), "/system.slice/docker-abc.scope");
+    ASSERT_EQ(parse_path(v2, "memory"), "<null>");
+    ASSERT_EQ(parse_path(hybrid, nullptr), "/unified/a");
+    ASSERT_EQ(parse_path(hybrid, "cpuacct"), "/a");
+
+    /* colon in path is kept */
+    ASSERT_EQ(parse_path("0::/a:b\n", nullptr), "/a:b");
+    /* malformed lines are skipped */
+    ASSERT_EQ(parse_path("garbage\n4:memory\n4:memory:/m", "memory"), "/m");
+    ASSERT_EQ(parse_path("", "memory"), "<null>");
+    ASSERT_EQ(parse_path(nullptr, "memory"), "<null>");
+}
+
+TEST(isula_cgroup_parse_llt, test_parse_u64)
+{
+    ASSERT_EQ(cgroup_parse_u64("123\n"), 123U);
+    ASSERT_EQ(cgroup_parse_u64("  42"), 42U);
+    ASSERT_EQ(cgroup_parse_u64("9223372036854771712\n"), 9223372036854771712ULL);
+    ASSERT_EQ(cgroup_parse_u64("max\n"), UINT64_MAX);
+    ASSERT_EQ(cgroup_parse_u64("max"), UINT64_MAX);
+    ASSERT_EQ(cgroup_parse_u64(""), 0U);
+    ASSERT_EQ(cgroup_parse_u64("abc"), 0U);
+    ASSERT_EQ(cgroup_parse_u64("-1"), 0U);
+    ASSERT_EQ(cgroup_parse_u64("+1"), 0U);
+    ASSERT_EQ(cgroup_parse_u64("99999999999999999999999"), 0U);
+}
+
+TEST(isula_cgroup_parse_llt, test_parse_field)
+{
+    const char *cpu_stat = "usage_usec 1500\nuser_usec 1000\nsystem_usec 500\n";
+    const char *memory_stat = "cache 10\nrss 20\ntotal_cache 30\ntotal_rss 40\n";
+
+    ASSERT_EQ(cgroup_parse_field_u64(cpu_stat, "usage_usec"), 1500U);
+    ASSERT_EQ(cgroup_parse_field_u64(cpu_stat, "system_usec"), 500U);
+    ASSERT_EQ(cgroup_parse_field_u64(cpu_stat, "usec"), 0U);
+    ASSERT_EQ(cgroup_parse_field_u64(cpu_stat, "nr_periods"), 0U);
+
+    /* key is not matched inside other keys */
+    ASSERT_EQ(cgroup_parse_field_u64(memory_stat, "rss"), 20U);
+    ASSERT_EQ(cgroup_parse_field_u64(memory_stat, "cache"), 10U);
+    ASSERT_EQ(cgroup_parse_field_u64("total_rss 40\nrss 20\n", "rss"), 20U);
+
+    ASSERT_EQ(cgroup_parse_field_u64("8:0 rbytes=100 wbytes=200", "wbytes"), 200U);
+    ASSERT_EQ(cgroup_parse_field_u64("memory.high max", "memory.high"), UINT64_MAX);
+    ASSERT_EQ(cgroup_parse_field_u64("usage_usec\n", "usage_usec"), 0U);
+    ASSERT_EQ(cgroup_parse_field_u64("usage_usec x\n", "usage_usec"), 0U);
+    ASSERT_EQ(cgroup_parse_field_u64("", "usage_usec"), 0U);
+}
+
+TEST(isula_cgroup_parse_llt, test_parse_sum_field)
+{
+    const char *io_stat = "8:0 rbytes=100 wbytes=200 rios=1 wios=2 dbytes=0 dios=0\n"
+                          "8:16 rbytes=1000 wbytes=2000 rios=10 wios=20 dbytes=0 dios=0\n";
+    const char *blkio = "8:0 Read 100\n8:0 Write 200\n8:0 Sync 300\n8:0 Async 0\n8:0 Total 300\n"
+                        "8:16 Read 1000\n8:16 Write 2000\n8:16 Total 3000\nTotal 3300\n";
+
+    ASSERT_EQ(cgroup_parse_sum_field_u64(io_stat, "rbytes"), 1100U);
+    ASSERT_EQ(cgroup_parse_sum_field_u64(io_stat, "wbytes"), 2200U);
+    ASSERT_EQ(cgroup_parse_sum_field_u64(io_stat, "bytes"), 0U);
+
+    ASSERT_EQ(cgroup_parse_sum_field_u64(blkio, "Read"), 1100U);
+    ASSERT_EQ(cgroup_parse_sum_field_u64(blkio, "Write"), 2200U);
+    ASSERT_EQ(cgroup_parse_sum_field_u64(blkio, "Discard"), 0U);
+
+    /* last line without newline, and malformed lines */
+    ASSERT_EQ(cgroup_parse_sum_field_u64("8:0 Read 1\n\ngarbage\n8:0 Read x\n8:16 Read 2", "Read"), 3U);
+    ASSERT_EQ(cgroup_parse_sum_field_u64("", "Read"), 0U);
+}
+
+static std::string parse_pids(const char *content, int expect_ret = 0)
+{
+    pid_t *pids = nullptr;
+    size_t len = 0;
+    char *dup = util_strdup_s(content);
+    std::string result;
+
+    EXPECT_EQ(cgroup_parse_pids(dup, &pids, &len), expect_ret);
+    for (size_t i = 0; i < len; i++) {
+        result += std::to_string(pids[i]) + ",";
+    }
+    free(pids);
+    free(dup);
+    return result;
+}
+
+TEST(isula_cgroup_parse_llt, test_parse_pids)
+{
+    ASSERT_EQ(parse_pids("1\n23\n456\n"), "1,23,456,");
+    ASSERT_EQ(parse_pids(""), "");
+    ASSERT_EQ(parse_pids("\n"), "");
+    /* last pid without newline is kept */
+    ASSERT_EQ(parse_pids("1\n2"), "1,2,");
+    ASSERT_EQ(parse_pids("7"), "7,");
+    /* invalid lines are skipped */
+    ASSERT_EQ(parse_pids("1\nabc\n\n-3\n0\n99999999999\n5\n"), "1,5,");
+}
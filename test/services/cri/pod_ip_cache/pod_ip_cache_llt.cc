@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Description: pod_ip_cache llt
+ * Author: tanyifeng
+ * Create: 2020-04-16
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include "pod_ip_cache.h"
+
+namespace {
+const std::string JSON_CHECKPOINT { "{\"version\":\"v1\"}" };
+
+// keeps checkpoints in memory, saving can be held to emulate slow disk
+class FakePodIPCache : public Network::PodIPCache {
+public:
+    std::map<std::string, std::map<std::string, std::string>> disk;
+    int saves { 0 };
+    int loads { 0 };
+
+    void HoldSave()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_hold = true;
+    }
+
+    void ReleaseSave()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_hold = false;
+        m_cond.notify_all();
+    }
+
+    bool WaitSaving()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_cond.wait_for(lock, std::chrono::seconds(5), [this] { return m_saving; });
+    }
+
+protected:
+    void SaveCheckpoint(const std::string &podSandboxID, const std::map<std::string, std::string> &podIPs,
+                        const std::string &jsonCheckpoint) override
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_saving = true;
+        m_cond.notify_all();
+        m_cond.wait(lock, [this] { return !m_hold; });
+        m_saving = false;
+        saves++;
+        if (podIPs.empty() || jsonCheckpoint.empty()) {
+            disk.erase(podSandboxID);
+        } else {
+            disk[podSandboxID] = podIPs;
+        }
+    }
+
+    void LoadCheckpoint(const std::string &podSandboxID, std::map<std::string, std::string> &podIPs) override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        loads++;
+        auto iter = disk.find(podSandboxID);
+        if (iter != disk.end()) {
+            podIPs = iter->second;
+        }
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_hold { false };
+    bool m_saving { false };
+};
+}
+
+TEST(PodIPCacheUnitTest, test_get_not_blocked_by_save)
+{
+    FakePodIPCache cache;
+    std::string ip;
+
+    cache.Add("pod1", "eth0", "10.0.0.1", JSON_CHECKPOINT);
+    cache.HoldSave();
+    std::thread writer([&cache]() {
+        cache.Add("pod1", "eth1", "10.0.0.2", JSON_CHECKPOINT);
+    });
+    ASSERT_TRUE(cache.WaitSaving());
+
+    // ips are queried while the checkpoint of the same pod is being written
+    auto reader = std::async(std::launch::async, [&cache]() {
+        std::string eth1;
+        return cache.Get("pod1", "eth1", eth1) ? eth1 : std::string();
+    });
+    bool ready = reader.wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+    EXPECT_TRUE(ready);
+    EXPECT_TRUE(cache.Get("pod1", "eth0", ip));
+    EXPECT_EQ(ip, "10.0.0.1");
+
+    cache.ReleaseSave();
+    writer.join();
+    EXPECT_EQ(reader.get(), "10.0.0.2");
+    EXPECT_EQ(cache.disk["pod1"].size(), 2u);
+}
+
+TEST(PodIPCacheUnitTest, test_saves_follow_update_order)
+{
+    FakePodIPCache cache;
+    std::vector<std::thread> threads;
+    const int count = 16;
+
+    for (int i = 0; i < count; i++) {
+        threads.emplace_back([&cache, i]() {
+            cache.Add("pod1", "eth" + std::to_string(i), "10.0.0." + std::to_string(i), JSON_CHECKPOINT);
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    // the last write carries every ip, not a copy taken before a later update
+    EXPECT_EQ(cache.saves, count);
+    ASSERT_EQ(cache.disk["pod1"].size(), (size_t)count);
+    for (int i = 0; i < count; i++) {
+        EXPECT_EQ(cache.disk["pod1"]["eth" + std::to_string(i)], "10.0.0." + std::to_string(i));
+    }
+}
+
+TEST(PodIPCacheUnitTest, test_load_on_miss)
+{
+    FakePodIPCache cache;
+    std::string ip;
+
+    cache.disk["pod1"]["eth0"] = "10.0.0.1";
+
+    EXPECT_TRUE(cache.Get("pod1", "eth0", ip));
+    EXPECT_EQ(ip, "10.0.0.1");
+    EXPECT_EQ(cache.loads, 1);
+
+    // pod is known now, a missing interface does not load checkpoint again
+    EXPECT_FALSE(cache.Get("pod1", "eth1", ip));
+    EXPECT_EQ(cache.loads, 1);
+
+    // nothing cached for unknown pod, it is looked up every time
+    EXPECT_FALSE(cache.Get("pod2", "eth0", ip));
+    EXPECT_FALSE(cache.Get("pod2", "eth0", ip));
+    EXPECT_EQ(cache.loads, 3);
+}
+
+TEST(PodIPCacheUnitTest, test_add_without_checkpoint)
+{
+    FakePodIPCache cache;
+    std::string ip;
+
+    cache.Add("pod1", "eth0", "10.0.0.1", "");
+    cache.Add("pod1", "", "10.0.0.2", JSON_CHECKPOINT);
+    cache.Add("pod1", "eth1", "", JSON_CHECKPOINT);
+
+    EXPECT_EQ(cache.saves, 0);
+    EXPECT_TRUE(cache.disk.empty());
+    EXPECT_TRUE(cache.Get("pod1", "eth0", ip));
+    EXPECT_EQ(ip, "10.0.0.1");
+    EXPECT_FALSE(cache.Get("pod1", "eth1", ip));
+    EXPECT_EQ(cache.loads, 0);
+}
+
+TEST(PodIPCacheUnitTest, test_remove)
+{
+    FakePodIPCache cache;
+    std::string ip;
+
+    cache.Add("pod1", "eth0", "10.0.0.1", JSON_CHECKPOINT);
+    cache.Add("pod1", "eth1", "10.0.0.2", JSON_CHECKPOINT);
+
+    cache.Remove("pod1", "eth0", JSON_CHECKPOINT);
+    EXPECT_FALSE(cache.Get("pod1", "eth0", ip));
+    ASSERT_EQ(cache.disk["pod1"].size(), 1u);
+    EXPECT_EQ(cache.disk["pod1"]["eth1"], "10.0.0.2");
+
+    cache.Remove("pod1", "eth1", JSON_CHECKPOINT);
+    EXPECT_TRUE(cache.disk.empty());
+
+    // checkpoint of pod torn down without sandbox checkpoint is removed as well
+    cache.Add("pod2", "eth0", "10.0.0.3", JSON_CHECKPOINT);
+    cache.Add("pod2", "eth1", "10.0.0.4", JSON_CHECKPOINT);
+    cache.Remove("pod2", "eth0", "");
+    EXPECT_TRUE(cache.disk.empty());
+    EXPECT_TRUE(cache.Get("pod2", "eth1", ip));
+    EXPECT_EQ(ip, "10.0.0.4");
+}
@@ -144,7 +144,7 @@ bool invokeGcIsGcProgress(const char *id)
     return false;
 }
 
-int invokeContainerToDisk(const container_t *cont)
+int invokeContainerStateToDisk(container_t *cont)
 {
     return 0;
 }
@@ -212,7 +212,7 @@ TEST_F(ExecutionExtendUnitTest, test_container_extend_callback_init_pause)
     EXPECT_CALL(m_containersGc, GcIsGcProgress(_)).WillRepeatedly(Invoke(invokeGcIsGcProgress));
     EXPECT_CALL(m_containerState, IsPaused(_)).WillRepeatedly(Invoke(invokeIsPaused));
     EXPECT_CALL(m_containerState, IsRestarting(_)).WillRepeatedly(Invoke(invokeIsRestarting));
-    EXPECT_CALL(m_containerUnix, ContainerToDisk(_)).WillRepeatedly(Invoke(invokeContainerToDisk));
+    EXPECT_CALL(m_containerUnix, ContainerStateToDisk(_)).WillRepeatedly(Invoke(invokeContainerStateToDisk));
     container_extend_callback_init(&cb);
     ASSERT_EQ(cb.pause(request, &response), 0);
     testing::Mock::VerifyAndClearExpectations(&m_runtime);
@@ -235,7 +235,7 @@ TEST_F(ExecutionExtendUnitTest, test_container_extend_callback_init_resume)
     EXPECT_CALL(m_containerState, IsRunning(_)).WillRepeatedly(Invoke(invokeIsRunning));
     EXPECT_CALL(m_containersGc, GcIsGcProgress(_)).WillRepeatedly(Invoke(invokeGcIsGcProgress));
     EXPECT_CALL(m_containerState, IsPaused(_)).WillOnce(Return(true));
-    EXPECT_CALL(m_containerUnix, ContainerToDisk(_)).WillRepeatedly(Invoke(invokeContainerToDisk));
+    EXPECT_CALL(m_containerUnix, ContainerStateToDisk(_)).WillRepeatedly(Invoke(invokeContainerStateToDisk));
     container_extend_callback_init(&cb);
     ASSERT_EQ(cb.resume(request, &response), 0);
     testing::Mock::VerifyAndClearExpectations(&m_runtime);
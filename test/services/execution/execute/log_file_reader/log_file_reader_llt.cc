@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Description: container json log file reader llt
+ * Author: tanyifeng
+ * Create: 2020-04-10
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "log_file_reader.h"
+#include "log_index.h"
+#include "utils.h"
+
+#define LOG_TIME_SECOND 1000000000LL
+
+static bool collect_entry(void *writer, void *data)
+{
+    std::vector<std::string> *lines = static_cast<std::vector<std::string> *>(writer);
+    logger_json_file *entry = static_cast<logger_json_file *>(data);
+
+    lines->push_back(std::string(reinterpret_cast<char *>(entry->log), entry->log_len));
+    return true;
+}
+
+static std::string log_line(const std::string &log, int sec)
+{
+    char tm[64] = { 0 };
+
+    (void)snprintf(tm, sizeof(tm), "2020-04-10T08:00:%02d.000000000Z", sec);
+    return "{\"log\":\"" + log + "\\n\",\"stream\":\"stdout\",\"time\":\"" + tm + "\"}\n";
+}
+
+class LogFileReaderUnitTest : public testing::Test {
+protected:
+    void SetUp() override
+    {
+        char tmpl[] = "/tmp/log_file_reader_llt_XXXXXX";
+
+        ASSERT_NE(mkdtemp(tmpl), nullptr);
+        m_dir = tmpl;
+        m_path = m_dir + "/console.log";
+        m_stream.writer = &m_lines;
+        m_stream.write_func = collect_entry;
+    }
+
+    void TearDown() override
+    {
+        (void)unlink(m_path.c_str());
+        (void)unlink((m_path + LOG_INDEX_SUFFIX).c_str());
+        (void)rmdir(m_dir.c_str());
+    }
+
+    void WriteFile(const std::string &path, const std::string &content)
+    {
+        ASSERT_EQ(util_write_file(path.c_str(), content.c_str(), content.size(), 0600), 0);
+    }
+
+    std::string m_dir;
+    std::string m_path;
+    std::vector<std::string> m_lines;
+    stream_func_wrapper m_stream = { 0 };
+};
+
+static bool decode(const std::string &line, logger_json_file *entry, std::vector<char> &buf)
+{
+    buf.assign(line.size() + 4, 0);
+    return log_file_decode_line(line.c_str(), line.size(), buf.data(), entry);
+}
+
+TEST(log_file_reader_llt, test_decode_line_escapes)
+{
+    std::vector<char> buf;
+    logger_json_file entry = { 0 };
+    std::string line = "{\"log\":\"a\\\"b\\\\c\\/d\\b\\f\\n\\r\\t\\u0041\\u00e9\\u4e2d\","
+                       "\"stream\":\"stderr\",\"time\":\"2020-04-10T08:00:00.000000000Z\"}";
+
+    ASSERT_TRUE(decode(line, &entry, buf));
+    ASSERT_EQ(std::string((char *)entry.log, entry.log_len), "a\"b\\c/d\b\f\n\r\tA\xc3\xa9\xe4\xb8\xad");
+    ASSERT_STREQ(entry.stream, "stderr");
+    ASSERT_STREQ(entry.time, "2020-04-10T08:00:00.000000000Z");
+
+    /* time is optional */
+    line = "{\"log\":\"\",\"stream\":\"stdout\"}";
+    ASSERT_TRUE(decode(line, &entry, buf));
+    ASSERT_EQ(entry.log_len, 0U);
+    ASSERT_EQ(entry.time, nullptr);
+}
+
+TEST(log_file_reader_llt, test_decode_line_fallback)
+{
+    std::vector<char> buf;
+    logger_json_file entry = { 0 };
+    const char *lines[] = {
+        /* surrogate pairs are left to yajl */
+        "{\"log\":\"\\ud83d\\ude00\",\"stream\":\"stdout\"}",
+        "{\"log\":\"\\u12\",\"stream\":\"stdout\"}",
+        "{\"log\":\"\\u12zz\",\"stream\":\"stdout\"}",
+        "{\"log\":\"\\x\",\"stream\":\"stdout\"}",
+        "{\"log\":\"abc\\",
+        "{\"log\":\"abc",
+        "{\"log\":\"abc\",\"stream\":\"stdout\"",
+        "{\"log\":\"abc\",\"stream\":\"stdout\"} ",
+        "{\"stream\":\"stdout\",\"log\":\"abc\"}",
+        "{ \"log\":\"abc\",\"stream\":\"stdout\"}",
+        "",
+    };
+
+    for (size_t i = 0; i < sizeof(lines) / sizeof(lines[0]); i++) {
+        ASSERT_FALSE(decode(lines[i], &entry, buf)) << lines[i];
+    }
+}
+
+TEST(log_file_reader_llt, test_parse_time)
+{
+    int64_t nanos = 0;
+    int64_t slow = 0;
+
+    ASSERT_TRUE(log_file_parse_time("1970-01-01T00:00:00.000000001Z", &nanos));
+    ASSERT_EQ(nanos, 1);
+    ASSERT_TRUE(log_file_parse_time("2020-04-10T08:00:00.123456789Z", &nanos));
+    ASSERT_EQ(nanos, 1586505600LL * LOG_TIME_SECOND + 123456789);
+
+    /* leap years */
+    ASSERT_TRUE(log_file_parse_time("2020-02-29T00:00:00.000000000Z", &nanos));
+    ASSERT_EQ(nanos, 1582934400LL * LOG_TIME_SECOND);
+    ASSERT_TRUE(log_file_parse_time("2000-02-29T00:00:00.000000000Z", &nanos));
+    ASSERT_EQ(nanos, 951782400LL * LOG_TIME_SECOND);
+    ASSERT_TRUE(log_file_parse_time("2100-03-01T00:00:00.000000000Z", &nanos));
+    ASSERT_EQ(nanos, 4107542400LL * LOG_TIME_SECOND);
+    ASSERT_TRUE(log_file_parse_time("1969-12-31T23:59:59.000000000Z", &nanos));
+    ASSERT_EQ(nanos, -LOG_TIME_SECOND);
+
+    /* timezones */
+    ASSERT_TRUE(log_file_parse_time("2020-04-10T16:00:00.123456789+08:00", &nanos));
+    ASSERT_EQ(nanos, 1586505600LL * LOG_TIME_SECOND + 123456789);
+    ASSERT_TRUE(log_file_parse_time("2020-04-10T02:30:00.000000000-05:30", &nanos));
+    ASSERT_EQ(nanos, 1586505600LL * LOG_TIME_SECOND);
+    ASSERT_TRUE(log_file_parse_time("2020-04-10T08:00:00.000000000+00:00", &nanos));
+    ASSERT_EQ(nanos, 1586505600LL * LOG_TIME_SECOND);
+
+    /* other layouts take the slow path and agree with the fast one */
+    ASSERT_TRUE(log_file_parse_time("2020-04-10T08:00:00Z", &slow));
+    ASSERT_EQ(slow, 1586505600LL * LOG_TIME_SECOND);
+
+    ASSERT_FALSE(log_file_parse_time("2020-13-10T08:00:00.000000000Z", &nanos));
+    ASSERT_FALSE(log_file_parse_time("2020-04-10 08:00:00", &nanos));
+    ASSERT_FALSE(log_file_parse_time("2020-04-10T08:00:00.000000000+8:00", &nanos));
+    ASSERT_FALSE(log_file_parse_time(nullptr, &nanos));
+}
+
+TEST_F(LogFileReaderUnitTest, test_read_lines)
+{
+    long last_pos = 0;
+    std::string content = log_line("a", 0) + "not json\n" + log_line("b", 1) + log_line("c", 2);
+    std::string partial = "{\"log\":\"d\\n\",\"stream\"";
+
+    WriteFile(m_path, content + partial);
+
+    ASSERT_EQ(log_file_read_lines(m_path.c_str(), -1, 0, 0, &m_stream, &last_pos), 3);
+    ASSERT_EQ(m_lines, std::vector<std::string>({ "a\n", "b\n", "c\n" }));
+    /* the line being written is not consumed */
+    ASSERT_EQ(last_pos, (long)content.size());
+
+    m_lines.clear();
+    ASSERT_EQ(log_file_read_lines(m_path.c_str(), 2, 0, 0, &m_stream, &last_pos), 2);
+    ASSERT_EQ(m_lines, std::vector<std::string>({ "a\n", "b\n" }));
+    ASSERT_EQ(last_pos, (long)(content.size() - log_line("c", 2).size()));
+
+    /* lines older than since are consumed but not sent */
+    m_lines.clear();
+    ASSERT_EQ(log_file_read_lines(m_path.c_str(), -1, 0, 1586505601LL * LOG_TIME_SECOND, &m_stream, &last_pos), 3);
+    ASSERT_EQ(m_lines, std::vector<std::string>({ "b\n", "c\n" }));
+
+    /* file truncated behind the saved position */
+    m_lines.clear();
+    ASSERT_EQ(log_file_read_lines(m_path.c_str(), -1, (long)content.size() * 2, 0, &m_stream, &last_pos), 0);
+    ASSERT_EQ(last_pos, (long)content.size() * 2);
+    ASSERT_TRUE(m_lines.empty());
+
+    ASSERT_LT(log_file_read_lines((m_dir + "/missing").c_str(), -1, 0, 0, &m_stream, &last_pos), 0);
+    ASSERT_EQ(errno, ENOENT);
+}
+
+TEST_F(LogFileReaderUnitTest, test_read_long_line)
+{
+    long last_pos = 0;
+    std::string log(200 * 1024, 'x');
+    std::string content = log_line("a", 0) + log_line(log, 1) + log_line("c", 2);
+
+    WriteFile(m_path, content);
+
+    ASSERT_EQ(log_file_read_lines(m_path.c_str(), -1, 0, 0, &m_stream, &last_pos), 3);
+    ASSERT_EQ(m_lines.size(), 3U);
+    ASSERT_EQ(m_lines[1], log + "\n");
+    ASSERT_EQ(last_pos, (long)content.size());
+}
+
+TEST_F(LogFileReaderUnitTest, test_read_not_json)
+{
+    long last_pos = 0;
+    std::string content;
+
+    for (int i = 0; i < 30; i++) {
+        content += "plain text\n";
+    }
+    WriteFile(m_path, content);
+
+    ASSERT_LT(log_file_read_lines(m_path.c_str(), -1, 0, 0, &m_stream, &last_pos), 0);
+    ASSERT_TRUE(m_lines.empty());
+}
+
+TEST_F(LogFileReaderUnitTest, test_index_seek)
+{
+    int fd = -1;
+    std::string content;
+    std::vector<log_index_entry> entries;
+
+    for (int i = 0; i < 10; i++) {
+        log_index_entry entry = { 0 };
+
+        entry.timestamp = (1586505600LL + i) * LOG_TIME_SECOND;
+        entry.offset = content.size();
+        entries.push_back(entry);
+        content += log_line("l" + std::to_string(i), i);
+    }
+    WriteFile(m_path, content);
+    fd = open(m_path.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+
+    /* no index */
+    ASSERT_EQ(log_file_index_seek(m_path.c_str(), fd, entries[5].timestamp), 0U);
+
+    WriteFile(m_path + LOG_INDEX_SUFFIX,
+              std::string((const char *)entries.data(), entries.size() * sizeof(log_index_entry)));
+    ASSERT_EQ(log_file_index_seek(m_path.c_str(), fd, entries[5].timestamp), entries[4].offset);
+    ASSERT_EQ(log_file_index_seek(m_path.c_str(), fd, entries[5].timestamp + 1), entries[5].offset);
+    ASSERT_EQ(log_file_index_seek(m_path.c_str(), fd, entries[0].timestamp), 0U);
+    ASSERT_EQ(log_file_index_seek(m_path.c_str(), fd, entries[9].timestamp * 2), entries[9].offset);
+
+    /* offset not at a line start */
+    entries[4].offset += 1;
+    WriteFile(m_path + LOG_INDEX_SUFFIX,
+              std::string((const char *)entries.data(), entries.size() * sizeof(log_index_entry)));
+    ASSERT_EQ(log_file_index_seek(m_path.c_str(), fd, entries[5].timestamp), 0U);
+
+    /* index of a longer file, the log was truncated */
+    entries[4].offset = content.size() + 100;
+    WriteFile(m_path + LOG_INDEX_SUFFIX,
+              std::string((const char *)entries.data(), entries.size() * sizeof(log_index_entry)) + "torn");
+    ASSERT_EQ(log_file_index_seek(m_path.c_str(), fd, entries[5].timestamp), 0U);
+
+    close(fd);
+}
+
+TEST_F(LogFileReaderUnitTest, test_find_tail_position)
+{
+    int fd = -1;
+    long pos = -1;
+    int64_t get_line = 0;
+    std::string content;
+
+    fd = open(m_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    ASSERT_EQ(log_file_find_tail_position(m_path.c_str(), 2, &get_line, &pos), 0);
+    ASSERT_EQ(get_line, 0);
+    ASSERT_EQ(pos, -1);
+
+    /* fewer lines than required, a trailing line without newline is not counted */
+    WriteFile(m_path, "l0\nl1\nl2");
+    ASSERT_EQ(log_file_find_tail_position(m_path.c_str(), 2, &get_line, &pos), 0);
+    ASSERT_EQ(get_line, 2);
+    ASSERT_EQ(pos, -1);
+
+    get_line = 0;
+    WriteFile(m_path, "l0\nl1\nl2\n");
+    ASSERT_EQ(log_file_find_tail_position(m_path.c_str(), 2, &get_line, &pos), 0);
+    ASSERT_EQ(get_line, 2);
+    ASSERT_EQ(pos, 3);
+
+    /* lines counted in a newer file are kept */
+    get_line = 1;
+    pos = -1;
+    ASSERT_EQ(log_file_find_tail_position(m_path.c_str(), 2, &get_line, &pos), 0);
+    ASSERT_EQ(get_line, 2);
+    ASSERT_EQ(pos, 6);
+
+    /* newlines across read chunks */
+    for (int i = 0; i < 20000; i++) {
+        content += "line " + std::to_string(i) + "\n";
+    }
+    WriteFile(m_path, content);
+    get_line = 0;
+    ASSERT_EQ(log_file_find_tail_position(m_path.c_str(), 15000, &get_line, &pos), 0);
+    ASSERT_EQ(get_line, 15000);
+    ASSERT_EQ(content.substr((size_t)pos, 10), "line 5000\n");
+
+    ASSERT_EQ(log_file_find_tail_position(nullptr, 2, &get_line, &pos), 0);
+    ASSERT_NE(log_file_find_tail_position((m_dir + "/missing").c_str(), 2, &get_line, &pos), 0);
+}
@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Description: container list view and its index in containers store llt
+ * Author: tanyifeng
+ * Create: 2020-04-14
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "containers_store.h"
+#include "container_list_view.h"
+#include "utils.h"
+
+static container_t *new_container(const char *id, const char *name, const char *app)
+{
+    container_t *cont = (container_t *)util_common_calloc_s(sizeof(container_t));
+    container_config_v2_common_config *config = NULL;
+
+    if (cont == nullptr) {
+        return nullptr;
+    }
+    config = (container_config_v2_common_config *)util_common_calloc_s(sizeof(container_config_v2_common_config));
+    config->id = util_strdup_s(id);
+    config->name = util_strdup_s(name);
+    config->config = (container_config *)util_common_calloc_s(sizeof(container_config));
+    config->config->labels = (json_map_string_string *)util_common_calloc_s(sizeof(json_map_string_string));
+    (void)append_json_map_string_string(config->config->labels, "app", app);
+    (void)append_json_map_string_string(config->config->labels, "tier", "web");
+    cont->common_config = config;
+    cont->runtime = util_strdup_s("lcr");
+    cont->state = container_state_new();
+    return cont;
+}
+
+static void free_container(container_t *cont)
+{
+    free_container_config_v2_common_config(cont->common_config);
+    container_state_free(cont->state);
+    free(cont->runtime);
+    free(cont);
+}
+
+static void set_running(container_t *cont, int pid)
+{
+    container_pid_t pid_info = { 0 };
+
+    pid_info.pid = pid;
+    state_set_running(cont->state, &pid_info, true);
+}
+
+// same as container_inc_restart_count, which is not linked in
+static void inc_restart_count(container_t *cont)
+{
+    container_state_lock(cont->state);
+    cont->common_config->restart_count++;
+    container_state_bump_seq(cont->state);
+    container_state_unlock(cont->state);
+}
+
+static std::vector<std::string> view_names(container_list_view_t **views, size_t len)
+{
+    std::vector<std::string> names;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        names.push_back(views[i]->name);
+        container_list_view_unref(views[i]);
+    }
+    free(views);
+    return names;
+}
+
+class ContainerListViewUnitTest : public testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+        ASSERT_EQ(containers_store_init(), 0);
+    }
+
+    void TearDown() override
+    {
+        for (auto cont : conts) {
+            (void)containers_store_remove(cont->common_config->id);
+            free_container(cont);
+        }
+        conts.clear();
+    }
+
+    container_t *Add(const char *id, const char *name, const char *app)
+    {
+        container_t *cont = new_container(id, name, app);
+
+        if (cont != nullptr && containers_store_add(id, cont)) {
+            conts.push_back(cont);
+        }
+        return cont;
+    }
+
+    std::vector<container_t *> conts;
+};
+
+TEST_F(ContainerListViewUnitTest, test_view_new_and_refresh)
+{
+    container_t *cont = new_container("c1", "first", "db");
+    container_list_view_t *view = nullptr;
+    container_list_view_t *fresh = nullptr;
+
+    ASSERT_NE(cont, nullptr);
+    view = container_list_view_new(cont);
+    ASSERT_NE(view, nullptr);
+    ASSERT_STREQ(view->id, "c1");
+    ASSERT_STREQ(view->name, "first");
+    ASSERT_STREQ(view->image, "none");
+    ASSERT_STREQ(view->runtime, "lcr");
+    ASSERT_EQ(view->labels->len, 2);
+    ASSERT_FALSE(view->running);
+    ASSERT_FALSE(container_list_view_is_stale(view));
+
+    set_running(cont, 1234);
+    ASSERT_TRUE(container_list_view_is_stale(view));
+
+    // refresh takes state only, config comes from the old view even if container is changed
+    free(cont->common_config->name);
+    cont->common_config->name = util_strdup_s("renamed");
+    fresh = container_list_view_refresh(view);
+    ASSERT_NE(fresh, nullptr);
+    ASSERT_STREQ(fresh->name, "first");
+    ASSERT_STREQ(fresh->labels->values[0], "db");
+    ASSERT_TRUE(fresh->running);
+    ASSERT_EQ(fresh->pid, 1234);
+    ASSERT_FALSE(container_list_view_is_stale(fresh));
+    ASSERT_FALSE(view->running);
+
+    container_list_view_unref(fresh);
+    container_list_view_unref(view);
+    free_container(cont);
+}
+
+TEST_F(ContainerListViewUnitTest, test_store_list_views)
+{
+    container_list_view_t **views = nullptr;
+    size_t len = 0;
+    container_t *b = nullptr;
+
+    ASSERT_NE(Add("bbb", "second", "db"), nullptr);
+    ASSERT_NE(Add("aaa", "first", "web"), nullptr);
+    b = conts[0];
+
+    ASSERT_EQ(containers_store_list_views(&views, &len), 0);
+    ASSERT_EQ(view_names(views, len), std::vector<std::string>({ "first", "second" }));
+
+    // state changed without publishing, list rebuilds the stale view
+    set_running(b, 42);
+    ASSERT_EQ(containers_store_list_views(&views, &len), 0);
+    ASSERT_EQ(len, 2);
+    ASSERT_TRUE(views[1]->running);
+    ASSERT_EQ(views[1]->pid, 42);
+    (void)view_names(views, len);
+
+    // config is published by the holder of container lock, a later refresh keeps it
+    free(b->common_config->name);
+    b->common_config->name = util_strdup_s("renamed");
+    containers_store_update_list_view(b);
+    state_set_stopped(b->state, 1);
+    containers_store_refresh_list_view("bbb");
+    ASSERT_EQ(containers_store_list_views(&views, &len), 0);
+    ASSERT_EQ(len, 2);
+    ASSERT_STREQ(views[1]->name, "renamed");
+    ASSERT_FALSE(views[1]->running);
+    ASSERT_EQ(views[1]->exit_code, 1);
+    (void)view_names(views, len);
+
+    ASSERT_TRUE(containers_store_remove("aaa"));
+    ASSERT_EQ(containers_store_list_views(&views, &len), 0);
+    ASSERT_EQ(view_names(views, len), std::vector<std::string>({ "renamed" }));
+
+    // view of a removed container is not published again
+    containers_store_update_list_view(conts[1]);
+    ASSERT_EQ(containers_store_list_views(&views, &len), 0);
+    ASSERT_EQ(len, 1);
+    (void)view_names(views, len);
+}
+
+TEST_F(ContainerListViewUnitTest, test_store_list_views_by_labels)
+{
+    container_list_view_t **views = nullptr;
+    size_t len = 0;
+    const char *keys[] = { "tier", "app" };
+    const char *db[] = { "web", "db" };
+    const char *cache[] = { "web", "cache" };
+
+    ASSERT_NE(Add("c1", "one", "db"), nullptr);
+    ASSERT_NE(Add("c2", "two", "web"), nullptr);
+    ASSERT_NE(Add("c3", "three", "db"), nullptr);
+
+    ASSERT_EQ(containers_store_list_views_by_labels(keys, db, 2, &views, &len), 0);
+    ASSERT_EQ(view_names(views, len), std::vector<std::string>({ "one", "three" }));
+
+    ASSERT_EQ(containers_store_list_views_by_labels(keys, db, 1, &views, &len), 0);
+    ASSERT_EQ(len, 3);
+    (void)view_names(views, len);
+
+    ASSERT_EQ(containers_store_list_views_by_labels(keys, cache, 2, &views, &len), 0);
+    ASSERT_EQ(len, 0);
+    free(views);
+
+    // labels index follows published config
+    free(conts[0]->common_config->config->labels->values[0]);
+    conts[0]->common_config->config->labels->values[0] = util_strdup_s("cache");
+    containers_store_update_list_view(conts[0]);
+    ASSERT_EQ(containers_store_list_views_by_labels(keys, cache, 2, &views, &len), 0);
+    ASSERT_EQ(view_names(views, len), std::vector<std::string>({ "one" }));
+
+    ASSERT_TRUE(containers_store_remove("c3"));
+    ASSERT_EQ(containers_store_list_views_by_labels(keys, db, 2, &views, &len), 0);
+    ASSERT_EQ(len, 0);
+    free(views);
+}
+
+TEST_F(ContainerListViewUnitTest, test_store_list_views_restart_count)
+{
+    container_list_view_t **views = nullptr;
+    size_t len = 0;
+    container_t *cont = nullptr;
+
+    cont = Add("c1", "one", "db");
+    ASSERT_NE(cont, nullptr);
+    set_running(cont, 42);
+    containers_store_update_list_view(cont);
+
+    // restart policy restarts the exited container, state is saved and refreshed on unlock
+    inc_restart_count(cont);
+    state_set_restarting(cont->state, 1);
+    containers_store_refresh_list_view("c1");
+    ASSERT_EQ(containers_store_list_views(&views, &len), 0);
+    ASSERT_EQ(len, 1);
+    ASSERT_EQ(views[0]->restart_count, 1);
+    ASSERT_FALSE(container_list_view_is_stale(views[0]));
+    (void)view_names(views, len);
+
+    set_running(cont, 43);
+    containers_store_refresh_list_view("c1");
+    inc_restart_count(cont);
+    state_set_restarting(cont->state, 1);
+    containers_store_refresh_list_view("c1");
+    ASSERT_EQ(containers_store_list_views(&views, &len), 0);
+    ASSERT_EQ(views[0]->restart_count, 2);
+    (void)view_names(views, len);
+
+    // count changed without publishing, list rebuilds the stale view
+    container_state_lock(cont->state);
+    cont->common_config->restart_count = 0;
+    container_state_bump_seq(cont->state);
+    container_state_unlock(cont->state);
+    ASSERT_EQ(containers_store_list_views(&views, &len), 0);
+    ASSERT_EQ(views[0]->restart_count, 0);
+    (void)view_names(views, len);
+}
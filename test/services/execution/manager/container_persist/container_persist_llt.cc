@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Description: group commit of container metadata files llt
+ * Author: tanyifeng
+ * Create: 2020-04-15
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "container_persist.h"
+#include "utils.h"
+
+class ContainerPersistUnitTest : public testing::Test {
+protected:
+    void SetUp() override
+    {
+        char tmpl[] = "/tmp/container_persist_llt_XXXXXX";
+
+        ASSERT_NE(mkdtemp(tmpl), nullptr);
+        m_dir = tmpl;
+    }
+
+    void TearDown() override
+    {
+        ASSERT_TRUE(util_recursive_rmdir(m_dir.c_str(), 0) == 0);
+    }
+
+    std::string ReadFile(const std::string &path)
+    {
+        char *content = util_read_text_file(path.c_str());
+        std::string result = content != nullptr ? content : "<null>";
+
+        free(content);
+        return result;
+    }
+
+    std::string m_dir;
+};
+
+TEST_F(ContainerPersistUnitTest, test_persist_wait)
+{
+    std::string path = m_dir + "/config.v2.json";
+    const char *paths[] = { path.c_str() };
+    const char *contents[] = { "{\"v\":1}" };
+    struct stat st;
+
+    ASSERT_EQ(container_persist_files(paths, contents, 1, true), 0);
+    ASSERT_EQ(ReadFile(path), "{\"v\":1}");
+    ASSERT_EQ(stat(path.c_str(), &st), 0);
+    ASSERT_EQ(st.st_mode & 0777, 0640U);
+    /* tmp file is renamed */
+    ASSERT_NE(access((path + ".tmp").c_str(), F_OK), 0);
+
+    ASSERT_EQ(container_persist_files(nullptr, contents, 1, true), -1);
+    ASSERT_EQ(container_persist_wait(nullptr), 0);
+}
+
+TEST_F(ContainerPersistUnitTest, test_persist_batch)
+{
+    std::vector<std::string> names;
+    std::vector<container_persist_ticket *> tickets;
+    container_persist_ticket *last = nullptr;
+
+    for (int i = 0; i < 100; i++) {
+        names.push_back(m_dir + "/file" + std::to_string(i));
+    }
+    for (int i = 0; i < 100; i++) {
+        const char *paths[] = { names[i].c_str() };
+        std::string content = std::to_string(i);
+        const char *contents[] = { content.c_str() };
+        container_persist_ticket *ticket = nullptr;
+
+        ASSERT_EQ(container_persist_queue(paths, contents, 1, &ticket), 0);
+        tickets.push_back(ticket);
+    }
+
+    /* files queued before are committed in the same or an earlier batch */
+    ASSERT_EQ(container_persist_wait(tickets.back()), 0);
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(ReadFile(names[i]), std::to_string(i));
+    }
+    tickets.pop_back();
+    for (auto ticket : tickets) {
+        container_persist_release(ticket);
+    }
+
+    /* files queued together share a ticket */
+    const char *paths[] = { names[0].c_str(), names[1].c_str() };
+    const char *contents[] = { "a", "b" };
+    ASSERT_EQ(container_persist_queue(paths, contents, 2, &last), 0);
+    ASSERT_EQ(container_persist_wait(last), 0);
+    ASSERT_EQ(ReadFile(names[0]), "a");
+    ASSERT_EQ(ReadFile(names[1]), "b");
+}
+
+TEST_F(ContainerPersistUnitTest, test_persist_replace)
+{
+    std::string path = m_dir + "/runtime-state.json";
+    const char *paths[] = { path.c_str() };
+
+    for (int i = 0; i < 50; i++) {
+        std::string content = "state" + std::to_string(i);
+        const char *contents[] = { content.c_str() };
+
+        ASSERT_EQ(container_persist_files(paths, contents, 1, false), 0);
+    }
+    const char *contents[] = { "final" };
+    ASSERT_EQ(container_persist_files(paths, contents, 1, true), 0);
+    ASSERT_EQ(ReadFile(path), "final");
+}
+
+TEST_F(ContainerPersistUnitTest, test_persist_removed_container)
+{
+    /* directory of a removed container is gone, its files are skipped */
+    std::string path = m_dir + "/removed/config.v2.json";
+    std::string other = m_dir + "/hostconfig.json";
+    const char *paths[] = { path.c_str(), other.c_str() };
+    const char *contents[] = { "{}", "{\"h\":1}" };
+
+    ASSERT_EQ(container_persist_files(paths, contents, 2, true), 0);
+    ASSERT_NE(access(path.c_str(), F_OK), 0);
+    ASSERT_EQ(ReadFile(other), "{\"h\":1}");
+}
+
+TEST_F(ContainerPersistUnitTest, test_persist_error)
+{
+    std::string dir = m_dir + "/dir";
+    std::string file = m_dir + "/file";
+    std::string good = m_dir + "/good";
+    const char *contents[] = { "{}", "{\"g\":1}" };
+
+    /* rename over a directory fails */
+    ASSERT_EQ(mkdir(dir.c_str(), 0700), 0);
+    const char *dir_paths[] = { dir.c_str(), good.c_str() };
+    ASSERT_EQ(container_persist_files(dir_paths, contents, 2, true), -1);
+    ASSERT_NE(access((dir + ".tmp").c_str(), F_OK), 0);
+    /* other files of the batch are still committed */
+    ASSERT_EQ(ReadFile(good), "{\"g\":1}");
+
+    /* parent is not a directory */
+    ASSERT_EQ(util_write_file(file.c_str(), "x", 1, 0600), 0);
+    std::string bad = file + "/config.v2.json";
+    const char *bad_paths[] = { bad.c_str() };
+    ASSERT_EQ(container_persist_files(bad_paths, contents, 1, true), -1);
+
+    /* an error is reported to the waiters of its batch only */
+    const char *good_paths[] = { good.c_str() };
+    ASSERT_EQ(container_persist_files(good_paths, contents, 1, true), 0);
+}
@@ -0,0 +1,462 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Description: containers_gc llt
+ * Author: tanyifeng
+ * Create: 2020-04-16
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include "containers_gc.h"
+#include "container_garbage_config.h"
+#include "isulad_config.h"
+#include "execution.h"
+#include "containers_store.h"
+#include "container_state.h"
+#include "restartmanager.h"
+#include "runtime.h"
+#include "utils.h"
+
+#define TEST_GC_PARALLELISM 2
+
+namespace {
+/*
+ * gc list, journal and worker pool are global in containers_gc.c and can be
+ * started only once, so the tests below run in order against the same gc.
+ */
+std::string g_rootdir;
+
+struct clean_record {
+    std::string id;
+    std::string runtime;
+};
+
+std::mutex g_mutex;
+std::condition_variable g_cond;
+std::vector<clean_record> g_cleaned;
+// ids which block in clean_container_resource until released
+std::map<std::string, bool> g_blocked;
+int g_blocking { 0 };
+int g_max_blocking { 0 };
+// number of failures left for each id
+std::map<std::string, int> g_failures;
+
+bool wait_for(const std::function<bool()> &cond)
+{
+    for (int i = 0; i < 1000; i++) {
+        if (cond()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+int clean_count(const std::string &id)
+{
+    std::lock_guard<std::mutex> lock(g_mutex);
+    int count = 0;
+
+    for (const auto &r : g_cleaned) {
+        if (r.id == id) {
+            count++;
+        }
+    }
+    return count;
+}
+
+std::string journal_path()
+{
+    return g_rootdir + "/garbage.journal";
+}
+
+std::string read_file(const std::string &path)
+{
+    char *content = util_read_text_file(path.c_str());
+    std::string ret = content != nullptr ? content : "";
+
+    free(content);
+    return ret;
+}
+
+off_t file_size(const std::string &path)
+{
+    struct stat st;
+
+    if (stat(path.c_str(), &st) != 0) {
+        return -1;
+    }
+    return st.st_size;
+}
+
+std::string add_record(const char *id, const char *runtime)
+{
+    container_garbage_config_gc_containers_element elem = { 0 };
+    container_garbage_config_gc_containers_element *conts[1] = { &elem };
+    container_garbage_config saves = { 0 };
+    struct parser_context ctx = { OPT_GEN_SIMPLIFY, 0 };
+    parser_error err = nullptr;
+    char *json = nullptr;
+    std::string record;
+
+    elem.id = (char *)id;
+    elem.runtime = (char *)runtime;
+    saves.gc_containers = conts;
+    saves.gc_containers_len = 1;
+    json = container_garbage_config_generate_json(&saves, &ctx, &err);
+    if (json != nullptr) {
+        record = std::string("A ") + json + "\n";
+    }
+    free(json);
+    free(err);
+    return record;
+}
+
+int add_container(const char *id, const char *runtime)
+{
+    // pid 0 is never alive, so gc cleans the container at once
+    container_pid_t pid_info = { 0 };
+
+    return gc_add_container(id, runtime, &pid_info);
+}
+} // namespace
+
+extern "C" {
+char *conf_get_isulad_rootdir()
+{
+    return util_strdup_s(g_rootdir.c_str());
+}
+
+int32_t conf_get_gc_parallelism()
+{
+    return TEST_GC_PARALLELISM;
+}
+
+int clean_container_resource(const char *id, const char *runtime, pid_t pid)
+{
+    std::unique_lock<std::mutex> lock(g_mutex);
+
+    (void)pid;
+    auto failure = g_failures.find(id);
+    if (failure != g_failures.end() && failure->second > 0) {
+        failure->second--;
+        return -1;
+    }
+    if (g_blocked.find(id) != g_blocked.end()) {
+        g_blocking++;
+        g_max_blocking = std::max(g_max_blocking, g_blocking);
+        g_cond.notify_all();
+        g_cond.wait(lock, [id]() { return !g_blocked[id]; });
+        g_blocking--;
+    }
+    g_cleaned.push_back({ id, runtime });
+    return 0;
+}
+
+// containers are not in store, so gc does nothing after clean
+container_t *containers_store_get(const char *id_or_name)
+{
+    (void)id_or_name;
+    return nullptr;
+}
+
+void container_unref(container_t *cont)
+{
+    (void)cont;
+}
+
+void container_lock(container_t *cont)
+{
+    (void)cont;
+}
+
+void container_unlock(container_t *cont)
+{
+    (void)cont;
+}
+
+int container_state_to_disk(container_t *cont)
+{
+    (void)cont;
+    return 0;
+}
+
+int container_state_to_disk_locking(container_t *cont)
+{
+    (void)cont;
+    return 0;
+}
+
+int cleanup_container(container_t *cont, bool force)
+{
+    (void)cont;
+    (void)force;
+    return 0;
+}
+
+int set_container_to_removal(const container_t *cont)
+{
+    (void)cont;
+    return 0;
+}
+
+int container_restart_in_thread(const char *id, uint64_t timeout, int exit_code)
+{
+    (void)id;
+    (void)timeout;
+    (void)exit_code;
+    return 0;
+}
+
+void container_inc_restart_count(container_t *cont)
+{
+    (void)cont;
+}
+
+bool restart_manager_should_restart(const char *id, uint32_t exit_code, bool has_been_manually_stopped,
+                                    int64_t exec_duration, uint64_t *timeout)
+{
+    (void)id;
+    (void)exit_code;
+    (void)has_been_manually_stopped;
+    (void)exec_duration;
+    (void)timeout;
+    return false;
+}
+
+bool is_running(container_state_t *s)
+{
+    (void)s;
+    return false;
+}
+
+uint32_t state_get_exitcode(container_state_t *s)
+{
+    (void)s;
+    return 0;
+}
+
+char *state_get_started_at(container_state_t *s)
+{
+    (void)s;
+    return nullptr;
+}
+
+void state_set_restarting(container_state_t *s, int exit_code)
+{
+    (void)s;
+    (void)exit_code;
+}
+
+void state_reset_paused(container_state_t *s)
+{
+    (void)s;
+}
+
+int runtime_resume(const char *name, const char *runtime, const rt_resume_params_t *params)
+{
+    (void)name;
+    (void)runtime;
+    (void)params;
+    return 0;
+}
+}
+
+class ContainersGcUnitTest : public testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+        char tmpl[] = "/tmp/containers_gc_llt_XXXXXX";
+        std::string journal;
+
+        ASSERT_NE(mkdtemp(tmpl), nullptr);
+        g_rootdir = tmpl;
+
+        // records left by last run of daemon, the last one is partially written
+        journal += add_record("restore-a", "runc-old");
+        journal += add_record("restore-b", "runc");
+        journal += add_record("restore-a", "runc-new");
+        journal += "D restore-b\n";
+        journal += "X invalid\n";
+        journal += "A {\"GarbageContainers\":[{\"id\":\"restore-c\"";
+        ASSERT_EQ(util_write_file(journal_path().c_str(), journal.c_str(), journal.size(), 0600), 0);
+
+        ASSERT_EQ(new_gchandler(), 0);
+    }
+
+    static void TearDownTestCase()
+    {
+        std::string cmd = "rm -rf " + g_rootdir;
+        (void)system(cmd.c_str());
+    }
+};
+
+TEST_F(ContainersGcUnitTest, test_restore_replays_journal)
+{
+    container_garbage_config *snapshot = nullptr;
+    std::string path = g_rootdir + "/garbage.json";
+    parser_error err = nullptr;
+
+    EXPECT_TRUE(gc_is_gc_progress("restore-a"));
+    EXPECT_FALSE(gc_is_gc_progress("restore-b"));
+    EXPECT_FALSE(gc_is_gc_progress("restore-c"));
+
+    // journal is compacted into snapshot
+    EXPECT_EQ(file_size(journal_path()), 0);
+    snapshot = container_garbage_config_parse_file(path.c_str(), nullptr, &err);
+    ASSERT_NE(snapshot, nullptr);
+    ASSERT_EQ(snapshot->gc_containers_len, (size_t)1);
+    EXPECT_STREQ(snapshot->gc_containers[0]->id, "restore-a");
+    EXPECT_STREQ(snapshot->gc_containers[0]->runtime, "runc-new");
+    free_container_garbage_config(snapshot);
+    free(err);
+}
+
+TEST_F(ContainersGcUnitTest, test_add_same_container_twice)
+{
+    std::string journal;
+
+    ASSERT_EQ(add_container("dup", "runc-old"), 0);
+    ASSERT_EQ(add_container("dup", "runc-new"), 0);
+    EXPECT_TRUE(gc_is_gc_progress("dup"));
+
+    // both records are journaled, replay keeps the last one
+    journal = read_file(journal_path());
+    EXPECT_EQ(journal, add_record("dup", "runc-old") + add_record("dup", "runc-new"));
+}
+
+TEST_F(ContainersGcUnitTest, test_dispatch_in_parallel)
+{
+    const int count = 5;
+    std::vector<std::string> ids;
+
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        for (int i = 0; i < count; i++) {
+            ids.push_back("block-" + std::to_string(i));
+            g_blocked[ids.back()] = true;
+        }
+    }
+    for (const auto &id : ids) {
+        ASSERT_EQ(add_container(id.c_str(), "runc"), 0);
+    }
+
+    ASSERT_EQ(start_gchandler(), 0);
+
+    // restored and deduplicated containers are cleaned once with the last record
+    ASSERT_TRUE(wait_for([]() { return !gc_is_gc_progress("restore-a") && !gc_is_gc_progress("dup"); }));
+    EXPECT_EQ(clean_count("restore-a"), 1);
+    EXPECT_EQ(clean_count("dup"), 1);
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        for (const auto &r : g_cleaned) {
+            if (r.id == "restore-a" || r.id == "dup") {
+                EXPECT_EQ(r.runtime, "runc-new");
+            }
+        }
+    }
+
+    // no more than parallelism containers are processed at the same time
+    {
+        std::unique_lock<std::mutex> lock(g_mutex);
+        ASSERT_TRUE(g_cond.wait_for(lock, std::chrono::seconds(10),
+                                    []() { return g_blocking == TEST_GC_PARALLELISM; }));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        EXPECT_EQ(g_blocking, TEST_GC_PARALLELISM);
+        for (const auto &id : ids) {
+            g_blocked[id] = false;
+        }
+        g_cond.notify_all();
+    }
+
+    ASSERT_TRUE(wait_for([&ids]() {
+        for (const auto &id : ids) {
+            if (gc_is_gc_progress(id.c_str())) {
+                return false;
+            }
+        }
+        return true;
+    }));
+    EXPECT_EQ(g_max_blocking, TEST_GC_PARALLELISM);
+    for (const auto &id : ids) {
+        EXPECT_EQ(clean_count(id), 1);
+        EXPECT_NE(read_file(journal_path()).find("D " + id + "\n"), std::string::npos);
+    }
+}
+
+TEST_F(ContainersGcUnitTest, test_retry_failed_container)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_failures["retry"] = 2;
+    }
+    ASSERT_EQ(add_container("retry", "runc"), 0);
+
+    ASSERT_TRUE(wait_for([]() { return !gc_is_gc_progress("retry"); }));
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    EXPECT_EQ(clean_count("retry"), 1);
+    // retried twice with 100ms interval
+    EXPECT_GE(elapsed.count(), 200);
+    std::lock_guard<std::mutex> lock(g_mutex);
+    EXPECT_EQ(g_failures["retry"], 0);
+}
+
+TEST_F(ContainersGcUnitTest, test_add_container_in_progress)
+{
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_blocked["inprogress"] = true;
+    }
+    ASSERT_EQ(add_container("inprogress", "runc-first"), 0);
+    {
+        std::unique_lock<std::mutex> lock(g_mutex);
+        ASSERT_TRUE(g_cond.wait_for(lock, std::chrono::seconds(10), []() { return g_blocking == 1; }));
+    }
+
+    // the newer record waits for the running job instead of a second job of the same container
+    ASSERT_EQ(add_container("inprogress", "runc-second"), 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        EXPECT_EQ(g_blocking, 1);
+        g_blocked["inprogress"] = false;
+        g_cond.notify_all();
+    }
+
+    ASSERT_TRUE(wait_for([]() { return !gc_is_gc_progress("inprogress"); }));
+    std::lock_guard<std::mutex> lock(g_mutex);
+    std::vector<std::string> runtimes;
+    for (const auto &r : g_cleaned) {
+        if (r.id == "inprogress") {
+            runtimes.push_back(r.runtime);
+        }
+    }
+    ASSERT_EQ(runtimes.size(), (size_t)2);
+    EXPECT_EQ(runtimes[0], "runc-first");
+    EXPECT_EQ(runtimes[1], "runc-second");
+}
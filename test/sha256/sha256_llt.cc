@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Description: sha256 llt
+ * Author: tanyifeng
+ * Create: 2020-04-15
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <zlib.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "sha256.h"
+#include "utils.h"
+
+static std::string digest_of(const void *data, size_t len, bool generic)
+{
+    sha256_context ctx;
+    char out[SHA256_SIZE + 1] = { 0 };
+
+    if (generic) {
+        sha256_init_generic(&ctx);
+    } else {
+        sha256_init(&ctx);
+    }
+    sha256_update(&ctx, data, len);
+    sha256_final_hex(&ctx, out);
+    return std::string(out);
+}
+
+static std::vector<unsigned char> random_bytes(size_t len)
+{
+    std::vector<unsigned char> data(len);
+    unsigned int seed = 20200415;
+
+    for (size_t i = 0; i < len; i++) {
+        data[i] = (unsigned char)rand_r(&seed);
+    }
+    return data;
+}
+
+static std::string write_tmp_file(const void *data, size_t len)
+{
+    char path[] = "/tmp/sha256_llt_XXXXXX";
+    int fd = mkstemp(path);
+
+    if (fd < 0) {
+        return "";
+    }
+    if (len > 0 && write(fd, data, len) != (ssize_t)len) {
+        close(fd);
+        unlink(path);
+        return "";
+    }
+    close(fd);
+    return std::string(path);
+}
+
+TEST(sha256_llt, test_known_vectors)
+{
+    const char *abc = "abc";
+    const char *two_blocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+
+    ASSERT_EQ(digest_of("", 0, false), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    ASSERT_EQ(digest_of(abc, strlen(abc), false), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    ASSERT_EQ(digest_of(two_blocks, strlen(two_blocks), false),
+              "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    ASSERT_EQ(digest_of(abc, strlen(abc), true), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+}
+
+TEST(sha256_llt, test_million_a_in_chunks)
+{
+    std::string chunk(997, 'a');
+    size_t left = 1000000;
+    sha256_context ctx;
+    char out[SHA256_SIZE + 1] = { 0 };
+
+    sha256_init(&ctx);
+    while (left > 0) {
+        size_t n = left < chunk.size() ? left : chunk.size();
+        sha256_update(&ctx, chunk.data(), n);
+        left -= n;
+    }
+    sha256_final_hex(&ctx, out);
+    ASSERT_STREQ(out, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+TEST(sha256_llt, test_accelerated_matches_generic)
+{
+    std::vector<unsigned char> data = random_bytes(4096);
+
+    std::cout << "sha256 implementation: " << sha256_implementation() << std::endl;
+    for (size_t len = 0; len <= 300; len++) {
+        ASSERT_EQ(digest_of(data.data(), len, false), digest_of(data.data(), len, true)) << "length " << len;
+    }
+    ASSERT_EQ(digest_of(data.data(), data.size(), false), digest_of(data.data(), data.size(), true));
+}
+
+TEST(sha256_llt, test_calculate_buffer)
+{
+    const char *abc = "abc";
+    char out[SHA256_SIZE + 1] = { 0 };
+
+    ASSERT_EQ(sha256sum_calculate((void *)abc, out, strlen(abc), false, false), 0);
+    ASSERT_STREQ(out, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    ASSERT_NE(sha256sum_calculate(nullptr, out, 0, true, false), 0);
+}
+
+TEST(sha256_llt, test_digest_file_and_streams)
+{
+    std::vector<unsigned char> data = random_bytes(300000);
+    std::string expect = digest_of(data.data(), data.size(), true);
+    std::string path = write_tmp_file(data.data(), data.size());
+    std::string gz_path = path + ".gz";
+    char *digest = nullptr;
+    FILE *fp = nullptr;
+    gzFile gz = nullptr;
+    sha256_context ctx;
+    char out[SHA256_SIZE + 1] = { 0 };
+    int fd = -1;
+
+    ASSERT_FALSE(path.empty());
+
+    digest = sha256_digest_file(path.c_str(), false);
+    ASSERT_NE(digest, nullptr);
+    ASSERT_EQ(std::string(digest), expect);
+    free(digest);
+
+    fp = fopen(path.c_str(), "r");
+    ASSERT_NE(fp, nullptr);
+    digest = sha256_digest(fp, false);
+    fclose(fp);
+    ASSERT_NE(digest, nullptr);
+    ASSERT_EQ(std::string(digest), expect);
+    free(digest);
+
+    fd = open(path.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+    sha256_init(&ctx);
+    ASSERT_EQ(sha256_update_fd(&ctx, fd), 0);
+    close(fd);
+    sha256_final_hex(&ctx, out);
+    ASSERT_EQ(std::string(out), expect);
+
+    gz = gzopen(gz_path.c_str(), "wb");
+    ASSERT_NE(gz, nullptr);
+    ASSERT_EQ(gzwrite(gz, data.data(), (unsigned)data.size()), (int)data.size());
+    gzclose(gz);
+
+    digest = sha256_digest_file(gz_path.c_str(), true);
+    ASSERT_NE(digest, nullptr);
+    ASSERT_EQ(std::string(digest), expect);
+    free(digest);
+
+    gz = gzopen(gz_path.c_str(), "rb");
+    ASSERT_NE(gz, nullptr);
+    digest = sha256_digest(gz, true);
+    gzclose(gz);
+    ASSERT_NE(digest, nullptr);
+    ASSERT_EQ(std::string(digest), expect);
+    free(digest);
+
+    unlink(path.c_str());
+    unlink(gz_path.c_str());
+}
+
+TEST(sha256_llt, test_digest_empty_file)
+{
+    std::string path = write_tmp_file("", 0);
+    char *digest = nullptr;
+
+    ASSERT_FALSE(path.empty());
+    digest = sha256_digest_file(path.c_str(), false);
+    ASSERT_NE(digest, nullptr);
+    ASSERT_STREQ(digest, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    free(digest);
+    unlink(path.c_str());
+
+    ASSERT_EQ(sha256_digest_file("/tmp/sha256_llt_not_exist", false), nullptr);
+}
+
+/* digest by sha256sum in a child fed by pipe, how it was done before */
+static std::string fork_sha256sum(const char *path)
+{
+    int in[2] = { -1, -1 };
+    int out[2] = { -1, -1 };
+    char buf[32768];
+    char result[SHA256_SIZE + 1] = { 0 };
+    ssize_t n = 0;
+    pid_t pid;
+    int fd = -1;
+    int status = 0;
+
+    if (pipe2(in, O_CLOEXEC) != 0 || pipe2(out, O_CLOEXEC) != 0) {
+        return "";
+    }
+
+    pid = fork();
+    if (pid == 0) {
+        dup2(in[0], 0);
+        dup2(out[1], 1);
+        execlp("sha256sum", "sha256sum", NULL);
+        _exit(127);
+    }
+    close(in[0]);
+    close(out[1]);
+
+    fd = open(path, O_RDONLY);
+    while (fd >= 0 && (n = read(fd, buf, sizeof(buf))) > 0) {
+        if (write(in[1], buf, (size_t)n) != n) {
+            break;
+        }
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    close(in[1]);
+
+    n = read(out[0], result, SHA256_SIZE);
+    close(out[0]);
+    waitpid(pid, &status, 0);
+    if (n != SHA256_SIZE || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return "";
+    }
+    return std::string(result);
+}
+
+static double elapsed_seconds(const struct timeval *begin)
+{
+    struct timeval end;
+
+    gettimeofday(&end, nullptr);
+    return (double)(end.tv_sec - begin->tv_sec) + (double)(end.tv_usec - begin->tv_usec) / 1000000;
+}
+
+/* run with --gtest_also_run_disabled_tests */
+TEST(sha256_llt, DISABLED_benchmark_against_sha256sum)
+{
+    const size_t size = 256 * 1024 * 1024;
+    const size_t small_size = 4096;
+    const int small_rounds = 200;
+    std::vector<unsigned char> data = random_bytes(size);
+    std::string path = write_tmp_file(data.data(), data.size());
+    std::string small_path = write_tmp_file(data.data(), small_size);
+    std::string native;
+    std::string forked;
+    struct timeval begin;
+    double native_secs = 0;
+    double fork_secs = 0;
+    char *digest = nullptr;
+    int i;
+
+    ASSERT_FALSE(path.empty());
+    ASSERT_FALSE(small_path.empty());
+
+    gettimeofday(&begin, nullptr);
+    digest = sha256_digest_file(path.c_str(), false);
+    native_secs = elapsed_seconds(&begin);
+    ASSERT_NE(digest, nullptr);
+    native = digest;
+    free(digest);
+
+    gettimeofday(&begin, nullptr);
+    forked = fork_sha256sum(path.c_str());
+    fork_secs = elapsed_seconds(&begin);
+    ASSERT_EQ(native, forked);
+
+    std::cout << "large file " << size / (1024 * 1024) << "MB: native(" << sha256_implementation() << ") "
+              << size / (1024 * 1024) / native_secs << " MB/s, fork sha256sum " << size / (1024 * 1024) / fork_secs
+              << " MB/s" << std::endl;
+
+    gettimeofday(&begin, nullptr);
+    for (i = 0; i < small_rounds; i++) {
+        digest = sha256_digest_file(small_path.c_str(), false);
+        free(digest);
+    }
+    native_secs = elapsed_seconds(&begin);
+
+    gettimeofday(&begin, nullptr);
+    for (i = 0; i < small_rounds; i++) {
+        forked = fork_sha256sum(small_path.c_str());
+    }
+    fork_secs = elapsed_seconds(&begin);
+
+    std::cout << "small file " << small_size << "B: native " << native_secs * 1000000 / small_rounds
+              << " us/digest, fork sha256sum " << fork_secs * 1000000 / small_rounds << " us/digest" << std::endl;
+
+    unlink(path.c_str());
+    unlink(small_path.c_str());
+}
@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020. All rights reserved.
+ * iSulad licensed under the Mulan PSL v1.
+ * You can use this software according to the terms and conditions of the Mulan PSL v1.
+ * You may obtain a copy of Mulan PSL v1 at:
+ *     http://license.coscl.org.cn/MulanPSL
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND, EITHER EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR
+ * PURPOSE.
+ * See the Mulan PSL v1 for more details.
+ * Description: libtar llt
+ * Author: tanyifeng
+ * Create: 2020-04-15
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <gtest/gtest.h>
+#include "libtar.h"
+#include "utils.h"
+
+class LibtarUnitTest : public testing::Test {
+protected:
+    void SetUp() override
+    {
+        char tmpl[] = "/tmp/libtar_llt_XXXXXX";
+
+        signal(SIGPIPE, SIG_IGN);
+        ASSERT_NE(mkdtemp(tmpl), nullptr);
+        root = tmpl;
+        src = root + "/src";
+        dst = root + "/dst";
+        ASSERT_EQ(mkdir(src.c_str(), 0755), 0);
+        ASSERT_EQ(mkdir(dst.c_str(), 0755), 0);
+    }
+
+    void TearDown() override
+    {
+        std::string cmd = "rm -rf " + root;
+        ASSERT_EQ(system(cmd.c_str()), 0);
+    }
+
+    static void WriteFile(const std::string &path, const std::string &content, mode_t mode)
+    {
+        std::ofstream out(path);
+        out << content;
+        out.close();
+        ASSERT_EQ(chmod(path.c_str(), mode), 0);
+    }
+
+    static std::string ReadFile(const std::string &path)
+    {
+        std::ifstream in(path);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+
+    /* archive dir/base by archive_path and extract it by archive_untar */
+    static int Copy(const std::string &dir, const std::string &base, const char *rebase, bool compression,
+                    const std::string &to, const char *src_base, const char *dst_base)
+    {
+        struct io_read_wrapper reader = { 0 };
+        char *err = nullptr;
+        int ret = 0;
+
+        if (archive_path(dir.c_str(), base.c_str(), rebase, compression, &reader) != 0) {
+            return -1;
+        }
+        ret = archive_untar(&reader, compression, to.c_str(), src_base, dst_base, &err);
+        free(err);
+        err = nullptr;
+        if (reader.close(reader.context, &err) != 0) {
+            ret = -1;
+        }
+        free(err);
+        return ret;
+    }
+
+    /* append a ustar header of an entry without content to archive */
+    static void AppendHeader(std::string &archive, const std::string &name, char type, mode_t mode,
+                             const std::string &linkname)
+    {
+        char hdr[512] = { 0 };
+        unsigned int sum = 0;
+        size_t i;
+
+        (void)snprintf(hdr, 100, "%s", name.c_str());
+        (void)snprintf(hdr + 100, 8, "%07o", (unsigned int)mode);
+        (void)snprintf(hdr + 108, 8, "%07o", 0);
+        (void)snprintf(hdr + 116, 8, "%07o", 0);
+        (void)snprintf(hdr + 124, 12, "%011o", 0);
+        (void)snprintf(hdr + 136, 12, "%011o", 0);
+        hdr[156] = type;
+        (void)snprintf(hdr + 157, 100, "%s", linkname.c_str());
+        (void)memcpy(hdr + 257, "ustar", 6);
+        (void)memcpy(hdr + 263, "00", 2);
+        (void)memset(hdr + 148, ' ', 8);
+        for (i = 0; i < sizeof(hdr); i++) {
+            sum += (unsigned char)hdr[i];
+        }
+        (void)snprintf(hdr + 148, 8, "%06o", sum);
+        archive.append(hdr, sizeof(hdr));
+    }
+
+    struct MemReader {
+        std::string data;
+        size_t off;
+    };
+
+    static int Untar(std::string archive, const std::string &to)
+    {
+        struct io_read_wrapper reader = { 0 };
+        struct MemReader mem;
+        char *err = nullptr;
+        int ret;
+
+        // end of archive
+        mem.data = archive.append(1024, '\0');
+        mem.off = 0;
+        reader.context = &mem;
+        reader.read = [](void *context, void *buf, size_t len) -> ssize_t {
+            MemReader *m = (MemReader *)context;
+            size_t n = std::min(len, m->data.size() - m->off);
+            (void)memcpy(buf, m->data.data() + m->off, n);
+            m->off += n;
+            return (ssize_t)n;
+        };
+        ret = archive_untar(&reader, false, to.c_str(), nullptr, nullptr, &err);
+        free(err);
+        return ret;
+    }
+
+    std::string root;
+    std::string src;
+    std::string dst;
+};
+
+TEST_F(LibtarUnitTest, test_archive_and_untar)
+{
+    std::string long_name(150, 'l');
+    std::string big(300000, 'b');
+    struct stat st;
+    char target[PATH_MAX] = { 0 };
+
+    ASSERT_EQ(mkdir((src + "/dir").c_str(), 0750), 0);
+    ASSERT_EQ(mkdir((src + "/dir/" + long_name).c_str(), 0755), 0);
+    WriteFile(src + "/dir/" + long_name + "/" + long_name, "long", 0644);
+    WriteFile(src + "/dir/big", big, 0600);
+    WriteFile(src + "/dir/exec", "#!/bin/sh", 0755);
+    WriteFile(src + "/empty", "", 0644);
+    ASSERT_EQ(link((src + "/dir/exec").c_str(), (src + "/hard").c_str()), 0);
+    ASSERT_EQ(symlink("dir/exec", (src + "/link").c_str()), 0);
+
+    for (bool compression : { false, true }) {
+        std::string to = dst + (compression ? "/gz" : "/plain");
+        ASSERT_EQ(mkdir(to.c_str(), 0755), 0);
+        ASSERT_EQ(Copy(root, "src", nullptr, compression, to, nullptr, nullptr), 0);
+
+        ASSERT_EQ(ReadFile(to + "/src/dir/" + long_name + "/" + long_name), "long");
+        ASSERT_EQ(ReadFile(to + "/src/dir/big"), big);
+        ASSERT_EQ(ReadFile(to + "/src/empty"), "");
+        ASSERT_EQ(stat((to + "/src/dir").c_str(), &st), 0);
+        ASSERT_EQ(st.st_mode & 0777, 0750);
+        ASSERT_EQ(stat((to + "/src/dir/exec").c_str(), &st), 0);
+        ASSERT_EQ(st.st_mode & 0777, 0755);
+        ASSERT_EQ(st.st_nlink, 2);
+        ASSERT_GT(readlink((to + "/src/link").c_str(), target, sizeof(target) - 1), 0);
+        ASSERT_STREQ(target, "dir/exec");
+    }
+}
+
+TEST_F(LibtarUnitTest, test_untar_rebase)
+{
+    ASSERT_EQ(mkdir((src + "/sub").c_str(), 0755), 0);
+    WriteFile(src + "/sub/file", "content", 0644);
+    WriteFile(src + "/file", "top", 0644);
+
+    ASSERT_EQ(Copy(root, "src", nullptr, false, dst, "src", "renamed"), 0);
+    ASSERT_EQ(ReadFile(dst + "/renamed/sub/file"), "content");
+    ASSERT_EQ(ReadFile(dst + "/renamed/file"), "top");
+    ASSERT_NE(access((dst + "/src").c_str(), F_OK), 0);
+
+    ASSERT_EQ(Copy(root, "src", "archived", false, dst, nullptr, nullptr), 0);
+    ASSERT_EQ(ReadFile(dst + "/archived/sub/file"), "content");
+
+    ASSERT_EQ(Copy(src, "file", nullptr, false, dst, "file", "other"), 0);
+    ASSERT_EQ(ReadFile(dst + "/other"), "top");
+}
+
+TEST_F(LibtarUnitTest, test_untar_skip_parent_entries)
+{
+    WriteFile(src + "/file", "evil", 0644);
+
+    // entries named ../escaped must not be extracted out of dst
+    ASSERT_EQ(Copy(root, "src", "../escaped", false, dst, nullptr, nullptr), 0);
+    ASSERT_NE(access((root + "/escaped").c_str(), F_OK), 0);
+
+    // symlink in dst is followed in scope of dst
+    ASSERT_EQ(symlink(root.c_str(), (dst + "/abs").c_str()), 0);
+    ASSERT_EQ(Copy(root, "src", "abs/escaped", false, dst, nullptr, nullptr), 0);
+    ASSERT_NE(access((root + "/escaped").c_str(), F_OK), 0);
+    ASSERT_EQ(ReadFile(dst + root + "/escaped/file"), "evil");
+}
+
+TEST_F(LibtarUnitTest, test_untar_dir_replaced_by_symlink)
+{
+    std::string archive;
+    std::string victim = root + "/victim";
+    struct stat st;
+
+    WriteFile(victim, "host", 0644);
+
+    // attributes of dir d are set after extraction, they must not go through the symlink replacing it
+    AppendHeader(archive, "d/", '5', 0750, "");
+    AppendHeader(archive, "d", '2', 0777, victim);
+    ASSERT_EQ(Untar(archive, dst), 0);
+
+    ASSERT_EQ(lstat((dst + "/d").c_str(), &st), 0);
+    ASSERT_TRUE(S_ISLNK(st.st_mode));
+    ASSERT_EQ(stat(victim.c_str(), &st), 0);
+    ASSERT_EQ(st.st_mode & 07777, 0644);
+}
+
+TEST_F(LibtarUnitTest, test_untar_invalid_archive)
+{
+    struct io_read_wrapper reader = { 0 };
+    char *err = nullptr;
+    int fd = open("/dev/urandom", O_RDONLY);
+    int zero_fd = open("/dev/null", O_RDONLY);
+
+    ASSERT_GE(fd, 0);
+    ASSERT_GE(zero_fd, 0);
+    reader.context = &fd;
+    reader.read = [](void *context, void *buf, size_t len) -> ssize_t {
+        return read(*(int *)context, buf, len > 1024 ? 1024 : len);
+    };
+    ASSERT_NE(archive_untar(&reader, false, dst.c_str(), nullptr, nullptr, &err), 0);
+    ASSERT_NE(err, nullptr);
+    free(err);
+    err = nullptr;
+
+    // empty stream
+    reader.context = &zero_fd;
+    ASSERT_NE(archive_untar(&reader, false, dst.c_str(), nullptr, nullptr, &err), 0);
+    free(err);
+    close(fd);
+    close(zero_fd);
+}